@@ -0,0 +1,17 @@
+# Find the bliss library (canonical labeling of graphs), used by the graph
+# mining apps
+#  BLISS_FOUND - system has bliss
+#  BLISS_INCLUDE_DIRS - the directory with the bliss headers (graph.hh)
+#  BLISS_LIBRARIES - libraries needed to use bliss
+
+if(BLISS_INCLUDE_DIRS AND BLISS_LIBRARIES)
+  set(Bliss_FIND_QUIETLY TRUE)
+endif()
+
+find_path(BLISS_INCLUDE_DIRS NAMES graph.hh defs.hh PATH_SUFFIXES bliss)
+find_library(BLISS_LIBRARIES NAMES bliss libbliss)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(Bliss DEFAULT_MSG BLISS_INCLUDE_DIRS BLISS_LIBRARIES)
+
+mark_as_advanced(BLISS_INCLUDE_DIRS BLISS_LIBRARIES)
@@ -6,6 +6,12 @@
 #include <utility>
 #include <cmath>
 #include <limits>
+#include <atomic>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 class NoCommunication : public galois::graphs::ReadMasterAssignment {
  public:
@@ -542,6 +548,177 @@ class FennelP : public galois::graphs::CustomMasterAssignment {
   }
 };
 
+/**
+ * Edge cut whose masters come from a precomputed vertex-to-host partition,
+ * e.g. the -output file of lonestar/gmetis: a text file with one host id per
+ * line, where line i holds the host of node i. Set the file name with
+ * setPartitionFile before constructing the graph.
+ *
+ * Each host only keeps the assignment of the nodes it reads. The file is
+ * mmap'd and scanned in parallel: every thread counts the lines starting in
+ * its block of bytes, and after a prefix sum over the counts the threads
+ * that hold lines of this host's read range parse them.
+ */
+class PartitionFileP : public galois::graphs::CustomMasterAssignment {
+  //! host of each node in [_readOffset, _readOffset + _readMasters.size())
+  std::vector<uint32_t> _readMasters;
+  uint64_t _readOffset;
+
+  static std::string& partitionFileName() {
+    static std::string name;
+    return name;
+  }
+
+  /**
+   * Reads the masters of nodes [beginNode, endNode) from the partition file.
+   */
+  void readPartitionFile(uint64_t beginNode, uint64_t endNode) {
+    const std::string& filename = partitionFileName();
+    if (filename.empty()) {
+      GALOIS_DIE("no partition file set for PartitionFileP");
+    }
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) {
+      GALOIS_SYS_DIE("failed opening ", "'", filename, "'");
+    }
+    struct stat buf;
+    if (fstat(fd, &buf) == -1) {
+      GALOIS_SYS_DIE("failed reading ", "'", filename, "'");
+    }
+    size_t size = buf.st_size;
+    const char* data = nullptr;
+    if (size > 0) {
+      void* base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (base == MAP_FAILED) {
+        GALOIS_SYS_DIE("failed mmap of ", "'", filename, "'");
+      }
+      data = static_cast<const char*>(base);
+    }
+
+    // a line starts at byte i if i is the first byte or follows a newline;
+    // each thread owns the lines that start in its block of bytes
+    auto isLineStart = [&](size_t i) { return i == 0 || data[i - 1] == '\n'; };
+
+    unsigned numThreads = galois::getActiveThreads();
+    std::vector<uint64_t> firstLine(numThreads + 1, 0);
+    galois::on_each([&](unsigned tid, unsigned total) {
+      size_t b, e;
+      std::tie(b, e) = galois::block_range((size_t)0, size, tid, total);
+      uint64_t lines = 0;
+      for (size_t i = b; i < e; i++) {
+        lines += isLineStart(i);
+      }
+      firstLine[tid + 1] = lines;
+    });
+    for (unsigned t = 0; t < numThreads; t++) {
+      firstLine[t + 1] += firstLine[t];
+    }
+
+    if (firstLine[numThreads] != _numNodes) {
+      GALOIS_DIE("partition file ", filename, " has ", firstLine[numThreads],
+                 " lines but the graph has ", _numNodes, " nodes");
+    }
+
+    _readOffset = beginNode;
+    _readMasters.assign(endNode - beginNode, 0);
+
+    std::atomic<uint64_t> badLine(std::numeric_limits<uint64_t>::max());
+    galois::on_each([&](unsigned tid, unsigned total) {
+      if (firstLine[tid + 1] <= beginNode || firstLine[tid] >= endNode) {
+        return;
+      }
+      size_t b, e;
+      std::tie(b, e) = galois::block_range((size_t)0, size, tid, total);
+      uint64_t line = firstLine[tid];
+      for (size_t i = b; i < e && line < endNode; i++) {
+        if (!isLineStart(i)) {
+          continue;
+        }
+        if (line >= beginNode) {
+          // parse the host id; a line may run past the end of the block
+          uint64_t host = 0;
+          size_t j = i;
+          for (; j < size && data[j] >= '0' && data[j] <= '9'; j++) {
+            host = host * 10 + (data[j] - '0');
+            if (host >= _numHosts) {
+              break;
+            }
+          }
+          bool ok = j > i && host < _numHosts &&
+                    (j == size || data[j] == '\n' || data[j] == '\r');
+          if (ok) {
+            _readMasters[line - beginNode] = host;
+          } else {
+            badLine = line;
+          }
+        }
+        line++;
+      }
+    });
+
+    if (data) {
+      munmap(const_cast<char*>(data), size);
+    }
+    close(fd);
+
+    if (badLine != std::numeric_limits<uint64_t>::max()) {
+      GALOIS_DIE("partition file ", filename, " line ", badLine + 1,
+                 " is not a host id less than ", _numHosts);
+    }
+  }
+
+ public:
+  PartitionFileP(uint32_t hostID, uint32_t numHosts, uint64_t numNodes,
+                 uint64_t numEdges) :
+      galois::graphs::CustomMasterAssignment(hostID, numHosts, numNodes,
+                                             numEdges),
+      _readOffset(0) {}
+
+  /**
+   * Sets the vertex-to-host partition file read by every PartitionFileP
+   * constructed afterwards.
+   */
+  static void setPartitionFile(const std::string& filename) {
+    partitionFileName() = filename;
+  }
+
+  /**
+   * Saves the reading ranges of the hosts, then loads the masters of the
+   * nodes this host reads.
+   */
+  void saveGIDToHost(std::vector<std::pair<uint64_t, uint64_t>>& gid2host) {
+    galois::graphs::CustomMasterAssignment::saveGIDToHost(gid2host);
+    readPartitionFile(gid2host[_hostID].first, gid2host[_hostID].second);
+  }
+
+  template<typename EdgeTy>
+  uint32_t getMaster(uint32_t src, galois::graphs::BufferedGraph<EdgeTy>&,
+                     const std::vector<uint32_t>&,
+                     std::unordered_map<uint64_t, uint32_t>&,
+                     const std::vector<uint64_t>&,
+                     std::vector<galois::CopyableAtomic<uint64_t>>&,
+                     const std::vector<uint64_t>&,
+                     std::vector<galois::CopyableAtomic<uint64_t>>&) {
+    // placement is fixed by the file, so the loads are not needed
+    assert(src - _readOffset < _readMasters.size());
+    return _readMasters[src - _readOffset];
+  }
+
+  // edge cut: all edges on source
+  uint32_t getEdgeOwner(uint32_t src, uint32_t, uint64_t) const {
+    return retrieveMaster(src);
+  }
+
+  bool noCommunication() { return false; }
+  bool isVertexCut() const { return false; }
+  void serializePartition(boost::archive::binary_oarchive&) { return; }
+  void deserializePartition(boost::archive::binary_iarchive&) { return; }
+  std::pair<unsigned, unsigned> cartesianGrid() {
+    return std::make_pair(0u, 0u);
+  }
+};
+
 class SugarP : public galois::graphs::CustomMasterAssignment {
   // used in hybrid cut
   uint32_t _vCutThreshold;
@@ -0,0 +1,172 @@
+/*
+ * This file belongs to the Galois project, a C++ library for exploiting parallelism.
+ * The code is being released under the terms of the 3-Clause BSD License (a
+ * copy is located in LICENSE.txt at the top-level directory).
+ *
+ * Copyright (C) 2019, The University of Texas at Austin. All rights reserved.
+ * UNIVERSITY EXPRESSLY DISCLAIMS ANY AND ALL WARRANTIES CONCERNING THIS
+ * SOFTWARE AND DOCUMENTATION, INCLUDING ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR ANY PARTICULAR PURPOSE, NON-INFRINGEMENT AND WARRANTIES OF
+ * PERFORMANCE, AND ANY WARRANTY THAT MIGHT OTHERWISE ARISE FROM COURSE OF
+ * DEALING OR USAGE OF TRADE.  NO WARRANTY IS EITHER EXPRESS OR IMPLIED WITH
+ * RESPECT TO THE USE OF THE SOFTWARE OR DOCUMENTATION. Under no circumstances
+ * shall University be liable for incidental, special, indirect, direct or
+ * consequential damages or loss of profits, interruption of business, or
+ * related expenses which may arise from use of Software or Documentation,
+ * including but not limited to those resulting from defects in Software and/or
+ * Documentation, or loss or inaccuracy of data of any kind.
+ */
+
+/**
+ * @file galois/Buckets.h
+ *
+ * Bucketing structure for peeling algorithms (k-core, k-truss, ...) in the
+ * style of Julienne (Dhulipala et al., SPAA'17): items are kept in buckets
+ * by an integer key that only decreases, and the algorithm repeatedly
+ * extracts the lowest nonempty bucket, processes it in parallel and moves
+ * the items whose keys changed.
+ */
+
+#ifndef GALOIS_BUCKETS_H
+#define GALOIS_BUCKETS_H
+
+#include "galois/Bag.h"
+#include "galois/Loops.h"
+#include "galois/Reduction.h"
+
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace galois {
+
+/**
+ * Buckets of items ordered by key.
+ *
+ * Only a window of numOpen consecutive keys starting at the current bucket
+ * is materialized; items with larger keys are kept in a single overflow bag
+ * that is redistributed when the window is exhausted.
+ *
+ * Moving an item is lazy: the item is pushed again with its new key and the
+ * old entry stays behind. The current key of an item is obtained from the
+ * user's key function when a bucket is extracted, and entries whose key no
+ * longer matches are dropped then. Hence, an item must be pushed at most
+ * once per key, and keys may not be lowered below the current bucket.
+ *
+ * push() may be called concurrently; nextBucket() must be called serially.
+ *
+ * @tparam T type of item, e.g., a graph node
+ */
+template <typename T>
+class Buckets {
+public:
+  //! Key function value for items that should be dropped
+  constexpr static const size_t NULL_KEY = std::numeric_limits<size_t>::max();
+
+private:
+  using Entry = std::pair<T, size_t>;
+
+  std::vector<InsertBag<T>> open;
+  InsertBag<Entry> overflow;
+  size_t base;
+  size_t cur;
+
+public:
+  /**
+   * @param numOpen number of keys materialized at a time
+   */
+  explicit Buckets(size_t numOpen = 128)
+      : open(numOpen), base(0), cur(0) {
+    assert(numOpen > 0);
+  }
+
+  //! Key of the bucket returned by the last call to nextBucket()
+  size_t current() const { return cur; }
+
+  /**
+   * Adds item to the bucket for key. Thread safe.
+   */
+  void push(const T& item, size_t key) {
+    assert(key >= cur && key != NULL_KEY);
+    if (key < base + open.size()) {
+      open[key - base].push(item);
+    } else {
+      overflow.push(Entry(item, key));
+    }
+  }
+
+  /**
+   * Moves the items of the lowest nonempty bucket whose current key, as
+   * returned by keyFn, still equals the key of the bucket into out.
+   *
+   * @param keyFn returns the current key of an item or NULL_KEY
+   * @param out cleared and filled with the items of the bucket
+   * @returns false if all buckets are empty
+   */
+  template <typename KeyFn>
+  bool nextBucket(const KeyFn& keyFn, InsertBag<T>& out) {
+    out.clear();
+
+    while (true) {
+      for (; cur < base + open.size(); ++cur) {
+        InsertBag<T>& bucket = open[cur - base];
+        if (bucket.empty()) {
+          continue;
+        }
+
+        const size_t key = cur;
+        galois::do_all(galois::iterate(bucket),
+                       [&](const T& item) {
+                         if (keyFn(item) == key) {
+                           out.push(item);
+                         }
+                       },
+                       galois::steal(), galois::no_stats(),
+                       galois::loopname("BucketsExtract"));
+        bucket.clear();
+
+        if (!out.empty()) {
+          return true;
+        }
+      }
+
+      if (overflow.empty()) {
+        return false;
+      }
+
+      // window exhausted: restart it at the smallest key in overflow
+      galois::GReduceMin<size_t> minKey;
+      galois::do_all(galois::iterate(overflow),
+                     [&](const Entry& e) {
+                       if (keyFn(e.first) == e.second) {
+                         minKey.update(e.second);
+                       }
+                     },
+                     galois::no_stats(), galois::loopname("BucketsMinKey"));
+
+      const size_t next = minKey.reduce();
+      if (next == std::numeric_limits<size_t>::max()) {
+        overflow.clear();
+        return false;
+      }
+
+      InsertBag<Entry> old;
+      old.swap(overflow);
+      base = cur = next;
+      galois::do_all(galois::iterate(old),
+                     [&](const Entry& e) {
+                       if (keyFn(e.first) == e.second) {
+                         push(e.first, e.second);
+                       }
+                     },
+                     galois::steal(), galois::no_stats(),
+                     galois::loopname("BucketsRefill"));
+    }
+  }
+};
+
+} // namespace galois
+
+#endif
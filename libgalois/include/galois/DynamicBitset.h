@@ -38,12 +38,24 @@
 #include <assert.h>
 
 namespace galois {
+namespace internal {
+//! Number of bits set in the words [w, w + n); uses AVX-512 VPOPCNTDQ or
+//! AVX2 when the CPU supports them
+uint64_t popcountWords(const uint64_t* w, size_t n);
+
+//! Index of the first nonzero word in [begin, end) of w, or end if there is
+//! none; skips zero words a SIMD register at a time
+size_t findNonZeroWord(const uint64_t* w, size_t begin, size_t end);
+} // namespace internal
+
 /**
  * Concurrent dynamically allocated bitset
  **/
 class DynamicBitSet {
 protected:
-  galois::PODResizeableArray<galois::CopyableAtomic<uint64_t>> bitvec;
+  //! plain words so that the array stays trivially copyable (it is grown with
+  //! realloc); set(), reset() and test() access them with __atomic builtins
+  galois::PODResizeableArray<uint64_t> bitvec;
   size_t num_bits;
   static constexpr uint32_t bits_uint64 = sizeof(uint64_t) * CHAR_BIT;
 
@@ -54,8 +66,8 @@ public:
   /**
    * Returns the underlying bitset representation to the user
    *
-   * @returns constant reference vector of copyable atomics that represents
-   * the bitset
+   * @returns constant reference to the vector of words that represents the
+   * bitset
    */
   const auto& get_vec() const {
     return bitvec;
@@ -64,11 +76,21 @@ public:
   /**
    * Returns the underlying bitset representation to the user
    *
-   * @returns reference to vector of copyable atomics that represents the
-   * bitset
+   * @returns reference to the vector of words that represents the bitset
    */
   auto& get_vec() { return bitvec; }
 
+  /**
+   * Returns the words of the bitset as plain integers, for bulk reads in
+   * phases where no bit is being set or reset
+   *
+   * @returns pointer to the first of the (size() + 63) / 64 words
+   */
+  const uint64_t* words() const { return bitvec.data(); }
+
+  //! Number of 64-bit words in the bitset
+  size_t num_words() const { return bitvec.size(); }
+
   /**
    * Resizes the bitset.
    *
@@ -159,7 +181,7 @@ public:
         mask |= ~or_mask;
 
         size_t bit_index = begin / bits_uint64;
-        bitvec[bit_index] &= mask;
+        __atomic_fetch_and(&bitvec[bit_index], mask, __ATOMIC_SEQ_CST);
       }
     } else {
       if (begin < vec_begin) {
@@ -167,14 +189,14 @@ public:
         assert(diff < 64);
         uint64_t mask    = ((uint64_t)1 << (64 - diff)) - 1;
         size_t bit_index = begin / bits_uint64;
-        bitvec[bit_index] &= mask;
+        __atomic_fetch_and(&bitvec[bit_index], mask, __ATOMIC_SEQ_CST);
       }
       if (end >= vec_end) {
         size_t diff = end - vec_end + 1;
         assert(diff < 64);
         uint64_t mask    = ((uint64_t)1 << diff) - 1;
         size_t bit_index = end / bits_uint64;
-        bitvec[bit_index] &= ~mask;
+        __atomic_fetch_and(&bitvec[bit_index], ~mask, __ATOMIC_SEQ_CST);
       }
     }
   }
@@ -191,7 +213,8 @@ public:
     size_t bit_index    = index / bits_uint64;
     uint64_t bit_offset = 1;
     bit_offset <<= (index % bits_uint64);
-    return ((bitvec[bit_index].load(std::memory_order_relaxed) & bit_offset) != 0);
+    return ((__atomic_load_n(&bitvec[bit_index], __ATOMIC_RELAXED) &
+             bit_offset) != 0);
   }
 
   /**
@@ -204,12 +227,13 @@ public:
     size_t bit_index    = index / bits_uint64;
     uint64_t bit_offset = 1;
     bit_offset <<= (index % bits_uint64);
-    uint64_t old_val = bitvec[bit_index];
+    uint64_t old_val = __atomic_load_n(&bitvec[bit_index], __ATOMIC_RELAXED);
     // test and set
     // if old_bit is 0, then atomically set it
     while (((old_val & bit_offset) == 0) &&
-            !bitvec[bit_index].compare_exchange_weak(
-              old_val, old_val | bit_offset, std::memory_order_relaxed))
+           !__atomic_compare_exchange_n(&bitvec[bit_index], &old_val,
+                                        old_val | bit_offset, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
       ;
     return (old_val & bit_offset);
   }
@@ -224,12 +248,13 @@ public:
     size_t bit_index = index/bits_uint64;
     uint64_t bit_offset = 1;
     bit_offset <<= (index%bits_uint64);
-    uint64_t old_val = bitvec[bit_index];
+    uint64_t old_val = __atomic_load_n(&bitvec[bit_index], __ATOMIC_RELAXED);
     // test and reset
     // if old_bit is 1, then atomically reset it
     while (((old_val & bit_offset) != 0) &&
-            !bitvec[bit_index].compare_exchange_weak(
-              old_val, old_val & ~bit_offset, std::memory_order_relaxed))
+           !__atomic_compare_exchange_n(&bitvec[bit_index], &old_val,
+                                        old_val & ~bit_offset, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
       ;
     return (old_val & bit_offset);
   }
@@ -318,19 +343,16 @@ public:
    * @returns number of set bits in the bitset
    */
   uint64_t count() const {
+    // blocks of words so that the SIMD kernel has runs to work on
+    constexpr size_t BLOCK = 1024;
+    const uint64_t* w      = words();
+    const size_t n         = bitvec.size();
     galois::GAccumulator<uint64_t> ret;
-    galois::do_all(galois::iterate(bitvec.begin(), bitvec.end()),
-                   [&](uint64_t n) {
-  #ifdef __GNUC__
-                     ret += __builtin_popcountll(n);
-  #else
-                     n = n - ((n >> 1) & 0x5555555555555555UL);
-                     n = (n & 0x3333333333333333UL) +
-                         ((n >> 2) & 0x3333333333333333UL);
-                     ret += (((n + (n >> 4)) & 0xF0F0F0F0F0F0F0FUL) *
-                             0x101010101010101UL) >>
-                            56;
-  #endif
+    galois::do_all(galois::iterate(size_t{0}, (n + BLOCK - 1) / BLOCK),
+                   [&](size_t b) {
+                     size_t beg = b * BLOCK;
+                     ret += internal::popcountWords(w + beg,
+                                                    std::min(BLOCK, n - beg));
                    },
                    galois::no_stats());
     return ret.reduce();
@@ -0,0 +1,522 @@
+/*
+ * This file belongs to the Galois project, a C++ library for exploiting parallelism.
+ * The code is being released under the terms of the 3-Clause BSD License (a
+ * copy is located in LICENSE.txt at the top-level directory).
+ *
+ * Copyright (C) 2019, The University of Texas at Austin. All rights reserved.
+ * UNIVERSITY EXPRESSLY DISCLAIMS ANY AND ALL WARRANTIES CONCERNING THIS
+ * SOFTWARE AND DOCUMENTATION, INCLUDING ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR ANY PARTICULAR PURPOSE, NON-INFRINGEMENT AND WARRANTIES OF
+ * PERFORMANCE, AND ANY WARRANTY THAT MIGHT OTHERWISE ARISE FROM COURSE OF
+ * DEALING OR USAGE OF TRADE.  NO WARRANTY IS EITHER EXPRESS OR IMPLIED WITH
+ * RESPECT TO THE USE OF THE SOFTWARE OR DOCUMENTATION. Under no circumstances
+ * shall University be liable for incidental, special, indirect, direct or
+ * consequential damages or loss of profits, interruption of business, or
+ * related expenses which may arise from use of Software or Documentation,
+ * including but not limited to those resulting from defects in Software and/or
+ * Documentation, or loss or inaccuracy of data of any kind.
+ */
+
+/**
+ * @file galois/Frontier.h
+ *
+ * Frontier of active nodes for level-synchronous graph algorithms. Small
+ * frontiers are kept as a vector of node ids per thread, large ones as a
+ * bitset over all nodes, and the frontier switches between the two
+ * representations by its size (Beamer et al., SC'12; Ligra, PPoPP'13).
+ * for_each_frontier() runs a level-synchronous loop over such frontiers.
+ */
+
+#ifndef GALOIS_FRONTIER_H
+#define GALOIS_FRONTIER_H
+
+#include "galois/DynamicBitset.h"
+#include "galois/Loops.h"
+#include "galois/Reduction.h"
+#include "galois/Traits.h"
+#include "galois/runtime/Statistics.h"
+#include "galois/substrate/PerThreadStorage.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace galois {
+
+namespace internal {
+
+//! Options of a do_all whose work items hold up to itemNodes nodes. A
+//! chunk_size counts nodes, so it is converted to work items.
+struct PerItemArgs {
+  template <typename A>
+  static std::enable_if_t<!std::is_base_of<chunk_size_tag, A>::value, A>
+  convert(const A& a, size_t) {
+    return a;
+  }
+
+  template <typename A>
+  static std::enable_if_t<std::is_base_of<chunk_size_tag, A>::value,
+                          chunk_size<>>
+  convert(const A& a, size_t itemNodes) {
+    return chunk_size<>(std::max<size_t>(a.value / itemNodes, 1));
+  }
+
+  template <typename Tup, size_t... Is>
+  static auto get(const Tup& t, size_t itemNodes, std::index_sequence<Is...>) {
+    return std::make_tuple(convert(std::get<Is>(t), itemNodes)...);
+  }
+
+  template <typename... Args>
+  static auto get(const std::tuple<Args...>& t, size_t itemNodes) {
+    return get(t, itemNodes, std::index_sequence_for<Args...>());
+  }
+};
+
+} // namespace internal
+
+/**
+ * Set of active nodes in [0, numNodes).
+ *
+ * push() may be called concurrently in either representation. The sparse
+ * representation keeps every push, so a node pushed twice is visited twice
+ * unless the operator filters duplicates (e.g., by checking a distance);
+ * converting to the dense representation removes them. The bitset is only
+ * allocated the first time the frontier becomes dense.
+ *
+ * adapt() picks the representation for the next iteration: dense when more
+ * than numNodes / denseDivisor nodes are active, sparse otherwise. Nodes may
+ * not be pushed into a frontier while it is being iterated.
+ *
+ * @tparam T type of node ids
+ */
+template <typename T = uint32_t>
+class Frontier {
+  //! piece of one thread's sparse vector; unit of work of sparse loops
+  struct Run {
+    const T* begin;
+    const T* end;
+  };
+
+  constexpr static const size_t RUN_SIZE    = 1024; //!< nodes per run
+  constexpr static const size_t BLOCK_WORDS = 64;   //!< words per dense task
+
+  size_t numNodes;
+  size_t denseDivisor;
+  bool dense;
+  substrate::PerThreadStorage<std::vector<T>> sparse;
+  DynamicBitSet bits;
+
+  std::vector<Run> runs() const {
+    std::vector<Run> retval;
+    for (unsigned t = 0; t < sparse.size(); ++t) {
+      const std::vector<T>& local = *sparse.getRemote(t);
+      for (size_t i = 0; i < local.size(); i += RUN_SIZE)
+        retval.push_back(Run{local.data() + i,
+                             local.data() + std::min(i + RUN_SIZE,
+                                                     local.size())});
+    }
+    return retval;
+  }
+
+  size_t numBlocks() const {
+    return (bits.num_words() + BLOCK_WORDS - 1) / BLOCK_WORDS;
+  }
+
+  //! calls fn on the set bits of the words of dense task b
+  template <typename F>
+  void forEachInBlock(size_t b, const F& fn) const {
+    const uint64_t* w = bits.words();
+    size_t end        = std::min((b + 1) * BLOCK_WORDS, bits.num_words());
+    for (size_t i = internal::findNonZeroWord(w, b * BLOCK_WORDS, end);
+         i < end; i = internal::findNonZeroWord(w, i + 1, end)) {
+      for (uint64_t word = w[i]; word; word &= word - 1)
+        fn(static_cast<T>(i * 64 + __builtin_ctzll(word)));
+    }
+  }
+
+  void clearSparse() {
+    for (unsigned t = 0; t < sparse.size(); ++t)
+      sparse.getRemote(t)->clear();
+  }
+
+  void clearDense() {
+    auto& vec = bits.get_vec();
+    galois::do_all(galois::iterate(size_t{0}, vec.size()),
+                   [&](size_t i) { vec[i] = 0; }, galois::no_stats());
+  }
+
+  //! keeps the nodes with a bit set in keep
+  void filter(const DynamicBitSet& keep) {
+    if (dense) {
+      bits.bitwise_and(keep);
+      return;
+    }
+    galois::do_all(galois::iterate(0u, sparse.size()),
+                   [&](unsigned t) {
+                     std::vector<T>& local = *sparse.getRemote(t);
+                     local.erase(std::remove_if(local.begin(), local.end(),
+                                                [&](const T& n) {
+                                                  return !keep.test(n);
+                                                }),
+                                 local.end());
+                   },
+                   galois::no_stats());
+  }
+
+  //! sets the bits of the nodes of this frontier in out
+  void setBits(DynamicBitSet& out) const {
+    if (dense) {
+      out.bitwise_or(bits);
+      return;
+    }
+    auto rs = runs();
+    galois::do_all(galois::iterate(rs),
+                   [&](const Run& r) {
+                     for (const T* p = r.begin; p != r.end; ++p)
+                       out.set(*p);
+                   },
+                   galois::steal(), galois::no_stats());
+  }
+
+public:
+  /**
+   * @param n number of nodes; node ids are in [0, n)
+   * @param divisor the frontier is dense with more than n / divisor nodes
+   */
+  explicit Frontier(size_t n, size_t divisor = 20)
+      : numNodes(n), denseDivisor(std::max<size_t>(divisor, 1)),
+        dense(false) {}
+
+  //! Adds node n to the frontier
+  void push(T n) {
+    assert(n < numNodes);
+    if (dense)
+      bits.set(n);
+    else
+      sparse.getLocal()->push_back(n);
+  }
+
+  bool isDense() const { return dense; }
+
+  //! Number of nodes; counts duplicates in the sparse representation
+  size_t size() const {
+    if (dense)
+      return bits.count();
+    size_t retval = 0;
+    for (unsigned t = 0; t < sparse.size(); ++t)
+      retval += sparse.getRemote(t)->size();
+    return retval;
+  }
+
+  bool empty() const {
+    if (dense)
+      return internal::findNonZeroWord(bits.words(), 0, bits.num_words()) ==
+             bits.num_words();
+    for (unsigned t = 0; t < sparse.size(); ++t)
+      if (!sparse.getRemote(t)->empty())
+        return false;
+    return true;
+  }
+
+  //! Tests whether node n is in the frontier; dense representation only
+  bool test(T n) const {
+    assert(dense);
+    return bits.test(n);
+  }
+
+  //! Removes all nodes; the frontier becomes sparse
+  void clear() {
+    if (dense)
+      clearDense();
+    clearSparse();
+    dense = false;
+  }
+
+  //! Switches to the bitset representation
+  void toDense() {
+    if (dense)
+      return;
+    if (bits.size() != numNodes)
+      bits.resize(numNodes);
+    setBits(bits);
+    clearSparse();
+    dense = true;
+  }
+
+  //! Switches to the vector representation. Nodes are in increasing order
+  //! within each block of 64 words, but blocks are appended by whichever
+  //! thread runs them, so the vectors are not sorted
+  void toSparse() {
+    if (!dense)
+      return;
+    galois::do_all(galois::iterate(size_t{0}, numBlocks()),
+                   [&](size_t b) {
+                     std::vector<T>& local = *sparse.getLocal();
+                     forEachInBlock(b, [&](T n) { local.push_back(n); });
+                   },
+                   galois::steal(), galois::no_stats());
+    clearDense();
+    dense = false;
+  }
+
+  /**
+   * Picks the representation by the number of nodes.
+   *
+   * @returns the number of nodes afterwards, so that callers need not count
+   * the bits again; only a sparse frontier that becomes dense is recounted,
+   * since the conversion removes duplicates
+   */
+  size_t adapt() {
+    size_t retval  = size();
+    bool wantDense = retval > numNodes / denseDivisor;
+    if (wantDense && !dense) {
+      toDense();
+      retval = bits.count();
+    } else if (!wantDense) {
+      toSparse();
+    }
+    return retval;
+  }
+
+  //! Adds the nodes of other to this frontier
+  void unite(const Frontier& other) {
+    assert(numNodes == other.numNodes);
+    if (other.dense)
+      toDense();
+    if (dense) {
+      other.setBits(bits);
+      return;
+    }
+    auto rs = other.runs();
+    galois::do_all(galois::iterate(rs),
+                   [&](const Run& r) {
+                     std::vector<T>& local = *sparse.getLocal();
+                     local.insert(local.end(), r.begin, r.end);
+                   },
+                   galois::steal(), galois::no_stats());
+  }
+
+  //! Keeps only the nodes that are also in other
+  void intersect(const Frontier& other) {
+    assert(numNodes == other.numNodes);
+    if (other.dense) {
+      filter(other.bits);
+    } else {
+      DynamicBitSet keep;
+      keep.resize(numNodes);
+      other.setBits(keep);
+      filter(keep);
+    }
+  }
+
+  /**
+   * Applies fn to every node of the frontier in parallel, with the stealing
+   * do_all. In the dense representation, runs of empty words are skipped
+   * with SIMD tests and the nodes of a word are found with ctz.
+   *
+   * @param fn operator, called as fn(n)
+   * @param args further loop options, e.g., {@see loopname}; a {@see
+   * chunk_size} counts nodes and is divided by the nodes per work item
+   */
+  template <typename F, typename... Args>
+  void do_all(const F& fn, const Args&... args) const {
+    auto tpl = std::make_tuple(galois::steal(), args...);
+    if (dense) {
+      auto opts = internal::PerItemArgs::get(tpl, BLOCK_WORDS * 64);
+      runtime::do_all_gen(galois::iterate(size_t{0}, numBlocks())(opts),
+                          [&](size_t b) { forEachInBlock(b, fn); }, opts);
+    } else {
+      auto rs   = runs();
+      auto opts = internal::PerItemArgs::get(tpl, RUN_SIZE);
+      runtime::do_all_gen(galois::iterate(rs)(opts),
+                          [&](const Run& r) {
+                            for (const T* p = r.begin; p != r.end; ++p)
+                              fn(*p);
+                          },
+                          opts);
+    }
+  }
+};
+
+/**
+ * Handle passed to the operators of {@link for_each_frontier()}.
+ */
+template <typename T>
+class FrontierContext {
+  const Frontier<T>& curr;
+  Frontier<T>& next;
+  DynamicBitSet& seen;
+  unsigned rnd;
+
+public:
+  FrontierContext(const Frontier<T>& c, Frontier<T>& n, DynamicBitSet& s,
+                  unsigned r)
+      : curr(c), next(n), seen(s), rnd(r) {}
+
+  //! Adds node n to the next frontier; a node is added at most once a round
+  void push(T n) const {
+    if (next.isDense() || !seen.set(n))
+      next.push(n);
+  }
+
+  //! Tests whether node n is in the current frontier; pull rounds only
+  bool contains(T n) const { return curr.test(n); }
+
+  //! Number of rounds before this one; 0 while the initial nodes are active
+  unsigned round() const { return rnd; }
+};
+
+namespace internal {
+
+struct NoPullOp {
+  template <typename T, typename C>
+  bool operator()(T, const C&) const {
+    return false;
+  }
+};
+
+template <typename Tup,
+          bool HAS_PULL = exists_by_supertype<pull_op_tag, Tup>::value>
+struct PullOpOf {
+  static NoPullOp get(const Tup&) { return NoPullOp(); }
+};
+
+template <typename Tup>
+struct PullOpOf<Tup, true> {
+  static auto get(const Tup& t)
+      -> decltype(get_by_supertype<pull_op_tag>(t).value) {
+    return get_by_supertype<pull_op_tag>(t).value;
+  }
+};
+
+} // namespace internal
+
+/**
+ * Bulk-synchronous loop over the nodes of a graph. Each round applies the
+ * operator to the nodes of the current frontier, which push the nodes of the
+ * next one; the loop ends when a round activates no node. The two frontiers
+ * are owned by the loop and keep their memory across rounds, and a bitset
+ * removes duplicate pushes within a round. Every round is a do_all with
+ * {@link steal}. A {@link chunk_size} counts nodes in every round, whatever
+ * the representation of the frontier.
+ *
+ * With a {@link pull_op}, rounds whose frontier and its out-edges cover more
+ * than a twentieth of the edges run in the pull direction instead: the pull
+ * operator is called on every node and returns whether the node becomes
+ * active, using ctx.contains() to test nodes of the current frontier (Beamer
+ * et al., SC'12; Ligra, PPoPP'13).
+ *
+ * With a {@link loopname}, the number of rounds, pull rounds and dense rounds,
+ * the total and largest frontier size are reported under that name; with
+ * {@link more_stats}, so is the size of every round's frontier.
+ *
+ * @param graph graph whose nodes are ids in [0, graph.size()), e.g.,
+ * {@link galois::graphs::LC_CSR_Graph}
+ * @param rangeMaker initial frontier, typically returned by
+ * <code>galois::iterate(...)</code>
+ * @param fn push operator, called as <code>fn(n, ctx)</code> with a
+ * {@link FrontierContext}
+ * @param args optional arguments to loop, e.g., {@see loopname},
+ * {@see chunk_size}, {@see pull_op}
+ * @returns number of rounds
+ */
+template <typename Graph, typename RangeFunc, typename FunctionTy,
+          typename... Args>
+size_t for_each_frontier(Graph& graph, const RangeFunc& rangeMaker,
+                         const FunctionTy& fn, const Args&... args) {
+  using T   = typename Graph::GraphNode;
+  using Tup = std::tuple<Args...>;
+
+  constexpr static const bool HAS_PULL =
+      exists_by_supertype<pull_op_tag, Tup>::value;
+  constexpr static const bool NEED_STATS = internal::NeedStats<Tup>::value;
+  constexpr static const bool MORE_STATS =
+      NEED_STATS && exists_by_supertype<more_stats_tag, Tup>::value;
+  constexpr static const size_t PULL_DIVISOR = 20;
+
+  Tup tpl               = std::make_tuple(args...);
+  auto&& pullFn         = internal::PullOpOf<Tup>::get(tpl);
+  const char* loopname  = internal::getLoopName(tpl);
+  const size_t pullSize = graph.sizeEdges() / PULL_DIVISOR;
+
+  Frontier<T> a(graph.size()), b(graph.size());
+  Frontier<T>* curr = &a;
+  Frontier<T>* next = &b;
+  DynamicBitSet seen;
+  seen.resize(graph.size());
+
+  FrontierContext<T> seedCtx(*curr, *next, seen, 0);
+  galois::do_all(rangeMaker, [&](T n) { seedCtx.push(n); }, galois::no_stats());
+
+  size_t rounds = 0, pullRounds = 0, denseRounds = 0;
+  size_t activations = 0, maxFrontier = 0;
+
+  while (!next->empty()) {
+    // a sparse frontier was deduplicated with seen; clear its bits there
+    if (!next->isDense())
+      next->do_all([&](T n) { seen.reset(n); }, galois::no_stats());
+    size_t size = next->adapt();
+    std::swap(curr, next);
+    next->clear();
+
+    bool pull = false;
+    if (HAS_PULL) {
+      GAccumulator<size_t> edges;
+      curr->do_all(
+          [&](T n) {
+            edges += std::distance(
+                graph.edge_begin(n, MethodFlag::UNPROTECTED),
+                graph.edge_end(n, MethodFlag::UNPROTECTED));
+          },
+          galois::no_stats());
+      pull = size + edges.reduce() > pullSize;
+    }
+    if (curr->isDense())
+      ++denseRounds;
+
+    FrontierContext<T> ctx(*curr, *next, seen, rounds);
+    if (pull) {
+      curr->toDense();
+      next->toDense();
+      // the work items are single nodes here, so a chunk_size applies as is
+      galois::do_all(galois::iterate(graph),
+                     [&](T n) {
+                       if (pullFn(n, ctx))
+                         next->push(n);
+                     },
+                     galois::steal(), args...);
+      ++pullRounds;
+    } else {
+      curr->do_all([&](T n) { fn(n, ctx); }, args...);
+    }
+
+    if (MORE_STATS)
+      runtime::reportStat_Single(loopname,
+                                 "Round" + std::to_string(rounds) +
+                                     (pull ? "PullFrontier" : "PushFrontier"),
+                                 size);
+    activations += size;
+    maxFrontier = std::max(maxFrontier, size);
+    ++rounds;
+  }
+
+  if (NEED_STATS) {
+    runtime::reportStat_Single(loopname, "Rounds", rounds);
+    runtime::reportStat_Single(loopname, "PullRounds", pullRounds);
+    runtime::reportStat_Single(loopname, "DenseRounds", denseRounds);
+    runtime::reportStat_Single(loopname, "Activations", activations);
+    runtime::reportStat_Single(loopname, "MaxFrontier", maxFrontier);
+  }
+  return rounds;
+}
+
+} // namespace galois
+
+#endif
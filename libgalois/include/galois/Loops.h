@@ -59,6 +59,10 @@ void for_each(const RangeFunc& rangeMaker, FunctionTy &&fn,
  * Operator should conform to <code>fn(item)</code> where item is a value from
  * the iteration range.
  *
+ * A do_all may be called from within the operator of another parallel loop
+ * (e.g., to split the edge loop of a high-degree node); threads that run out
+ * of work in the enclosing loop steal chunks of the nested loop.
+ *
  * @param rangeMaker an iterate range maker typically returned by
  * <code>galois::iterate(...)</code>
  * (@see galois::iterate()). rangeMaker is a functor which when called returns a
@@ -27,6 +27,12 @@
 #include "galois/UserContext.h"
 #include "galois/worklists/Chunk.h"
 #include "galois/runtime/Range.h"
+#include "galois/Threads.h"
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <vector>
 
 namespace galois {
 //! Parallel versions of STL library algorithms.
@@ -288,6 +294,47 @@ T map_reduce(InputIterator first, InputIterator last, MapFn mapFn,
   return reducer.reduce();
 }
 
+/**
+ * Inclusive prefix sum of [first, last) written to out, which may be first.
+ * The range is split into blocks whose sums are computed in parallel; the
+ * block sums are scanned serially and the blocks are then scanned in parallel
+ * starting from their offsets.
+ */
+template <class RandomAccessIterator, class OutputIterator>
+OutputIterator partial_sum(RandomAccessIterator first,
+                           RandomAccessIterator last, OutputIterator out) {
+  using T = typename std::iterator_traits<RandomAccessIterator>::value_type;
+
+  const size_t n = std::distance(first, last);
+  const size_t numBlocks =
+      std::min<size_t>((n + 1023) / 1024, 8 * galois::getActiveThreads());
+  if (numBlocks <= 1)
+    return std::partial_sum(first, last, out);
+
+  auto blockBegin = [&](size_t b) { return n * b / numBlocks; };
+  std::vector<T> offsets(numBlocks + 1);
+  do_all(galois::iterate(size_t{0}, numBlocks),
+         [&](size_t b) {
+           T sum = T();
+           for (size_t i = blockBegin(b), e = blockBegin(b + 1); i < e; ++i)
+             sum += first[i];
+           offsets[b + 1] = sum;
+         },
+         galois::no_stats());
+  for (size_t b = 1; b < numBlocks; ++b)
+    offsets[b + 1] += offsets[b];
+  do_all(galois::iterate(size_t{0}, numBlocks),
+         [&](size_t b) {
+           T sum = offsets[b];
+           for (size_t i = blockBegin(b), e = blockBegin(b + 1); i < e; ++i) {
+             sum += first[i];
+             out[i] = sum;
+           }
+         },
+         galois::no_stats());
+  return out + n;
+}
+
 template <typename I>
 std::enable_if_t<!std::is_scalar<internal::Val_ty<I>>::value> destroy(I first,
                                                                       I last) {
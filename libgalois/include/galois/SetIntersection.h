@@ -0,0 +1,193 @@
+/*
+ * This file belongs to the Galois project, a C++ library for exploiting parallelism.
+ * The code is being released under the terms of the 3-Clause BSD License (a
+ * copy is located in LICENSE.txt at the top-level directory).
+ *
+ * Copyright (C) 2019, The University of Texas at Austin. All rights reserved.
+ * UNIVERSITY EXPRESSLY DISCLAIMS ANY AND ALL WARRANTIES CONCERNING THIS
+ * SOFTWARE AND DOCUMENTATION, INCLUDING ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR ANY PARTICULAR PURPOSE, NON-INFRINGEMENT AND WARRANTIES OF
+ * PERFORMANCE, AND ANY WARRANTY THAT MIGHT OTHERWISE ARISE FROM COURSE OF
+ * DEALING OR USAGE OF TRADE.  NO WARRANTY IS EITHER EXPRESS OR IMPLIED WITH
+ * RESPECT TO THE USE OF THE SOFTWARE OR DOCUMENTATION. Under no circumstances
+ * shall University be liable for incidental, special, indirect, direct or
+ * consequential damages or loss of profits, interruption of business, or
+ * related expenses which may arise from use of Software or Documentation,
+ * including but not limited to those resulting from defects in Software and/or
+ * Documentation, or loss or inaccuracy of data of any kind.
+ */
+
+/**
+ * @file galois/SetIntersection.h
+ *
+ * Kernels for intersecting sorted, duplicate-free lists of node ids (e.g.,
+ * the sorted adjacency lists used by triangle counting and k-truss).
+ *
+ * count() picks a kernel per pair of lists: galloping search when one list
+ * is much longer than the other, otherwise a block-compare merge using the
+ * widest SIMD instruction set (AVX-512 or AVX2) supported by the CPU at
+ * runtime, falling back to a scalar merge. HubBitmap covers the case where
+ * one high-degree list is intersected with many others.
+ */
+
+#ifndef GALOIS_SET_INTERSECTION_H
+#define GALOIS_SET_INTERSECTION_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace galois {
+namespace intersect {
+
+//! Intersection kernels
+enum Kernel { Auto, Merge, Gallop, SIMD };
+
+//! Use galloping when the longer list is this many times longer
+constexpr static const size_t GALLOP_RATIO = 32;
+
+//! Scalar merge
+size_t countMerge(const uint32_t* a, size_t na, const uint32_t* b, size_t nb);
+
+//! Searches each element of the shorter list in the longer one
+size_t countGallop(const uint32_t* a, size_t na, const uint32_t* b,
+                   size_t nb);
+
+//! Block-compare merge with the SIMD instruction set selected at runtime;
+//! scalar merge if the CPU supports neither AVX-512 nor AVX2
+size_t countSIMD(const uint32_t* a, size_t na, const uint32_t* b, size_t nb);
+
+//! Name of the instruction set used by countSIMD: "avx512", "avx2" or
+//! "scalar"
+const char* simdName();
+
+/**
+ * Returns the number of elements common to the sorted, duplicate-free lists
+ * [a, a + na) and [b, b + nb).
+ *
+ * @param k kernel to use; Auto selects one by the lengths of the lists
+ */
+inline size_t count(const uint32_t* a, size_t na, const uint32_t* b,
+                    size_t nb, Kernel k = Auto) {
+  switch (k) {
+  case Merge:
+    return countMerge(a, na, b, nb);
+  case Gallop:
+    return countGallop(a, na, b, nb);
+  case SIMD:
+    return countSIMD(a, na, b, nb);
+  default:
+    break;
+  }
+
+  if (!na || !nb) {
+    return 0;
+  }
+  if (na > nb * GALLOP_RATIO || nb > na * GALLOP_RATIO) {
+    return countGallop(a, na, b, nb);
+  }
+  return countSIMD(a, na, b, nb);
+}
+
+/**
+ * Calls f(i, j) for every a[i] == b[j] of the sorted, duplicate-free lists
+ * [a, a + na) and [b, b + nb), in increasing order. Stops early if f returns
+ * false.
+ *
+ * Unlike count, the matching positions are needed, so this uses a scalar
+ * merge, or a galloping search for skewed list lengths.
+ */
+template <typename F>
+void forEachMatch(const uint32_t* a, size_t na, const uint32_t* b, size_t nb,
+                  F f) {
+  size_t i = 0, j = 0;
+
+  if (na > nb * GALLOP_RATIO) {
+    for (; j < nb && i < na; ++j) {
+      i = std::lower_bound(a + i, a + na, b[j]) - a;
+      if (i < na && a[i] == b[j]) {
+        if (!f(i, j)) {
+          return;
+        }
+        ++i;
+      }
+    }
+    return;
+  }
+
+  if (nb > na * GALLOP_RATIO) {
+    for (; i < na && j < nb; ++i) {
+      j = std::lower_bound(b + j, b + nb, a[i]) - b;
+      if (j < nb && b[j] == a[i]) {
+        if (!f(i, j)) {
+          return;
+        }
+        ++j;
+      }
+    }
+    return;
+  }
+
+  while (i < na && j < nb) {
+    if (a[i] < b[j]) {
+      ++i;
+    } else if (b[j] < a[i]) {
+      ++j;
+    } else {
+      if (!f(i, j)) {
+        return;
+      }
+      ++i;
+      ++j;
+    }
+  }
+}
+
+/**
+ * Bitmap over node ids for intersecting one long (hub) list with many
+ * others: set() the hub list once, then each count() costs one lookup per
+ * element of the other list. reset() clears only the bits of the hub list,
+ * so a per-thread instance can be reused across hubs.
+ */
+class HubBitmap {
+  std::vector<uint64_t> bits;
+
+public:
+  HubBitmap() = default;
+  explicit HubBitmap(size_t universe) { resize(universe); }
+
+  //! Allow ids in [0, universe)
+  void resize(size_t universe) { bits.assign((universe + 63) / 64, 0); }
+
+  size_t universe() const { return bits.size() * 64; }
+
+  void set(const uint32_t* a, size_t na) {
+    for (size_t i = 0; i < na; ++i) {
+      assert(a[i] < universe());
+      bits[a[i] / 64] |= uint64_t(1) << (a[i] % 64);
+    }
+  }
+
+  void reset(const uint32_t* a, size_t na) {
+    for (size_t i = 0; i < na; ++i) {
+      bits[a[i] / 64] = 0;
+    }
+  }
+
+  bool test(uint32_t x) const { return (bits[x / 64] >> (x % 64)) & 1; }
+
+  size_t count(const uint32_t* b, size_t nb) const {
+    size_t retval = 0;
+    for (size_t j = 0; j < nb; ++j) {
+      retval += test(b[j]);
+    }
+    return retval;
+  }
+};
+
+} // namespace intersect
+} // namespace galois
+
+#endif
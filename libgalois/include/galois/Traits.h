@@ -308,6 +308,21 @@ struct local_state_tag {};
 template <typename T>
 struct local_state : public trait_has_type<T>, local_state_tag {};
 
+/**
+ * Indicates the operator of a {@link for_each_frontier()} loop has a pull
+ * counterpart, which lets rounds with many active nodes run in the pull
+ * direction.
+ *
+ * The function should have the signature <code>bool (n, ctx)</code>; it is
+ * called on every node n of the graph and returns true if n becomes active.
+ */
+struct pull_op_tag {};
+template <typename T>
+struct pull_op : public trait_has_value<T>, pull_op_tag {
+  pull_op(const T& t = T()) : trait_has_value<T>(t) {}
+  pull_op(T&& t) : trait_has_value<T>(std::move(t)) {}
+};
+
 // TODO: separate to libdist
 /** For distributed Galois **/
 struct op_tag {};
@@ -30,6 +30,7 @@
 
 #include <boost/mpl/if.hpp>
 #include <algorithm>
+#include <new>
 
 namespace galois {
 namespace graphs {
@@ -259,6 +260,13 @@ public:
   NodeInfoBase(Args&&... args) : data(std::forward<Args>(args)...) {}
 
   typename NodeInfoBase::reference getData() { return data; }
+
+  //! Replaces the data in place, keeping the lock
+  template <typename... Args>
+  void reconstructData(Args&&... args) {
+    data.~NodeTy();
+    new (&data) NodeTy(std::forward<Args>(args)...);
+  }
   /*
    * To support boost serialization
    * IMPORTANT: This is temp fix for benchmarks using non-trivial structures in
@@ -282,6 +290,8 @@ struct NodeInfoBase<void, HasLockable>
                               NoLockable>::type,
       public NodeInfoBaseTypes<void, HasLockable> {
   typename NodeInfoBase::reference getData() { return 0; }
+
+  void reconstructData() {}
 };
 
 template <bool Enable>
@@ -21,6 +21,7 @@
 #define GALOIS_GRAPH__LC_CSR_GRAPH_H
 
 #include "galois/Galois.h"
+#include "galois/ParallelSTL.h"
 #include "galois/graphs/Details.h"
 #include "galois/graphs/FileGraph.h"
 #include "galois/graphs/GraphHelpers.h"
@@ -348,7 +349,7 @@ public:
       edgeDst.allocateBlocked(numEdges);
       edgeData.allocateBlocked(numEdges);
       //! [numaallocex]
-      this->outOfLineAllocateBlocked(numNodes, false);
+      this->outOfLineAllocateBlocked(numNodes);
     } else {
       nodeData.allocateInterleaved(numNodes);
       edgeIndData.allocateInterleaved(numNodes);
@@ -407,6 +408,23 @@ public:
 
   GraphNode getEdgeDst(edge_iterator ni) { return edgeDst[*ni]; }
 
+  /**
+   * Returns a pointer to the destination of edge ni. The destinations of the
+   * edges of a node are contiguous, so [getEdgeDstPtr(edge_begin(N)),
+   * getEdgeDstPtr(edge_end(N))) is the adjacency list of N as an array.
+   */
+  const GraphNode* getEdgeDstPtr(edge_iterator ni) const {
+    return edgeDst.data() + *ni;
+  }
+
+  /**
+   * Returns a pointer to the data of edge ni. Like getEdgeDstPtr, the data of
+   * the edges of a node are contiguous.
+   */
+  const edge_data_type* getEdgeDataPtr(edge_iterator ni) const {
+    return edgeData.data() + *ni;
+  }
+
   size_t size() const { return numNodes; }
   size_t sizeEdges() const { return numEdges; }
 
@@ -700,6 +718,101 @@ public:
     timer.stop();
   }
 
+  /**
+   * Relabels the nodes in place: node n becomes node newId[n]. Node data
+   * moves with its node, and the edges of every node are sorted by (new)
+   * destination afterwards. Node data must be move constructible. Does not
+   * change the local ranges used by local_begin()/local_end().
+   *
+   * @param newId permutation of [0, size()), e.g. from one of the orders in
+   * galois/graphs/Reorder.h
+   * @param regionName region to report the timer in
+   */
+  template <typename PermutationTy>
+  void permute(const PermutationTy& newId, const char* regionName = NULL) {
+    galois::StatTimer timer("TIMER_GRAPH_PERMUTE", regionName);
+    timer.start();
+
+    LargeArray<uint32_t> oldId;
+    EdgeIndData edgeIndData_new;
+    EdgeDst edgeDst_new;
+    EdgeData edgeData_new;
+    NodeData nodeData_new;
+
+    if (UseNumaAlloc) {
+      oldId.allocateBlocked(numNodes);
+      edgeIndData_new.allocateBlocked(numNodes);
+      edgeDst_new.allocateBlocked(numEdges);
+      edgeData_new.allocateBlocked(numEdges);
+      nodeData_new.allocateBlocked(numNodes);
+    } else {
+      oldId.allocateInterleaved(numNodes);
+      edgeIndData_new.allocateInterleaved(numNodes);
+      edgeDst_new.allocateInterleaved(numEdges);
+      edgeData_new.allocateInterleaved(numEdges);
+      nodeData_new.allocateInterleaved(numNodes);
+    }
+
+    galois::do_all(galois::iterate(UINT64_C(0), numNodes),
+                   [&](uint64_t n) {
+                     assert(newId[n] < numNodes);
+                     oldId[newId[n]] = n;
+                   },
+                   galois::no_stats(), galois::loopname("PERMUTE_INVERT"));
+
+    // degrees in the new order, turned into the new edge index
+    galois::do_all(galois::iterate(UINT64_C(0), numNodes),
+                   [&](uint64_t n) {
+                     edgeIndData_new[n] =
+                         *raw_end(oldId[n]) - *raw_begin(oldId[n]);
+                   },
+                   galois::no_stats(), galois::loopname("PERMUTE_DEGREES"));
+    galois::ParallelSTL::partial_sum(edgeIndData_new.begin(),
+                                     edgeIndData_new.end(),
+                                     edgeIndData_new.begin());
+
+    galois::do_all(
+        galois::iterate(UINT64_C(0), numNodes),
+        [&](uint64_t n) {
+          uint64_t e_new = (n == 0) ? 0 : edgeIndData_new[n - 1];
+          for (auto e = *raw_begin(oldId[n]), ee = *raw_end(oldId[n]); e != ee;
+               ++e, ++e_new) {
+            edgeDst_new[e_new] = newId[edgeDst[e]];
+            edgeDataCopy(edgeData_new, edgeData, e_new, e);
+          }
+          nodeDataMove(nodeData_new, nodeData, n, oldId[n]);
+        },
+        galois::steal(), galois::no_stats(), galois::loopname("PERMUTE_EDGES"));
+
+    // the old arrays are freed by the destructors of the *_new arrays
+    swap(nodeData, nodeData_new);
+    swap(edgeIndData, edgeIndData_new);
+    swap(edgeDst, edgeDst_new);
+    if (EdgeData::has_value)
+      swap(edgeData, edgeData_new);
+
+    galois::do_all(
+        galois::iterate(UINT64_C(0), numNodes),
+        [&](uint64_t n) { sortEdgesByDst(n, MethodFlag::UNPROTECTED); },
+        galois::steal(), galois::no_stats(), galois::loopname("PERMUTE_SORT"));
+
+    timer.stop();
+  }
+
+  template <bool is_non_void = !std::is_void<NodeTy>::value>
+  void nodeDataMove(NodeData& nodeData_new, NodeData& nodeData, uint64_t n_new,
+                    uint64_t n,
+                    typename std::enable_if<is_non_void>::type* = 0) {
+    nodeData_new.constructAt(n_new, std::move(nodeData[n].getData()));
+  }
+
+  template <bool is_non_void = !std::is_void<NodeTy>::value>
+  void nodeDataMove(NodeData& nodeData_new, NodeData& nodeData, uint64_t n_new,
+                    uint64_t n,
+                    typename std::enable_if<!is_non_void>::type* = 0) {
+    nodeData_new.constructAt(n_new);
+  }
+
   template <bool is_non_void = EdgeData::has_value>
   void edgeDataCopy(EdgeData& edgeData_new, EdgeData& edgeData, uint64_t e_new,
                     uint64_t e,
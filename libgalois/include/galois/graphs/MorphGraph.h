@@ -509,6 +509,10 @@ private:///////////////////////////////////////////////////////////////////////
 
   internal::EdgeFactory<EdgeTy, Directional && !InOut> edgesF;
 
+  //! recycled nodes, by the thread that recycled them, for createNode() to
+  //! reuse
+  substrate::PerThreadStorage<gstl::Vector<gNode*>> freeNodes;
+
   // Helpers for iterator classes
   struct is_node : public std::unary_function<gNode&, bool> {
     bool operator()(const gNode& g) const { return g.active; }
@@ -721,11 +725,25 @@ public://///////////////////////////////////////////////////////////////////////
    * Creates a new node holding the indicated data. Usually you should call
    * {@link addNode()} afterwards.
    *
+   * A node taken from the free list of {@link recycleNode()} is locked, which
+   * may signal a conflict, so inside a conflict-detecting loop the operator
+   * must create its nodes before it modifies the graph.
+   *
    * @param[in] args constructor arguments for node data
    * @returns newly created graph node
    */
   template <typename... Args>
   GraphNode createNode(Args&&... args) {
+    gstl::Vector<gNode*>& freeList = *freeNodes.getLocal();
+    if (!freeList.empty()) {
+      gNode* N = freeList.back();
+      // stale handles to a recycled node may still be checked with
+      // containsNode(), so the node is locked before it is reused
+      N->acquire(MethodFlag::WRITE);
+      freeList.pop_back();
+      N->reconstructData(std::forward<Args>(args)...);
+      return GraphNode(N);
+    }
     gNode* N  = &(nodes.emplace(std::forward<Args>(args)...));
     N->active = false;
     return GraphNode(N);
@@ -776,6 +794,38 @@ public://///////////////////////////////////////////////////////////////////////
     }
   }
 
+  /**
+   * Removes a node from the graph like {@link removeNode()} and hands its
+   * storage to a later createNode() on this thread, which then does not
+   * allocate. The edges of the node and the edges pointing to it are
+   * erased; the node keeps the capacity of its edge list.
+   *
+   * The caller must not use n afterwards, except for stale handles that are
+   * only checked with containsNode() (or another locking call) first: they
+   * may see a new node. Directed graphs without in-edges cannot find the
+   * edges pointing to n, so the caller must remove them first.
+   */
+  void recycleNode(GraphNode n, galois::MethodFlag mflag = MethodFlag::WRITE) {
+    assert(n);
+    n->acquire(mflag);
+    gNode* N = n;
+    if (!N->active)
+      return;
+    if (!Directional || InOut) {
+      for (auto& e : N->edges) {
+        gNode* dst = e.first();
+        if (dst == N || !dst->active)
+          continue;
+        dst->acquire(mflag);
+        // the reverse of an in-edge is an out-edge and vice versa
+        dst->erase(N, Directional ? !e.isInEdge() : false);
+      }
+    }
+    N->active = false;
+    N->edges.clear();
+    freeNodes.getLocal()->push_back(N);
+  }
+
   /**
    * Resize the edges of the node. For best performance, should be done
    * serially.
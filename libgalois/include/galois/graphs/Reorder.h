@@ -0,0 +1,430 @@
+/*
+ * This file belongs to the Galois project, a C++ library for exploiting parallelism.
+ * The code is being released under the terms of the 3-Clause BSD License (a
+ * copy is located in LICENSE.txt at the top-level directory).
+ *
+ * Copyright (C) 2019, The University of Texas at Austin. All rights reserved.
+ * UNIVERSITY EXPRESSLY DISCLAIMS ANY AND ALL WARRANTIES CONCERNING THIS
+ * SOFTWARE AND DOCUMENTATION, INCLUDING ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR ANY PARTICULAR PURPOSE, NON-INFRINGEMENT AND WARRANTIES OF
+ * PERFORMANCE, AND ANY WARRANTY THAT MIGHT OTHERWISE ARISE FROM COURSE OF
+ * DEALING OR USAGE OF TRADE.  NO WARRANTY IS EITHER EXPRESS OR IMPLIED WITH
+ * RESPECT TO THE USE OF THE SOFTWARE OR DOCUMENTATION. Under no circumstances
+ * shall University be liable for incidental, special, indirect, direct or
+ * consequential damages or loss of profits, interruption of business, or
+ * related expenses which may arise from use of Software or Documentation,
+ * including but not limited to those resulting from defects in Software and/or
+ * Documentation, or loss or inaccuracy of data of any kind.
+ */
+
+/**
+ * @file Reorder.h
+ *
+ * Parallel locality-improving node orders for CSR graphs. Each order is
+ * returned as a permutation newId (node n becomes node newId[n]), which
+ * LC_CSR_Graph::permute applies in place; reorder() does both and keeps the
+ * mapping back to the original ids for output.
+ *
+ * All orders only look at out-edges, so they are meant for symmetric graphs
+ * or for graphs whose out-edges are the ones traversed.
+ */
+
+#ifndef GALOIS_GRAPHS_REORDER_H
+#define GALOIS_GRAPHS_REORDER_H
+
+#include "galois/AtomicHelpers.h"
+#include "galois/Bag.h"
+#include "galois/Galois.h"
+#include "galois/ParallelSTL.h"
+#include "galois/Reduction.h"
+#include "galois/Timer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace galois {
+namespace graphs {
+
+enum class ReorderAlgo {
+  DEGREE, //!< decreasing degree
+  HUB,    //!< high-degree nodes first, otherwise original order
+  RCM,    //!< reverse Cuthill-McKee
+  GORDER  //!< windowed Gorder, greedily within partitions
+};
+
+//! Permutation applied to a graph and its inverse
+struct NodeRelabeling {
+  std::vector<uint32_t> newId; //!< id after reordering of an original node
+  std::vector<uint32_t> oldId; //!< original id of a reordered node
+};
+
+namespace internal {
+
+template <typename GraphTy>
+std::vector<uint32_t> outDegrees(GraphTy& graph) {
+  std::vector<uint32_t> degree(graph.size());
+  galois::do_all(galois::iterate(graph),
+                 [&](typename GraphTy::GraphNode n) {
+                   degree[n] = std::distance(
+                       graph.edge_begin(n, MethodFlag::UNPROTECTED),
+                       graph.edge_end(n, MethodFlag::UNPROTECTED));
+                 },
+                 galois::no_stats(), galois::loopname("ReorderDegrees"));
+  return degree;
+}
+
+//! newId of the nodes listed in order
+inline std::vector<uint32_t> positionsOf(const std::vector<uint32_t>& order) {
+  std::vector<uint32_t> newId(order.size());
+  galois::do_all(galois::iterate(size_t{0}, order.size()),
+                 [&](size_t i) { newId[order[i]] = i; }, galois::no_stats());
+  return newId;
+}
+
+} // namespace internal
+
+//! Returns the inverse of the permutation newId
+inline std::vector<uint32_t>
+invertPermutation(const std::vector<uint32_t>& newId) {
+  return internal::positionsOf(newId);
+}
+
+/**
+ * Orders the nodes by decreasing degree (ties by id), which packs the
+ * frequently accessed high-degree nodes together.
+ */
+template <typename GraphTy>
+std::vector<uint32_t> degreeSortOrder(GraphTy& graph) {
+  std::vector<uint32_t> degree = internal::outDegrees(graph);
+  std::vector<uint32_t> order(graph.size());
+  galois::do_all(galois::iterate(size_t{0}, order.size()),
+                 [&](size_t i) { order[i] = i; }, galois::no_stats());
+  galois::ParallelSTL::sort(order.begin(), order.end(),
+                            [&](uint32_t a, uint32_t b) {
+                              return degree[a] > degree[b] ||
+                                     (degree[a] == degree[b] && a < b);
+                            });
+  return internal::positionsOf(order);
+}
+
+/**
+ * Hub clustering (Balaji and Lucia, IISWC'18): moves the nodes of more than
+ * average degree to the front and keeps the relative order of the nodes
+ * within both groups, which preserves whatever locality the input order had.
+ */
+template <typename GraphTy>
+std::vector<uint32_t> hubClusterOrder(GraphTy& graph) {
+  const size_t numNodes = graph.size();
+  std::vector<uint32_t> degree = internal::outDegrees(graph);
+  const double average = numNodes ? double(graph.sizeEdges()) / numNodes : 0;
+
+  // hubs[n] is the number of hubs among the nodes up to n
+  std::vector<uint32_t> hubs(numNodes);
+  galois::do_all(galois::iterate(size_t{0}, numNodes),
+                 [&](size_t n) { hubs[n] = degree[n] > average; },
+                 galois::no_stats());
+  galois::ParallelSTL::partial_sum(hubs.begin(), hubs.end(), hubs.begin());
+  const uint32_t numHubs = numNodes ? hubs.back() : 0;
+
+  std::vector<uint32_t> newId(numNodes);
+  galois::do_all(galois::iterate(size_t{0}, numNodes),
+                 [&](size_t n) {
+                   newId[n] = degree[n] > average ? hubs[n] - 1
+                                                  : numHubs + n - hubs[n];
+                 },
+                 galois::no_stats());
+  return newId;
+}
+
+/**
+ * Reverse Cuthill-McKee order, computed level by level in parallel as in
+ * Karantasis et al., SC'14: every node of the next BFS level is assigned to
+ * its earliest numbered parent, and the level is sorted by (parent, degree),
+ * which gives the same order as the serial algorithm. Each connected
+ * component starts from a pseudo-peripheral node, found by one BFS from the
+ * unvisited node of least degree.
+ */
+template <typename GraphTy>
+std::vector<uint32_t> rcmOrder(GraphTy& graph) {
+  constexpr uint32_t INF = std::numeric_limits<uint32_t>::max();
+  // levels smaller than this are expanded serially
+  constexpr size_t SERIAL_LEVEL = 1024;
+  const size_t numNodes = graph.size();
+
+  std::vector<uint32_t> degree = internal::outDegrees(graph);
+  std::vector<uint32_t> byDegree(numNodes);
+  galois::do_all(galois::iterate(size_t{0}, numNodes),
+                 [&](size_t i) { byDegree[i] = i; }, galois::no_stats());
+  galois::ParallelSTL::sort(byDegree.begin(), byDegree.end(),
+                            [&](uint32_t a, uint32_t b) {
+                              return degree[a] < degree[b] ||
+                                     (degree[a] == degree[b] && a < b);
+                            });
+
+  // CM position of the earliest parent; INF while unvisited
+  std::vector<std::atomic<uint32_t>> parent(numNodes);
+  // sweep that last reached a node, for the pseudo-peripheral search
+  std::vector<std::atomic<uint32_t>> sweep(numNodes);
+  galois::do_all(galois::iterate(size_t{0}, numNodes),
+                 [&](size_t n) {
+                   parent[n].store(INF, std::memory_order_relaxed);
+                   sweep[n].store(INF, std::memory_order_relaxed);
+                 },
+                 galois::no_stats());
+
+  std::vector<uint32_t> order; // Cuthill-McKee order
+  order.reserve(numNodes);
+  std::vector<uint32_t> position(numNodes); // position of a node in order
+
+  // calls visit(v) for each neighbor v of the nodes in curr; a do_all for
+  // large levels. next gets the nodes for which visit returns true.
+  auto expand = [&](const std::vector<uint32_t>& curr,
+                    std::vector<uint32_t>& next, const auto& visit) {
+    next.clear();
+    auto edges = [&](uint32_t u, const auto& push) {
+      for (auto e : graph.edges(u, MethodFlag::UNPROTECTED)) {
+        uint32_t v = graph.getEdgeDst(e);
+        if (visit(u, v))
+          push(v);
+      }
+    };
+    if (curr.size() < SERIAL_LEVEL) {
+      for (uint32_t u : curr)
+        edges(u, [&](uint32_t v) { next.push_back(v); });
+    } else {
+      galois::InsertBag<uint32_t> bag;
+      galois::do_all(galois::iterate(curr),
+                     [&](uint32_t u) {
+                       edges(u, [&](uint32_t v) { bag.push(v); });
+                     },
+                     galois::steal(), galois::no_stats(),
+                     galois::loopname("RCMExpand"));
+      next.assign(bag.begin(), bag.end());
+    }
+  };
+
+  std::vector<uint32_t> curr, next;
+  uint32_t numSweeps = 0;
+
+  for (uint32_t start : byDegree) {
+    if (parent[start].load(std::memory_order_relaxed) != INF)
+      continue;
+
+    // pseudo-peripheral root: the node of least degree in the last level of
+    // a BFS from start
+    uint32_t root = start;
+    if (degree[start]) {
+      const uint32_t s = numSweeps++;
+      sweep[start]     = s;
+      curr.assign(1, start);
+      while (true) {
+        expand(curr, next, [&](uint32_t, uint32_t v) {
+          if (parent[v].load(std::memory_order_relaxed) != INF)
+            return false;
+          uint32_t old = sweep[v].load(std::memory_order_relaxed);
+          return old != s && sweep[v].compare_exchange_strong(old, s);
+        });
+        if (next.empty())
+          break;
+        std::swap(curr, next);
+      }
+      root = *std::min_element(curr.begin(), curr.end(),
+                               [&](uint32_t a, uint32_t b) {
+                                 return degree[a] < degree[b] ||
+                                        (degree[a] == degree[b] && a < b);
+                               });
+    }
+
+    position[root] = order.size();
+    parent[root]   = 0;
+    order.push_back(root);
+    curr.assign(1, root);
+    while (true) {
+      expand(curr, next, [&](uint32_t u, uint32_t v) {
+        return galois::atomicMin(parent[v], position[u]) == INF;
+      });
+      if (next.empty())
+        break;
+      galois::ParallelSTL::sort(next.begin(), next.end(),
+                                [&](uint32_t a, uint32_t b) {
+                                  uint32_t pa = parent[a], pb = parent[b];
+                                  return pa < pb ||
+                                         (pa == pb &&
+                                          (degree[a] < degree[b] ||
+                                           (degree[a] == degree[b] && a < b)));
+                                });
+      const size_t base = order.size();
+      order.insert(order.end(), next.begin(), next.end());
+      auto place = [&](size_t i) { position[next[i]] = base + i; };
+      if (next.size() < SERIAL_LEVEL) {
+        for (size_t i = 0; i < next.size(); ++i)
+          place(i);
+      } else {
+        galois::do_all(galois::iterate(size_t{0}, next.size()), place,
+                       galois::no_stats());
+      }
+      std::swap(curr, next);
+    }
+  }
+
+  std::reverse(order.begin(), order.end());
+  return internal::positionsOf(order);
+}
+
+/**
+ * Gorder (Wei et al., SIGMOD'16): greedily appends the node with the largest
+ * score, the number of edges and common neighbors it has with the last
+ * window nodes placed, so that nodes accessed together are stored together.
+ * The greedy pass is serial by nature, so the nodes are cut into partitions
+ * of consecutive ids which are ordered independently and in parallel; ids
+ * never move across partitions. Common neighbors through nodes of degree
+ * above sqrt(n) are not counted, as in the paper.
+ *
+ * @param window number of recently placed nodes that score candidates
+ * @param partitionSize number of nodes ordered by one greedy pass
+ */
+template <typename GraphTy>
+std::vector<uint32_t> gorderOrder(GraphTy& graph, unsigned window = 5,
+                                  size_t partitionSize = 1 << 16) {
+  const size_t numNodes = graph.size();
+  std::vector<uint32_t> degree = internal::outDegrees(graph);
+  const uint32_t hubDegree = std::sqrt(double(numNodes));
+  partitionSize            = std::max<size_t>(partitionSize, 1);
+  const size_t numParts    = (numNodes + partitionSize - 1) / partitionSize;
+
+  std::vector<uint32_t> newId(numNodes);
+
+  galois::do_all(
+      galois::iterate(size_t{0}, numParts),
+      [&](size_t part) {
+        const uint32_t begin = part * partitionSize;
+        const uint32_t end   = std::min(numNodes, begin + partitionSize);
+        const uint32_t size  = end - begin;
+
+        // unplaced nodes of nonzero score are kept in one list per score
+        // (the unit heap of the paper), so that updates take constant time
+        constexpr uint32_t NIL = std::numeric_limits<uint32_t>::max();
+        std::vector<uint32_t> score(size, 0);
+        std::vector<uint32_t> prev(size), next(size);
+        std::vector<uint32_t> head(1, NIL);
+        std::vector<bool> placed(size, false);
+        uint32_t maxScore = 0;
+
+        auto unlink = [&](uint32_t i) {
+          if (!score[i])
+            return;
+          if (prev[i] != NIL)
+            next[prev[i]] = next[i];
+          else
+            head[score[i]] = next[i];
+          if (next[i] != NIL)
+            prev[next[i]] = prev[i];
+        };
+        auto link = [&](uint32_t i) {
+          uint32_t k = score[i];
+          if (!k)
+            return;
+          if (head.size() <= k)
+            head.resize(k + 1, NIL);
+          prev[i] = NIL;
+          next[i] = head[k];
+          if (next[i] != NIL)
+            prev[next[i]] = i;
+          head[k]  = i;
+          maxScore = std::max(maxScore, k);
+        };
+        auto bump = [&](uint32_t u, int delta) {
+          if (u < begin || u >= end || placed[u - begin])
+            return;
+          unlink(u - begin);
+          score[u - begin] += delta;
+          link(u - begin);
+        };
+        // adds delta to the scores of the neighbors and siblings of v
+        auto update = [&](uint32_t v, int delta) {
+          for (auto e : graph.edges(v, MethodFlag::UNPROTECTED)) {
+            uint32_t x = graph.getEdgeDst(e);
+            bump(x, delta);
+            if (degree[x] > hubDegree)
+              continue;
+            for (auto f : graph.edges(x, MethodFlag::UNPROTECTED)) {
+              uint32_t u = graph.getEdgeDst(f);
+              if (u != v)
+                bump(u, delta);
+            }
+          }
+        };
+
+        std::vector<uint32_t> order;
+        order.reserve(size);
+        uint32_t cursor = 0; // next node in input order
+        while (order.size() < size) {
+          while (maxScore && head[maxScore] == NIL)
+            --maxScore;
+          uint32_t i;
+          if (maxScore) {
+            i = head[maxScore];
+          } else {
+            while (placed[cursor])
+              ++cursor;
+            i = cursor;
+          }
+
+          unlink(i);
+          placed[i]        = true;
+          newId[begin + i] = begin + order.size();
+          order.push_back(begin + i);
+          update(begin + i, 1);
+          if (order.size() > window)
+            update(order[order.size() - 1 - window], -1);
+        }
+      },
+      galois::steal(), galois::chunk_size<1>(), galois::no_stats(),
+      galois::loopname("Gorder"));
+
+  return newId;
+}
+
+/**
+ * Computes the given order, applies it to graph in place with
+ * LC_CSR_Graph::permute and returns the relabeling, whose oldId maps the
+ * nodes of the reordered graph back to the original ids for output.
+ */
+template <typename GraphTy>
+NodeRelabeling reorder(GraphTy& graph, ReorderAlgo algo) {
+  galois::StatTimer timer("TIMER_GRAPH_REORDER");
+  timer.start();
+
+  NodeRelabeling retval;
+  switch (algo) {
+  case ReorderAlgo::DEGREE:
+    retval.newId = degreeSortOrder(graph);
+    break;
+  case ReorderAlgo::HUB:
+    retval.newId = hubClusterOrder(graph);
+    break;
+  case ReorderAlgo::RCM:
+    retval.newId = rcmOrder(graph);
+    break;
+  case ReorderAlgo::GORDER:
+    retval.newId = gorderOrder(graph);
+    break;
+  default:
+    GALOIS_DIE("unknown reordering algorithm");
+  }
+  graph.permute(retval.newId);
+  retval.oldId = invertPermutation(retval.newId);
+
+  timer.stop();
+  return retval;
+}
+
+} // namespace graphs
+} // namespace galois
+
+#endif
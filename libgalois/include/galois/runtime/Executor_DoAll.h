@@ -23,6 +23,7 @@
 #include "galois/gIO.h"
 #include "galois/Timer.h"
 
+#include "galois/runtime/Context.h"
 #include "galois/runtime/Executor_OnEach.h"
 #include "galois/runtime/OperatorReferenceTypes.h"
 #include "galois/runtime/Statistics.h"
@@ -256,6 +257,35 @@ private:
     return succ;
   }
 
+  GALOIS_ATTRIBUTE_NOINLINE bool stealWithinL3(ThreadContext& poor) {
+
+    bool sawWork   = false;
+    bool stoleWork = false;
+
+    auto& tp = substrate::getThreadPool();
+
+    const unsigned maxT   = galois::getActiveThreads();
+    const unsigned my_dom = substrate::ThreadPool::getL3Domain();
+
+    for (unsigned i = 1; i < maxT; ++i) {
+
+      // go around the active threads starting from the next thread
+      unsigned t = (poor.id + i) % maxT;
+
+      if (tp.getL3Domain(t) == my_dom && workers.getRemote(t)->hasWorkWeak()) {
+        sawWork = true;
+
+        stoleWork = transferWork(*workers.getRemote(t), poor, HALF);
+
+        if (stoleWork) {
+          break;
+        }
+      }
+    }
+
+    return sawWork || stoleWork;
+  }
+
   GALOIS_ATTRIBUTE_NOINLINE bool stealWithinSocket(ThreadContext& poor) {
 
     bool sawWork   = false;
@@ -370,6 +400,18 @@ private:
   GALOIS_ATTRIBUTE_NOINLINE bool trySteal(ThreadContext& poor) {
     bool ret = false;
 
+    auto& tp = substrate::getThreadPool();
+
+    // when sockets are split into several L3 domains (e.g., AMD CCXs),
+    // try the threads that share our L3 before the rest of the socket
+    if (tp.getMaxL3Domains() > tp.getMaxSockets()) {
+      ret = stealWithinL3(poor);
+
+      if (ret) {
+        return true;
+      }
+    }
+
     ret = stealWithinSocket(poor);
 
     if (ret) {
@@ -378,7 +420,7 @@ private:
 
     substrate::asmPause();
 
-    if (substrate::getThreadPool().isLeader(poor.id)) {
+    if (tp.isLeader(poor.id)) {
       ret = stealOutsideSocket(poor, HALF);
 
       if (ret) {
@@ -593,6 +635,60 @@ struct ChooseDoAllImpl<false> {
   }
 };
 
+/**
+ * Executes a do_all invoked from inside a running parallel region (e.g., from
+ * the operator of a for_each or do_all). The range is published as a nested
+ * task of the thread pool: the calling thread works through it chunk by chunk
+ * while threads that have run out of work in the enclosing loop steal chunks.
+ * Ranges without random access iterators, and loops nested in an iteration
+ * that runs under conflict detection, are executed serially by the caller.
+ *
+ * A nested loop runs within the time of the enclosing loop, so it only
+ * reports Iterations under its loopname (summed over calls), not timers.
+ */
+template <typename Iter, typename F>
+class DoAllNestedExec {
+  Iter beg;
+  F func;
+
+  static void runChunk(void* self, size_t b, size_t e) {
+    auto& exec = *static_cast<DoAllNestedExec*>(self);
+    Iter ii    = exec.beg + b;
+    Iter ei    = exec.beg + e;
+    for (; ii != ei; ++ii) {
+      exec.func(*ii);
+    }
+  }
+
+  static void call(Iter b, Iter e, F func, size_t chunk,
+                   std::random_access_iterator_tag) {
+    // Another thread would run its chunks without the iteration context of
+    // the caller, so the locks they acquire would escape conflict detection
+    if (getThreadContext()) {
+      call(b, e, func, chunk, std::input_iterator_tag());
+      return;
+    }
+    DoAllNestedExec exec(b, func);
+    substrate::ThreadPool::nested_task task(&runChunk, &exec,
+                                            std::distance(b, e), chunk);
+    substrate::getThreadPool().runNested(task);
+  }
+
+  static void call(Iter b, Iter e, F func, size_t, std::input_iterator_tag) {
+    for (; b != e; ++b) {
+      func(*b);
+    }
+  }
+
+  DoAllNestedExec(Iter b, F f) : beg(b), func(f) {}
+
+public:
+  static void go(Iter b, Iter e, F func, size_t chunk) {
+    call(b, e, func, chunk,
+         typename std::iterator_traits<Iter>::iterator_category());
+  }
+};
+
 } // end namespace internal
 
 template <typename R, typename F, typename ArgsTuple>
@@ -610,6 +706,21 @@ void do_all_gen(const R& range, F&& func, const ArgsTuple& argsTuple) {
 
   using ArgsT = decltype(argsT);
 
+  if (substrate::getThreadPool().isRunning()) {
+    OperatorReferenceType<decltype(std::forward<F>(func))> func_ref = func;
+    internal::DoAllNestedExec<decltype(range.begin()), decltype(func_ref)>::go(
+        range.begin(), range.end(), func_ref,
+        get_by_supertype<chunk_size_tag>(argsT).value);
+
+    if (galois::internal::NeedStats<ArgsT>::value) {
+      galois::runtime::reportStat_Tsum(galois::internal::getLoopName(argsT),
+                                       "Iterations",
+                                       size_t(std::distance(range.begin(),
+                                                            range.end())));
+    }
+    return;
+  }
+
   constexpr bool TIME_IT = exists_by_supertype<loopname_tag, ArgsT>::value;
   CondStatTimer<TIME_IT> timer(galois::internal::getLoopName(argsT));
 
@@ -331,6 +331,10 @@ protected:
           didWork = b || didWork;
         }
 
+        // Idle threads help with do_all loops nested in running iterations
+        if (!didWork && !couldAbort)
+          substrate::getThreadPool().helpNested();
+
         // Update node color and prop token
         term.localTermination(didWork);
         substrate::asmPause(); // Let token propagate
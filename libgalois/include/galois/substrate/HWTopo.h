@@ -33,6 +33,9 @@ struct threadTopoInfo {
   unsigned cumulativeMaxSocket; // max socket id seen from [0, tid]
   unsigned osContext;           // OS ID to use for thread binding
   unsigned osNumaNode;          // OS ID for numa node
+  unsigned l3Leader;            // first thread id in tid's L3 domain
+  unsigned l3Domain;            // shared L3 (e.g., AMD CCX); nested in socket
+  unsigned cumulativeMaxL3;     // max L3 domain id seen from [0, tid]
 };
 
 struct machineTopoInfo {
@@ -40,6 +43,7 @@ struct machineTopoInfo {
   unsigned maxCores;
   unsigned maxSockets;
   unsigned maxNumaNodes;
+  unsigned maxL3Domains; // equal to maxSockets unless sockets split L3
 };
 
 // parse machine topology
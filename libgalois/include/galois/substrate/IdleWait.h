@@ -0,0 +1,155 @@
+/*
+ * This file belongs to the Galois project, a C++ library for exploiting parallelism.
+ * The code is being released under the terms of the 3-Clause BSD License (a
+ * copy is located in LICENSE.txt at the top-level directory).
+ *
+ * Copyright (C) 2019, The University of Texas at Austin. All rights reserved.
+ * UNIVERSITY EXPRESSLY DISCLAIMS ANY AND ALL WARRANTIES CONCERNING THIS
+ * SOFTWARE AND DOCUMENTATION, INCLUDING ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR ANY PARTICULAR PURPOSE, NON-INFRINGEMENT AND WARRANTIES OF
+ * PERFORMANCE, AND ANY WARRANTY THAT MIGHT OTHERWISE ARISE FROM COURSE OF
+ * DEALING OR USAGE OF TRADE.  NO WARRANTY IS EITHER EXPRESS OR IMPLIED WITH
+ * RESPECT TO THE USE OF THE SOFTWARE OR DOCUMENTATION. Under no circumstances
+ * shall University be liable for incidental, special, indirect, direct or
+ * consequential damages or loss of profits, interruption of business, or
+ * related expenses which may arise from use of Software or Documentation,
+ * including but not limited to those resulting from defects in Software and/or
+ * Documentation, or loss or inaccuracy of data of any kind.
+ */
+
+#ifndef GALOIS_SUBSTRATE_IDLEWAIT_H
+#define GALOIS_SUBSTRATE_IDLEWAIT_H
+
+#include "galois/substrate/CompilerSpecific.h"
+
+#include <atomic>
+#include <thread>
+
+namespace galois {
+namespace substrate {
+
+/**
+ * What a thread does once it has spun for the spin budget without the
+ * condition it waits for becoming true. Applies to threads of the pool
+ * between parallel regions and to threads waiting at a barrier.
+ *
+ * SPIN keeps spinning (lowest wakeup latency, burns the core), YIELD spins
+ * with sched_yield in between polls, and SLEEP blocks in the kernel (a futex
+ * on Linux) until the waker signals.
+ */
+enum class IdlePolicy { SPIN, YIELD, SLEEP };
+
+/**
+ * Sets the idle policy and the number of polls (each followed by a pause
+ * instruction) a waiting thread spends before applying it. The defaults are
+ * SLEEP and 16384 polls, and can be changed through the environment
+ * variables GALOIS_IDLE_POLICY (spin, yield or sleep) and GALOIS_IDLE_SPIN.
+ * Applies to waits that start after the call.
+ */
+void setIdlePolicy(IdlePolicy policy, unsigned spinBudget);
+
+namespace internal {
+extern std::atomic<IdlePolicy> idlePolicy;
+extern std::atomic<unsigned> idleSpinBudget;
+
+//! Blocks while *addr == expected (or returns spuriously)
+void futexWait(std::atomic<int>* addr, int expected);
+//! Wakes all threads blocked on addr
+void futexWakeAll(std::atomic<int>* addr);
+} // namespace internal
+
+inline IdlePolicy getIdlePolicy() {
+  return internal::idlePolicy.load(std::memory_order_relaxed);
+}
+
+inline unsigned getIdleSpinBudget() {
+  return internal::idleSpinBudget.load(std::memory_order_relaxed);
+}
+
+/**
+ * Event count for waiting on an arbitrary condition under the idle policy.
+ *
+ * Waiters call await(ready), which returns once ready() is true; the thread
+ * that makes the condition true calls notifyAll() afterwards. notifyAll() is
+ * a single load when nobody sleeps. The condition must be changed and
+ * read with sequentially consistent atomic operations (the default for
+ * std::atomic), which orders them with the sleeper count.
+ */
+class IdleEvent {
+  std::atomic<int> epoch;
+  std::atomic<int> sleepers;
+
+  template <typename Pred>
+  GALOIS_ATTRIBUTE_NOINLINE void awaitSlow(const Pred& ready) {
+    switch (getIdlePolicy()) {
+    case IdlePolicy::SPIN:
+      while (!ready())
+        asmPause();
+      break;
+    case IdlePolicy::YIELD:
+      while (!ready())
+        std::this_thread::yield();
+      break;
+    case IdlePolicy::SLEEP:
+      while (!ready()) {
+        int e = epoch.load();
+        ++sleepers;
+        if (!ready())
+          internal::futexWait(&epoch, e);
+        --sleepers;
+      }
+      break;
+    }
+  }
+
+public:
+  IdleEvent() : epoch(0), sleepers(0) {}
+  //! Events are not shared by copying; copies start out without waiters
+  IdleEvent(const IdleEvent&) : epoch(0), sleepers(0) {}
+  IdleEvent& operator=(const IdleEvent&) { return *this; }
+
+  template <typename Pred>
+  void await(const Pred& ready) {
+    for (unsigned i = getIdleSpinBudget(); i; --i) {
+      if (ready())
+        return;
+      asmPause();
+    }
+    awaitSlow(ready);
+  }
+
+  void notifyAll() {
+    if (sleepers.load()) {
+      ++epoch;
+      internal::futexWakeAll(&epoch);
+    }
+  }
+};
+
+/**
+ * Backoff for polling loops that nobody signals (e.g., waiting for other
+ * threads to finish while looking for work to help with): spins for the spin
+ * budget and then yields between polls unless the policy is SPIN.
+ */
+class IdleBackoff {
+  unsigned polls;
+
+public:
+  IdleBackoff() : polls(0) {}
+
+  void pause() {
+    if (polls < getIdleSpinBudget()) {
+      ++polls;
+      asmPause();
+    } else if (getIdlePolicy() == IdlePolicy::SPIN) {
+      asmPause();
+    } else {
+      std::this_thread::yield();
+    }
+  }
+};
+
+} // end namespace substrate
+} // end namespace galois
+
+#endif
@@ -251,6 +251,90 @@ public:
   unsigned size() const { return getThreadPool().getMaxThreads(); }
 };
 
+/**
+ * One instance of T per L3 domain (see ThreadPool::getL3Domain). The
+ * instances live in the per-thread storage of the domain leaders, so every
+ * access from a non-leader goes through the leader's slot.
+ */
+template <typename T>
+class PerL3Storage {
+protected:
+  PerBackend* b;
+  unsigned offset;
+
+  void destruct() {
+    if (offset == ~0U)
+      return;
+
+    auto& tp = getThreadPool();
+    for (unsigned d = 0; d < tp.getMaxL3Domains(); ++d)
+      reinterpret_cast<T*>(b->getRemote(tp.getLeaderForL3Domain(d), offset))
+          ->~T();
+    b->deallocOffset(offset, sizeof(T));
+    offset = ~0U;
+  }
+
+public:
+  template <typename... Args>
+  PerL3Storage(Args&&... args) : b(&getPTSBackend()) {
+    // in case we make one of these before initializing the thread pool
+    auto& tp = getThreadPool();
+
+    offset = b->allocOffset(sizeof(T));
+    for (unsigned d = 0; d < tp.getMaxL3Domains(); ++d)
+      new (b->getRemote(tp.getLeaderForL3Domain(d), offset))
+          T(std::forward<Args>(args)...);
+  }
+
+  PerL3Storage(PerL3Storage&& rhs) : b(rhs.b), offset(rhs.offset) {
+    rhs.offset = ~0;
+  }
+
+  ~PerL3Storage() { destruct(); }
+
+  PerL3Storage& operator=(PerL3Storage&& rhs) {
+    std::swap(offset, rhs.offset);
+    std::swap(b, rhs.b);
+    return *this;
+  }
+
+  PerL3Storage(const PerL3Storage&) = delete;
+  PerL3Storage& operator=(const PerL3Storage&) = delete;
+
+  T* getLocal() {
+    void* ditem = b->getLocal(offset, ThreadPool::getL3Leader());
+    return reinterpret_cast<T*>(ditem);
+  }
+
+  const T* getLocal() const {
+    void* ditem = b->getLocal(offset, ThreadPool::getL3Leader());
+    return reinterpret_cast<T*>(ditem);
+  }
+
+  //! instance of the L3 domain of thread
+  T* getRemote(unsigned int thread) {
+    void* ditem = b->getRemote(getThreadPool().getL3Leader(thread), offset);
+    return reinterpret_cast<T*>(ditem);
+  }
+
+  const T* getRemote(unsigned int thread) const {
+    void* ditem = b->getRemote(getThreadPool().getL3Leader(thread), offset);
+    return reinterpret_cast<T*>(ditem);
+  }
+
+  T* getRemoteByL3Domain(unsigned int d) {
+    void* ditem = b->getRemote(getThreadPool().getLeaderForL3Domain(d), offset);
+    return reinterpret_cast<T*>(ditem);
+  }
+
+  const T* getRemoteByL3Domain(unsigned int d) const {
+    void* ditem = b->getRemote(getThreadPool().getLeaderForL3Domain(d), offset);
+    return reinterpret_cast<T*>(ditem);
+  }
+
+  unsigned size() const { return getThreadPool().getMaxThreads(); }
+};
+
 } // namespace substrate
 } // end namespace galois
 #endif
@@ -22,12 +22,13 @@
 
 #include "CacheLineStorage.h"
 #include "HWTopo.h"
+#include "IdleWait.h"
 
-#include <condition_variable>
 #include <thread>
 #include <functional>
 #include <atomic>
 #include <vector>
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 
@@ -54,6 +55,25 @@ struct ExecuteTupleImpl<tpl, s, 0> {
 class ThreadPool {
   friend class SharedMemSubstrate;
 
+public:
+  //! Continuation task published by a parallel loop nested inside a running
+  //! parallel region. The publishing thread and idle threads claim chunks of
+  //! [0, size) through next and report completed iterations in finished.
+  struct nested_task {
+    void (*fn)(void*, size_t, size_t);
+    void* ctx;
+    size_t size;
+    size_t chunk;
+    std::atomic<size_t> next;
+    std::atomic<size_t> finished;
+    nested_task* parent;
+
+    nested_task(void (*f)(void*, size_t, size_t), void* c, size_t sz,
+                size_t ch)
+        : fn(f), ctx(c), size(sz), chunk(std::max<size_t>(1, ch)), next(0),
+          finished(0), parent(nullptr) {}
+  };
+
 protected:
   struct shutdown_ty {}; //! type for shutting down thread
   struct fastmode_ty {
@@ -65,36 +85,32 @@ protected:
 
   //! Per-thread mailboxes for notification
   struct per_signal {
-    std::condition_variable cv;
-    std::mutex m;
+    IdleEvent idle; //!< wakes the thread under the idle policy
     unsigned wbegin, wend;
     std::atomic<int> done;
-    std::atomic<int> fastRelease;
+    std::atomic<int> release;
+    std::atomic<nested_task*> nested; //!< innermost nested task published
+    std::atomic<unsigned> nestedRefs; //!< helpers inspecting nested
     threadTopoInfo topo;
 
-    void wakeup(bool fastmode) {
-      if (fastmode) {
-        done        = 0;
-        fastRelease = 1;
-      } else {
-        std::lock_guard<std::mutex> lg(m);
-        done = 0;
-        cv.notify_one();
-        // start.release();
-      }
+    per_signal() : release(0), nested(nullptr), nestedRefs(0) {}
+
+    void wakeup() {
+      done    = 0;
+      release = 1;
+      idle.notifyAll();
     }
 
+    //! in fastmode (burnPower), spin regardless of the idle policy
     void wait(bool fastmode) {
       if (fastmode) {
-        while (!fastRelease.load(std::memory_order_relaxed)) {
+        while (!release.load(std::memory_order_relaxed)) {
           asmPause();
         }
-        fastRelease = 0;
       } else {
-        std::unique_lock<std::mutex> lg(m);
-        cv.wait(lg, [=] { return !done; });
-        // start.acquire();
+        idle.await([this] { return release.load() != 0; });
       }
+      release = 0;
     }
   };
 
@@ -106,6 +122,9 @@ protected:
   unsigned reserved;
   unsigned masterFastmode;
   bool running;
+  unsigned numRunning;
+  std::atomic<unsigned> busy; //!< threads still executing work
+  std::atomic<bool> nestedSeen; //!< a nested task was published this run
   std::function<void(void)> work;
 
   //! destroy all threads
@@ -118,7 +137,7 @@ protected:
   void threadLoop(unsigned tid);
 
   //! spin up for run
-  void cascade(bool fastmode);
+  void cascade();
 
   //! spin down after run
   void decascade();
@@ -126,6 +145,9 @@ protected:
   //! execute work on num threads
   void runInternal(unsigned num);
 
+  //! help nested tasks until all threads of the current run are done
+  void quiesce();
+
   ThreadPool();
 
 public:
@@ -159,6 +181,15 @@ public:
   //! run function in a dedicated thread until the threadpool exits
   void runDedicated(std::function<void(void)>& f);
 
+  //! execute a nested task from within a running parallel region; idle
+  //! threads of the region steal chunks of it. Returns once all iterations of
+  //! the task have completed.
+  void runNested(nested_task& t);
+
+  //! execute one chunk of some nested task published by another thread.
+  //! Returns true if a chunk was executed
+  bool helpNested();
+
   // experimental: busy wait for work
   void burnPower(unsigned num);
   // experimental: leave busy wait
@@ -174,6 +205,7 @@ public:
   unsigned getMaxCores() const { return mi.maxCores; }
   unsigned getMaxSockets() const { return mi.maxSockets; }
   unsigned getMaxNumaNodes() const { return mi.maxNumaNodes; }
+  unsigned getMaxL3Domains() const { return mi.maxL3Domains; }
 
   unsigned getLeaderForSocket(unsigned pid) const {
     for (unsigned i = 0; i < getMaxThreads(); ++i)
@@ -196,6 +228,29 @@ public:
     return signals[tid]->topo.numaNode;
   }
 
+  //! L3 domains are the groups of threads sharing an L3 cache. They nest
+  //! within sockets and coincide with them unless a socket has several L3
+  //! caches (e.g., the CCXs of AMD EPYC processors).
+  unsigned getLeaderForL3Domain(unsigned d) const {
+    for (unsigned i = 0; i < getMaxThreads(); ++i)
+      if (getL3Domain(i) == d && isL3Leader(i))
+        return i;
+    abort();
+  }
+
+  bool isL3Leader(unsigned tid) const {
+    return signals[tid]->topo.l3Leader == tid;
+  }
+  unsigned getL3Domain(unsigned tid) const {
+    return signals[tid]->topo.l3Domain;
+  }
+  unsigned getL3Leader(unsigned tid) const {
+    return signals[tid]->topo.l3Leader;
+  }
+  unsigned getCumulativeMaxL3Domain(unsigned tid) const {
+    return signals[tid]->topo.cumulativeMaxL3;
+  }
+
   static unsigned getTID() { return my_box.topo.tid; }
   static bool isLeader() { return my_box.topo.tid == my_box.topo.socketLeader; }
   static unsigned getLeader() { return my_box.topo.socketLeader; }
@@ -204,6 +259,12 @@ public:
     return my_box.topo.cumulativeMaxSocket;
   }
   static unsigned getNumaNode() { return my_box.topo.numaNode; }
+  static bool isL3Leader() { return my_box.topo.tid == my_box.topo.l3Leader; }
+  static unsigned getL3Leader() { return my_box.topo.l3Leader; }
+  static unsigned getL3Domain() { return my_box.topo.l3Domain; }
+  static unsigned getCumulativeMaxL3Domain() {
+    return my_box.topo.cumulativeMaxL3;
+  }
 };
 
 namespace internal {
@@ -84,7 +84,8 @@ private:
   typedef QT<Chunk, Concurrent> LevelItem;
 
   squeue<Concurrent, substrate::PerThreadStorage, p> data;
-  squeue<Distributed, substrate::PerSocketStorage, LevelItem> Q;
+  // distributed queues are shared by the threads of an L3 domain
+  squeue<Distributed, substrate::PerL3Storage, LevelItem> Q;
 
   Chunk* mkChunk() {
     Chunk* ptr = alloc.allocate(1);
@@ -285,6 +286,8 @@ GALOIS_WLCOMPILECHECK(ChunkLIFO)
 
 /**
  * Distributed chunked FIFO. A more scalable version of {@link ChunkFIFO}.
+ * There is one FIFO per L3 domain, which is the socket unless the socket has
+ * several L3 caches; threads take chunks from their own domain first.
  *
  * @tparam ChunkSize chunk size
  */
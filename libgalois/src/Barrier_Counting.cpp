@@ -17,24 +17,27 @@
  * Documentation, or loss or inaccuracy of data of any kind.
  */
 
-#include "galois/substrate/ThreadPool.h"
+#include "galois/substrate/PerThreadStorage.h"
 #include "galois/substrate/Barrier.h"
 #include "galois/substrate/CompilerSpecific.h"
+#include "galois/substrate/IdleWait.h"
 
 namespace {
 
 class CountingBarrier : public galois::substrate::Barrier {
   std::atomic<unsigned> count;
   std::atomic<bool> sense;
+  galois::substrate::IdleEvent idle;
   unsigned num;
-  std::vector<galois::substrate::CacheLineStorage<bool>> local_sense;
+  // a vector of cache line sized (over-aligned) elements is not allocated
+  // aligned before C++17
+  galois::substrate::PerThreadStorage<bool> local_sense;
 
   void _reinit(unsigned val) {
     count = num = val;
     sense       = false;
-    local_sense.resize(val);
     for (unsigned i = 0; i < val; ++i)
-      local_sense.at(i).get() = false;
+      *local_sense.getRemote(i) = false;
   }
 
 public:
@@ -45,16 +48,14 @@ public:
   virtual void reinit(unsigned val) { _reinit(val); }
 
   virtual void wait() {
-    bool& lsense =
-        local_sense.at(galois::substrate::ThreadPool::getTID()).get();
+    bool& lsense = *local_sense.getLocal();
     lsense = !lsense;
     if (--count == 0) {
       count = num;
       sense = lsense;
+      idle.notifyAll();
     } else {
-      while (sense != lsense) {
-        galois::substrate::asmPause();
-      }
+      idle.await([&] { return sense == lsense; });
     }
   }
 
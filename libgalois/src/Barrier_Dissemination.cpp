@@ -20,6 +20,7 @@
 #include "galois/substrate/ThreadPool.h"
 #include "galois/substrate/Barrier.h"
 #include "galois/substrate/CompilerSpecific.h"
+#include "galois/substrate/IdleWait.h"
 
 #include <atomic>
 
@@ -34,6 +35,7 @@ class DisseminationBarrier : public galois::substrate::Barrier {
 
   struct node {
     std::atomic<int> flag[2];
+    galois::substrate::IdleEvent idle;
     node* partner;
     node() : partner(nullptr) {}
     node(const node& rhs) : partner(rhs.partner) {
@@ -81,10 +83,10 @@ public:
     auto& sense  = ld.sense;
     auto& parity = ld.parity;
     for (unsigned r = 0; r < LogP; ++r) {
-      ld.myflags[r].partner->flag[parity] = sense;
-      while (ld.myflags[r].flag[parity] != sense) {
-        galois::substrate::asmPause();
-      }
+      node& mine = ld.myflags[r];
+      mine.partner->flag[parity] = sense;
+      mine.partner->idle.notifyAll();
+      mine.idle.await([&] { return mine.flag[parity] == sense; });
     }
     if (parity == 1)
       sense = 1 - ld.sense;
@@ -20,6 +20,7 @@
 #include "galois/substrate/ThreadPool.h"
 #include "galois/substrate/Barrier.h"
 #include "galois/substrate/CompilerSpecific.h"
+#include "galois/substrate/IdleWait.h"
 
 #include <atomic>
 
@@ -35,11 +36,20 @@ class MCSBarrier : public galois::substrate::Barrier {
     std::atomic<bool> childnotready[4];
     std::atomic<bool> parentsense;
     bool sense;
+
+    // wakes this node's thread; the events of the nodes pointed to above
+    galois::substrate::IdleEvent idle;
+    galois::substrate::IdleEvent* parentidle;
+    galois::substrate::IdleEvent* childidle[2];
+
     treenode() {}
     treenode(const treenode& rhs)
-        : parentpointer(rhs.parentpointer), sense(rhs.sense) {
+        : parentpointer(rhs.parentpointer), sense(rhs.sense),
+          parentidle(rhs.parentidle) {
       childpointers[0] = rhs.childpointers[0];
       childpointers[1] = rhs.childpointers[1];
+      childidle[0]     = rhs.childidle[0];
+      childidle[1]     = rhs.childidle[1];
       for (int i = 0; i < 4; ++i) {
         havechild[i]     = rhs.havechild[i];
         childnotready[i] = rhs.childnotready[i].load();
@@ -65,6 +75,11 @@ class MCSBarrier : public galois::substrate::Barrier {
           ((2 * i + 1) >= P) ? 0 : &nodes.at(2 * i + 1).get().parentsense;
       n.childpointers[1] =
           ((2 * i + 2) >= P) ? 0 : &nodes.at(2 * i + 2).get().parentsense;
+      n.parentidle = (i == 0) ? 0 : &nodes.at((i - 1) / 4).get().idle;
+      n.childidle[0] =
+          ((2 * i + 1) >= P) ? 0 : &nodes.at(2 * i + 1).get().idle;
+      n.childidle[1] =
+          ((2 * i + 2) >= P) ? 0 : &nodes.at(2 * i + 2).get().idle;
     }
   }
 
@@ -75,25 +90,26 @@ public:
 
   virtual void wait() {
     treenode& n = nodes.at(galois::substrate::ThreadPool::getTID()).get();
-    while (n.childnotready[0] || n.childnotready[1] || n.childnotready[2] ||
-           n.childnotready[3]) {
-      galois::substrate::asmPause();
-    }
+    n.idle.await([&] {
+      return !(n.childnotready[0] || n.childnotready[1] ||
+               n.childnotready[2] || n.childnotready[3]);
+    });
     for (int i = 0; i < 4; ++i)
       n.childnotready[i] = n.havechild[i];
     if (n.parentpointer) {
       // FIXME: make sure the compiler doesn't do a RMW because of the as-if
       // rule
       *n.parentpointer = false;
-      while (n.parentsense != n.sense) {
-        galois::substrate::asmPause();
-      }
+      n.parentidle->notifyAll();
+      n.idle.await([&] { return n.parentsense == n.sense; });
     }
     // signal children in wakeup tree
-    if (n.childpointers[0])
-      *n.childpointers[0] = n.sense;
-    if (n.childpointers[1])
-      *n.childpointers[1] = n.sense;
+    for (int i = 0; i < 2; ++i) {
+      if (n.childpointers[i]) {
+        *n.childpointers[i] = n.sense;
+        n.childidle[i]->notifyAll();
+      }
+    }
     n.sense = !n.sense;
   }
 
@@ -20,6 +20,7 @@
 #include "galois/substrate/PerThreadStorage.h"
 #include "galois/substrate/Barrier.h"
 #include "galois/substrate/CompilerSpecific.h"
+#include "galois/substrate/IdleWait.h"
 
 #include <atomic>
 
@@ -29,7 +30,7 @@ class TopoBarrier : public galois::substrate::Barrier {
   struct treenode {
     // vpid is galois::runtime::LL::getTID()
 
-    // socket binary tree
+    // L3 domain tree
     treenode* parentpointer; // null of vpid == 0
     treenode* childpointers[2];
 
@@ -39,16 +40,19 @@ class TopoBarrier : public galois::substrate::Barrier {
 
     // signal values
     std::atomic<unsigned> parentsense;
+
+    // wakes the threads waiting on either of the values above
+    galois::substrate::IdleEvent idle;
   };
 
-  galois::substrate::PerSocketStorage<treenode> nodes;
+  galois::substrate::PerL3Storage<treenode> nodes;
   galois::substrate::PerThreadStorage<unsigned> sense;
 
   void _reinit(unsigned P) {
     auto& tp      = galois::substrate::getThreadPool();
-    unsigned pkgs = tp.getCumulativeMaxSocket(P - 1) + 1;
+    unsigned pkgs = tp.getCumulativeMaxL3Domain(P - 1) + 1;
     for (unsigned i = 0; i < pkgs; ++i) {
-      treenode& n     = *nodes.getRemoteByPkg(i);
+      treenode& n     = *nodes.getRemoteByL3Domain(i);
       n.childnotready = 0;
       n.havechild     = 0;
       for (int j = 0; j < 4; ++j) {
@@ -58,16 +62,17 @@ class TopoBarrier : public galois::substrate::Barrier {
         }
       }
       for (unsigned j = 0; j < P; ++j) {
-        if (tp.getSocket(j) == i && !tp.isLeader(j)) {
+        if (tp.getL3Domain(j) == i && !tp.isL3Leader(j)) {
           ++n.childnotready;
           ++n.havechild;
         }
       }
-      n.parentpointer = (i == 0) ? 0 : nodes.getRemoteByPkg((i - 1) / 4);
+      n.parentpointer =
+          (i == 0) ? 0 : nodes.getRemoteByL3Domain((i - 1) / 4);
       n.childpointers[0] =
-          ((2 * i + 1) >= pkgs) ? 0 : nodes.getRemoteByPkg(2 * i + 1);
+          ((2 * i + 1) >= pkgs) ? 0 : nodes.getRemoteByL3Domain(2 * i + 1);
       n.childpointers[1] =
-          ((2 * i + 2) >= pkgs) ? 0 : nodes.getRemoteByPkg(2 * i + 2);
+          ((2 * i + 2) >= pkgs) ? 0 : nodes.getRemoteByL3Domain(2 * i + 2);
       n.parentsense = 0;
     }
     for (unsigned i = 0; i < P; ++i)
@@ -84,35 +89,37 @@ public:
     unsigned id = galois::substrate::ThreadPool::getTID();
     treenode& n = *nodes.getLocal();
     unsigned& s = *sense.getLocal();
-    bool leader = galois::substrate::ThreadPool::isLeader();
+    bool leader = galois::substrate::ThreadPool::isL3Leader();
     // completion tree
     if (leader) {
-      while (n.childnotready) {
-        galois::substrate::asmPause();
-      }
+      n.idle.await([&] { return n.childnotready == 0; });
       n.childnotready = n.havechild;
       if (n.parentpointer) {
         --n.parentpointer->childnotready;
+        n.parentpointer->idle.notifyAll();
       }
     } else {
       --n.childnotready;
+      n.idle.notifyAll();
     }
 
     // wait for signal
     if (id != 0) {
-      while (n.parentsense != s) {
-        galois::substrate::asmPause();
-      }
+      n.idle.await([&] { return n.parentsense == s; });
     }
 
     // signal children in wakeup tree
     if (leader) {
-      if (n.childpointers[0])
-        n.childpointers[0]->parentsense = s;
-      if (n.childpointers[1])
-        n.childpointers[1]->parentsense = s;
-      if (id == 0)
+      for (treenode* c : n.childpointers) {
+        if (c) {
+          c->parentsense = s;
+          c->idle.notifyAll();
+        }
+      }
+      if (id == 0) {
         n.parentsense = s;
+        n.idle.notifyAll();
+      }
     }
     ++s;
   }
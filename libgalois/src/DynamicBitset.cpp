@@ -20,6 +20,142 @@
 /**
  * @file DynamicBitset.cpp
  *
- * All the implementation of the DynamicBitSet class incorporated into
- * DynamicBitset.h
+ * Most of the implementation of the DynamicBitSet class is in
+ * DynamicBitset.h; this file has the SIMD kernels over its words.
  */
+
+#include "galois/DynamicBitset.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define GALOIS_BITSET_X86 1
+#include <immintrin.h>
+// VPOPCNTDQ is an extension of its own, which older compilers can neither
+// target nor query with __builtin_cpu_supports
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 8
+#define GALOIS_BITSET_VPOPCNT 1
+#endif
+#endif
+
+static uint64_t popcountScalar(const uint64_t* w, size_t n) {
+  uint64_t retval = 0;
+  for (size_t i = 0; i < n; ++i)
+    retval += __builtin_popcountll(w[i]);
+  return retval;
+}
+
+static size_t findNonZeroScalar(const uint64_t* w, size_t begin,
+                                size_t end) {
+  while (begin < end && !w[begin])
+    ++begin;
+  return begin;
+}
+
+#ifdef GALOIS_BITSET_X86
+
+// Nibble lookup popcount (Mula et al., "Faster population counts using AVX2
+// instructions", 2016): count each nibble with a byte shuffle and sum the
+// bytes of every 64-bit lane with SAD
+__attribute__((target("avx2"))) static uint64_t
+popcountAVX2(const uint64_t* w, size_t n) {
+  const __m256i lookup =
+      _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1,
+                       2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low = _mm256_set1_epi8(0x0f);
+  __m256i acc       = _mm256_setzero_si256();
+  size_t i          = 0;
+
+  for (; i + 4 <= n; i += 4) {
+    __m256i v  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + i));
+    __m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low));
+    __m256i hi = _mm256_shuffle_epi8(
+        lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+    acc = _mm256_add_epi64(
+        acc, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+  }
+
+  uint64_t lanes[4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+         popcountScalar(w + i, n - i);
+}
+
+#ifdef GALOIS_BITSET_VPOPCNT
+__attribute__((target("avx512f,avx512vpopcntdq"))) static uint64_t
+popcountAVX512(const uint64_t* w, size_t n) {
+  __m512i acc = _mm512_setzero_si512();
+  size_t i    = 0;
+
+  for (; i + 8 <= n; i += 8)
+    acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_loadu_si512(w + i)));
+
+  // sum the lanes through memory: GCC 12 warns about an uninitialized
+  // operand inside _mm512_reduce_add_epi64 (_mm512_extracti64x4_epi64)
+  uint64_t lanes[8];
+  _mm512_storeu_si512(lanes, acc);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] +
+         lanes[6] + lanes[7] + popcountScalar(w + i, n - i);
+}
+#endif
+
+__attribute__((target("avx2"))) static size_t
+findNonZeroAVX2(const uint64_t* w, size_t begin, size_t end) {
+  for (; begin + 4 <= end; begin += 4) {
+    __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + begin));
+    if (!_mm256_testz_si256(v, v))
+      break;
+  }
+  return findNonZeroScalar(w, begin, end);
+}
+
+__attribute__((target("avx512f"))) static size_t
+findNonZeroAVX512(const uint64_t* w, size_t begin, size_t end) {
+  for (; begin + 8 <= end; begin += 8) {
+    __m512i v = _mm512_loadu_si512(w + begin);
+    if (_mm512_test_epi64_mask(v, v))
+      break;
+  }
+  return findNonZeroScalar(w, begin, end);
+}
+
+#endif
+
+namespace {
+
+struct BitsetKernels {
+  uint64_t (*popcount)(const uint64_t*, size_t);
+  size_t (*findNonZero)(const uint64_t*, size_t, size_t);
+
+  BitsetKernels() : popcount(&popcountScalar), findNonZero(&findNonZeroScalar) {
+#ifdef GALOIS_BITSET_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+      findNonZero = &findNonZeroAVX512;
+      popcount    = &popcountAVX2;
+#ifdef GALOIS_BITSET_VPOPCNT
+      if (__builtin_cpu_supports("avx512vpopcntdq"))
+        popcount = &popcountAVX512;
+#endif
+    } else if (__builtin_cpu_supports("avx2")) {
+      popcount    = &popcountAVX2;
+      findNonZero = &findNonZeroAVX2;
+    }
+#endif
+  }
+};
+
+const BitsetKernels& getKernels() {
+  static BitsetKernels kernels;
+  return kernels;
+}
+
+} // namespace
+
+uint64_t galois::internal::popcountWords(const uint64_t* w, size_t n) {
+  return getKernels().popcount(w, n);
+}
+
+size_t galois::internal::findNonZeroWord(const uint64_t* w, size_t begin,
+                                         size_t end) {
+  return getKernels().findNonZero(w, begin, end);
+}
@@ -54,6 +54,7 @@ galois::substrate::getHWTopo() {
   mti.maxThreads   = getIntValue("hw.logicalcpu_max");
   mti.maxCores     = getIntValue("hw.physicalcpu_max");
   mti.maxNumaNodes = mti.maxSockets;
+  mti.maxL3Domains = mti.maxSockets;
 
   std::vector<threadTopoInfo> tti;
   tti.reserve(mti.maxThreads);
@@ -82,6 +83,8 @@ galois::substrate::getHWTopo() {
         .numaNode     = socket,
         .osContext    = i,
         .osNumaNode   = socket,
+        .l3Leader     = leader,
+        .l3Domain     = socket,
     });
   }
 
@@ -102,6 +105,7 @@ galois::substrate::getHWTopo() {
     m                          = std::max(m, tti[i].socket);
     tti[i].tid                 = i;
     tti[i].cumulativeMaxSocket = m;
+    tti[i].cumulativeMaxL3     = m;
   }
 
   return std::make_pair(mti, tti);
@@ -29,6 +29,7 @@
 #include <fstream>
 #include <functional>
 #include <set>
+#include <string>
 
 #ifdef GALOIS_USE_NUMA
 #include <numa.h>
@@ -51,6 +52,7 @@ struct cpuinfo {
   unsigned coreid;
   unsigned cpucores;
   unsigned numaNode; // from libnuma
+  int l3;            // first OS cpu sharing the L3 cache; -1 if unknown
   bool valid;        // from cpuset
   bool smt;          // computed
 };
@@ -60,6 +62,8 @@ static bool operator<(const cpuinfo& lhs, const cpuinfo& rhs) {
     return lhs.smt < rhs.smt;
   if (lhs.physid != rhs.physid)
     return lhs.physid < rhs.physid;
+  if (lhs.l3 != rhs.l3)
+    return lhs.l3 < rhs.l3;
   if (lhs.coreid != rhs.coreid)
     return lhs.coreid < rhs.coreid;
   return lhs.proc < rhs.proc;
@@ -94,6 +98,59 @@ static unsigned getNumaNode(cpuinfo& c) {
 #endif
 }
 
+//! Parse a list of cpus such as "0-3,8,10-11"
+static std::vector<int> parseCPUList(const std::string& buffer) {
+  std::vector<int> vals;
+  size_t current;
+  size_t next = -1;
+  do {
+    current  = next + 1;
+    next     = buffer.find_first_of(',', current);
+    auto buf = buffer.substr(current, next - current);
+    if (buf.size()) {
+      size_t dash = buf.find_first_of('-', 0);
+      if (dash != std::string::npos) { // range
+        auto first  = buf.substr(0, dash);
+        auto second = buf.substr(dash + 1, std::string::npos);
+        unsigned b  = atoi(first.data());
+        unsigned e  = atoi(second.data());
+        while (b <= e)
+          vals.push_back(b++);
+      } else { // singleton
+        vals.push_back(atoi(buf.data()));
+      }
+    }
+  } while (next != std::string::npos);
+  return vals;
+}
+
+//! Returns the first OS cpu that shares the L3 cache with proc, which
+//! identifies its L3 domain, or -1 if sysfs does not describe an L3
+static int parseL3Domain(unsigned proc) {
+  std::string cpu("/sys/devices/system/cpu/cpu");
+  cpu += std::to_string(proc);
+  cpu += "/cache/index";
+  for (unsigned index = 0;; ++index) {
+    std::string dir = cpu + std::to_string(index);
+    std::ifstream levelFile(dir + "/level");
+    if (!levelFile)
+      return -1;
+    unsigned level = 0;
+    levelFile >> level;
+    if (level != 3)
+      continue;
+
+    std::ifstream sharedFile(dir + "/shared_cpu_list");
+    std::string buffer;
+    if (!std::getline(sharedFile, buffer))
+      return -1;
+    auto cpus = parseCPUList(buffer);
+    if (cpus.empty())
+      return -1;
+    return *std::min_element(cpus.begin(), cpus.end());
+  }
+}
+
 //! Parse /proc/cpuinfo
 static std::vector<cpuinfo> parseCPUInfo() {
   std::vector<cpuinfo> vals;
@@ -129,8 +186,10 @@ static std::vector<cpuinfo> parseCPUInfo() {
     }
   }
 
-  for (auto& c : vals)
+  for (auto& c : vals) {
     c.numaNode = getNumaNode(c);
+    c.l3       = parseL3Domain(c.proc);
+  }
 
   return vals;
 }
@@ -169,27 +228,7 @@ static std::vector<int> parseCPUSet() {
   if (!cpuSet)
     return vals;
 
-  size_t current;
-  size_t next = -1;
-  do {
-    current  = next + 1;
-    next     = buffer.find_first_of(',', current);
-    auto buf = buffer.substr(current, next - current);
-    if (buf.size()) {
-      size_t dash = buf.find_first_of('-', 0);
-      if (dash != std::string::npos) { // range
-        auto first  = buf.substr(0, dash);
-        auto second = buf.substr(dash + 1, std::string::npos);
-        unsigned b  = atoi(first.data());
-        unsigned e  = atoi(second.data());
-        while (b <= e)
-          vals.push_back(b++);
-      } else { // singleton
-        vals.push_back(atoi(buf.data()));
-      }
-    }
-  } while (next != std::string::npos);
-  return vals;
+  return parseCPUList(buffer);
 }
 
 static unsigned countSockets(const std::vector<cpuinfo>& info) {
@@ -206,6 +245,13 @@ static unsigned countCores(const std::vector<cpuinfo>& info) {
   return cores.size();
 }
 
+static unsigned countL3Domains(const std::vector<cpuinfo>& info) {
+  std::set<std::pair<unsigned, int>> domains;
+  for (auto& c : info)
+    domains.insert(std::make_pair(c.physid, c.l3));
+  return domains.size();
+}
+
 static unsigned countNumaNodes(const std::vector<cpuinfo>& info) {
   std::set<unsigned> nodes;
   for (auto& c : info)
@@ -244,8 +290,7 @@ std::vector<cpuinfo> transform(std::vector<cpuinfo>& info) {
 
 } // namespace
 
-std::pair<machineTopoInfo, std::vector<threadTopoInfo>>
-galois::substrate::getHWTopo() {
+static std::pair<machineTopoInfo, std::vector<threadTopoInfo>> parseHWTopo() {
   machineTopoInfo retMTI;
 
   auto rawInfo = parseCPUInfo();
@@ -265,19 +310,26 @@ galois::substrate::getHWTopo() {
   retMTI.maxThreads   = info.size();
   retMTI.maxCores     = countCores(info);
   retMTI.maxNumaNodes = countNumaNodes(info);
+  retMTI.maxL3Domains = countL3Domains(info);
 
   std::vector<threadTopoInfo> retTTI;
   retTTI.reserve(retMTI.maxThreads);
   // compute renumberings
   std::set<unsigned> sockets;
   std::set<unsigned> numaNodes;
+  // L3 domains are numbered within sockets; a cpu without L3 information
+  // forms one domain with the rest of its socket
+  std::set<std::pair<unsigned, int>> l3Domains;
   for (auto& i : info) {
     sockets.insert(i.physid);
     numaNodes.insert(i.numaNode);
+    l3Domains.insert(std::make_pair(i.physid, i.l3));
   }
-  unsigned mid = 0; // max socket id
+  unsigned mid  = 0; // max socket id
+  unsigned ml3d = 0; // max L3 domain id
   for (unsigned i = 0; i < info.size(); ++i) {
     unsigned pid = info[i].physid;
+    int l3       = info[i].l3;
     unsigned repid =
         std::distance(sockets.begin(), sockets.find(info[i].physid));
     mid             = std::max(mid, repid);
@@ -285,16 +337,32 @@ galois::substrate::getHWTopo() {
         info.begin(),
         std::find_if(info.begin(), info.end(),
                      [pid](const cpuinfo& c) { return c.physid == pid; }));
+    unsigned repl3 = std::distance(l3Domains.begin(),
+                                   l3Domains.find(std::make_pair(pid, l3)));
+    ml3d              = std::max(ml3d, repl3);
+    unsigned l3Leader = std::distance(
+        info.begin(), std::find_if(info.begin(), info.end(),
+                                   [pid, l3](const cpuinfo& c) {
+                                     return c.physid == pid && c.l3 == l3;
+                                   }));
     retTTI.push_back(
         threadTopoInfo{i, leader, repid,
                        (unsigned)std::distance(
                            numaNodes.begin(), numaNodes.find(info[i].numaNode)),
-                       mid, info[i].proc, info[i].numaNode});
+                       mid, info[i].proc, info[i].numaNode, l3Leader, repl3,
+                       ml3d});
   }
 
   return std::make_pair(retMTI, retTTI);
 }
 
+std::pair<machineTopoInfo, std::vector<threadTopoInfo>>
+galois::substrate::getHWTopo() {
+  // every thread of the pool asks for the topology; parse it only once
+  static const auto topo = parseHWTopo();
+  return topo;
+}
+
 //! binds current thread to OS HW context "proc"
 bool galois::substrate::bindThreadSelf(unsigned osContext) {
 #ifdef GALOIS_USE_SCHED_SETAFFINITY
@@ -0,0 +1,89 @@
+/*
+ * This file belongs to the Galois project, a C++ library for exploiting parallelism.
+ * The code is being released under the terms of the 3-Clause BSD License (a
+ * copy is located in LICENSE.txt at the top-level directory).
+ *
+ * Copyright (C) 2019, The University of Texas at Austin. All rights reserved.
+ * UNIVERSITY EXPRESSLY DISCLAIMS ANY AND ALL WARRANTIES CONCERNING THIS
+ * SOFTWARE AND DOCUMENTATION, INCLUDING ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR ANY PARTICULAR PURPOSE, NON-INFRINGEMENT AND WARRANTIES OF
+ * PERFORMANCE, AND ANY WARRANTY THAT MIGHT OTHERWISE ARISE FROM COURSE OF
+ * DEALING OR USAGE OF TRADE.  NO WARRANTY IS EITHER EXPRESS OR IMPLIED WITH
+ * RESPECT TO THE USE OF THE SOFTWARE OR DOCUMENTATION. Under no circumstances
+ * shall University be liable for incidental, special, indirect, direct or
+ * consequential damages or loss of profits, interruption of business, or
+ * related expenses which may arise from use of Software or Documentation,
+ * including but not limited to those resulting from defects in Software and/or
+ * Documentation, or loss or inaccuracy of data of any kind.
+ */
+
+#include "galois/substrate/IdleWait.h"
+#include "galois/substrate/EnvCheck.h"
+#include "galois/gIO.h"
+
+#include <climits>
+#include <string>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+galois::substrate::IdlePolicy policyFromEnv() {
+  using galois::substrate::IdlePolicy;
+  std::string val;
+  if (!galois::substrate::EnvCheck("GALOIS_IDLE_POLICY", val) ||
+      val == "sleep")
+    return IdlePolicy::SLEEP;
+  if (val == "spin")
+    return IdlePolicy::SPIN;
+  if (val == "yield")
+    return IdlePolicy::YIELD;
+  galois::gWarn("unknown GALOIS_IDLE_POLICY ", val, "; using sleep");
+  return IdlePolicy::SLEEP;
+}
+
+unsigned spinBudgetFromEnv() {
+  int val;
+  if (galois::substrate::EnvCheck("GALOIS_IDLE_SPIN", val) && val >= 0)
+    return val;
+  return 16 * 1024;
+}
+
+} // namespace
+
+std::atomic<galois::substrate::IdlePolicy>
+    galois::substrate::internal::idlePolicy(policyFromEnv());
+std::atomic<unsigned>
+    galois::substrate::internal::idleSpinBudget(spinBudgetFromEnv());
+
+void galois::substrate::setIdlePolicy(IdlePolicy policy, unsigned spinBudget) {
+  internal::idlePolicy.store(policy, std::memory_order_relaxed);
+  internal::idleSpinBudget.store(spinBudget, std::memory_order_relaxed);
+}
+
+void galois::substrate::internal::futexWait(std::atomic<int>* addr,
+                                            int expected) {
+#ifdef __linux__
+  static_assert(sizeof(std::atomic<int>) == sizeof(int),
+                "futex word must be a plain int");
+  syscall(SYS_futex, reinterpret_cast<int*>(addr), FUTEX_WAIT_PRIVATE,
+          expected, nullptr, nullptr, 0);
+#else
+  // no portable futex; the caller rechecks its condition
+  if (addr->load() == expected)
+    std::this_thread::yield();
+#endif
+}
+
+void galois::substrate::internal::futexWakeAll(std::atomic<int>* addr) {
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<int*>(addr), FUTEX_WAKE_PRIVATE, INT_MAX,
+          nullptr, nullptr, 0);
+#else
+  (void)addr;
+#endif
+}
@@ -21,6 +21,10 @@
 
 //#include "galois/runtime/Mem.h"
 #include "galois/gIO.h"
+#include "galois/substrate/CompilerSpecific.h"
+
+#include <algorithm>
+#include <cstdlib>
 #include <mutex>
 
 thread_local char* galois::substrate::ptsBase;
@@ -41,7 +45,13 @@ galois::substrate::PerBackend& galois::substrate::getPPSBackend() {
 #ifdef MORE_MEM_HACK
 const size_t allocSize =
     16 * (2 << 20); // galois::runtime::MM::hugePageSize * 16;
-inline void* alloc() { return malloc(allocSize); }
+inline void* alloc() {
+  // offsets are aligned up to a cache line, so the base must be as well
+  void* ptr = nullptr;
+  if (posix_memalign(&ptr, GALOIS_CACHE_LINE_SIZE, allocSize))
+    GALOIS_DIE("out of memory");
+  return ptr;
+}
 
 #else
 const size_t allocSize = galois::runtime::MM::hugePageSize;
@@ -65,9 +75,24 @@ unsigned galois::substrate::PerBackend::allocOffset(const unsigned sz) {
   unsigned ll     = nextLog2(sz);
   unsigned size   = (1 << ll);
 
-  if ((nextLoc + size) <= allocSize) {
+  // Objects may be over-aligned (e.g., cache-line aligned locks), and the
+  // compiler is free to use aligned vector stores on them, so keep each
+  // allocation aligned to its size up to a cache line. Free offsets are
+  // reused only for the same or larger sizes and stay aligned as well.
+  const unsigned align = std::min(size, (unsigned)GALOIS_CACHE_LINE_SIZE);
+
+  unsigned cur = nextLoc;
+  unsigned aligned;
+  do {
+    aligned = (cur + align - 1) & ~(align - 1);
+    if (aligned + size > allocSize)
+      break;
+  } while (!__atomic_compare_exchange_n(&nextLoc, &cur, aligned + size, false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST));
+
+  if (aligned + size <= allocSize) {
     // simple path, where we allocate bump ptr style
-    retval = __sync_fetch_and_add(&nextLoc, size);
+    retval = aligned;
   } else if (!invalid) {
     // find a free offset
     std::lock_guard<Lock> llock(freeOffsetsLock);
@@ -40,7 +40,8 @@ thread_local ThreadPool::per_signal ThreadPool::my_box;
 
 ThreadPool::ThreadPool()
     : mi(getHWTopo().first), reserved(0), masterFastmode(false),
-      running(false) {
+      running(false), numRunning(0), busy(0),
+      nestedSeen(false) {
   signals.resize(mi.maxThreads);
   initThread(0);
 
@@ -130,7 +131,7 @@ void ThreadPool::threadLoop(unsigned tid) {
   auto& me      = my_box;
   do {
     me.wait(fastmode);
-    cascade(fastmode);
+    cascade();
     try {
       work();
     } catch (const shutdown_ty&) {
@@ -148,10 +149,84 @@ void ThreadPool::threadLoop(unsigned tid) {
     } catch (...) {
       abort();
     }
+    quiesce();
     decascade();
   } while (true);
 }
 
+void ThreadPool::quiesce() {
+  // Threads that run out of work stay available to nested tasks of threads
+  // still executing; nested tasks can only be published by busy threads.
+  // Regions without nested loops skip the wait, so they only pay for the
+  // decrement; a nested task published after a thread left is still run to
+  // completion by its owner, just with fewer helpers
+  busy.fetch_sub(1, std::memory_order_acq_rel);
+  if (!nestedSeen.load(std::memory_order_relaxed)) {
+    return;
+  }
+  IdleBackoff backoff;
+  while (busy.load(std::memory_order_acquire)) {
+    if (!helpNested()) {
+      backoff.pause();
+    }
+  }
+}
+
+bool ThreadPool::helpNested() {
+  const unsigned num = numRunning;
+  const unsigned tid = my_box.topo.tid;
+
+  for (unsigned i = 1; i < num; ++i) {
+    per_signal& owner = *signals[(tid + i) % num];
+    if (!owner.nested.load(std::memory_order_relaxed))
+      continue;
+
+    // nestedRefs keeps the task alive between reading it and claiming a
+    // chunk; a claimed but unfinished chunk keeps it alive after that. The
+    // increment and the load pair with the store and the load in runNested
+    // (store-load on both sides), so both need sequential consistency
+    owner.nestedRefs.fetch_add(1, std::memory_order_seq_cst);
+    nested_task* t = owner.nested.load(std::memory_order_seq_cst);
+    size_t b       = t ? t->next.fetch_add(t->chunk) : 0;
+    owner.nestedRefs.fetch_sub(1, std::memory_order_release);
+
+    if (t && b < t->size) {
+      size_t e = std::min(b + t->chunk, t->size);
+      t->fn(t->ctx, b, e);
+      t->finished.fetch_add(e - b, std::memory_order_release);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::runNested(nested_task& t) {
+  auto& me = my_box;
+  t.parent = me.nested.load(std::memory_order_relaxed);
+  if (!nestedSeen.load(std::memory_order_relaxed)) {
+    nestedSeen.store(true, std::memory_order_relaxed);
+  }
+  me.nested.store(&t, std::memory_order_release);
+
+  size_t b;
+  while ((b = t.next.fetch_add(t.chunk)) < t.size) {
+    size_t e = std::min(b + t.chunk, t.size);
+    t.fn(t.ctx, b, e);
+    t.finished.fetch_add(e - b, std::memory_order_release);
+  }
+
+  // Unpublish before checking for helpers: a helper that incremented
+  // nestedRefs after this load is ordered after the store and sees parent
+  me.nested.store(t.parent, std::memory_order_seq_cst);
+
+  // wait for chunks stolen by other threads
+  IdleBackoff backoff;
+  while (t.finished.load(std::memory_order_acquire) != t.size ||
+         me.nestedRefs.load(std::memory_order_seq_cst)) {
+    backoff.pause();
+  }
+}
+
 void ThreadPool::decascade() {
   auto& me = my_box;
   // nothing to wake up
@@ -171,7 +246,7 @@ void ThreadPool::decascade() {
   me.done = 1;
 }
 
-void ThreadPool::cascade(bool fastmode) {
+void ThreadPool::cascade() {
   auto& me = my_box;
   assert(me.wbegin <= me.wend);
 
@@ -191,13 +266,13 @@ void ThreadPool::cascade(bool fastmode) {
   auto child1    = signals[me.wbegin];
   child1->wbegin = me.wbegin + 1;
   child1->wend   = midpoint;
-  child1->wakeup(fastmode);
+  child1->wakeup();
 
   if (midpoint < me.wend) {
     auto child2    = signals[midpoint];
     child2->wbegin = midpoint + 1;
     child2->wend   = me.wend;
-    child2->wakeup(fastmode);
+    child2->wakeup();
   }
 }
 
@@ -212,9 +287,13 @@ void ThreadPool::runInternal(unsigned num) {
   me.wbegin = 1;
   me.wend   = num;
 
+  numRunning = num;
+  nestedSeen.store(false, std::memory_order_relaxed);
+  busy.store(num, std::memory_order_release);
+
   assert(!masterFastmode || masterFastmode == num);
   // launch threads
-  cascade(masterFastmode);
+  cascade();
   // Do master thread work
   try {
     work();
@@ -222,6 +301,7 @@ void ThreadPool::runInternal(unsigned num) {
     return;
   } catch (const fastmode_ty& fm) {
   }
+  quiesce();
   // wait for children
   decascade();
   // Clean up
@@ -239,7 +319,7 @@ void ThreadPool::runDedicated(std::function<void(void)>& f) {
   child->wbegin = 0;
   child->wend   = 0;
   child->done   = 0;
-  child->wakeup(masterFastmode);
+  child->wakeup();
   while (!child->done) {
     asmPause();
   }
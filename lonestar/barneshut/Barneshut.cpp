@@ -21,6 +21,8 @@
 #include "galois/Timer.h"
 #include "galois/Bag.h"
 #include "galois/Reduction.h"
+#include "galois/ParallelSTL.h"
+#include "galois/substrate/PerThreadStorage.h"
 #include "Lonestar/BoilerPlate.h"
 #include "galois/runtime/Profile.h"
 
@@ -54,6 +56,16 @@ static llvm::cl::opt<int> seed("seed",
                                llvm::cl::desc("Random seed (default value 7)"),
                                llvm::cl::init(7));
 
+enum Algo { octree, morton };
+
+static llvm::cl::opt<Algo> algo(
+    "algo", llvm::cl::desc("Choose an algorithm:"),
+    llvm::cl::values(
+        clEnumVal(octree, "Pointer-based octree built with locks (default)"),
+        clEnumVal(morton, "Bodies sorted by Morton key and a linear octree"),
+        clEnumValEnd),
+    llvm::cl::init(octree));
+
 struct Node {
   Point pos;
   double mass;
@@ -162,7 +174,7 @@ struct BuildOctree {
 
     // go through the tree lock-free while we can
     if (child && !child->Leaf) {
-      insert(b, static_cast<Octree*>(child), radius);
+      insert(b, static_cast<Octree*>(child), radius * 0.5);
       return;
     }
 
@@ -338,6 +350,348 @@ struct ComputeForces {
   }
 };
 
+/**
+ * Spreads the low 21 bits of v so that there are two zero bits between
+ * consecutive bits.
+ */
+inline uint64_t spreadBits(uint64_t v) {
+  v &= 0x1fffff;
+  v = (v | v << 32) & 0x1f00000000ffffULL;
+  v = (v | v << 16) & 0x1f0000ff0000ffULL;
+  v = (v | v << 8) & 0x100f00f00f00f00fULL;
+  v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+  v = (v | v << 2) & 0x1249249249249249ULL;
+  return v;
+}
+
+/**
+ * Octree stored as an array of nodes, built from bodies sorted by Morton key.
+ *
+ * Sorting by key puts the bodies of every octree cell next to each other, so
+ * a node only records its range of bodies, and its children are consecutive
+ * nodes. The tree is built one level at a time: the children of a node
+ * follow from binary searches for the octant digits of its keys, and the
+ * nodes of a level are independent, so no locks are needed. Centers of mass
+ * are then summarized bottom up, one level at a time.
+ *
+ * Cells with at most LEAF_SIZE bodies are leaves. Forces are computed for
+ * the bodies of a leaf together: one traversal with the opening criterion
+ * applied to the bounding box of the leaf collects the interactions of all
+ * its bodies, which are then evaluated over arrays of positions and masses
+ * that the compiler vectorizes.
+ */
+class LinearOctree {
+  static const unsigned MAX_DEPTH = 21; // key bits per dimension
+  static const unsigned LEAF_SIZE = 32;
+
+  struct LinearNode {
+    Point pos; // center of mass
+    double mass;
+    uint32_t begin; // bodies in key order
+    uint32_t end;
+    uint32_t firstChild;
+    uint8_t nChildren; // 0 for leaves
+    uint8_t level;
+  };
+
+  struct Interactions {
+    std::vector<double> x, y, z, mass;
+    std::vector<uint32_t> stack;
+
+    void clear() {
+      x.clear();
+      y.clear();
+      z.clear();
+      mass.clear();
+    }
+
+    void push(double px, double py, double pz, double m) {
+      x.push_back(px);
+      y.push_back(py);
+      z.push_back(pz);
+      mass.push_back(m);
+    }
+  };
+
+  std::vector<std::pair<uint64_t, Body*>> order;
+  std::vector<uint64_t> keys;
+  // positions and masses of the bodies in key order
+  std::vector<double> bx, by, bz, bmass;
+  std::vector<LinearNode> nodes;
+  // nodes of level l are [levels[l], levels[l + 1])
+  std::vector<uint32_t> levels;
+  std::vector<uint32_t> leaves;
+  galois::substrate::PerThreadStorage<Interactions> interactions;
+
+  static unsigned digit(uint64_t key, unsigned level) {
+    return (key >> (3 * (MAX_DEPTH - 1 - level))) & 7;
+  }
+
+  bool isLeaf(const LinearNode& node) const {
+    return node.end - node.begin <= LEAF_SIZE || node.level == MAX_DEPTH;
+  }
+
+  //! Calls fn(begin, end) for the range of each child of node
+  template <typename F>
+  void forEachChild(const LinearNode& node, const F& fn) const {
+    auto first = keys.begin() + node.begin;
+    auto last  = keys.begin() + node.end;
+    while (first != last) {
+      unsigned d = digit(*first, node.level);
+      auto next  = std::partition_point(first, last, [&](uint64_t k) {
+        return digit(k, node.level) <= d;
+      });
+      fn(first - keys.begin(), next - keys.begin());
+      first = next;
+    }
+  }
+
+  void sortBodies(BodyPtrs& pBodies, const BoundingBox& box, double side) {
+    // bodies move little in a step, so the order of the last step is kept
+    // as a nearly sorted starting point
+    if (order.empty())
+      for (Body* b : pBodies)
+        order.emplace_back(0, b);
+    size_t n = order.size();
+
+    // quantize positions to 21 bits per dimension within the bounding cube
+    double scale = double(1 << MAX_DEPTH) / side;
+    galois::do_all(galois::iterate(size_t{0}, n),
+                   [&](size_t i) {
+                     const Point& p = order[i].second->pos;
+                     uint64_t key   = 0;
+                     for (int d = 0; d < 3; ++d) {
+                       double q = (p[d] - box.min[d]) * scale;
+                       uint64_t c =
+                           std::min<uint64_t>(q > 0 ? q : 0, (1 << MAX_DEPTH) - 1);
+                       key |= spreadBits(c) << d;
+                     }
+                     order[i].first = key;
+                   },
+                   galois::loopname("MortonKeys"));
+
+    galois::ParallelSTL::sort(order.begin(), order.end());
+
+    keys.resize(n);
+    bx.resize(n);
+    by.resize(n);
+    bz.resize(n);
+    bmass.resize(n);
+    galois::do_all(galois::iterate(size_t{0}, n),
+                   [&](size_t i) {
+                     const Body* b = order[i].second;
+                     keys[i]       = order[i].first;
+                     bx[i]         = b->pos[0];
+                     by[i]         = b->pos[1];
+                     bz[i]         = b->pos[2];
+                     bmass[i]      = b->mass;
+                   },
+                   galois::loopname("GatherBodies"));
+  }
+
+  void buildLevels() {
+    nodes.clear();
+    levels.clear();
+    LinearNode root;
+    root.begin = 0;
+    root.end   = keys.size();
+    root.level = 0;
+    nodes.push_back(root);
+    levels.push_back(0);
+    levels.push_back(1);
+
+    for (unsigned l = 0; levels[l] != levels[l + 1]; ++l) {
+      uint32_t lb = levels[l];
+      uint32_t le = levels[l + 1];
+
+      galois::do_all(galois::iterate(lb, le),
+                     [&](uint32_t i) {
+                       LinearNode& node = nodes[i];
+                       node.nChildren   = 0;
+                       if (!isLeaf(node))
+                         forEachChild(node, [&](size_t, size_t) {
+                           ++node.nChildren;
+                         });
+                     },
+                     galois::steal(), galois::loopname("CountChildren"));
+
+      // children of a level go right after it, in the order of their parents
+      uint32_t next = le;
+      for (uint32_t i = lb; i < le; ++i) {
+        nodes[i].firstChild = next;
+        next += nodes[i].nChildren;
+      }
+      nodes.resize(next);
+
+      galois::do_all(galois::iterate(lb, le),
+                     [&](uint32_t i) {
+                       const LinearNode& node = nodes[i];
+                       uint32_t c             = node.firstChild;
+                       if (node.nChildren)
+                         forEachChild(node, [&](size_t b, size_t e) {
+                           LinearNode& child = nodes[c++];
+                           child.begin       = b;
+                           child.end         = e;
+                           child.level       = node.level + 1;
+                         });
+                     },
+                     galois::steal(), galois::loopname("LinkChildren"));
+      levels.push_back(next);
+    }
+  }
+
+  void summarize() {
+    for (size_t l = levels.size() - 1; l-- > 0;) {
+      galois::do_all(
+          galois::iterate(levels[l], levels[l + 1]),
+          [&](uint32_t i) {
+            LinearNode& node = nodes[i];
+            double mass      = 0.0;
+            Point accum;
+            if (node.nChildren) {
+              for (uint32_t c = node.firstChild;
+                   c < node.firstChild + node.nChildren; ++c) {
+                mass += nodes[c].mass;
+                accum += nodes[c].pos * nodes[c].mass;
+              }
+            } else {
+              for (uint32_t b = node.begin; b < node.end; ++b) {
+                mass += bmass[b];
+                accum += Point(bx[b], by[b], bz[b]) * bmass[b];
+              }
+            }
+            node.mass = mass;
+            if (mass > 0.0)
+              node.pos = accum / mass;
+          },
+          galois::loopname("Summarize"));
+    }
+  }
+
+  /**
+   * Collects the interactions of the bodies of leaf, whose bounding box is
+   * [lo, hi]: a node is summarized by its center of mass if that is far
+   * enough from every point of the box, and leaves that are too close
+   * contribute all their bodies (including those of leaf itself, which add
+   * nothing to their own force).
+   */
+  void gather(const Point& lo, const Point& hi, const double* levelDsq,
+              Interactions& list) const {
+    list.clear();
+    list.stack.clear();
+    list.stack.push_back(0);
+    while (!list.stack.empty()) {
+      const LinearNode& node = nodes[list.stack.back()];
+      list.stack.pop_back();
+
+      double psq = 0.0;
+      for (int d = 0; d < 3; ++d) {
+        double gap = std::max(lo[d] - node.pos[d], node.pos[d] - hi[d]);
+        if (gap > 0)
+          psq += gap * gap;
+      }
+
+      if (psq >= levelDsq[node.level]) {
+        list.push(node.pos[0], node.pos[1], node.pos[2], node.mass);
+      } else if (node.nChildren) {
+        for (uint32_t c = node.firstChild;
+             c < node.firstChild + node.nChildren; ++c)
+          list.stack.push_back(c);
+      } else {
+        for (uint32_t b = node.begin; b < node.end; ++b)
+          list.push(bx[b], by[b], bz[b], bmass[b]);
+      }
+    }
+  }
+
+public:
+  /**
+   * Builds the tree over the bodies in the cube of the given side whose
+   * lowest corner is the lower corner of box.
+   */
+  void build(BodyPtrs& pBodies, const BoundingBox& box, double side) {
+    galois::StatTimer T_sort("SortTime");
+    T_sort.start();
+    sortBodies(pBodies, box, side);
+    T_sort.stop();
+
+    galois::StatTimer T_build("BuildTime");
+    T_build.start();
+    buildLevels();
+    T_build.stop();
+
+    galois::timeThis([&](void) { summarize(); }, "summarize");
+
+    // leaves in key order, so that consecutive work items are close in space
+    leaves.clear();
+    for (uint32_t i = 0; i < nodes.size(); ++i)
+      if (!nodes[i].nChildren)
+        leaves.push_back(i);
+    galois::ParallelSTL::sort(leaves.begin(), leaves.end(),
+                              [&](uint32_t a, uint32_t b) {
+                                return nodes[a].begin < nodes[b].begin;
+                              });
+    std::cout << "Tree Size: " << nodes.size() << " nodes, " << leaves.size()
+              << " leaves\n";
+  }
+
+  const Point& centerOfMass() const { return nodes[0].pos; }
+
+  /**
+   * Computes the acceleration of every body and updates its velocity like
+   * ComputeForces.
+   */
+  void computeForces(double side) {
+    // the opening criterion of each level, for cells of side side / 2^level
+    double levelDsq[MAX_DEPTH + 1];
+    levelDsq[0] = side * side * config.itolsq;
+    for (unsigned l = 1; l <= MAX_DEPTH; ++l)
+      levelDsq[l] = levelDsq[l - 1] * 0.25;
+
+    galois::do_all(
+        galois::iterate(leaves),
+        [&](uint32_t leaf) {
+          const LinearNode& node = nodes[leaf];
+          Point lo(bx[node.begin], by[node.begin], bz[node.begin]);
+          Point hi(lo);
+          for (uint32_t b = node.begin + 1; b < node.end; ++b) {
+            lo.pairMin(Point(bx[b], by[b], bz[b]));
+            hi.pairMax(Point(bx[b], by[b], bz[b]));
+          }
+
+          Interactions& list = *interactions.getLocal();
+          gather(lo, hi, levelDsq, list);
+
+          const double* __restrict__ x = list.x.data();
+          const double* __restrict__ y = list.y.data();
+          const double* __restrict__ z = list.z.data();
+          const double* __restrict__ m = list.mass.data();
+          const size_t size            = list.x.size();
+          for (uint32_t b = node.begin; b < node.end; ++b) {
+            const double px = bx[b], py = by[b], pz = bz[b];
+            double ax = 0.0, ay = 0.0, az = 0.0;
+            // same as updateForce, over all interactions at once
+            for (size_t j = 0; j < size; ++j) {
+              double dx    = px - x[j];
+              double dy    = py - y[j];
+              double dz    = pz - z[j];
+              double psq   = dx * dx + dy * dy + dz * dz;
+              double idr   = 1 / sqrt((float)(psq + config.epssq));
+              double scale = m[j] * idr * idr * idr;
+              ax += dx * scale;
+              ay += dy * scale;
+              az += dz * scale;
+            }
+            Body* body = order[b].second;
+            Point p    = body->acc;
+            body->acc  = Point(ax, ay, az);
+            body->vel += (body->acc - p) * config.dthf;
+          }
+        },
+        galois::steal(), galois::loopname("compute"));
+  }
+};
+
 struct centerXCmp {
   template <typename T>
   bool operator()(const T& lhs, const T& rhs) const {
@@ -470,11 +824,55 @@ double checkAllPairs(Bodies& bodies, int N) {
          N;
 }
 
-void run(Bodies& bodies, BodyPtrs& pBodies, size_t nbodies) {
+/**
+ * Builds the pointer-based octree of the bodies, computes their forces by
+ * traversing it, and returns the center of mass of all bodies.
+ */
+Point computeForcesOctree(BodyPtrs& pBodies, const BoundingBox& box) {
   typedef galois::worklists::StableIterator<true> WLL;
 
+  Tree t;
+  BuildOctree treeBuilder{t};
+  Octree& top = t.emplace(box.center());
+
+  galois::StatTimer T_build("BuildTime");
+  T_build.start();
+  galois::do_all(
+      galois::iterate(pBodies),
+      [&](Body* body) { treeBuilder.insert(body, &top, box.radius()); },
+      galois::loopname("BuildTree"));
+  T_build.stop();
+
+  // update centers of mass in tree
+  galois::timeThis(
+      [&](void) {
+        unsigned size = computeCenterOfMass(&top);
+        // printTree(&top);
+        std::cout << "Tree Size: " << size << "\n";
+      },
+      "summarize-Serial");
+
+  ComputeForces cf(&top, box.diameter());
+
+  galois::StatTimer T_compute("ComputeTime");
+  T_compute.start();
+  galois::for_each(galois::iterate(pBodies),
+                   [&](Body* b, auto& cnx) { cf.computeForce(b, cnx); },
+                   galois::loopname("compute"), galois::wl<WLL>(),
+                   galois::no_conflicts(), galois::no_pushes(),
+                   galois::per_iter_alloc());
+  T_compute.stop();
+
+  return top.pos;
+}
+
+void run(Bodies& bodies, BodyPtrs& pBodies, size_t nbodies) {
+  LinearOctree linearTree;
+
+  // the linear octree lives in std::vectors, not in Galois pages
+  size_t treeBytes = algo == octree ? 3 * sizeof(Octree) : 0;
   galois::preAlloc(galois::getActiveThreads() +
-                   (3 * sizeof(Octree) + 2 * sizeof(Body)) * nbodies /
+                   (treeBytes + 2 * sizeof(Body)) * nbodies /
                        galois::runtime::pagePoolSize());
   galois::reportPageAlloc("MeminfoPre");
 
@@ -492,37 +890,22 @@ void run(Bodies& bodies, BodyPtrs& pBodies, size_t nbodies) {
     BoundingBox box = boxes.reduce(
         [](BoundingBox& lhs, BoundingBox& rhs) { lhs.merge(rhs); });
 
-    Tree t;
-    BuildOctree treeBuilder{t};
-    Octree& top = t.emplace(box.center());
-
-    galois::StatTimer T_build("BuildTime");
-    T_build.start();
-    galois::do_all(
-        galois::iterate(pBodies),
-        [&](Body* body) { treeBuilder.insert(body, &top, box.radius()); },
-        galois::loopname("BuildTree"));
-    T_build.stop();
-
-    // update centers of mass in tree
-    galois::timeThis(
-        [&](void) {
-          unsigned size = computeCenterOfMass(&top);
-          // printTree(&top);
-          std::cout << "Tree Size: " << size << "\n";
-        },
-        "summarize-Serial");
-
-    ComputeForces cf(&top, box.diameter());
-
-    galois::StatTimer T_compute("ComputeTime");
-    T_compute.start();
-    galois::for_each(galois::iterate(pBodies),
-                     [&](Body* b, auto& cnx) { cf.computeForce(b, cnx); },
-                     galois::loopname("compute"), galois::wl<WLL>(),
-                     galois::no_conflicts(), galois::no_pushes(),
-                     galois::per_iter_alloc());
-    T_compute.stop();
+    Point centerOfMass;
+    if (algo == morton) {
+      // the cube of the tree must contain every body
+      Point extent = box.max - box.min;
+      double side  = std::max(extent[0], std::max(extent[1], extent[2]));
+      side *= 1.0 + 1e-9;
+      linearTree.build(pBodies, box, side);
+
+      galois::StatTimer T_compute("ComputeTime");
+      T_compute.start();
+      linearTree.computeForces(side);
+      T_compute.stop();
+      centerOfMass = linearTree.centerOfMass();
+    } else {
+      centerOfMass = computeForcesOctree(pBodies, box);
+    }
 
     if (!skipVerify) {
       galois::timeThis(
@@ -549,7 +932,7 @@ void run(Bodies& bodies, BodyPtrs& pBodies, size_t nbodies) {
     std::ios::fmtflags flags =
         std::cout.setf(std::ios::showpos | std::ios::right |
                        std::ios::scientific | std::ios::showpoint);
-    std::cout << top.pos;
+    std::cout << centerOfMass;
     std::cout.flags(flags);
     std::cout << "\n";
   }
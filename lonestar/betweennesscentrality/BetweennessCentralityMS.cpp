@@ -0,0 +1,576 @@
+/*
+ * This file belongs to the Galois project, a C++ library for exploiting parallelism.
+ * The code is being released under the terms of the 3-Clause BSD License (a
+ * copy is located in LICENSE.txt at the top-level directory).
+ *
+ * Copyright (C) 2018, The University of Texas at Austin. All rights reserved.
+ * UNIVERSITY EXPRESSLY DISCLAIMS ANY AND ALL WARRANTIES CONCERNING THIS
+ * SOFTWARE AND DOCUMENTATION, INCLUDING ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR ANY PARTICULAR PURPOSE, NON-INFRINGEMENT AND WARRANTIES OF
+ * PERFORMANCE, AND ANY WARRANTY THAT MIGHT OTHERWISE ARISE FROM COURSE OF
+ * DEALING OR USAGE OF TRADE.  NO WARRANTY IS EITHER EXPRESS OR IMPLIED WITH
+ * RESPECT TO THE USE OF THE SOFTWARE OR DOCUMENTATION. Under no circumstances
+ * shall University be liable for incidental, special, indirect, direct or
+ * consequential damages or loss of profits, interruption of business, or
+ * related expenses which may arise from use of Software or Documentation,
+ * including but not limited to those resulting from defects in Software and/or
+ * Documentation, or loss or inaccuracy of data of any kind.
+ */
+
+constexpr static const char* const REGION_NAME = "BC";
+
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include "galois/gstl.h"
+#include "galois/LargeArray.h"
+#include "galois/Reduction.h"
+#include "galois/Timer.h"
+#include "galois/AtomicHelpers.h"
+#include "galois/graphs/LCGraph.h"
+#include "llvm/Support/CommandLine.h"
+#include "Lonestar/BoilerPlate.h"
+
+// type of the num shortest paths variable
+using ShortPathType = double;
+
+/******************************************************************************/
+/* Declaration of command line arguments */
+/******************************************************************************/
+namespace cll = llvm::cl;
+static cll::opt<std::string>
+    filename(cll::Positional, cll::desc("<input graph>"), cll::Required);
+static cll::opt<std::string>
+    sourcesToUse("sourcesToUse",
+                 cll::desc("Whitespace separated list of sources in a file to "
+                           "use in BC (default empty)"),
+                 cll::init(""));
+static cll::opt<bool>
+    singleSourceBC("singleSource",
+                   cll::desc("Use for single source BC (default off)"),
+                   cll::init(false));
+static cll::opt<unsigned long long>
+    startSource("startNode", // not uint64_t due to a bug in llvm cl
+                cll::desc("Starting source node used for "
+                          "betweeness-centrality (default 0); works with "
+                          "singleSource flag only"),
+                cll::init(0));
+static cll::opt<unsigned int>
+    numberOfSources("numOfSources",
+                    cll::desc("Number of sources to use for "
+                              "betweeness-centraility (default all)"),
+                    cll::init(0));
+static cll::opt<unsigned int>
+    sourcesPerBatch("sourcesPerBatch",
+                    cll::desc("Number of sources searched together, 64 or "
+                              "256 (default 64)"),
+                    cll::init(64));
+static cll::opt<bool> verify("verify",
+                             cll::desc("Flag to verify (default: false)"),
+                             cll::init(false));
+static cll::opt<std::string>
+    referenceOutput("referenceOutput",
+                    cll::desc("-verify output of another BC app (e.g., "
+                              "bc-level) on the same sources to compare "
+                              "against (default empty)"),
+                    cll::init(""));
+
+/******************************************************************************/
+/* Graph structure declarations */
+/******************************************************************************/
+using Graph = galois::graphs::LC_CSR_Graph<void, void>::
+                with_no_lockable<true>::type::with_numa_alloc<true>::type;
+using GNode = Graph::GraphNode;
+
+constexpr static const unsigned CHUNK_SIZE = 64u;
+
+//! Calls f(i) for every set bit i of word
+template <typename F>
+inline void forEachBit(uint64_t word, const F& f) {
+  while (word) {
+    f(__builtin_ctzll(word));
+    word &= word - 1;
+  }
+}
+
+/******************************************************************************/
+/* Functions for running the algorithm */
+/******************************************************************************/
+/**
+ * Multi-source BC (MS-BFS style, Then et al., VLDB'15): the BFSs of a batch
+ * of 64 * NumWords sources are run together. Every node carries a bitmask of
+ * the sources whose BFS reached it, so one scan of the edges of a frontier
+ * node advances all of those searches at once. Path counts and dependencies
+ * are kept per (node, source) pair. The backward Brandes pass walks the
+ * levels in reverse and, for each node, pulls the dependencies of the
+ * successors in the next level for all sources of the batch.
+ */
+template <unsigned NumWords>
+class MultiSourceBC {
+public:
+  constexpr static const unsigned BatchSize = 64 * NumWords;
+
+private:
+  using Mask = std::array<uint64_t, NumWords>;
+
+  //! A node in a BFS level and the sources for which it is at that level
+  struct Visit {
+    GNode node;
+    Mask sources;
+  };
+  using Level = galois::InsertBag<Visit>;
+
+  Graph& graph;
+  //! sources that have reached a node
+  galois::LargeArray<uint64_t> seen;
+  //! sources that reach a node in the next level
+  galois::LargeArray<std::atomic<uint64_t>> next;
+  //! sources for which a node is in the level after the one being processed
+  //! in the backward pass
+  galois::LargeArray<uint64_t> succ;
+  //! last level a node was added to; avoids duplicates in a level
+  galois::LargeArray<std::atomic<uint32_t>> addedAt;
+  galois::LargeArray<std::atomic<ShortPathType>> numShortestPaths;
+  galois::LargeArray<float> dependency;
+  galois::LargeArray<float> bc;
+
+  uint64_t* seenOf(GNode n) { return &seen[(size_t)n * NumWords]; }
+  uint64_t* succOf(GNode n) { return &succ[(size_t)n * NumWords]; }
+  std::atomic<uint64_t>* nextOf(GNode n) {
+    return &next[(size_t)n * NumWords];
+  }
+  size_t slot(GNode n, unsigned source) {
+    return (size_t)n * BatchSize + source;
+  }
+
+  /**
+   * Forward phase: level-synchronous BFS from all sources of the batch.
+   * Saves the levels for the backward phase.
+   */
+  void forward(galois::gstl::Vector<Level>& levels) {
+    uint32_t currentLevel = 0;
+
+    while (!levels[currentLevel].empty()) {
+      levels.emplace_back();
+      uint32_t nextLevel = currentLevel + 1;
+      Level& nextVisits  = levels[nextLevel];
+
+      galois::InsertBag<GNode> reached;
+
+      galois::do_all(
+        galois::iterate(levels[currentLevel]),
+        [&] (const Visit& v) {
+          for (auto e : graph.edges(v.node)) {
+            GNode dest = graph.getEdgeDst(e);
+            uint64_t* destSeen = seenOf(dest);
+
+            // searches that reach dest for the first time
+            Mask fresh;
+            uint64_t any = 0;
+            for (unsigned w = 0; w < NumWords; ++w) {
+              fresh[w] = v.sources[w] & ~destSeen[w];
+              any |= fresh[w];
+            }
+            if (!any) {
+              continue;
+            }
+
+            std::atomic<uint64_t>* destNext = nextOf(dest);
+            for (unsigned w = 0; w < NumWords; ++w) {
+              if (fresh[w]) {
+                destNext[w].fetch_or(fresh[w], std::memory_order_relaxed);
+                forEachBit(fresh[w], [&] (unsigned bit) {
+                  unsigned s = w * 64 + bit;
+                  galois::atomicAdd(numShortestPaths[slot(dest, s)],
+                                    numShortestPaths[slot(v.node, s)].load());
+                });
+              }
+            }
+
+            if (addedAt[dest].exchange(nextLevel) != nextLevel) {
+              reached.emplace(dest);
+            }
+          }
+        },
+        galois::steal(),
+        galois::chunk_size<CHUNK_SIZE>(),
+        galois::no_stats(),
+        galois::loopname("MSBFS")
+      );
+
+      // nodes reached in this level become the next frontier
+      galois::do_all(
+        galois::iterate(reached),
+        [&] (GNode n) {
+          Visit v;
+          v.node = n;
+          uint64_t* nSeen = seenOf(n);
+          std::atomic<uint64_t>* nNext = nextOf(n);
+          for (unsigned w = 0; w < NumWords; ++w) {
+            v.sources[w] = nNext[w].exchange(0, std::memory_order_relaxed);
+            nSeen[w] |= v.sources[w];
+          }
+          nextVisits.push(v);
+        },
+        galois::no_stats(),
+        galois::loopname("MSBFSNextFrontier")
+      );
+
+      currentLevel++;
+    }
+  }
+
+  /**
+   * Marks (or clears) in succ the sources for which the nodes of a level are
+   * at that level.
+   */
+  void markLevel(Level& level, bool set) {
+    galois::do_all(
+      galois::iterate(level),
+      [&] (const Visit& v) {
+        uint64_t* vSucc = succOf(v.node);
+        for (unsigned w = 0; w < NumWords; ++w) {
+          vSucc[w] = set ? v.sources[w] : 0;
+        }
+      },
+      galois::no_stats(),
+      galois::loopname("MarkLevel")
+    );
+  }
+
+  /**
+   * Backward phase: Brandes dependency propagation for all sources of the
+   * batch, one level at a time. Level 0 only has the sources themselves.
+   */
+  void backward(galois::gstl::Vector<Level>& levels) {
+    // the last level is empty
+    if (levels.size() < 3) {
+      return;
+    }
+
+    markLevel(levels[levels.size() - 2], true);
+
+    for (size_t currentLevel = levels.size() - 3; currentLevel > 0;
+         --currentLevel) {
+      galois::do_all(
+        galois::iterate(levels[currentLevel]),
+        [&] (const Visit& v) {
+          for (auto e : graph.edges(v.node)) {
+            GNode dest = graph.getEdgeDst(e);
+            uint64_t* destSucc = succOf(dest);
+
+            for (unsigned w = 0; w < NumWords; ++w) {
+              forEachBit(v.sources[w] & destSucc[w], [&] (unsigned bit) {
+                unsigned s = w * 64 + bit;
+                dependency[slot(v.node, s)] +=
+                    ((float)1 + dependency[slot(dest, s)]) /
+                    numShortestPaths[slot(dest, s)];
+              });
+            }
+          }
+
+          // multiply at end to get final dependency values and accumulate
+          // them into bc
+          float sum = 0;
+          for (unsigned w = 0; w < NumWords; ++w) {
+            forEachBit(v.sources[w], [&] (unsigned bit) {
+              unsigned s = w * 64 + bit;
+              float& d = dependency[slot(v.node, s)];
+              d *= numShortestPaths[slot(v.node, s)];
+              sum += d;
+            });
+          }
+          bc[v.node] += sum;
+        },
+        galois::steal(),
+        galois::chunk_size<CHUNK_SIZE>(),
+        galois::no_stats(),
+        galois::loopname("MSBrandes")
+      );
+
+      markLevel(levels[currentLevel + 1], false);
+      markLevel(levels[currentLevel], true);
+    }
+
+    markLevel(levels[1], false);
+  }
+
+  /**
+   * Resets the state of the nodes reached by the batch.
+   */
+  void reset(galois::gstl::Vector<Level>& levels) {
+    for (Level& level : levels) {
+      galois::do_all(
+        galois::iterate(level),
+        [&] (const Visit& v) {
+          uint64_t* vSeen = seenOf(v.node);
+          for (unsigned w = 0; w < NumWords; ++w) {
+            vSeen[w] = 0;
+            forEachBit(v.sources[w], [&] (unsigned bit) {
+              unsigned s = w * 64 + bit;
+              numShortestPaths[slot(v.node, s)] = 0;
+              dependency[slot(v.node, s)]       = 0;
+            });
+          }
+          addedAt[v.node] = 0;
+        },
+        galois::no_stats(),
+        galois::loopname("ResetBatch")
+      );
+    }
+  }
+
+public:
+  MultiSourceBC(Graph& g) : graph(g) {
+    size_t numNodes = graph.size();
+    seen.create(numNodes * NumWords, 0);
+    next.create(numNodes * NumWords, 0);
+    succ.create(numNodes * NumWords, 0);
+    addedAt.create(numNodes, 0);
+    numShortestPaths.create(numNodes * BatchSize, 0);
+    dependency.create(numNodes * BatchSize, 0);
+    bc.create(numNodes, 0);
+  }
+
+  /**
+   * Adds the BC contributions of up to BatchSize sources.
+   */
+  void runBatch(const uint64_t* sources, size_t numSources) {
+    assert(numSources <= BatchSize);
+
+    galois::gstl::Vector<Level> levels;
+    levels.emplace_back();
+
+    // level 0; a node may be given more than once as a source
+    for (unsigned s = 0; s < numSources; ++s) {
+      GNode src = sources[s];
+      uint64_t* srcSeen = seenOf(src);
+      bool first = true;
+      for (unsigned w = 0; w < NumWords; ++w) {
+        first &= !srcSeen[w];
+      }
+      srcSeen[s / 64] |= (uint64_t)1 << (s % 64);
+      numShortestPaths[slot(src, s)] = 1;
+      if (first) {
+        Visit v;
+        v.node = src;
+        levels[0].push(v);
+      }
+    }
+    for (Visit& v : levels[0]) {
+      uint64_t* srcSeen = seenOf(v.node);
+      std::copy(srcSeen, srcSeen + NumWords, v.sources.begin());
+    }
+
+    forward(levels);
+    backward(levels);
+    reset(levels);
+  }
+
+  float getBC(GNode n) const { return bc[n]; }
+};
+
+/******************************************************************************/
+/* Sanity check */
+/******************************************************************************/
+
+/**
+ * Get some sanity numbers (max, min, sum of BC)
+ *
+ * @param graph Graph to sanity check
+ * @param bc BC values to check
+ */
+template <typename BC>
+void Sanity(Graph& graph, BC& bc) {
+  galois::GReduceMax<float> accumMax;
+  galois::GReduceMin<float> accumMin;
+  galois::GAccumulator<float> accumSum;
+  accumMax.reset();
+  accumMin.reset();
+  accumSum.reset();
+
+  // get max, min, sum of BC values using accumulators and reducers
+  galois::do_all(
+    galois::iterate(graph),
+    [&] (GNode n) {
+      accumMax.update(bc.getBC(n));
+      accumMin.update(bc.getBC(n));
+      accumSum += bc.getBC(n);
+    },
+    galois::no_stats(),
+    galois::loopname("Sanity")
+  );
+
+  galois::gPrint("Max BC is ", accumMax.reduce(), "\n");
+  galois::gPrint("Min BC is ", accumMin.reduce(), "\n");
+  galois::gPrint("BC sum is ", accumSum.reduce(), "\n");
+}
+
+/**
+ * Compare BC values with the -verify output of another BC implementation.
+ * Lines of the output that are not "node bc" pairs are ignored.
+ *
+ * @param graph Graph BC was computed on
+ * @param bc BC values to check
+ * @param file file with the reference output
+ */
+template <typename BC>
+void CheckReference(Graph& graph, BC& bc, const std::string& file) {
+  std::ifstream refFile(file);
+  if (!refFile) {
+    GALOIS_DIE("Could not open reference output ", file);
+  }
+
+  size_t numChecked = 0;
+  std::string line;
+  while (std::getline(refFile, line)) {
+    unsigned node;
+    float refBC;
+    char rest;
+    if (sscanf(line.c_str(), "%u %f %c", &node, &refBC, &rest) != 2) {
+      continue;
+    }
+    if (node >= graph.size()) {
+      GALOIS_DIE("Reference node ", node, " is not a node of the graph");
+    }
+    // the apps accumulate in different orders, so allow float rounding
+    float diff = std::fabs(bc.getBC(node) - refBC);
+    if (diff > 1e-4f * std::max(1.0f, std::fabs(refBC))) {
+      GALOIS_DIE("BC of node ", node, " is ", bc.getBC(node),
+                 " but the reference has ", refBC);
+    }
+    numChecked++;
+  }
+
+  if (numChecked != graph.size()) {
+    GALOIS_DIE("Reference has ", numChecked, " of ", graph.size(), " nodes");
+  }
+  galois::gPrint("BC matches the reference on all ", numChecked, " nodes\n");
+}
+
+/**
+ * Runs BC over the sources in batches and reports the results.
+ *
+ * @param graph Graph to run on
+ * @param sources sources to use
+ */
+template <unsigned NumWords>
+void run(Graph& graph, const std::vector<uint64_t>& sources) {
+  using BC = MultiSourceBC<NumWords>;
+  BC bc(graph);
+
+  galois::gInfo("Beginning main computation with ", BC::BatchSize,
+                " sources per batch");
+  galois::StatTimer runtimeTimer;
+
+  uint64_t numBatches = 0;
+  for (size_t i = 0; i < sources.size(); i += BC::BatchSize) {
+    size_t numSources =
+        std::min(sources.size() - i, (size_t)BC::BatchSize);
+    runtimeTimer.start();
+    bc.runBatch(&sources[i], numSources);
+    runtimeTimer.stop();
+    numBatches++;
+  }
+  galois::runtime::reportStat_Single(REGION_NAME, "Batches", numBatches);
+
+  // sanity checking numbers
+  Sanity(graph, bc);
+
+  if (referenceOutput != "") {
+    CheckReference(graph, bc, referenceOutput);
+  }
+
+  // Verify, i.e. print out graph data for examination
+  if (verify) {
+    char* v_out = (char*)malloc(40);
+    for (auto ii = graph.begin(); ii != graph.end(); ++ii) {
+      // outputs betweenness centrality
+      sprintf(v_out, "%u %.9f\n", (*ii), bc.getBC(*ii));
+      galois::gPrint(v_out);
+    }
+    free(v_out);
+  }
+}
+
+/******************************************************************************/
+/* Main method for running */
+/******************************************************************************/
+constexpr static const char* const name =
+    "Betweeness Centrality Multi-Source";
+constexpr static const char* const desc =
+    "Betweeness Centrality over batches of sources, using bit-parallel "
+    "multi-source BFS and batched Brandes backward dependency propagation.";
+
+int main(int argc, char** argv) {
+  galois::SharedMemSys G;
+  LonestarStart(argc, argv, name, desc, NULL);
+
+  if (sourcesPerBatch != 64 && sourcesPerBatch != 256) {
+    GALOIS_DIE("sourcesPerBatch must be 64 or 256");
+  }
+
+  // some initial stat reporting
+  galois::gInfo("Worklist chunk size of ", CHUNK_SIZE, ": best size may depend"
+                " on input.");
+  galois::runtime::reportStat_Single(REGION_NAME, "ChunkSize", CHUNK_SIZE);
+  galois::reportPageAlloc("MemAllocPre");
+
+  galois::StatTimer totalTimer("TimerTotal", REGION_NAME);
+  totalTimer.start();
+
+  // Graph construction
+  galois::StatTimer graphConstructTimer("TimerConstructGraph", REGION_NAME);
+  graphConstructTimer.start();
+  Graph graph;
+  galois::graphs::readGraph(graph, filename);
+  graphConstructTimer.stop();
+  galois::gInfo("Graph construction complete");
+
+  // preallocate pages in memory so allocation doesn't occur during compute
+  galois::StatTimer preallocTime("PreAllocTime", REGION_NAME);
+  preallocTime.start();
+  galois::preAlloc(std::max(
+    (size_t)galois::getActiveThreads() * (graph.size() / 2000000),
+    std::max(10u, galois::getActiveThreads()) * (size_t)10
+  ));
+  preallocTime.stop();
+  galois::reportPageAlloc("MemAllocMid");
+
+  // determine the sources based on command line args
+  std::vector<uint64_t> sources;
+  if (singleSourceBC) {
+    sources.push_back(startSource);
+  } else if (sourcesToUse != "") {
+    std::ifstream sourceFile(sourcesToUse);
+    sources.assign(std::istream_iterator<uint64_t>{sourceFile},
+                   std::istream_iterator<uint64_t>{});
+    if (numberOfSources && numberOfSources < sources.size()) {
+      sources.resize(numberOfSources);
+    }
+  } else {
+    uint64_t loop_end = numberOfSources ? numberOfSources : graph.size();
+    for (uint64_t i = 0; i < loop_end; i++) {
+      sources.push_back(i);
+    }
+  }
+
+  for (uint64_t s : sources) {
+    if (s >= graph.size()) {
+      GALOIS_DIE("Source ", s, " is not a node of the graph");
+    }
+  }
+
+  if (sourcesPerBatch == 64) {
+    run<1>(graph, sources);
+  } else {
+    run<4>(graph, sources);
+  }
+
+  totalTimer.stop();
+  galois::reportPageAlloc("MemAllocPost");
+
+  return 0;
+}
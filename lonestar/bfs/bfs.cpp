@@ -22,7 +22,9 @@
 #include "galois/Reduction.h"
 #include "galois/Timer.h"
 #include "galois/Timer.h"
+#include "galois/Frontier.h"
 #include "galois/graphs/LCGraph.h"
+#include "galois/graphs/Reorder.h"
 #include "galois/graphs/TypeTraits.h"
 #include "llvm/Support/CommandLine.h"
 
@@ -55,16 +57,30 @@ static cll::opt<unsigned int>
     reportNode("reportNode",
                cll::desc("Node to report distance to (default value 1)"),
                cll::init(1));
+static cll::opt<bool> symmetricGraph(
+    "symmetricGraph",
+    cll::desc("Input graph is symmetric, which lets SyncFrontier pull on "
+              "large levels (default value false)"),
+    cll::init(false));
 // static cll::opt<unsigned int> stepShiftw("delta",
 // cll::desc("Shift value for the deltastep"),
 // cll::init(10));
 
 enum Exec { SERIAL, PARALLEL };
 
-enum Algo { AsyncTile = 0, Async, SyncTile, Sync, Sync2pTile, Sync2p };
+enum Algo {
+  AsyncTile = 0,
+  Async,
+  SyncTile,
+  Sync,
+  Sync2pTile,
+  Sync2p,
+  SyncFrontier
+};
 
-const char* const ALGO_NAMES[] = {"AsyncTile", "Async",      "SyncTile",
-                                  "Sync",      "Sync2pTile", "Sync2p"};
+const char* const ALGO_NAMES[] = {"AsyncTile",  "Async",  "SyncTile",
+                                  "Sync",       "Sync2pTile", "Sync2p",
+                                  "SyncFrontier"};
 
 static cll::opt<Exec> execution(
     "exec",
@@ -78,9 +94,24 @@ static cll::opt<Algo> algo(
     cll::values(clEnumVal(AsyncTile, "AsyncTile"), clEnumVal(Async, "Async"),
                 clEnumVal(SyncTile, "SyncTile"), clEnumVal(Sync, "Sync"),
                 clEnumVal(Sync2pTile, "Sync2pTile"),
-                clEnumVal(Sync2p, "Sync2p"), clEnumValEnd),
+                clEnumVal(Sync2p, "Sync2p"),
+                clEnumVal(SyncFrontier, "SyncFrontier"), clEnumValEnd),
     cll::init(SyncTile));
 
+enum Reorder { NoReorder = 0, Degree, Hub, RCM, Gorder };
+
+static cll::opt<Reorder> reorderAlgo(
+    "reorder",
+    cll::desc("Relabel the nodes for locality before running (default "
+              "value NoReorder); node ids in options and output stay the "
+              "original ones:"),
+    cll::values(clEnumVal(NoReorder, "NoReorder"),
+                clEnumVal(Degree, "decreasing degree"),
+                clEnumVal(Hub, "hub clustering"),
+                clEnumVal(RCM, "reverse Cuthill-McKee"),
+                clEnumVal(Gorder, "windowed Gorder"), clEnumValEnd),
+    cll::init(NoReorder));
+
 using Graph =
     galois::graphs::LC_CSR_Graph<unsigned, void>::with_no_lockable<true>::type;
 //::with_numa_alloc<true>::type;
@@ -355,6 +386,56 @@ void sync2phaseAlgo(Graph& graph, GNode source, const P& pushWrap,
   }
 }
 
+//! Level-synchronous BFS with galois::for_each_frontier, which keeps small
+//! levels as per-thread vectors and large ones as a bitset. On symmetric
+//! graphs (-symmetricGraph), levels reached by many edges are found by
+//! pulling instead: unvisited nodes look for a neighbor in the current level.
+//! Always runs with Galois loops; use -t 1 for a serial run.
+void syncFrontierAlgo(Graph& graph, GNode source) {
+
+  constexpr galois::MethodFlag flag = galois::MethodFlag::UNPROTECTED;
+  using Context                     = galois::FrontierContext<GNode>;
+
+  graph.getData(source, flag) = 0u;
+
+  auto push = [&](const GNode& src, const Context& next) {
+    Dist nextLevel = next.round() + 1;
+    for (auto e : graph.edges(src, flag)) {
+      auto dst      = graph.getEdgeDst(e);
+      auto& dstData = graph.getData(dst, flag);
+
+      if (dstData == BFS::DIST_INFINITY) {
+        dstData = nextLevel;
+        next.push(dst);
+      }
+    }
+  };
+
+  auto pull = [&](const GNode& dst, const Context& curr) {
+    auto& dstData = graph.getData(dst, flag);
+    if (dstData != BFS::DIST_INFINITY)
+      return false;
+    for (auto e : graph.edges(dst, flag)) {
+      if (curr.contains(graph.getEdgeDst(e))) {
+        dstData = curr.round() + 1;
+        return true;
+      }
+    }
+    return false;
+  };
+
+  if (symmetricGraph) {
+    galois::for_each_frontier(
+        graph, galois::iterate({source}), push,
+        galois::make_trait_with_args<galois::pull_op>(pull),
+        galois::chunk_size<CHUNK_SIZE>(), galois::loopname("SyncFrontier"));
+  } else {
+    galois::for_each_frontier(graph, galois::iterate({source}), push,
+                              galois::chunk_size<CHUNK_SIZE>(),
+                              galois::loopname("SyncFrontier"));
+  }
+}
+
 template <bool CONCURRENT>
 void runAlgo(Graph& graph, const GNode& source) {
 
@@ -383,6 +464,9 @@ void runAlgo(Graph& graph, const GNode& source) {
     sync2phaseAlgo<CONCURRENT>(graph, source, OneTilePushWrap{graph},
                                TileRangeFn());
     break;
+  case SyncFrontier:
+    syncFrontierAlgo(graph, source);
+    break;
   default:
     std::cerr << "ERROR: unkown algo type" << std::endl;
   }
@@ -407,11 +491,39 @@ int main(int argc, char** argv) {
     abort();
   }
 
+  galois::graphs::NodeRelabeling relabeling;
+  switch (reorderAlgo) {
+  case NoReorder:
+    break;
+  case Degree:
+    relabeling =
+        galois::graphs::reorder(graph, galois::graphs::ReorderAlgo::DEGREE);
+    break;
+  case Hub:
+    relabeling =
+        galois::graphs::reorder(graph, galois::graphs::ReorderAlgo::HUB);
+    break;
+  case RCM:
+    relabeling =
+        galois::graphs::reorder(graph, galois::graphs::ReorderAlgo::RCM);
+    break;
+  case Gorder:
+    relabeling =
+        galois::graphs::reorder(graph, galois::graphs::ReorderAlgo::GORDER);
+    break;
+  default:
+    std::cerr << "Unknown reordering\n";
+    abort();
+  }
+  auto relabel = [&](unsigned int n) {
+    return relabeling.newId.empty() ? n : relabeling.newId[n];
+  };
+
   auto it = graph.begin();
-  std::advance(it, startNode);
+  std::advance(it, relabel(startNode));
   source = *it;
   it     = graph.begin();
-  std::advance(it, reportNode);
+  std::advance(it, relabel(reportNode));
   report = *it;
 
   size_t approxNodeData = 4 * (graph.size() + graph.sizeEdges());
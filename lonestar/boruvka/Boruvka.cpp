@@ -18,6 +18,7 @@
  */
 
 #include "galois/Galois.h"
+#include "galois/AtomicHelpers.h"
 #include "galois/Reduction.h"
 #include "galois/Bag.h"
 #include "galois/Timer.h"
@@ -37,6 +38,9 @@
 #include <utility>
 #include <algorithm>
 #include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
 
 namespace cll = llvm::cl;
 
@@ -44,7 +48,7 @@ static const char* name = "Boruvka's Minimum Spanning Tree Algorithm";
 static const char* desc = "Computes the minimum spanning forest of a graph";
 static const char* url  = "mst";
 
-enum Algo { parallel, exp_parallel };
+enum Algo { parallel, exp_parallel, contract, filterKruskal };
 
 static cll::opt<std::string>
     inputFilename(cll::Positional, cll::desc("<input file>"), cll::Required);
@@ -58,6 +62,8 @@ static cll::opt<Algo>
 #ifdef GALOIS_USE_EXP
                      clEnumVal(exp_parallel, "Parallel (exp)"),
 #endif
+                     clEnumVal(contract, "Boruvka with edge-array contraction"),
+                     clEnumVal(filterKruskal, "Filter-Kruskal"),
                      clEnumValEnd),
          cll::init(parallel));
 
@@ -86,12 +92,88 @@ struct Edge {
       : src(s), dst(d), weight(w) {}
 };
 
+/**
+ * Input graph, spanning forest and verification shared by all algorithms.
+ */
+struct MSTBase {
+  Graph graph;
+  galois::InsertBag<Edge> mst;
+
+  void readInput() {
+    galois::graphs::FileGraph origGraph;
+    galois::graphs::FileGraph symGraph;
+
+    origGraph.fromFileInterleaved<EdgeData>(inputFilename);
+    if (!symmetricGraph)
+      galois::graphs::makeSymmetric<EdgeData>(origGraph, symGraph);
+    else
+      std::swap(symGraph, origGraph);
+
+    galois::graphs::readGraph(graph, symGraph);
+  }
+
+  bool checkAcyclic(void) {
+    galois::GAccumulator<unsigned> roots;
+
+    galois::do_all(galois::iterate(graph), [&roots, this](const GNode& n) {
+      const auto& data = graph.getData(n, galois::MethodFlag::UNPROTECTED);
+      if (data.isRep())
+        roots += 1;
+    });
+
+    unsigned numRoots = roots.reduce();
+    unsigned numEdges = std::distance(mst.begin(), mst.end());
+
+    if (graph.size() - numRoots != numEdges) {
+      std::cerr << "Generated graph is not a forest. "
+                << "Expected " << graph.size() - numRoots << " edges but "
+                << "found " << numEdges << "\n";
+      return false;
+    }
+
+    std::cout << "Num trees: " << numRoots << "\n";
+    std::cout << "Tree edges: " << numEdges << "\n";
+    return true;
+  }
+
+  bool verify() {
+
+    auto is_bad_graph = [this](const GNode& n) {
+      Node& me = graph.getData(n);
+      for (auto ii : graph.edges(n)) {
+        GNode dst  = graph.getEdgeDst(ii);
+        Node& data = graph.getData(dst);
+        if (me.findAndCompress() != data.findAndCompress()) {
+          std::cerr << "not in same component: " << me << " and " << data
+                    << "\n";
+          return true;
+        }
+      }
+      return false;
+    };
+
+    auto is_bad_mst = [this](const Edge& e) {
+      return graph.getData(e.src).findAndCompress() !=
+             graph.getData(e.dst).findAndCompress();
+    };
+
+    if (galois::ParallelSTL::find_if(graph.begin(), graph.end(),
+                                     is_bad_graph) == graph.end()) {
+      if (galois::ParallelSTL::find_if(mst.begin(), mst.end(), is_bad_mst) ==
+          mst.end()) {
+        return checkAcyclic();
+      }
+    }
+    return false;
+  }
+};
+
 /**
  * Boruvka's algorithm. Implemented bulk-synchronously in order to avoid the
  * need to merge edge lists.
  */
 template <bool useExp>
-struct ParallelAlgo {
+struct ParallelAlgo : public MSTBase {
   struct WorkItem {
     Edge edge;
     int cur;
@@ -101,14 +183,11 @@ struct ParallelAlgo {
 
   typedef galois::InsertBag<WorkItem> WL;
 
-  Graph graph;
-
   WL wls[3];
   WL* current;
   WL* next;
   WL* pending;
   EdgeData limit;
-  galois::InsertBag<Edge> mst;
   EdgeData inf;
   EdgeData heaviest;
 
@@ -312,30 +391,6 @@ struct ParallelAlgo {
     }
   }
 
-  bool checkAcyclic(void) {
-    galois::GAccumulator<unsigned> roots;
-
-    galois::do_all(galois::iterate(graph), [&roots, this](const GNode& n) {
-      const auto& data = graph.getData(n, galois::MethodFlag::UNPROTECTED);
-      if (data.isRep())
-        roots += 1;
-    });
-
-    unsigned numRoots = roots.reduce();
-    unsigned numEdges = std::distance(mst.begin(), mst.end());
-
-    if (graph.size() - numRoots != numEdges) {
-      std::cerr << "Generated graph is not a forest. "
-                << "Expected " << graph.size() - numRoots << " edges but "
-                << "found " << numEdges << "\n";
-      return false;
-    }
-
-    std::cout << "Num trees: " << numRoots << "\n";
-    std::cout << "Tree edges: " << numEdges << "\n";
-    return true;
-  }
-
   EdgeData sortEdges() {
 
     galois::GReduceMax<EdgeData> heavy;
@@ -360,48 +415,8 @@ struct ParallelAlgo {
     return heavy.reduce();
   }
 
-  bool verify() {
-
-    auto is_bad_graph = [this](const GNode& n) {
-      Node& me = graph.getData(n);
-      for (auto ii : graph.edges(n)) {
-        GNode dst  = graph.getEdgeDst(ii);
-        Node& data = graph.getData(dst);
-        if (me.findAndCompress() != data.findAndCompress()) {
-          std::cerr << "not in same component: " << me << " and " << data
-                    << "\n";
-          return true;
-        }
-      }
-      return false;
-    };
-
-    auto is_bad_mst = [this](const Edge& e) {
-      return graph.getData(e.src).findAndCompress() !=
-             graph.getData(e.dst).findAndCompress();
-    };
-
-    if (galois::ParallelSTL::find_if(graph.begin(), graph.end(),
-                                     is_bad_graph) == graph.end()) {
-      if (galois::ParallelSTL::find_if(mst.begin(), mst.end(), is_bad_mst) ==
-          mst.end()) {
-        return checkAcyclic();
-      }
-    }
-    return false;
-  }
-
   void initializeGraph() {
-    galois::graphs::FileGraph origGraph;
-    galois::graphs::FileGraph symGraph;
-
-    origGraph.fromFileInterleaved<EdgeData>(inputFilename);
-    if (!symmetricGraph)
-      galois::graphs::makeSymmetric<EdgeData>(origGraph, symGraph);
-    else
-      std::swap(symGraph, origGraph);
-
-    galois::graphs::readGraph(graph, symGraph);
+    readInput();
 
     galois::StatTimer Tsort("InitializeSortTime");
     Tsort.start();
@@ -419,6 +434,328 @@ struct ParallelAlgo {
   }
 };
 
+/**
+ * Undirected edge of the edge-array algorithms. The endpoints are nodes of
+ * the graph, or components after contraction; node is the source of the edge
+ * in the graph (it fills what would be padding) and id its position there.
+ */
+struct ArrayEdge {
+  uint32_t src;
+  uint32_t dst;
+  EdgeData weight;
+  uint32_t node;
+  uint64_t id;
+};
+
+//! strict total order on edges: by weight, ties broken by position in graph
+static bool lighterEdge(const ArrayEdge& a, const ArrayEdge& b) {
+  return a.weight < b.weight || (a.weight == b.weight && a.id < b.id);
+}
+
+/**
+ * Base of the algorithms that work on an array holding every undirected edge
+ * once instead of on the graph.
+ */
+struct EdgeArrayAlgo : public MSTBase {
+  galois::LargeArray<ArrayEdge> edges;
+  size_t numEdges;
+
+  void initializeGraph() {
+    readInput();
+    std::cout << "Nodes: " << graph.size() << " edges: " << graph.sizeEdges()
+              << "\n";
+  }
+
+  //! copies each edge (src, dst) with src < dst to the edge array
+  void buildEdgeArray() {
+    galois::LargeArray<uint64_t> offsets;
+    offsets.allocateInterleaved(graph.size());
+
+    galois::do_all(galois::iterate(graph),
+                   [&](const GNode& src) {
+                     uint64_t count = 0;
+                     for (auto ii :
+                          graph.edges(src, galois::MethodFlag::UNPROTECTED))
+                       count += src < graph.getEdgeDst(ii);
+                     offsets[src] = count;
+                   },
+                   galois::steal(), galois::loopname("CountEdges"));
+    galois::ParallelSTL::partial_sum(offsets.begin(), offsets.end(),
+                                     offsets.begin());
+    numEdges = graph.size() ? offsets[graph.size() - 1] : 0;
+
+    edges.allocateInterleaved(numEdges);
+    galois::do_all(
+        galois::iterate(graph),
+        [&](const GNode& src) {
+          uint64_t pos = src ? offsets[src - 1] : 0;
+          for (auto ii : graph.edges(src, galois::MethodFlag::UNPROTECTED)) {
+            GNode dst = graph.getEdgeDst(ii);
+            if (src < dst)
+              edges[pos++] =
+                  ArrayEdge{src, dst, graph.getEdgeData(ii), src, *ii};
+          }
+        },
+        galois::steal(), galois::loopname("BuildEdgeArray"));
+  }
+
+  bool verify() {
+    // the union-find in the nodes is not used by these algorithms; build the
+    // components of the forest from its edges for the checks
+    galois::do_all(galois::iterate(mst), [this](const Edge& e) {
+      graph.getData(e.src).merge(&graph.getData(e.dst));
+    });
+    return MSTBase::verify();
+  }
+};
+
+/**
+ * Boruvka's algorithm with explicit contraction. Each round finds the
+ * lightest edge of every component, hooks components along those edges,
+ * shortcuts the resulting trees to their roots and relabels the roots
+ * densely. The edges that still join different components are then compacted
+ * into a new edge array (count per block, prefix sum, scatter), so later
+ * rounds only scan live edges instead of rescanning the whole graph.
+ */
+struct ContractAlgo : public EdgeArrayAlgo {
+  static constexpr uint64_t NONE = std::numeric_limits<uint64_t>::max();
+
+  //! key of the edge at pos ordered like lighterEdge; the position in the
+  //! edge array is unique per round and follows graph order
+  static uint64_t edgeKey(EdgeData weight, size_t pos) {
+    uint32_t w = static_cast<uint32_t>(weight) ^ 0x80000000u;
+    return (static_cast<uint64_t>(w) << 32) | pos;
+  }
+
+  void operator()() {
+    buildEdgeArray();
+    if (numEdges >= std::numeric_limits<uint32_t>::max())
+      GALOIS_DIE("too many edges for contraction");
+
+    uint32_t numComponents = graph.size();
+    galois::LargeArray<std::atomic<uint64_t>> lightest;
+    galois::LargeArray<uint32_t> parents[2];
+    galois::LargeArray<uint32_t> labels;
+    galois::LargeArray<ArrayEdge> compacted;
+    lightest.allocateInterleaved(numComponents);
+    parents[0].allocateInterleaved(numComponents);
+    parents[1].allocateInterleaved(numComponents);
+    labels.allocateInterleaved(numComponents);
+
+    ArrayEdge* cur  = edges.data();
+    ArrayEdge* next = nullptr;
+    size_t rounds   = 0;
+
+    while (numEdges) {
+      rounds += 1;
+
+      galois::do_all(galois::iterate(0u, numComponents),
+                     [&](uint32_t c) { lightest[c] = NONE; },
+                     galois::no_stats());
+      galois::do_all(galois::iterate(size_t{0}, numEdges),
+                     [&](size_t pos) {
+                       const ArrayEdge& e = cur[pos];
+                       uint64_t key       = edgeKey(e.weight, pos);
+                       galois::atomicMin(lightest[e.src], key);
+                       galois::atomicMin(lightest[e.dst], key);
+                     },
+                     galois::steal(), galois::loopname("FindLightest"));
+
+      // hook each component to the other end of its lightest edge; when two
+      // components picked the same edge, the smaller one becomes the root
+      uint32_t* parent = parents[0].data();
+      galois::do_all(galois::iterate(0u, numComponents),
+                     [&](uint32_t c) {
+                       uint64_t key = lightest[c];
+                       parent[c]    = c;
+                       if (key == NONE)
+                         return;
+                       const ArrayEdge& e = cur[key & 0xFFFFFFFFu];
+                       uint32_t other     = e.src == c ? e.dst : e.src;
+                       if (c < other && lightest[other] == key)
+                         return;
+                       parent[c] = other;
+                       mst.push(Edge(e.node, graph.getEdgeDst(e.id),
+                                     &graph.getEdgeData(e.id)));
+                     },
+                     galois::steal(), galois::loopname("Hook"));
+
+      // pointer jumping until every component points to its root
+      uint32_t* jump = parents[1].data();
+      while (true) {
+        galois::GReduceLogicalOR changed;
+        galois::do_all(galois::iterate(0u, numComponents),
+                       [&](uint32_t c) {
+                         jump[c] = parent[parent[c]];
+                         if (jump[c] != parent[c])
+                           changed.update(true);
+                       },
+                       galois::loopname("Shortcut"));
+        std::swap(parent, jump);
+        if (!changed.reduce())
+          break;
+      }
+
+      // number the roots that still have edges; a component without edges
+      // has no lightest edge and is a root of its own
+      galois::do_all(galois::iterate(0u, numComponents),
+                     [&](uint32_t c) {
+                       labels[c] = parent[c] == c && lightest[c] != NONE;
+                     },
+                     galois::no_stats());
+      galois::ParallelSTL::partial_sum(labels.begin(),
+                                       labels.begin() + numComponents,
+                                       labels.begin());
+      uint32_t nextComponents = numComponents ? labels[numComponents - 1] : 0;
+      uint32_t* component = jump;
+      galois::do_all(galois::iterate(0u, numComponents),
+                     [&](uint32_t c) { component[c] = labels[parent[c]] - 1; },
+                     galois::no_stats());
+
+      // relabel the edges in place and count those joining different
+      // components per block; then copy them to the next array in order
+      const size_t numBlocks =
+          std::min<size_t>((numEdges + 1023) / 1024,
+                           8 * galois::getActiveThreads());
+      auto blockBegin = [&](size_t b) { return numEdges * b / numBlocks; };
+      std::vector<size_t> offsets(numBlocks + 1, 0);
+      galois::do_all(galois::iterate(size_t{0}, numBlocks),
+                     [&](size_t b) {
+                       size_t count = 0;
+                       for (size_t i = blockBegin(b), e = blockBegin(b + 1);
+                            i < e; ++i) {
+                         ArrayEdge& edge = cur[i];
+                         edge.src        = component[edge.src];
+                         edge.dst        = component[edge.dst];
+                         count += edge.src != edge.dst;
+                       }
+                       offsets[b + 1] = count;
+                     },
+                     galois::steal(), galois::loopname("Relabel"));
+      std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+      if (!next) {
+        // later rounds keep no more edges than this one, so the first
+        // compacted array and the input array can be swapped from now on
+        compacted.allocateInterleaved(offsets[numBlocks]);
+        next = compacted.data();
+      }
+      galois::do_all(galois::iterate(size_t{0}, numBlocks),
+                     [&](size_t b) {
+                       ArrayEdge* out = next + offsets[b];
+                       for (size_t i = blockBegin(b), e = blockBegin(b + 1);
+                            i < e; ++i) {
+                         if (cur[i].src != cur[i].dst)
+                           *out++ = cur[i];
+                       }
+                     },
+                     galois::steal(), galois::loopname("Compact"));
+
+      numEdges      = offsets[numBlocks];
+      numComponents = nextComponents;
+      std::swap(cur, next);
+    }
+
+    galois::runtime::reportStat_Single("Boruvka", "rounds", rounds);
+  }
+};
+
+/**
+ * Filter-Kruskal: partitions the edges around a pivot weight, recurses on the
+ * light part, drops the heavy edges that now lie inside a tree and recurses
+ * on the rest. Sorting and union-find only run on small parts, so heavy edges
+ * of sparse graphs are mostly filtered out without ever being sorted.
+ */
+struct FilterKruskalAlgo : public EdgeArrayAlgo {
+  //! union-find parents; only changed by the serial kruskal step
+  galois::LargeArray<uint32_t> components;
+  size_t forestSize;
+  size_t sortedEdges;
+  std::minstd_rand rng;
+
+  uint32_t find(uint32_t n) const {
+    while (components[n] != n)
+      n = components[n];
+    return n;
+  }
+
+  uint32_t findAndCompress(uint32_t n) {
+    while (components[n] != n) {
+      components[n] = components[components[n]];
+      n             = components[n];
+    }
+    return n;
+  }
+
+  void kruskal(ArrayEdge* begin, ArrayEdge* end) {
+    galois::ParallelSTL::sort(begin, end, lighterEdge);
+    sortedEdges += end - begin;
+    for (; begin != end && forestSize + 1 < graph.size(); ++begin) {
+      uint32_t src = findAndCompress(begin->src);
+      uint32_t dst = findAndCompress(begin->dst);
+      if (src == dst)
+        continue;
+      components[src] = dst;
+      forestSize += 1;
+      mst.push(Edge(begin->src, begin->dst, &graph.getEdgeData(begin->id)));
+    }
+  }
+
+  //! median of a sample of the edges
+  ArrayEdge choosePivot(ArrayEdge* begin, ArrayEdge* end) {
+    std::uniform_int_distribution<size_t> pick(0, end - begin - 1);
+    std::vector<ArrayEdge> sample(63);
+    for (auto& e : sample)
+      e = begin[pick(rng)];
+    std::nth_element(sample.begin(), sample.begin() + sample.size() / 2,
+                     sample.end(), lighterEdge);
+    return sample[sample.size() / 2];
+  }
+
+  void filterKruskal(ArrayEdge* begin, ArrayEdge* end) {
+    // a spanning tree is complete; no other edge can join it
+    if (forestSize + 1 >= graph.size())
+      return;
+
+    size_t numEdges = end - begin;
+    if (numEdges <= std::max<size_t>(graph.size(), 1024)) {
+      kruskal(begin, end);
+      return;
+    }
+
+    ArrayEdge pivot = choosePivot(begin, end);
+    ArrayEdge* mid  = galois::ParallelSTL::partition(
+        begin, end,
+        [&](const ArrayEdge& e) { return lighterEdge(e, pivot); });
+    if (mid == begin || mid == end) {
+      kruskal(begin, end);
+      return;
+    }
+
+    filterKruskal(begin, mid);
+    ArrayEdge* live = galois::ParallelSTL::partition(
+        mid, end,
+        [&](const ArrayEdge& e) { return find(e.src) != find(e.dst); });
+    filterKruskal(mid, live);
+  }
+
+  void operator()() {
+    buildEdgeArray();
+
+    components.allocateInterleaved(graph.size());
+    galois::do_all(galois::iterate(graph),
+                   [&](const GNode& n) { components[n] = n; },
+                   galois::no_stats());
+    forestSize  = 0;
+    sortedEdges = 0;
+
+    filterKruskal(edges.begin(), edges.begin() + numEdges);
+
+    galois::runtime::reportStat_Single("Boruvka", "KruskalSortedEdges",
+                                       sortedEdges);
+  }
+};
+
 template <typename Algo>
 void run() {
 
@@ -465,6 +802,12 @@ int main(int argc, char** argv) {
   case exp_parallel:
     run<ParallelAlgo<true>>();
     break;
+  case contract:
+    run<ContractAlgo>();
+    break;
+  case filterKruskal:
+    run<FilterKruskalAlgo>();
+    break;
   default:
     std::cerr << "Unknown algo: " << algo << "\n";
   }
@@ -20,20 +20,26 @@
 #include <vector>
 #include <algorithm>
 
+/**
+ * The cavity of a bad triangle. Its buffers are cleared but not freed by
+ * initialize(), so a cavity that is reused for many triangles (with the
+ * default allocator) stops allocating once they have grown.
+ */
+template <typename Alloc = std::allocator<char>>
 class Cavity {
   //! [STL vector using PerIterAllocTy]
   typedef std::vector<EdgeTuple,
-                      galois::PerIterAllocTy::rebind<EdgeTuple>::other>
+                      typename Alloc::template rebind<EdgeTuple>::other>
       ConnTy;
   //! [STL vector using PerIterAllocTy]
 
   Tuple center;
   GNode centerNode;
-  std::vector<GNode, galois::PerIterAllocTy::rebind<GNode>::other> frontier;
+  std::vector<GNode, typename Alloc::template rebind<GNode>::other> frontier;
   // !the cavity itself
-  PreGraph pre;
+  PreGraph<Alloc> pre;
   // !what the new elements should look like
-  PostGraph post;
+  PostGraph<Alloc> post;
   // the edge-relations that connect the boundary to the cavity
   ConnTy connections;
   Element* centerElement;
@@ -95,8 +101,8 @@ class Cavity {
   }
 
 public:
-  Cavity(Graph* g, galois::PerIterAllocTy& cnx)
-      : frontier(cnx), pre(cnx), post(cnx), connections(cnx), graph(g) {}
+  Cavity(Graph* g, const Alloc& a = Alloc())
+      : frontier(a), pre(a), post(a), connections(a), graph(g) {}
 
   void initialize(GNode node) {
     pre.reset();
@@ -142,7 +148,8 @@ public:
       post.addNode(n2);
     }
 
-    for (ConnTy::iterator ii = connections.begin(), ee = connections.end();
+    for (typename ConnTy::iterator ii = connections.begin(),
+                                   ee = connections.end();
          ii != ee; ++ii) {
       EdgeTuple tuple = *ii;
       Element newElement(center, tuple.data.getPoint(0),
@@ -154,8 +161,9 @@ public:
       const Edge& otherEdge = newElement.getRelatedEdge(otherElement);
       post.addEdge(newNode, other, otherEdge);
 
-      for (PostGraph::iterator ii = post.begin(), ee = post.end(); ii != ee;
-           ++ii) {
+      for (typename PostGraph<Alloc>::iterator ii = post.begin(),
+                                               ee = post.end();
+           ii != ee; ++ii) {
         GNode node       = *ii;
         Element& element = graph->getData(node, galois::MethodFlag::WRITE);
         if (element.isRelated(newElement)) {
@@ -168,12 +176,15 @@ public:
   }
 
   void update(GNode node, galois::UserContext<GNode>& ctx) {
-    for (PreGraph::iterator ii = pre.begin(), ee = pre.end(); ii != ee; ++ii)
-      graph->removeNode(*ii, galois::MethodFlag::UNPROTECTED);
+    // the storage of the removed triangles is reused by later cavities of
+    // this thread
+    for (typename PreGraph<Alloc>::iterator ii = pre.begin(), ee = pre.end();
+         ii != ee; ++ii)
+      graph->recycleNode(*ii, galois::MethodFlag::UNPROTECTED);
 
     // add new data
-    for (PostGraph::iterator ii = post.begin(), ee = post.end(); ii != ee;
-         ++ii) {
+    for (typename PostGraph<Alloc>::iterator ii = post.begin(), ee = post.end();
+         ii != ee; ++ii) {
       GNode n = *ii;
       graph->addNode(n, galois::MethodFlag::UNPROTECTED);
       Element& element = graph->getData(n, galois::MethodFlag::UNPROTECTED);
@@ -182,7 +193,8 @@ public:
       }
     }
 
-    for (PostGraph::edge_iterator ii = post.edge_begin(), ee = post.edge_end();
+    for (typename PostGraph<Alloc>::edge_iterator ii = post.edge_begin(),
+                                                  ee = post.edge_end();
          ii != ee; ++ii) {
       EdgeTuple edge = *ii;
       graph->addEdge(edge.src, edge.dst, galois::MethodFlag::UNPROTECTED);
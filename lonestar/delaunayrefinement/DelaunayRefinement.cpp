@@ -57,23 +57,31 @@ template <typename WL, int Version = detBase>
 void refine(galois::InsertBag<GNode>& initialBad, Graph& graph) {
 
   struct LocalState {
-    Cavity cav;
+    Cavity<galois::PerIterAllocTy> cav;
     LocalState(Graph& graph, galois::PerIterAllocTy& alloc)
         : cav(&graph, alloc) {}
   };
 
+  // cavities whose buffers are reused by all iterations of a thread
+  galois::substrate::PerThreadStorage<Cavity<>> cavities(&graph);
+
   //! [for_each example]
   galois::for_each(
       galois::iterate(initialBad),
       [&](GNode item, auto& ctx) {
-        if (!graph.containsNode(item, galois::MethodFlag::WRITE))
+        // triangles are recycled, so item may have been replaced by a new
+        // triangle that is not bad
+        if (!graph.containsNode(item, galois::MethodFlag::WRITE) ||
+            !graph.getData(item, galois::MethodFlag::UNPROTECTED).isBad())
           return;
 
         if (Version == detDisjoint) {
 
           if (ctx.isFirstPass()) {
+            //! [Accessing Per Iteration Allocator in DMR]
             LocalState* localState = ctx.template createLocalState<LocalState>(
                 graph, ctx.getPerIterAlloc());
+            //! [Accessing Per Iteration Allocator in DMR]
             localState->cav.initialize(item);
             localState->cav.build();
             localState->cav.computePost();
@@ -84,9 +92,7 @@ void refine(galois::InsertBag<GNode>& initialBad, Graph& graph) {
 
           return;
         } else {
-          //! [Accessing Per Iteration Allocator in DMR]
-          Cavity cav(&graph, ctx.getPerIterAlloc());
-          //! [Accessing Per Iteration Allocator in DMR]
+          Cavity<>& cav = *cavities.getLocal();
           cav.initialize(item);
           cav.build();
           cav.computePost();
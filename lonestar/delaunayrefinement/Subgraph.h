@@ -46,15 +46,16 @@ struct EdgeTuple {
  *  A sub-graph of the mesh. Used to store information about the original
  *  cavity
  */
+template <typename Alloc = std::allocator<char>>
 class PreGraph {
-  typedef std::vector<GNode, galois::PerIterAllocTy::rebind<GNode>::other>
+  typedef std::vector<GNode, typename Alloc::template rebind<GNode>::other>
       NodesTy;
   NodesTy nodes;
 
 public:
-  typedef NodesTy::iterator iterator;
+  typedef typename NodesTy::iterator iterator;
 
-  explicit PreGraph(galois::PerIterAllocTy& cnx) : nodes(cnx) {}
+  explicit PreGraph(const Alloc& a = Alloc()) : nodes(a) {}
 
   bool containsNode(GNode N) {
     return std::find(nodes.begin(), nodes.end(), N) != nodes.end();
@@ -70,6 +71,7 @@ public:
  *  A sub-graph of the mesh. Used to store information about the original
  *  and updated cavity
  */
+template <typename Alloc = std::allocator<char>>
 class PostGraph {
   struct TempEdge {
     size_t src;
@@ -78,10 +80,10 @@ class PostGraph {
     TempEdge(size_t s, GNode d, const Edge& e) : src(s), dst(d), edge(e) {}
   };
 
-  typedef std::vector<GNode, galois::PerIterAllocTy::rebind<GNode>::other>
+  typedef std::vector<GNode, typename Alloc::template rebind<GNode>::other>
       NodesTy;
   typedef std::vector<EdgeTuple,
-                      galois::PerIterAllocTy::rebind<EdgeTuple>::other>
+                      typename Alloc::template rebind<EdgeTuple>::other>
       EdgesTy;
 
   //! the nodes in the graph before updating
@@ -90,10 +92,10 @@ class PostGraph {
   EdgesTy edges;
 
 public:
-  typedef NodesTy::iterator iterator;
-  typedef EdgesTy::iterator edge_iterator;
+  typedef typename NodesTy::iterator iterator;
+  typedef typename EdgesTy::iterator edge_iterator;
 
-  explicit PostGraph(galois::PerIterAllocTy& cnx) : nodes(cnx), edges(cnx) {}
+  explicit PostGraph(const Alloc& a = Alloc()) : nodes(a), edges(a) {}
 
   void addNode(GNode n) { nodes.push_back(n); }
 
@@ -24,7 +24,8 @@
 
 #include <vector>
 
-//! A cavity which will be retrangulated
+//! A cavity which will be retrangulated. A cavity can be reused for many
+//! points; init() clears its buffers but keeps their storage.
 template <typename Alloc = std::allocator<char>>
 class Cavity : private boost::noncopyable {
   typedef typename Alloc::template rebind<GNode>::other GNodeVectorAlloc;
@@ -50,7 +51,6 @@ class Cavity : private boost::noncopyable {
   GNode center;
   Point* point;
   Graph& graph;
-  const Alloc& alloc;
 
   //! Find triangles that border cavity but are not in the cavity
   void findOutside() {
@@ -76,21 +76,30 @@ class Cavity : private boost::noncopyable {
     }
   }
 
-  void addElements() {
-    GNodeVector newNodes(alloc);
-
-    // Create new nodes
+  //! Creates the triangles that fill the cavity, one per outside edge.
+  //! createNode() locks the nodes it recycles, which may abort the
+  //! iteration, so this runs before the cavity is modified
+  void createElements() {
     for (auto& ii : outside) {
-      const GNode& n = ii.first;
-      int& index     = ii.second;
+      Element& e = graph.getData(ii.first, galois::MethodFlag::UNPROTECTED);
+      Element newE(point, e.getPoint(ii.second),
+                   e.getPoint((ii.second + 1) % 3));
+      newNodes.push_back(graph.createNode(newE));
+    }
+  }
+
+  void addElements() {
+    // Connect new nodes
+    for (unsigned i = 0; i < outside.size(); ++i) {
+      const GNode& n = outside[i].first;
+      int& index     = outside[i].second;
 
       Element& e = graph.getData(n, galois::MethodFlag::UNPROTECTED);
 
       Point* p2 = e.getPoint(index);
       Point* p3 = e.getPoint((index + 1) % 3);
 
-      Element newE(point, p2, p3);
-      GNode newNode = graph.createNode(newE);
+      GNode newNode = newNodes[i];
       graph.addNode(newNode, galois::MethodFlag::UNPROTECTED);
 
       point->addElement(newNode);
@@ -101,8 +110,6 @@ class Cavity : private boost::noncopyable {
           graph.addEdge(newNode, n, galois::MethodFlag::UNPROTECTED)) = 1;
       graph.getEdgeData(
           graph.addEdge(n, newNode, galois::MethodFlag::UNPROTECTED)) = index;
-
-      newNodes.push_back(newNode);
     }
 
     // Update new node connectivity
@@ -133,18 +140,30 @@ class Cavity : private boost::noncopyable {
   }
 
   void removeElements() {
+    // The graph only stores out-edges, so the edges from the outside into
+    // the cavity are removed here; recycleNode() erases the rest
+    for (auto& ii : outside) {
+      for (GNode n : searcher.matches) {
+        auto jj = graph.findEdge(ii.first, n, galois::MethodFlag::UNPROTECTED);
+        if (jj != graph.edge_end(ii.first, galois::MethodFlag::UNPROTECTED))
+          graph.removeEdge(ii.first, jj, galois::MethodFlag::UNPROTECTED);
+      }
+    }
     for (auto ii : searcher.matches) {
-      graph.removeNode(ii, galois::MethodFlag::UNPROTECTED);
+      graph.recycleNode(ii, galois::MethodFlag::UNPROTECTED);
     }
   }
 
 public:
   Cavity(Graph& g, const Alloc& a = Alloc())
-      : searcher(g, a), newNodes(a), outside(a), graph(g), alloc(a) {}
+      : searcher(g, a), newNodes(a), outside(a), graph(g) {}
 
   void init(const GNode& c, Point* p) {
     center = c;
     point  = p;
+    searcher.clear();
+    newNodes.clear();
+    outside.clear();
   }
 
   void build() {
@@ -155,6 +174,7 @@ public:
   }
 
   void update() {
+    createElements();
     removeElements();
     addElements();
   }
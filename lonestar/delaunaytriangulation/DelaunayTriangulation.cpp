@@ -74,8 +74,6 @@ struct Process {
   Process(Graph& g, Tree& t, ptrPointBag& p)
       : graph(g), tree(t), ptrPoints(p) {}
 
-  typedef galois::PerIterAllocTy Alloc;
-
   struct ContainsTuple {
     const Graph& graph;
     Tuple tuple;
@@ -191,6 +189,8 @@ struct Process {
 
   void generateMesh() {
     typedef galois::worklists::PerThreadChunkLIFO<32> CA;
+    // cavities whose buffers are reused by all iterations of a thread
+    galois::substrate::PerThreadStorage<Cavity<>> cavities(graph);
     galois::for_each(galois::iterate(ptrPoints),
                      [&, self = this](Point* p, auto& ctx) {
                        p->get(galois::MethodFlag::WRITE);
@@ -209,14 +209,14 @@ struct Process {
                        assert(self->graph.getData(node).inTriangle(p->t()));
                        assert(self->graph.containsNode(node));
 
-                       Cavity<Alloc> cav(self->graph, ctx.getPerIterAlloc());
+                       Cavity<>& cav = *cavities.getLocal();
                        cav.init(node, p);
                        cav.build();
                        cav.update();
                        self->tree.insert(p->t().x(), p->t().y(), p);
                      },
-                     galois::no_pushes(), galois::per_iter_alloc(),
-                     galois::loopname("Main"), galois::wl<CA>());
+                     galois::no_pushes(), galois::loopname("Main"),
+                     galois::wl<CA>());
   }
 };
 
@@ -31,12 +31,17 @@
 typedef galois::graphs::MorphGraph<Element, char, true> Graph;
 typedef Graph::GraphNode GNode;
 
-//! Factor out common graph traversals
+//! Factor out common graph traversals. The buffers of a searcher are kept
+//! across searches.
 template <typename Alloc = std::allocator<char>>
 struct Searcher : private boost::noncopyable {
   typedef Alloc allocator_type;
   typedef typename Alloc::template rebind<GNode>::other GNodeVectorAlloc;
   typedef std::vector<GNode, GNodeVectorAlloc> GNodeVector;
+  typedef galois::optional<GNode> SomeGNode;
+  typedef typename Alloc::template rebind<std::pair<GNode, SomeGNode>>::other
+      WorklistAlloc;
+  typedef std::deque<std::pair<GNode, SomeGNode>, WorklistAlloc> Worklist;
 
   struct Marker {
     GNodeVector seen;
@@ -45,14 +50,22 @@ struct Searcher : private boost::noncopyable {
     bool hasMark(GNode n) {
       return std::find(seen.begin(), seen.end(), n) != seen.end();
     }
+    void clear() { seen.clear(); }
   };
 
   Graph& graph;
   GNodeVector matches, inside;
-  const allocator_type& alloc;
+  Worklist wl;
+  Marker marker;
 
   Searcher(Graph& g, const Alloc& a = allocator_type())
-      : graph(g), matches(a), inside(a), alloc(a) {}
+      : graph(g), matches(a), inside(a), wl(a), marker(g, a) {}
+
+  //! forget the results of the previous search
+  void clear() {
+    matches.clear();
+    inside.clear();
+  }
 
   struct DetLess : public std::binary_function<GNode, GNode, bool> {
     Graph& g;
@@ -85,15 +98,10 @@ struct Searcher : private boost::noncopyable {
 
   template <typename Pred>
   void find_(const GNode& start, const Pred& pred, bool all) {
-    typedef galois::optional<GNode> SomeGNode;
-    typedef typename Alloc::template rebind<std::pair<GNode, SomeGNode>>::other
-        WorklistAlloc;
-    typedef std::deque<std::pair<GNode, SomeGNode>, WorklistAlloc> Worklist;
-
-    Worklist wl(alloc);
+    wl.clear();
     wl.push_back(std::make_pair(start, SomeGNode()));
 
-    Marker marker(graph, alloc);
+    marker.clear();
     while (!wl.empty()) {
       GNode cur      = wl.front().first;
       SomeGNode prev = wl.front().second;
@@ -86,7 +86,7 @@ typedef LocalQpMapFreq LocalQpMap;
 typedef LocalCgMapFreq LocalCgMap;
 #endif
 
-int aggregator(Miner& miner, EmbeddingQueue& queue, CgMap& cg_map, UintMap& id_map, UintMap& support_map) {
+int aggregator(Miner& miner, EmbeddingQueue& queue, CgMap& cg_map, UintMap& support_map) {
 #ifdef USE_DOMAIN
 	unsigned numDomains = miner.get_embedding_size() / sizeof(ElementType);
 #endif
@@ -133,7 +133,7 @@ int aggregator(Miner& miner, EmbeddingQueue& queue, CgMap& cg_map, UintMap& id_m
 	galois::do_all(
 		galois::iterate(qp_map),
 		[&](std::pair<QuickPattern, SupportType> qp) {
-			miner.canonical_aggregate_each(qp.first, qp.second, *(cg_localmap.getLocal()), id_map);
+			miner.canonical_aggregate_each(qp.first, qp.second, *(cg_localmap.getLocal()));
 		},
 		galois::chunk_size<CHUNK_SIZE>(), galois::steal(),
 		//galois::no_conflicts(), galois::wl<galois::worklists::PerSocketChunkFIFO<CHUNK_SIZE>>(),
@@ -168,22 +168,22 @@ int aggregator(Miner& miner, EmbeddingQueue& queue, CgMap& cg_map, UintMap& id_m
 	return num_frequent_patterns;
 }
 
-void filter(Miner& miner, EmbeddingQueue& in_queue, EmbeddingQueue& out_queue, CgMap& cg_map, const UintMap id_map, const UintMap support_map) {
+// Filtering looks up the canonical pattern of every embedding in cg_map,
+// rather than going through the hash ids of its quick and canonical
+// patterns, which may collide. The embeddings share a handful of quick
+// patterns, so the canonical pattern of almost every embedding comes from
+// the canonical cache of the miner instead of bliss.
+void filter(Miner& miner, EmbeddingQueue& in_queue, EmbeddingQueue& out_queue, CgMap& cg_map) {
 	//galois::StatTimer Tfilter("Filter");
 	//Tfilter.start();
-	//miner.filter(in_queue, id_map, support_map, out_queue);
+	//miner.filter(in_queue, cg_map, out_queue);
 	///*
-	//std::cout << "id_map size: " << id_map.size() << ", support_map size: " << support_map.size() << "\n";
 	galois::do_all(
 	//galois::for_each(
 		galois::iterate(in_queue),
 		//[&](Embedding &emb, auto& ctx) {
 		[&](Embedding &emb) {
-			//miner.filter_each(emb, id_map, support_map, out_queue);
-			unsigned qp_id = emb.get_qpid();
-			unsigned cg_id = id_map.at(qp_id);
-			if (support_map.at(cg_id) >= minsup) out_queue.push_back(emb);
-	
+			miner.filter_each(emb, cg_map, out_queue);
 		},
 		galois::chunk_size<CHUNK_SIZE>(), galois::steal(), 
 		//galois::no_conflicts(), galois::wl<galois::worklists::PerSocketChunkFIFO<CHUNK_SIZE>>(),
@@ -201,10 +201,9 @@ void FsmSolver(Graph &graph, Miner &miner) {
 
 	std::cout << "\n---------------------------- Aggregating ----------------------------\n";
 	CgMap cg_map; // canonical graph map
-	UintMap id_map, support_map;
+	UintMap support_map;
 	cg_map.clear();
-	id_map.clear();
-	int num_freq_patterns = aggregator(miner, queue, cg_map, id_map, support_map);
+	int num_freq_patterns = aggregator(miner, queue, cg_map, support_map);
 	if(num_freq_patterns == 0) {
 		std::cout << "No frequent pattern found\n";
 		return;
@@ -212,7 +211,7 @@ void FsmSolver(Graph &graph, Miner &miner) {
 	if(show) miner.printout_agg(cg_map);
 
 	std::cout << "\n----------------------------- Filtering -----------------------------\n";
-	filter(miner, queue, filtered_queue, cg_map, id_map, support_map);
+	filter(miner, queue, filtered_queue, cg_map);
 	printout_embeddings(0, miner, filtered_queue);
 	unsigned level = 1;
 
@@ -233,15 +232,14 @@ void FsmSolver(Graph &graph, Miner &miner) {
 
 		std::cout << "\n---------------------------- Aggregating ----------------------------\n";
 		cg_map.clear();
-		id_map.clear();
 		support_map.clear();
-		num_freq_patterns = aggregator(miner, queue, cg_map, id_map, support_map);
+		num_freq_patterns = aggregator(miner, queue, cg_map, support_map);
 		if(show) miner.printout_agg(cg_map);
 		if(num_freq_patterns == 0) break;
 
 		std::cout << "\n----------------------------- Filtering -----------------------------\n";
 		filtered_queue.clear();
-		filter(miner, queue, filtered_queue, cg_map, id_map, support_map);
+		filter(miner, queue, filtered_queue, cg_map);
 		printout_embeddings(level, miner, filtered_queue);
 		level ++;
 	}
@@ -265,5 +263,6 @@ int main(int argc, char** argv) {
 	Tcomp.start();
 	FsmSolver(graph, miner);
 	Tcomp.stop();
+	miner.report_cache_stats("FSM");
 	return 0;
 }
@@ -38,6 +38,7 @@ static cll::opt<std::string> filetype(cll::Positional, cll::desc("<filetype: txt
 static cll::opt<std::string> filename(cll::Positional, cll::desc("<filename: symmetrized graph>"), cll::Required);
 static cll::opt<unsigned> k("k", cll::desc("max number of vertices in k-clique (default value 3)"), cll::init(3));
 static cll::opt<unsigned> show("s", cll::desc("print out the details"), cll::init(0));
+static cll::opt<unsigned> mem("mem", cll::desc("memory budget for embeddings in MB: extend in chunks that fit and explore each chunk depth first (default 0: level by level)"), cll::init(0));
 typedef galois::graphs::LC_CSR_Graph<uint32_t, void>::with_numa_alloc<true>::type ::with_no_lockable<true>::type Graph;
 typedef Graph::GraphNode GNode;
 
@@ -71,6 +72,7 @@ void KclSolver(Graph& graph, Miner &miner) {
 	initialization(graph, queue);
 	if(show) printout_embeddings(0, miner, queue);
 	unsigned level = 1;
+	size_t peak_embeddings = std::distance(queue.begin(), queue.end());
 	while (level < k-1) {
 		if(show) std::cout << "\n============================== Level " << level << " ==============================\n";
 		if(show) std::cout << "\n------------------------- Step 1: Expanding -------------------------\n";
@@ -85,6 +87,8 @@ void KclSolver(Graph& graph, Miner &miner) {
 			galois::loopname("ExtendVertex")
 		);
 		miner.update_embedding_size(); // increase the embedding size since one more edge added
+		peak_embeddings = std::max(peak_embeddings, (size_t)std::distance(queue.begin(), queue.end())
+			+ std::distance(queue2.begin(), queue2.end()));
 		if(show) printout_embeddings(level, miner, queue2);
 
 		if(show) std::cout << "\n------------------------ Step 2: Aggregation ------------------------\n";
@@ -124,10 +128,82 @@ void KclSolver(Graph& graph, Miner &miner) {
 		if(show) printout_embeddings(level, miner, queue);
 		level ++;
 	}
+	galois::runtime::reportStat_Single("Kcl", "PeakEmbeddings", peak_embeddings);
 	if(show) std::cout << "\n=============================== Done ================================\n";
 	galois::gPrint("\n\ttotal_num_cliques = ", std::distance(queue.begin(), queue.end()), "\n\n");
 }
 
+// Memory-bounded exploration. The level-by-level solver decides that a set
+// of vertices is a clique by counting how many of its sub-embeddings
+// generated it, which needs the whole level at once. Here a vertex is
+// added only if it is adjacent to every vertex of the embedding
+// (extend_vertex_clique), so each clique is built exactly once from its
+// ascending prefix and chunks of a level can be explored independently.
+// Embeddings of a level are extended in chunks whose extensions (bounded by
+// count_clique_extensions) fit in 'budget' embeddings, and every chunk is
+// explored to the last level before the next one is extended.
+struct CliqueExplorer {
+	Miner& miner;
+	size_t budget;
+	size_t num_cliques;
+	size_t peak_embeddings;
+	size_t num_embeddings; // currently held in all levels
+
+	CliqueExplorer(Miner& m, size_t b) :
+		miner(m), budget(b), num_cliques(0), peak_embeddings(0), num_embeddings(0) {}
+
+	// extend embeddings of 'size' vertices until they have k vertices
+	void explore(const std::vector<BaseEmbedding>& embs, unsigned size) {
+		std::vector<size_t> num_new_emb;
+		miner.count_clique_extensions(embs, num_new_emb);
+		for (size_t begin = 0, end; begin < embs.size(); begin = end) {
+			end = Miner::chunk_end(num_new_emb, begin, budget);
+			BaseEmbeddingQueue queue;
+			miner.extend_vertex_clique(embs, begin, end, queue);
+			size_t num = std::distance(queue.begin(), queue.end());
+			peak_embeddings = std::max(peak_embeddings, num_embeddings + num);
+			if (size + 1 == k) num_cliques += num;
+			else if (num > 0) {
+				std::vector<BaseEmbedding> next(queue.begin(), queue.end());
+				queue.clear();
+				num_embeddings += num;
+				explore(next, size + 1);
+				num_embeddings -= num;
+			}
+		}
+	}
+};
+
+void KclSolverChunked(Graph& graph, Miner &miner) {
+	if(show) std::cout << "\n=============================== Start ===============================\n";
+	BaseEmbeddingQueue queue;
+	initialization(graph, queue);
+	std::vector<BaseEmbedding> edges(queue.begin(), queue.end());
+	queue.clear();
+	if (k <= 2) {
+		galois::gPrint("\n\ttotal_num_cliques = ", k == 2 ? edges.size() : 0, "\n\n");
+		return;
+	}
+
+	// split what the initial level leaves of the budget evenly among the
+	// other levels; a level holds each embedding twice while it is moved
+	// from the worklist into a vector
+	size_t bytes_per_emb = 2 * (sizeof(BaseEmbedding) + k * sizeof(SimpleElement));
+	size_t mem_bytes = (size_t)mem << 20;
+	size_t init_bytes = edges.size() * bytes_per_emb / 2;
+	if (mem_bytes <= init_bytes)
+		GALOIS_DIE("memory budget of ", mem, " MB does not fit the initial ", init_bytes, " bytes of embeddings");
+	size_t budget = std::max((size_t)1, (mem_bytes - init_bytes) / (k - 2) / bytes_per_emb);
+	galois::gPrint("Extending at most ", budget, " embeddings per level at a time\n");
+
+	CliqueExplorer explorer(miner, budget);
+	explorer.num_embeddings = edges.size();
+	explorer.explore(edges, 2);
+	galois::runtime::reportStat_Single("Kcl", "PeakEmbeddings", explorer.peak_embeddings);
+	if(show) std::cout << "\n=============================== Done ================================\n";
+	galois::gPrint("\n\ttotal_num_cliques = ", explorer.num_cliques, "\n\n");
+}
+
 int main(int argc, char** argv) {
 	galois::SharedMemSys G;
 	LonestarStart(argc, argv, name, desc, url);
@@ -141,7 +217,8 @@ int main(int argc, char** argv) {
 	Miner miner(&graph);
 	galois::StatTimer Tcomp("Compute");
 	Tcomp.start();
-	KclSolver(graph, miner);
+	if (mem) KclSolverChunked(graph, miner);
+	else KclSolver(graph, miner);
 	Tcomp.stop();
 	return 0;
 }
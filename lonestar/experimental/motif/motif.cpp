@@ -36,6 +36,7 @@ static cll::opt<std::string> filetype(cll::Positional, cll::desc("<filetype: txt
 static cll::opt<std::string> filename(cll::Positional, cll::desc("<filename: symmetrized graph>"), cll::Required);
 static cll::opt<unsigned> k("k", cll::desc("max number of vertices in k-motif(default value 0)"), cll::init(0));
 static cll::opt<unsigned> show("s", cll::desc("print out the details"), cll::init(0));
+static cll::opt<unsigned> mem("mem", cll::desc("memory budget for embeddings in MB: extend in chunks that fit and explore each chunk depth first (default 0: level by level)"), cll::init(0));
 typedef galois::graphs::LC_CSR_Graph<uint32_t, void>::with_numa_alloc<true>::type ::with_no_lockable<true>::type Graph;
 typedef Graph::GraphNode GNode;
 
@@ -43,116 +44,165 @@ typedef Graph::GraphNode GNode;
 #include "Mining/util.h"
 #define CHUNK_SIZE 256
 
-// insert edges into the worklist (task queue)
-void initialization(Graph& graph, EmbeddingQueue &queue) {
-	printf("\n=============================== Init ================================\n\n");
+// quick pattern aggregation of the embeddings in the last level of the list
+void quick_aggregate(Graph& graph, Miner& miner, EmbeddingList& emb_list, LocalQpMapFreq& qp_localmap) {
+	unsigned emb_size = emb_list.get_num_levels();
+	galois::do_all(
+		galois::iterate((size_t)0, emb_list.size()),
+		[&](size_t pos) {
+			ElementType emb[MAX_EMBEDDING_SIZE];
+			emb_list.get_embedding(graph, emb_size - 1, pos, emb);
+			miner.quick_aggregate_each(emb, emb_size, *(qp_localmap.getLocal())); // quick pattern aggregation
+		},
+		galois::chunk_size<CHUNK_SIZE>(), galois::steal(),
+		galois::loopname("QuickAggregation")
+	);
+}
+
+// aggregate the quick patterns of a level into canonical patterns and print them
+void canonical_aggregate(Miner& miner, LocalQpMapFreq& qp_localmap, size_t num_embeddings) {
+	QpMapFreq qp_map; // quick patterns map for counting the frequency
+	// merging results sequentially
+	for (unsigned i = 0; i < qp_localmap.size(); i++) {
+		QpMapFreq qp_lmap = *qp_localmap.getLocal(i);
+		for (auto element : qp_lmap) {
+			if (qp_map.find(element.first) != qp_map.end())
+				qp_map[element.first] += element.second;
+			else
+				qp_map[element.first] = element.second;
+		}
+	}
+
+	// Sub-step 2: aggregate on canonical patterns: gather quick patterns into different canonical patterns
+	CgMapFreq cg_map; // canonical graph map for couting the frequency
+	//miner.canonical_aggregate(qp_map, cg_map);
+	// Parallel canonical pattern aggregation
+	LocalCgMapFreq cg_localmap; // canonical graph local map for each thread
 	galois::do_all(
-		// for each vertex
-		galois::iterate(graph.begin(), graph.end()),
-		[&](const GNode& src) {
-			// for each edge of this vertex
-			for (auto e : graph.edges(src)) {
-				GNode dst = graph.getEdgeDst(e);
-				if(src < dst) {
-					// create a new embedding
-					Embedding new_emb;
-					new_emb.push_back(ElementType(src));
-					new_emb.push_back(ElementType(dst));
-					queue.push_back(new_emb);
-				}
-			}
+		galois::iterate(qp_map),
+		[&](std::pair<QuickPattern, Frequency> qp) {
+			miner.canonical_aggregate_each(qp.first, qp.second, *(cg_localmap.getLocal())); // canonical pattern aggregation
 		},
-		galois::chunk_size<CHUNK_SIZE>(), galois::steal(), galois::no_conflicts(),
-		galois::wl<galois::worklists::PerSocketChunkFIFO<CHUNK_SIZE>>(),
-		galois::loopname("Initialization")
+		galois::chunk_size<CHUNK_SIZE>(), galois::steal(),
+		//galois::no_conflicts(), galois::wl<galois::worklists::PerSocketChunkFIFO<CHUNK_SIZE>>(),
+		galois::loopname("CanonicalAggregation")
 	);
+	// merging results sequentially
+	for (unsigned i = 0; i < cg_localmap.size(); i++) {
+		CgMapFreq cg_lmap = *cg_localmap.getLocal(i);
+		for (auto element : cg_lmap) {
+			if (cg_map.find(element.first) != cg_map.end())
+				cg_map[element.first] += element.second;
+			else
+				cg_map[element.first] = element.second;
+		}
+	}
+	miner.printout_agg(cg_map);
+	if(show) std::cout << "num_patterns: " << cg_map.size() << " num_quick_patterns: " << qp_map.size()
+				<< " num_embeddings: " << num_embeddings << "\n";
 }
 
 void MotifSolver(Graph& graph, Miner &miner) {
 	std::cout << "=============================== Start ===============================\n";
-	EmbeddingQueue queue, queue2; // task queues. double buffering
-	initialization(graph, queue); // initialize the task queue
-	if(show) printout_embeddings(0, miner, queue);
+	// embeddings are stored level by level as (vertex, parent) pairs
+	EmbeddingList emb_list;
+	printf("\n=============================== Init ================================\n\n");
+	emb_list.init(graph); // one embedding per edge
+	if(show) printout_embeddings(0, emb_list);
 	unsigned level = 1;
-	int queue_size = std::distance(queue.begin(), queue.end());
+	size_t queue_size = emb_list.size();
 	unsigned max_num_edges = k * (k - 1) / 2; // maximum number of edges in k-motif (i.e. k-clique)
+	size_t peak_memory = emb_list.get_memory();
 
 	// a level-by-level approach for Apriori search space (breadth first seach)
 	//while (level < k) { // to get the same output as RStream (which is not complete)
 	while (queue_size > 0 && level < max_num_edges) { // to get the complete (correct) k-motif output
 		std::cout << "\n============================== Level " << level << " ==============================\n";
 		std::cout << "\n------------------------- Step 1: Expanding -------------------------\n";
-		// for each embedding in the task queue, do the edge-extension operation
-		galois::for_each(
-			galois::iterate(queue),
-			[&](const Embedding& emb, auto& ctx) {
-				miner.extend_edge(k, emb, queue2); // edge extension
-			},
-			galois::chunk_size<CHUNK_SIZE>(), galois::steal(), galois::no_conflicts(),
-			galois::wl<galois::worklists::PerSocketChunkFIFO<CHUNK_SIZE>>(),
-			galois::loopname("Expanding")
-		);
+		// for each embedding in the last level, do the edge-extension operation
+		miner.extend_edge(k, emb_list);
 		miner.update_embedding_size(); // increase the embedding size since one more edge added
-		queue.swap(queue2);
-		queue2.clear();
-		if(show) printout_embeddings(level, miner, queue);
+		peak_memory = std::max(peak_memory, emb_list.get_memory());
+		if(show) printout_embeddings(level, emb_list);
 
 		std::cout << "\n------------------------ Step 2: Aggregation ------------------------\n";
 		// Sub-step 1: aggregate on quick patterns: gather embeddings into different quick patterns
-		QpMapFreq qp_map; // quick patterns map for counting the frequency
-		//miner.quick_aggregate(queue, qp_map); // sequential implementaion
-		// Parallel quick pattern aggregation
 		LocalQpMapFreq qp_localmap; // quick patterns local map for each thread
-		galois::for_each(
-			galois::iterate(queue),
-			[&](Embedding& emb, auto& ctx) {
-				miner.quick_aggregate_each(emb, *(qp_localmap.getLocal())); // quick pattern aggregation
-			},
-			galois::chunk_size<CHUNK_SIZE>(), galois::steal(), galois::no_conflicts(),
-			galois::wl<galois::worklists::PerSocketChunkFIFO<CHUNK_SIZE>>(),
-			galois::loopname("QuickAggregation")
-		);
-		// merging results sequentially
-		for (unsigned i = 0; i < qp_localmap.size(); i++) {
-			QpMapFreq qp_lmap = *qp_localmap.getLocal(i);
-			for (auto element : qp_lmap) {
-				if (qp_map.find(element.first) != qp_map.end())
-					qp_map[element.first] += element.second;
-				else
-					qp_map[element.first] = element.second;
-			}
-		}
+		quick_aggregate(graph, miner, emb_list, qp_localmap);
+		queue_size = emb_list.size();
+		canonical_aggregate(miner, qp_localmap, queue_size);
+		level ++;
+	}
+	galois::runtime::reportStat_Single("Motif", "PeakEmbeddingListBytes", peak_memory);
+	std::cout << "\n=============================== Done ===============================\n\n";
+}
+
+// Memory-bounded exploration: the embeddings of a level are extended in
+// chunks whose extensions fit in 'budget' embeddings, and every chunk is
+// explored to the last level (depth first) before the next one is
+// extended. Quick patterns are aggregated per level across chunks, so the
+// results are the same as level by level.
+struct ChunkedExplorer {
+	Graph& graph;
+	Miner& miner;
+	EmbeddingList& emb_list;
+	unsigned max_num_edges;
+	size_t budget;
+	std::vector<LocalQpMapFreq> qp_localmaps; // per level
+	std::vector<size_t> num_embeddings; // per level
+	size_t peak_memory;
 
-		// Sub-step 2: aggregate on canonical patterns: gather quick patterns into different canonical patterns
-		CgMapFreq cg_map; // canonical graph map for couting the frequency
-		//miner.canonical_aggregate(qp_map, cg_map);
-		// Parallel canonical pattern aggregation
-		LocalCgMapFreq cg_localmap; // canonical graph local map for each thread
-		galois::do_all(
-			galois::iterate(qp_map),
-			[&](std::pair<QuickPattern, Frequency> qp) {
-				miner.canonical_aggregate_each(qp.first, qp.second, *(cg_localmap.getLocal())); // canonical pattern aggregation
-			},
-			galois::chunk_size<CHUNK_SIZE>(), galois::steal(),
-			//galois::no_conflicts(), galois::wl<galois::worklists::PerSocketChunkFIFO<CHUNK_SIZE>>(),
-			galois::loopname("CanonicalAggregation")
-		);
-		// merging results sequentially
-		for (unsigned i = 0; i < cg_localmap.size(); i++) {
-			CgMapFreq cg_lmap = *cg_localmap.getLocal(i);
-			for (auto element : cg_lmap) {
-				if (cg_map.find(element.first) != cg_map.end())
-					cg_map[element.first] += element.second;
-				else
-					cg_map[element.first] = element.second;
-			}
+	ChunkedExplorer(Graph& g, Miner& m, EmbeddingList& list, unsigned max_edges, size_t b) :
+		graph(g), miner(m), emb_list(list), max_num_edges(max_edges), budget(b),
+		qp_localmaps(max_edges), num_embeddings(max_edges, 0), peak_memory(list.get_memory()) {}
+
+	// extend the last level of the list into the embeddings of 'level'
+	void explore(unsigned level) {
+		std::vector<IndexTy> num_new_emb;
+		miner.count_edge_extensions(k, emb_list, num_new_emb);
+		for (size_t begin = 0, end; begin < num_new_emb.size(); begin = end) {
+			end = Miner::chunk_end(num_new_emb, begin, budget);
+			miner.extend_edge(k, emb_list, begin, end, num_new_emb);
+			peak_memory = std::max(peak_memory, emb_list.get_memory());
+			num_embeddings[level] += emb_list.size();
+			quick_aggregate(graph, miner, emb_list, qp_localmaps[level]);
+			if (level + 1 < max_num_edges && emb_list.size() > 0) explore(level + 1);
+			emb_list.remove_level();
 		}
-		miner.printout_agg(cg_map);
-		queue_size = std::distance(queue.begin(), queue.end());
-		if(show) std::cout << "num_patterns: " << cg_map.size() << " num_quick_patterns: " << qp_map.size()
-					<< " num_embeddings: " << queue_size << "\n";
-		level ++;
 	}
+};
+
+void MotifSolverChunked(Graph& graph, Miner &miner) {
+	std::cout << "=============================== Start ===============================\n";
+	EmbeddingList emb_list;
+	printf("\n=============================== Init ================================\n\n");
+	emb_list.init(graph); // one embedding per edge
+	if(show) printout_embeddings(0, emb_list);
+	unsigned max_num_edges = k * (k - 1) / 2; // maximum number of edges in k-motif (i.e. k-clique)
+	if (max_num_edges < 2) return;
+
+	// split what the initial level leaves of the budget evenly among the
+	// other levels; each embedding takes an element and an extension count
+	size_t mem_bytes = (size_t)mem << 20;
+	size_t init_bytes = emb_list.get_memory();
+	if (mem_bytes <= init_bytes)
+		GALOIS_DIE("memory budget of ", mem, " MB does not fit the initial ", init_bytes, " bytes of embeddings");
+	size_t bytes_per_emb = sizeof(VertexId) + sizeof(IndexTy) + sizeof(BYTE) + sizeof(IndexTy);
+	size_t budget = std::max((size_t)1, (mem_bytes - init_bytes) / (max_num_edges - 1) / bytes_per_emb);
+	galois::gPrint("Extending at most ", budget, " embeddings per level at a time\n");
+
+	ChunkedExplorer explorer(graph, miner, emb_list, max_num_edges, budget);
+	explorer.explore(1);
+
+	for (unsigned level = 1; level < max_num_edges; level ++) {
+		std::cout << "\n============================== Level " << level << " ==============================\n";
+		miner.update_embedding_size(); // increase the embedding size since one more edge added
+		if(show) std::cout << "Number of embeddings in level " << level << ": " << explorer.num_embeddings[level] << std::endl;
+		std::cout << "\n------------------------ Step 2: Aggregation ------------------------\n";
+		canonical_aggregate(miner, explorer.qp_localmaps[level], explorer.num_embeddings[level]);
+		if (explorer.num_embeddings[level] == 0) break;
+	}
+	galois::runtime::reportStat_Single("Motif", "PeakEmbeddingListBytes", explorer.peak_memory);
 	std::cout << "\n=============================== Done ===============================\n\n";
 }
 
@@ -170,7 +220,8 @@ int main(int argc, char** argv) {
 	Miner miner(&graph);
 	galois::StatTimer Tcomp("Compute");
 	Tcomp.start();
-	MotifSolver(graph, miner);
+	if (mem) MotifSolverChunked(graph, miner);
+	else MotifSolver(graph, miner);
 	Tcomp.stop();
 	return 0;
 }
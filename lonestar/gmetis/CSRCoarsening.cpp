@@ -0,0 +1,378 @@
+/*
+ * This file belongs to the Galois project, a C++ library for exploiting parallelism.
+ * The code is being released under the terms of the 3-Clause BSD License (a
+ * copy is located in LICENSE.txt at the top-level directory).
+ *
+ * Copyright (C) 2019, The University of Texas at Austin. All rights reserved.
+ * UNIVERSITY EXPRESSLY DISCLAIMS ANY AND ALL WARRANTIES CONCERNING THIS
+ * SOFTWARE AND DOCUMENTATION, INCLUDING ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR ANY PARTICULAR PURPOSE, NON-INFRINGEMENT AND WARRANTIES OF
+ * PERFORMANCE, AND ANY WARRANTY THAT MIGHT OTHERWISE ARISE FROM COURSE OF
+ * DEALING OR USAGE OF TRADE.  NO WARRANTY IS EITHER EXPRESS OR IMPLIED WITH
+ * RESPECT TO THE USE OF THE SOFTWARE OR DOCUMENTATION. Under no circumstances
+ * shall University be liable for incidental, special, indirect, direct or
+ * consequential damages or loss of profits, interruption of business, or
+ * related expenses which may arise from use of Software or Documentation,
+ * including but not limited to those resulting from defects in Software and/or
+ * Documentation, or loss or inaccuracy of data of any kind.
+ */
+
+#include "Metis.h"
+#include "galois/Galois.h"
+#include "galois/LargeArray.h"
+#include "galois/ParallelSTL.h"
+#include "galois/Timer.h"
+#include "galois/substrate/PerThreadStorage.h"
+
+#include <iostream>
+
+namespace {
+
+constexpr uint32_t UNMATCHED  = std::numeric_limits<uint32_t>::max();
+constexpr uint32_t EMPTY_SLOT = std::numeric_limits<uint32_t>::max();
+
+/*
+ * Matching takes no locks: threads race to pair up nodes and a verification
+ * pass keeps only the pairs whose two ends agree, so match fields are read
+ * and written atomically.
+ */
+uint32_t loadMatch(CSRGraph& g, CSRGNode n) {
+  return __atomic_load_n(&g.getData(n).match, __ATOMIC_RELAXED);
+}
+
+void storeMatch(CSRGraph& g, CSRGNode n, uint32_t m) {
+  __atomic_store_n(&g.getData(n).match, m, __ATOMIC_RELAXED);
+}
+
+size_t degree(CSRGraph& g, CSRGNode n) {
+  return std::distance(g.edge_begin(n), g.edge_end(n));
+}
+
+// Unmatched neighbor (other than skip) across the heaviest edge; n if none
+std::pair<CSRGNode, int> HEMmatch(CSRGraph& g, CSRGNode n, CSRGNode skip) {
+  std::pair<CSRGNode, int> retval(n, std::numeric_limits<int>::min());
+  for (auto jj : g.edges(n)) {
+    CSRGNode neighbor = g.getEdgeDst(jj);
+    int edgeData      = g.getEdgeData(jj);
+    if (neighbor != n && neighbor != skip && retval.second < edgeData &&
+        loadMatch(g, neighbor) == UNMATCHED)
+      retval = std::make_pair(neighbor, edgeData);
+  }
+  return retval;
+}
+
+CSRGNode TwoHopMatch(CSRGraph& g, CSRGNode n) {
+  std::pair<CSRGNode, int> retval(n, std::numeric_limits<int>::min());
+  for (auto jj : g.edges(n)) {
+    CSRGNode neighbor             = g.getEdgeDst(jj);
+    std::pair<CSRGNode, int> tval = HEMmatch(g, neighbor, n);
+    if (tval.first != neighbor && tval.second > retval.second)
+      retval = tval;
+  }
+  return retval.first;
+}
+
+template <bool twoHop>
+void matchRound(CSRGraph& g) {
+  // visit low degree nodes first, as the morph graph matching does
+  auto lowDegree = [&g](CSRGNode n) -> unsigned { return degree(g, n); };
+  typedef galois::worklists::PerSocketChunkLIFO<32> Chunk;
+  typedef galois::worklists::OrderedByIntegerMetric<decltype(lowDegree),
+                                                    Chunk>
+      pLD;
+
+  galois::for_each(
+      galois::iterate(g),
+      [&](CSRGNode n, auto&) {
+        if (loadMatch(g, n) != UNMATCHED)
+          return;
+        CSRGNode m = twoHop ? TwoHopMatch(g, n) : HEMmatch(g, n, n).first;
+        if (m == n)
+          return;
+        storeMatch(g, n, m);
+        storeMatch(g, m, n);
+      },
+      galois::wl<pLD>(lowDegree), galois::no_conflicts(),
+      galois::no_pushes(),
+      galois::loopname(twoHop ? "match2Hop" : "match"));
+
+  // a node may have been claimed by several threads; the last write wins and
+  // the losers go back to unmatched for the next round
+  galois::do_all(galois::iterate(g),
+                 [&](CSRGNode n) {
+                   uint32_t m = loadMatch(g, n);
+                   if (m != UNMATCHED && loadMatch(g, m) != n)
+                     storeMatch(g, n, UNMATCHED);
+                 },
+                 galois::loopname("verifyMatch"));
+}
+
+/*
+ * Heavy edge matching, optionally followed by two hop matching of the nodes
+ * that are left. Isolated nodes are paired with each other and whatever
+ * remains is matched with itself.
+ */
+void findMatching(CSRGraph& g, bool use2Hop, bool verbose) {
+  const unsigned rounds = 2;
+  for (unsigned r = 0; r < rounds; ++r)
+    matchRound<false>(g);
+  if (use2Hop)
+    for (unsigned r = 0; r < rounds; ++r)
+      matchRound<true>(g);
+
+  galois::InsertBag<CSRGNode> bagOfLoners;
+  galois::do_all(galois::iterate(g),
+                 [&](CSRGNode n) {
+                   if (loadMatch(g, n) == UNMATCHED && !degree(g, n))
+                     bagOfLoners.push(n);
+                 },
+                 galois::loopname("findLoners"));
+  unsigned count = 0;
+  for (auto ii = bagOfLoners.begin(), ee = bagOfLoners.end(); ii != ee; ++ii) {
+    auto i2 = ii;
+    if (++i2 == ee)
+      break;
+    storeMatch(g, *ii, *i2);
+    storeMatch(g, *i2, *ii);
+    ii = i2;
+    ++count;
+  }
+  if (verbose && count)
+    std::cout << "\n\tLone Matches " << count;
+
+  galois::do_all(galois::iterate(g),
+                 [&](CSRGNode n) {
+                   if (loadMatch(g, n) == UNMATCHED)
+                     storeMatch(g, n, n);
+                 },
+                 galois::loopname("selfMatch"));
+}
+
+using EdgeVec = std::vector<std::pair<uint32_t, int>>;
+
+/*
+ * Per-thread buffer that merges the edges of a matched pair pointing to the
+ * same coarse node while appending them to an output vector. Small pairs are
+ * merged by scanning what was appended so far; larger ones use an open
+ * addressing table that is sized from the degree of the pair, so it stays in
+ * cache, and is emptied by walking the slots that were filled.
+ */
+class EdgeHashBuffer {
+  static const size_t LINEAR_LIMIT = 16;
+
+  std::vector<uint32_t> keys;
+  std::vector<uint32_t> index;
+  std::vector<uint32_t> used;
+  uint32_t mask = 0;
+  bool linear   = true;
+  EdgeVec* out  = nullptr;
+  size_t start  = 0;
+
+public:
+  void reset(EdgeVec& o, size_t maxEntries) {
+    out    = &o;
+    start  = o.size();
+    linear = maxEntries <= LINEAR_LIMIT;
+    if (linear)
+      return;
+    size_t capacity = 2 * LINEAR_LIMIT;
+    while (capacity < 2 * maxEntries)
+      capacity <<= 1;
+    if (keys.size() < capacity) {
+      keys.resize(capacity, EMPTY_SLOT);
+      index.resize(capacity);
+    }
+    mask = capacity - 1;
+  }
+
+  void add(uint32_t key, int value) {
+    EdgeVec& edges = *out;
+    if (linear) {
+      for (size_t i = start, e = edges.size(); i < e; ++i)
+        if (edges[i].first == key) {
+          edges[i].second += value;
+          return;
+        }
+      edges.emplace_back(key, value);
+      return;
+    }
+    uint32_t slot = (key * 2654435761u) & mask;
+    while (keys[slot] != key) {
+      if (keys[slot] == EMPTY_SLOT) {
+        keys[slot]  = key;
+        index[slot] = edges.size() - start;
+        used.push_back(slot);
+        edges.emplace_back(key, value);
+        return;
+      }
+      slot = (slot + 1) & mask;
+    }
+    edges[start + index[slot]].second += value;
+  }
+
+  //! Returns the number of merged edges appended since reset
+  size_t finish() {
+    for (auto slot : used)
+      keys[slot] = EMPTY_SLOT;
+    used.clear();
+    return out->size() - start;
+  }
+};
+
+/*
+ * Builds the coarse graph from the matching of the fine graph. Coarse nodes
+ * are numbered by a prefix sum over the pair leaders (the lower id of each
+ * pair) and the edges of each pair are merged with the hash buffers.
+ */
+void createCoarseGraph(CSRGraph& fg, CSRGraph& cg) {
+  auto isLeader = [&](CSRGNode n) { return fg.getData(n).match >= n; };
+
+  galois::LargeArray<uint32_t> ids;
+  ids.create(fg.size());
+  galois::do_all(galois::iterate(fg),
+                 [&](CSRGNode n) { ids[n] = isLeader(n) ? 1 : 0; },
+                 galois::loopname("markLeaders"));
+  galois::ParallelSTL::partial_sum(ids.begin(), ids.end(), ids.begin());
+  uint32_t numCoarse = fg.size() ? ids[fg.size() - 1] : 0;
+
+  galois::LargeArray<uint32_t> children;
+  children.create(numCoarse);
+  galois::do_all(galois::iterate(fg),
+                 [&](CSRGNode n) {
+                   if (isLeader(n)) {
+                     fg.getData(n).parent = ids[n] - 1;
+                     children[ids[n] - 1] = n;
+                   }
+                 },
+                 galois::loopname("numberCoarse"));
+  // ids becomes a compact copy of the parents, which the edge gathering
+  // below looks up once per fine edge
+  galois::do_all(galois::iterate(fg),
+                 [&](CSRGNode n) {
+                   auto& nd = fg.getData(n);
+                   if (!isLeader(n))
+                     nd.parent = fg.getData(nd.match).parent;
+                   ids[n] = nd.parent;
+                 },
+                 galois::loopname("setParents"));
+
+  galois::substrate::PerThreadStorage<EdgeHashBuffer> buffers;
+  auto gather = [&](uint32_t c, EdgeHashBuffer& buf, EdgeVec& edges) {
+    CSRGNode child[2] = {children[c], fg.getData(children[c]).match};
+    unsigned num      = child[0] == child[1] ? 1 : 2;
+    buf.reset(edges,
+              degree(fg, child[0]) + (num == 2 ? degree(fg, child[1]) : 0));
+    for (unsigned x = 0; x < num; ++x)
+      for (auto ii : fg.edges(child[x])) {
+        uint32_t p = ids[fg.getEdgeDst(ii)];
+        if (p != c) // no self edges
+          buf.add(p, fg.getEdgeData(ii));
+      }
+    return buf.finish();
+  };
+
+  // Coarse nodes are gathered in blocks, each into its own buffer, so the
+  // edges are hashed once; the buffers are copied into the CSR once the
+  // degrees have been prefix summed into offsets.
+  const uint32_t blockSize = 256;
+  uint32_t numBlocks       = (numCoarse + blockSize - 1) / blockSize;
+  std::vector<EdgeVec> blockEdges(numBlocks);
+  galois::LargeArray<uint64_t> edgeEnd;
+  edgeEnd.create(numCoarse);
+  galois::do_all(galois::iterate(0u, numBlocks),
+                 [&](uint32_t b) {
+                   auto& buf   = *buffers.getLocal();
+                   auto& edges = blockEdges[b];
+                   uint32_t end = std::min(numCoarse, (b + 1) * blockSize);
+                   for (uint32_t c = b * blockSize; c < end; ++c)
+                     edgeEnd[c] = gather(c, buf, edges);
+                 },
+                 galois::steal(), galois::loopname("gatherCoarseEdges"));
+  galois::ParallelSTL::partial_sum(edgeEnd.begin(), edgeEnd.end(),
+                                   edgeEnd.begin());
+  uint64_t numEdges = numCoarse ? edgeEnd[numCoarse - 1] : 0;
+
+  cg.allocateFrom(numCoarse, numEdges);
+  cg.constructNodes();
+  galois::do_all(galois::iterate(0u, numBlocks),
+                 [&](uint32_t b) {
+                   uint32_t begin = b * blockSize;
+                   uint32_t end   = std::min(numCoarse, begin + blockSize);
+                   uint64_t e     = begin ? edgeEnd[begin - 1] : 0;
+                   for (auto& edge : blockEdges[b])
+                     cg.constructEdge(e++, edge.first, edge.second);
+                   EdgeVec().swap(blockEdges[b]);
+
+                   for (uint32_t c = begin; c < end; ++c) {
+                     cg.fixEndEdge(c, edgeEnd[c]);
+                     CSRGNode child0 = children[c];
+                     CSRGNode child1 = fg.getData(child0).match;
+                     auto& cd        = cg.getData(c);
+                     cd.weight       = fg.getData(child0).weight;
+                     if (child1 != child0)
+                       cd.weight += fg.getData(child1).weight;
+                   }
+                 },
+                 galois::steal(), galois::loopname("createCoarseEdges"));
+}
+
+MetisCSRGraph* coarsenOnce(MetisCSRGraph* fineMetisGraph, bool with2Hop,
+                           bool verbose) {
+  MetisCSRGraph* coarseMetisGraph = new MetisCSRGraph(fineMetisGraph);
+  galois::Timer t, t2;
+  if (verbose)
+    t.start();
+  findMatching(*fineMetisGraph->getGraph(), with2Hop, verbose);
+  if (verbose) {
+    t.stop();
+    std::cout << "\n\tTime Matching " << t.get() << "\n";
+    t2.start();
+  }
+  createCoarseGraph(*fineMetisGraph->getGraph(), *coarseMetisGraph->getGraph());
+  if (verbose) {
+    t2.stop();
+    std::cout << "\tTime Creating " << t2.get() << "\n";
+  }
+  return coarseMetisGraph;
+}
+
+} // namespace
+
+MetisCSRGraph* coarsenCSR(MetisCSRGraph* fineMetisGraph, unsigned coarsenTo,
+                          bool verbose) {
+  MetisCSRGraph* coarseGraph = fineMetisGraph;
+  unsigned size              = fineMetisGraph->getNumNodes();
+  unsigned iterNum           = 0;
+  bool with2Hop              = false;
+  unsigned stat              = 0;
+  while (size >= coarsenTo) {
+    if (verbose) {
+      std::cout << "Coarsening " << iterNum << "\t";
+      stat = graphStat(*coarseGraph->getGraph());
+    }
+    coarseGraph      = coarsenOnce(coarseGraph, with2Hop, verbose);
+    unsigned newSize = coarseGraph->getNumNodes();
+    if (verbose) {
+      std::cout << "\tTO\t";
+      unsigned stat2 = graphStat(*coarseGraph->getGraph());
+      std::cout << "\n\tRatio " << (double)stat2 / (double)stat
+                << " new size " << newSize << "\n";
+    }
+
+    // stop once even two hop matching hardly shrinks the graph
+    if (with2Hop && (uint64_t)size * 19 < (uint64_t)newSize * 20)
+      break;
+    if ((uint64_t)size * 3 < (uint64_t)newSize * 4) {
+      with2Hop = true;
+      if (verbose)
+        std::cout << "** Enabling 2 hop matching\n";
+    } else {
+      with2Hop = false;
+    }
+
+    size = newSize;
+    ++iterNum;
+  }
+
+  return coarseGraph;
+}
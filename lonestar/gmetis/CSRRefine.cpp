@@ -0,0 +1,152 @@
+/*
+ * This file belongs to the Galois project, a C++ library for exploiting parallelism.
+ * The code is being released under the terms of the 3-Clause BSD License (a
+ * copy is located in LICENSE.txt at the top-level directory).
+ *
+ * Copyright (C) 2019, The University of Texas at Austin. All rights reserved.
+ * UNIVERSITY EXPRESSLY DISCLAIMS ANY AND ALL WARRANTIES CONCERNING THIS
+ * SOFTWARE AND DOCUMENTATION, INCLUDING ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR ANY PARTICULAR PURPOSE, NON-INFRINGEMENT AND WARRANTIES OF
+ * PERFORMANCE, AND ANY WARRANTY THAT MIGHT OTHERWISE ARISE FROM COURSE OF
+ * DEALING OR USAGE OF TRADE.  NO WARRANTY IS EITHER EXPRESS OR IMPLIED WITH
+ * RESPECT TO THE USE OF THE SOFTWARE OR DOCUMENTATION. Under no circumstances
+ * shall University be liable for incidental, special, indirect, direct or
+ * consequential damages or loss of profits, interruption of business, or
+ * related expenses which may arise from use of Software or Documentation,
+ * including but not limited to those resulting from defects in Software and/or
+ * Documentation, or loss or inaccuracy of data of any kind.
+ */
+
+#include "galois/Galois.h"
+#include "galois/Timer.h"
+#include "Metis.h"
+
+#include <iostream>
+
+namespace {
+
+using CSRGNodeBag = galois::InsertBag<CSRGNode>;
+
+bool isBoundary(CSRGraph& g, CSRGNode n) {
+  unsigned nPart = g.getData(n).part;
+  for (auto ii : g.edges(n))
+    if (g.getData(g.getEdgeDst(ii)).part != nPart)
+      return true;
+  return false;
+}
+
+void findBoundary(CSRGNodeBag& bag, CSRGraph& g) {
+  galois::do_all(galois::iterate(g),
+                 [&](CSRGNode n) {
+                   auto& nd = g.getData(n);
+                   if (nd.maybeBoundary)
+                     nd.maybeBoundary = isBoundary(g, n);
+                   if (nd.maybeBoundary)
+                     bag.push(n);
+                 },
+                 galois::loopname("findBoundary"));
+}
+
+// project part and maybe boundary from the parents in the coarser level
+void projectPart(CSRGraph& cg, CSRGraph& fg) {
+  galois::do_all(galois::iterate(fg),
+                 [&](CSRGNode n) {
+                   auto& nd         = fg.getData(n);
+                   auto& pd         = cg.getData(nd.parent);
+                   nd.part          = pd.part;
+                   nd.maybeBoundary = pd.maybeBoundary;
+                 },
+                 galois::loopname("project"));
+}
+
+/*
+ * BKL2 refinement on one CSR level: boundary nodes move to the partition they
+ * are most connected to. The level has no abstract locks, so neighboring
+ * moves may race; as in the morph graph version the partition weights are
+ * kept with atomic updates.
+ */
+void refine_BKL2(unsigned minSize, unsigned maxSize, CSRGraph& g,
+                 std::vector<partInfo>& parts) {
+
+  auto gainIndexer = [&g](CSRGNode n) -> int {
+    int retval     = 0;
+    unsigned nPart = g.getData(n).part;
+    for (auto ii : g.edges(n)) {
+      if (g.getData(g.getEdgeDst(ii)).part == nPart)
+        retval -= g.getEdgeData(ii);
+      else
+        retval += g.getEdgeData(ii);
+    }
+    return -retval / 16;
+  };
+
+  typedef galois::worklists::PerSocketChunkFIFO<8> Chunk;
+  typedef galois::worklists::OrderedByIntegerMetric<decltype(gainIndexer),
+                                                    Chunk, 10>
+      pG;
+
+  CSRGNodeBag boundary;
+  findBoundary(boundary, g);
+
+  typedef galois::gstl::Vector<unsigned> VecTy;
+  typedef galois::substrate::PerThreadStorage<VecTy> ThreadLocalData;
+  ThreadLocalData edgesThreadLocal;
+
+  // Find the partition n is most connected to
+  auto pickPartitionEC = [&](CSRGNode n) -> unsigned {
+    auto& edges = *edgesThreadLocal.getLocal();
+    edges.clear();
+    edges.resize(parts.size(), 0);
+    unsigned P = g.getData(n).part;
+    for (auto ii : g.edges(n)) {
+      unsigned neighPart = g.getData(g.getEdgeDst(ii)).part;
+      if (parts[neighPart].partWeight < maxSize || neighPart == P)
+        edges[neighPart] += g.getEdgeData(ii);
+    }
+    return std::distance(edges.begin(),
+                         std::max_element(edges.begin(), edges.end()));
+  };
+
+  galois::for_each(
+      galois::iterate(boundary),
+      [&](CSRGNode n, auto&) {
+        auto& nd         = g.getData(n);
+        unsigned curpart = nd.part;
+        unsigned newpart = pickPartitionEC(n);
+        if (parts[curpart].partWeight < minSize)
+          return;
+        if (curpart != newpart) {
+          nd.part = newpart;
+          __sync_fetch_and_sub(&parts[curpart].partWeight, nd.weight);
+          __sync_fetch_and_add(&parts[newpart].partWeight, nd.weight);
+          for (auto ii : g.edges(n)) {
+            auto& ned = g.getData(g.getEdgeDst(ii));
+            if (ned.part != newpart && !ned.maybeBoundary)
+              ned.maybeBoundary = true;
+          }
+        }
+      },
+      galois::loopname("refine"), galois::wl<pG>(gainIndexer),
+      galois::no_conflicts(), galois::no_pushes());
+}
+
+} // namespace
+
+void refineCSR(MetisCSRGraph* coarseGraph, std::vector<partInfo>& parts,
+               unsigned minSize, unsigned maxSize, bool verbose) {
+  MetisCSRGraph* fineGraph;
+  do {
+    fineGraph = coarseGraph->getFinerGraph();
+    if (verbose) {
+      std::cout << "Cut " << computeCut(*coarseGraph->getGraph())
+                << " Weights ";
+      printPartStats(parts);
+      std::cout << "\n";
+    }
+    refine_BKL2(minSize, maxSize, *coarseGraph->getGraph(), parts);
+    if (fineGraph) {
+      projectPart(*coarseGraph->getGraph(), *fineGraph->getGraph());
+      delete coarseGraph;
+    }
+  } while ((coarseGraph = fineGraph));
+}
@@ -76,6 +76,11 @@ static cll::opt<std::string> filename(cll::Positional,
 static cll::opt<int> numPartitions(cll::Positional,
                                    cll::desc("<Number of partitions>"),
                                    cll::Required);
+static cll::opt<bool> csrLevels(
+    "csrLevels",
+    cll::desc("Coarsen into compact CSR levels instead of morph graphs "
+              "(BKL2 refinement only)"),
+    cll::init(false));
 static cll::opt<double> imbalance(
     "balance",
     cll::desc("Fraction deviated from mean partition size (default 0.01)"),
@@ -158,6 +163,94 @@ void Partition(MetisGraph* metisGraph, unsigned nparts) {
   return;
 }
 
+/**
+ * KMetis Algorithm on CSR levels
+ */
+void PartitionCSR(MetisCSRGraph* metisGraph, unsigned nparts) {
+  galois::StatTimer TM;
+  TM.start();
+  unsigned fineMetisGraphWeight = metisGraph->getTotalWeight();
+  unsigned meanWeight = ((double)fineMetisGraphWeight) / (double)nparts;
+  unsigned coarsenTo  = 20 * nparts;
+
+  if (verbose)
+    std::cout << "Starting coarsening: \n";
+  galois::StatTimer T("Coarsen");
+  T.start();
+  MetisCSRGraph* mcg = coarsenCSR(metisGraph, coarsenTo, verbose);
+  T.stop();
+  if (verbose)
+    std::cout << "Time coarsen: " << T.get() << "\n";
+
+  galois::StatTimer T2("Partition");
+  T2.start();
+  std::vector<partInfo> parts;
+  parts = partitionCSR(mcg, fineMetisGraphWeight, nparts, partMode);
+  T2.stop();
+
+  if (verbose)
+    std::cout << "Init edge cut : " << computeCut(*mcg->getGraph()) << "\n\n";
+
+  std::vector<partInfo> initParts = parts;
+  if (verbose)
+    std::cout << "Time clustering:  " << T2.get() << '\n';
+
+  galois::StatTimer T3("Refine");
+  T3.start();
+  refineCSR(mcg, parts, meanWeight - (unsigned)(meanWeight * imbalance),
+            meanWeight + (unsigned)(meanWeight * imbalance), verbose);
+  T3.stop();
+  if (verbose)
+    std::cout << "Time refinement: " << T3.get() << "\n";
+
+  TM.stop();
+
+  std::cout << "Initial dist\n";
+  printPartStats(initParts);
+  std::cout << "\n";
+
+  std::cout << "Refined dist\n";
+  printPartStats(parts);
+  std::cout << "\n";
+
+  std::cout << "Time:  " << TM.get() << '\n';
+}
+
+int runCSR() {
+  if (refineMode != BKL2)
+    GALOIS_DIE("CSR levels only support BKL2 refinement");
+  if (orderedfile != "" || permutationfile != "")
+    GALOIS_DIE("CSR levels do not support ordered graph output");
+
+  MetisCSRGraph metisGraph;
+  CSRGraph& graph = *metisGraph.getGraph();
+
+  galois::graphs::readGraph(graph, filename);
+
+  galois::do_all(galois::iterate(graph),
+                 [&](CSRGNode node) {
+                   for (auto jj : graph.edges(node))
+                     graph.getEdgeData(jj) = 1;
+                 },
+                 galois::loopname("initCSRGraph"));
+
+  graphStat(graph);
+  std::cout << "\n";
+
+  galois::reportPageAlloc("MeminfoPre");
+  PartitionCSR(&metisGraph, numPartitions);
+  galois::reportPageAlloc("MeminfoPost");
+
+  std::cout << "Total edge cut: " << computeCut(graph) << "\n";
+
+  if (outfile != "") {
+    std::ofstream outFile(outfile.c_str());
+    for (auto n : graph)
+      outFile << graph.getData(n).part << '\n';
+  }
+  return 0;
+}
+
 // printGraphBeg(*graph)
 
 typedef galois::graphs::FileGraph FG;
@@ -187,6 +280,9 @@ int main(int argc, char** argv) {
   LonestarStart(argc, argv, name, desc, url);
 
   srand(-1);
+  if (csrLevels)
+    return runCSR();
+
   MetisGraph metisGraph;
   GGraph& graph = *metisGraph.getGraph();
 
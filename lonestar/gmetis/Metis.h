@@ -20,8 +20,11 @@
 #ifndef METIS_H_
 #define METIS_H_
 
+#include "galois/graphs/LC_CSR_Graph.h"
 #include "galois/graphs/LC_Morph_Graph.h"
 
+#include <limits>
+
 class MetisNode;
 using GGraph   = galois::graphs::LC_Morph_Graph<MetisNode, int>;
 using GNode    = GGraph::GraphNode;
@@ -147,7 +150,62 @@ public:
     MetisGraph* f = this;
     while (f->finer)
       f = f->finer;
-    return std::distance(f->graph.begin(), f->graph.end());
+    unsigned weight = 0;
+    for (auto n : f->graph)
+      weight +=
+          f->graph.getData(n, galois::MethodFlag::UNPROTECTED).getWeight();
+    return weight;
+  }
+};
+
+// Nodes in a CSR level of the metis graph. Children are not stored: each
+// fine node points to its parent in the coarser level instead.
+struct MetisCSRNode {
+  unsigned weight    = 1;
+  uint32_t match     = std::numeric_limits<uint32_t>::max();
+  uint32_t parent    = 0;
+  unsigned part      = 0;
+  bool maybeBoundary = false;
+};
+
+using CSRGraph = galois::graphs::LC_CSR_Graph<MetisCSRNode, int>::
+    with_no_lockable<true>::type;
+using CSRGNode = CSRGraph::GraphNode;
+
+// Hierarchy of CSR levels, the array-based counterpart of MetisGraph
+class MetisCSRGraph {
+  MetisCSRGraph* coarser;
+  MetisCSRGraph* finer;
+
+  CSRGraph graph;
+
+public:
+  MetisCSRGraph() : coarser(0), finer(0) {}
+
+  explicit MetisCSRGraph(MetisCSRGraph* finerGraph)
+      : coarser(0), finer(finerGraph) {
+    finer->coarser = this;
+  }
+
+  // Coarse levels are heap allocated by coarsenCSR and released by refineCSR
+  // once their partition has been projected onto the finer level
+  ~MetisCSRGraph() {
+    if (finer)
+      finer->coarser = 0;
+  }
+
+  const CSRGraph* getGraph() const { return &graph; }
+  CSRGraph* getGraph() { return &graph; }
+  MetisCSRGraph* getFinerGraph() const { return finer; }
+  MetisCSRGraph* getCoarserGraph() const { return coarser; }
+
+  unsigned getNumNodes() const { return graph.size(); }
+
+  unsigned getTotalWeight() {
+    MetisCSRGraph* f = this;
+    while (f->finer)
+      f = f->finer;
+    return f->graph.size();
   }
 };
 
@@ -194,22 +252,32 @@ unsigned graphStat(GGraph& graph);
 std::vector<unsigned> edgeCut(GGraph& g, unsigned nparts);
 void printCuts(const char* str, MetisGraph* g, unsigned numPartitions);
 unsigned computeCut(GGraph& g);
+unsigned graphStat(CSRGraph& graph);
+unsigned computeCut(CSRGraph& g);
 
 // Coarsening
 MetisGraph* coarsen(MetisGraph* fineMetisGraph, unsigned coarsenTo,
                     bool verbose);
+MetisCSRGraph* coarsenCSR(MetisCSRGraph* fineMetisGraph, unsigned coarsenTo,
+                          bool verbose);
 
 // Partitioning
 std::vector<partInfo> partition(MetisGraph* coarseMetisGraph,
                                 unsigned fineMetisGraphWeight,
                                 unsigned numPartitions,
                                 InitialPartMode partMode);
+std::vector<partInfo> partitionCSR(MetisCSRGraph* coarseMetisGraph,
+                                   unsigned fineMetisGraphWeight,
+                                   unsigned numPartitions,
+                                   InitialPartMode partMode);
 std::vector<partInfo> BisectAll(MetisGraph* mcg, unsigned numPartitions,
                                 unsigned maxSize);
 // Refinement
 void refine(MetisGraph* coarseGraph, std::vector<partInfo>& parts,
             unsigned minSize, unsigned maxSize, refinementMode refM,
             bool verbose);
+void refineCSR(MetisCSRGraph* coarseGraph, std::vector<partInfo>& parts,
+               unsigned minSize, unsigned maxSize, bool verbose);
 // void refinePart(GGraph& g, std::vector<partInfo>& parts, unsigned maxSize);
 // Balancing
 void balance(MetisGraph* Graph, std::vector<partInfo>& parts, unsigned maxSize);
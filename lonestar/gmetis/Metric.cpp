@@ -18,6 +18,8 @@
  */
 
 #include "Metis.h"
+#include "galois/Galois.h"
+#include "galois/Reduction.h"
 
 #include <iomanip>
 #include <iostream>
@@ -97,6 +99,29 @@ unsigned computeCut(GGraph& g) {
   return cuts / 2;
 }
 
+unsigned graphStat(CSRGraph& graph) {
+  onlineStat e;
+  for (auto n : graph)
+    e.add(std::distance(graph.edge_begin(n), graph.edge_end(n)));
+  std::cout << "Nodes " << e.count() << " Edges(total, var, min, max) "
+            << e.total() << " " << e.variance() << " " << e.min() << " "
+            << e.max();
+  return e.count();
+}
+
+unsigned computeCut(CSRGraph& g) {
+  galois::GAccumulator<uint64_t> cuts;
+  galois::do_all(galois::iterate(g),
+                 [&](CSRGNode n) {
+                   unsigned gPart = g.getData(n).part;
+                   for (auto ii : g.edges(n))
+                     if (g.getData(g.getEdgeDst(ii)).part != gPart)
+                       cuts += g.getEdgeData(ii);
+                 },
+                 galois::loopname("computeCut"));
+  return cuts.reduce() / 2;
+}
+
 void printPartStats(std::vector<partInfo>& parts) {
   onlineStat e;
   assert(!parts.empty());
@@ -460,6 +460,37 @@ std::vector<partInfo> partition(MetisGraph* mcg, unsigned fineMetisGraphWeight,
   return parts;
 }
 
+/*
+ * The coarsest CSR level is only a few times the number of partitions, so it
+ * is copied into a morph graph to reuse the bisection code above.
+ */
+std::vector<partInfo> partitionCSR(MetisCSRGraph* mcg,
+                                   unsigned fineMetisGraphWeight,
+                                   unsigned numPartitions,
+                                   InitialPartMode partMode) {
+  CSRGraph& cg = *mcg->getGraph();
+  MetisGraph metisGraph;
+  GGraph& g = *metisGraph.getGraph();
+  std::vector<GNode> nodes(cg.size());
+  for (auto n : cg)
+    nodes[n] = g.createNode(std::distance(cg.edge_begin(n), cg.edge_end(n)),
+                            (int)cg.getData(n).weight);
+  for (auto n : cg)
+    for (auto ii : cg.edges(n))
+      g.addMultiEdge(nodes[n], nodes[cg.getEdgeDst(ii)],
+                     galois::MethodFlag::UNPROTECTED, cg.getEdgeData(ii));
+
+  std::vector<partInfo> parts =
+      partition(&metisGraph, fineMetisGraphWeight, numPartitions, partMode);
+
+  for (auto n : cg) {
+    auto& nd         = cg.getData(n);
+    nd.part          = g.getData(nodes[n]).getPart();
+    nd.maybeBoundary = true;
+  }
+  return parts;
+}
+
 namespace {
 int edgeCount(GGraph& g) {
   int count = 0;
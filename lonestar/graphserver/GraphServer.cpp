@@ -0,0 +1,660 @@
+/*
+ * This file belongs to the Galois project, a C++ library for exploiting parallelism.
+ * The code is being released under the terms of the 3-Clause BSD License (a
+ * copy is located in LICENSE.txt at the top-level directory).
+ *
+ * Copyright (C) 2019, The University of Texas at Austin. All rights reserved.
+ * UNIVERSITY EXPRESSLY DISCLAIMS ANY AND ALL WARRANTIES CONCERNING THIS
+ * SOFTWARE AND DOCUMENTATION, INCLUDING ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR ANY PARTICULAR PURPOSE, NON-INFRINGEMENT AND WARRANTIES OF
+ * PERFORMANCE, AND ANY WARRANTY THAT MIGHT OTHERWISE ARISE FROM COURSE OF
+ * DEALING OR USAGE OF TRADE.  NO WARRANTY IS EITHER EXPRESS OR IMPLIED WITH
+ * RESPECT TO THE USE OF THE SOFTWARE OR DOCUMENTATION. Under no circumstances
+ * shall University be liable for incidental, special, indirect, direct or
+ * consequential damages or loss of profits, interruption of business, or
+ * related expenses which may arise from use of Software or Documentation,
+ * including but not limited to those resulting from defects in Software and/or
+ * Documentation, or loss or inaccuracy of data of any kind.
+ */
+
+#include "galois/Galois.h"
+#include "galois/AtomicHelpers.h"
+#include "galois/Bag.h"
+#include "galois/LargeArray.h"
+#include "galois/Reduction.h"
+#include "galois/Timer.h"
+#include "galois/graphs/LCGraph.h"
+#include "llvm/Support/CommandLine.h"
+
+#include "Lonestar/BoilerPlate.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cll = llvm::cl;
+
+static const char* name = "Graph Server";
+static const char* desc =
+    "Loads graphs once and answers batches of BFS, SSSP and personalized "
+    "PageRank queries read from stdin, a file or a Unix socket";
+static const char* url = 0;
+
+static cll::list<std::string>
+    graphFiles(cll::Positional, cll::desc("[<name>=]<input graph> ..."),
+               cll::OneOrMore);
+static cll::opt<std::string> socketPath(
+    "socket",
+    cll::desc("Serve clients on this Unix socket instead of stdin (default "
+              "value empty)"),
+    cll::init(""));
+static cll::opt<std::string>
+    queryFile("queries",
+              cll::desc("Read queries from this file instead of stdin "
+                        "(default value empty)"),
+              cll::init(""));
+static cll::opt<unsigned int>
+    stepShift("delta",
+              cll::desc("Default shift value for the SSSP delta step "
+                        "(default value 13)"),
+              cll::init(13));
+static cll::opt<float>
+    pprAlpha("alpha",
+             cll::desc("Default continuation probability of personalized "
+                       "PageRank (default value 0.85)"),
+             cll::init(0.85));
+static cll::opt<float>
+    pprTolerance("tolerance",
+                 cll::desc("Default residual tolerance of personalized "
+                           "PageRank (default value 1e-4)"),
+                 cll::init(1.0e-4));
+static cll::opt<unsigned int>
+    pprTop("top",
+           cll::desc("Default number of top ranked nodes reported by "
+                     "personalized PageRank (default value 10)"),
+           cll::init(10));
+
+using Graph = galois::graphs::LC_CSR_Graph<void, void>::with_no_lockable<
+    true>::type::with_numa_alloc<true>::type;
+using GNode = Graph::GraphNode;
+
+constexpr static const unsigned CHUNK_SIZE  = 64u;
+constexpr static const uint32_t DIST_INFINITY =
+    std::numeric_limits<uint32_t>::max() / 2 - 1;
+
+/**
+ * A graph kept in memory between queries. Edge weights are stored next to
+ * the topology (unweighted graphs have unit weights), and the node data of a
+ * query lives in arrays that are allocated once and reset by every query.
+ */
+struct ResidentGraph {
+  std::string name;
+  Graph graph;
+  //! empty if the file has no edge data
+  galois::LargeArray<uint32_t> weights;
+
+  galois::LargeArray<std::atomic<uint32_t>> dist;
+  galois::LargeArray<std::atomic<float>> rank;
+  galois::LargeArray<std::atomic<float>> residual;
+
+  bool weighted() const { return weights.size() != 0; }
+
+  uint32_t weight(Graph::edge_iterator e) const {
+    return weighted() ? weights[*e] : 1;
+  }
+
+  void load(const std::string& filename) {
+    galois::graphs::FileGraph f;
+    f.fromFile(filename);
+    if (f.edgeSize() != 0 && f.edgeSize() != sizeof(uint32_t)) {
+      GALOIS_DIE("edge data of ", filename, " is not 32-bit integers");
+    }
+    galois::graphs::readGraph(graph, f);
+
+    if (f.edgeSize()) {
+      weights.allocateInterleaved(graph.sizeEdges());
+      galois::do_all(galois::iterate(UINT64_C(0), graph.sizeEdges()),
+                     [&](uint64_t e) {
+                       weights[e] = f.getEdgeData<uint32_t>(
+                           galois::graphs::FileGraph::edge_iterator(e));
+                     },
+                     galois::no_stats());
+    }
+
+    dist.allocateInterleaved(graph.size());
+    rank.allocateInterleaved(graph.size());
+    residual.allocateInterleaved(graph.size());
+  }
+};
+
+//! Parsed arguments of one query batch
+struct QueryArgs {
+  std::vector<GNode> sources;
+  //! nodes whose distance is reported for every source
+  std::vector<GNode> reports;
+  unsigned delta;
+  float alpha;
+  float tolerance;
+  unsigned top;
+};
+
+static bool parseUnsigned(const std::string& s, unsigned long& value) {
+  char* end;
+  errno = 0;
+  value = std::strtoul(s.c_str(), &end, 10);
+  return !s.empty() && *end == '\0' && errno == 0 && s[0] != '-';
+}
+
+static bool parseFloat(const std::string& s, float& value) {
+  char* end;
+  value = std::strtof(s.c_str(), &end);
+  return !s.empty() && *end == '\0';
+}
+
+/**
+ * Parses "<source>... [key=value]..." for a query on rg. Returns an empty
+ * string on success, otherwise a description of the first bad token.
+ */
+static std::string parseArgs(std::istream& tokens, ResidentGraph& rg,
+                             QueryArgs& args) {
+  args.delta     = stepShift;
+  args.alpha     = pprAlpha;
+  args.tolerance = pprTolerance;
+  args.top       = pprTop;
+
+  std::string tok;
+  while (tokens >> tok) {
+    size_t eq = tok.find('=');
+    std::string key = eq == std::string::npos ? "" : tok.substr(0, eq);
+    std::string val = eq == std::string::npos ? tok : tok.substr(eq + 1);
+    unsigned long n;
+
+    if (key.empty() || key == "report") {
+      if (!parseUnsigned(val, n) || n >= rg.graph.size())
+        return "bad node " + val;
+      (key.empty() ? args.sources : args.reports).push_back(n);
+    } else if (key == "delta") {
+      if (!parseUnsigned(val, n) || n >= 32)
+        return "bad delta " + val;
+      args.delta = n;
+    } else if (key == "top") {
+      if (!parseUnsigned(val, n))
+        return "bad top " + val;
+      args.top = n;
+    } else if (key == "alpha") {
+      if (!parseFloat(val, args.alpha) || args.alpha < 0 || args.alpha >= 1)
+        return "bad alpha " + val;
+    } else if (key == "tolerance") {
+      if (!parseFloat(val, args.tolerance) || args.tolerance <= 0)
+        return "bad tolerance " + val;
+    } else {
+      return "unknown parameter " + key;
+    }
+  }
+  if (args.sources.empty())
+    return "no source nodes";
+  return "";
+}
+
+static void resetDist(ResidentGraph& rg) {
+  galois::do_all(
+      galois::iterate(rg.graph),
+      [&](GNode n) {
+        rg.dist[n].store(DIST_INFINITY, std::memory_order_relaxed);
+      },
+      galois::no_stats());
+}
+
+//! prints the number of reached nodes, the largest distance and the
+//! distances of the report nodes
+static void printDist(ResidentGraph& rg, const QueryArgs& args,
+                      std::ostream& out) {
+  galois::GAccumulator<size_t> reached;
+  galois::GReduceMax<uint32_t> maxDist;
+  galois::do_all(galois::iterate(rg.graph),
+                 [&](GNode n) {
+                   uint32_t d = rg.dist[n].load(std::memory_order_relaxed);
+                   if (d != DIST_INFINITY) {
+                     reached += 1;
+                     maxDist.update(d);
+                   }
+                 },
+                 galois::no_stats());
+
+  out << " reached " << reached.reduce() << " maxdist " << maxDist.reduce();
+  for (GNode r : args.reports) {
+    out << " " << r << ":";
+    uint32_t d = rg.dist[r];
+    if (d == DIST_INFINITY)
+      out << "inf";
+    else
+      out << d;
+  }
+}
+
+//! level-synchronous BFS from source into rg.dist
+static void bfsQuery(ResidentGraph& rg, GNode source, const QueryArgs& args,
+                     std::ostream& out) {
+  Graph& graph = rg.graph;
+  resetDist(rg);
+  rg.dist[source] = 0;
+
+  galois::InsertBag<GNode> bags[2];
+  galois::InsertBag<GNode>* curr = &bags[0];
+  galois::InsertBag<GNode>* next = &bags[1];
+  curr->push(source);
+
+  for (uint32_t level = 1; !curr->empty(); ++level) {
+    galois::do_all(
+        galois::iterate(*curr),
+        [&](GNode n) {
+          for (auto e : graph.edges(n, galois::MethodFlag::UNPROTECTED)) {
+            GNode dst         = graph.getEdgeDst(e);
+            uint32_t expected = DIST_INFINITY;
+            auto& d           = rg.dist[dst];
+            if (d.load(std::memory_order_relaxed) == DIST_INFINITY &&
+                d.compare_exchange_strong(expected, level))
+              next->push(dst);
+          }
+        },
+        galois::steal(), galois::chunk_size<CHUNK_SIZE>(), galois::no_stats());
+    curr->clear();
+    std::swap(curr, next);
+  }
+
+  printDist(rg, args, out);
+}
+
+//! delta-stepping SSSP from source into rg.dist
+static void ssspQuery(ResidentGraph& rg, GNode source, const QueryArgs& args,
+                      std::ostream& out) {
+  struct UpdateRequest {
+    GNode node;
+    uint32_t dist;
+  };
+
+  struct UpdateRequestIndexer {
+    unsigned shift;
+    unsigned int operator()(const UpdateRequest& req) const {
+      return req.dist >> shift;
+    }
+  };
+
+  namespace gwl = galois::worklists;
+  using PSchunk = gwl::PerSocketChunkFIFO<CHUNK_SIZE>;
+  using OBIM    = gwl::OrderedByIntegerMetric<UpdateRequestIndexer, PSchunk>;
+
+  Graph& graph = rg.graph;
+  resetDist(rg);
+  rg.dist[source] = 0;
+
+  galois::InsertBag<UpdateRequest> initBag;
+  initBag.push(UpdateRequest{source, 0});
+
+  galois::for_each(
+      galois::iterate(initBag),
+      [&](const UpdateRequest& req, auto& ctx) {
+        if (rg.dist[req.node].load(std::memory_order_relaxed) < req.dist)
+          return;
+        for (auto e : graph.edges(req.node, galois::MethodFlag::UNPROTECTED)) {
+          GNode dst        = graph.getEdgeDst(e);
+          uint32_t newDist = req.dist + rg.weight(e);
+          if (newDist < galois::atomicMin(rg.dist[dst], newDist))
+            ctx.push(UpdateRequest{dst, newDist});
+        }
+      },
+      galois::wl<OBIM>(UpdateRequestIndexer{args.delta}),
+      galois::no_conflicts(), galois::no_stats());
+
+  printDist(rg, args, out);
+}
+
+/**
+ * Personalized PageRank of source by forward push: a node keeps (1 - alpha)
+ * of its residual and pushes the rest to its out-neighbors (a node without
+ * out-edges pushes it back to the source). Prints the top ranked nodes.
+ */
+static void pprQuery(ResidentGraph& rg, GNode source, const QueryArgs& args,
+                     std::ostream& out) {
+  using WL     = galois::worklists::PerSocketChunkFIFO<CHUNK_SIZE>;
+  using Ranked = std::pair<float, GNode>;
+
+  Graph& graph          = rg.graph;
+  const float alpha     = args.alpha;
+  const float tolerance = args.tolerance;
+
+  galois::do_all(galois::iterate(graph),
+                 [&](GNode n) {
+                   rg.rank[n].store(0, std::memory_order_relaxed);
+                   rg.residual[n].store(0, std::memory_order_relaxed);
+                 },
+                 galois::no_stats());
+  rg.residual[source] = 1;
+
+  galois::InsertBag<GNode> initBag;
+  initBag.push(source);
+
+  galois::for_each(
+      galois::iterate(initBag),
+      [&](GNode n, auto& ctx) {
+        float r = rg.residual[n].exchange(0);
+        if (r == 0)
+          return;
+        galois::atomicAdd(rg.rank[n], (1 - alpha) * r);
+
+        auto push = [&](GNode dst, float delta) {
+          float old = galois::atomicAdd(rg.residual[dst], delta);
+          if (old <= tolerance && old + delta > tolerance)
+            ctx.push(dst);
+        };
+        auto ii = graph.edge_begin(n, galois::MethodFlag::UNPROTECTED);
+        auto ee = graph.edge_end(n, galois::MethodFlag::UNPROTECTED);
+        if (ii == ee) {
+          push(source, alpha * r);
+          return;
+        }
+        float delta = alpha * r / std::distance(ii, ee);
+        for (; ii != ee; ++ii)
+          push(graph.getEdgeDst(ii), delta);
+      },
+      galois::wl<WL>(), galois::no_conflicts(), galois::no_stats());
+
+  galois::InsertBag<Ranked> ranked;
+  galois::do_all(galois::iterate(graph),
+                 [&](GNode n) {
+                   float v = rg.rank[n].load(std::memory_order_relaxed);
+                   if (v > 0)
+                     ranked.push(Ranked(v, n));
+                 },
+                 galois::no_stats());
+
+  std::vector<Ranked> top(ranked.begin(), ranked.end());
+  auto mid = top.begin() + std::min<size_t>(args.top, top.size());
+  std::partial_sort(top.begin(), mid, top.end(),
+                    [](const Ranked& a, const Ranked& b) {
+                      return a.first == b.first ? a.second < b.second
+                                                : a.first > b.first;
+                    });
+
+  out << " ranked " << top.size() << " top";
+  for (auto it = top.begin(); it != mid; ++it)
+    out << " " << it->second << ":" << it->first;
+}
+
+using QueryFn = void (*)(ResidentGraph&, GNode, const QueryArgs&,
+                         std::ostream&);
+
+class GraphServer {
+  std::vector<std::unique_ptr<ResidentGraph>> graphs;
+  //! latency of every query answered so far (usec), by algorithm
+  std::map<std::string, std::vector<unsigned long>> latencies;
+
+  ResidentGraph* find(const std::string& graphName) {
+    for (auto& g : graphs)
+      if (g->name == graphName)
+        return g.get();
+    return nullptr;
+  }
+
+  //! runs one query per source and prints one line per query
+  void batch(const std::string& algo, QueryFn fn, std::istream& tokens,
+             std::ostream& out) {
+    std::string graphName;
+    tokens >> graphName;
+    ResidentGraph* rg = find(graphName);
+    if (!rg) {
+      out << "error unknown graph " << graphName << "\n";
+      return;
+    }
+    QueryArgs args;
+    std::string err = parseArgs(tokens, *rg, args);
+    if (!err.empty()) {
+      out << "error " << err << "\n";
+      return;
+    }
+
+    std::vector<unsigned long>& lat = latencies[algo];
+    for (GNode source : args.sources) {
+      std::ostringstream result;
+      galois::Timer timer;
+      timer.start();
+      fn(*rg, source, args, result);
+      timer.stop();
+      lat.push_back(timer.get_usec());
+      out << algo << " " << rg->name << " " << source << " usec "
+          << timer.get_usec() << result.str() << "\n";
+    }
+  }
+
+  //! latency percentile of sorted samples: the smallest sample with at
+  //! least p percent of the samples at or below it (nearest rank)
+  static unsigned long percentile(const std::vector<unsigned long>& sorted,
+                                  double p) {
+    size_t rank = static_cast<size_t>(std::ceil(p / 100 * sorted.size()));
+    return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+  }
+
+public:
+  void load(const std::string& spec) {
+    size_t eq = spec.find('=');
+    std::unique_ptr<ResidentGraph> rg(new ResidentGraph);
+    rg->name = eq == std::string::npos ? std::to_string(graphs.size())
+                                       : spec.substr(0, eq);
+    if (find(rg->name))
+      GALOIS_DIE("duplicate graph name ", rg->name);
+
+    galois::StatTimer loadTime("LoadTime", rg->name.c_str());
+    loadTime.start();
+    rg->load(eq == std::string::npos ? spec : spec.substr(eq + 1));
+    loadTime.stop();
+
+    std::cout << "Loaded graph " << rg->name << " with " << rg->graph.size()
+              << " nodes and " << rg->graph.sizeEdges() << " edges"
+              << (rg->weighted() ? "" : " (unit weights)") << "\n";
+    graphs.push_back(std::move(rg));
+  }
+
+  //! prints count and latency percentiles (usec) of each algorithm
+  void printStats(std::ostream& out) {
+    for (auto& kv : latencies) {
+      if (kv.second.empty())
+        continue;
+      std::vector<unsigned long> sorted(kv.second);
+      std::sort(sorted.begin(), sorted.end());
+      out << "stats " << kv.first << " queries " << sorted.size() << " p50 "
+          << percentile(sorted, 50) << " p90 " << percentile(sorted, 90)
+          << " p99 " << percentile(sorted, 99) << " max " << sorted.back()
+          << "\n";
+    }
+  }
+
+  void reportStats() {
+    for (auto& kv : latencies) {
+      if (kv.second.empty())
+        continue;
+      std::vector<unsigned long> sorted(kv.second);
+      std::sort(sorted.begin(), sorted.end());
+      const char* region = kv.first.c_str();
+      galois::runtime::reportStat_Single(region, "Queries", sorted.size());
+      galois::runtime::reportStat_Single(region, "LatencyP50",
+                                         percentile(sorted, 50));
+      galois::runtime::reportStat_Single(region, "LatencyP90",
+                                         percentile(sorted, 90));
+      galois::runtime::reportStat_Single(region, "LatencyP99",
+                                         percentile(sorted, 99));
+      galois::runtime::reportStat_Single(region, "LatencyMax", sorted.back());
+    }
+  }
+
+  /**
+   * Answers the commands read from in, one per line. Every command is
+   * answered with its result lines followed by "done". Returns false if the
+   * client asked to shut the server down.
+   */
+  bool serve(std::istream& in, std::ostream& out) {
+    std::string line;
+    while (std::getline(in, line)) {
+      std::istringstream tokens(line);
+      std::string cmd;
+      if (!(tokens >> cmd) || cmd[0] == '#')
+        continue;
+
+      if (cmd == "quit") {
+        return true;
+      } else if (cmd == "shutdown") {
+        return false;
+      } else if (cmd == "graphs") {
+        for (auto& g : graphs)
+          out << "graph " << g->name << " nodes " << g->graph.size()
+              << " edges " << g->graph.sizeEdges()
+              << (g->weighted() ? " weighted" : "") << "\n";
+      } else if (cmd == "stats") {
+        printStats(out);
+      } else if (cmd == "bfs") {
+        batch(cmd, bfsQuery, tokens, out);
+      } else if (cmd == "sssp") {
+        batch(cmd, ssspQuery, tokens, out);
+      } else if (cmd == "ppr") {
+        batch(cmd, pprQuery, tokens, out);
+      } else {
+        out << "error unknown command " << cmd << "\n";
+      }
+      out << "done" << std::endl;
+    }
+    return true;
+  }
+};
+
+//! buffered stream over a connected socket
+class SocketBuf : public std::streambuf {
+  int fd;
+  char inBuf[4096];
+  char outBuf[4096];
+
+public:
+  explicit SocketBuf(int _fd) : fd(_fd) {
+    setg(inBuf, inBuf, inBuf);
+    setp(outBuf, outBuf + sizeof(outBuf));
+  }
+
+  ~SocketBuf() { sync(); }
+
+protected:
+  int_type underflow() override {
+    ssize_t n;
+    do {
+      n = ::read(fd, inBuf, sizeof(inBuf));
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0)
+      return traits_type::eof();
+    setg(inBuf, inBuf, inBuf + n);
+    return traits_type::to_int_type(*gptr());
+  }
+
+  int_type overflow(int_type c) override {
+    if (sync() < 0)
+      return traits_type::eof();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+    return traits_type::not_eof(c);
+  }
+
+  int sync() override {
+    for (char* p = pbase(); p < pptr();) {
+      // a client that went away must not kill the server with SIGPIPE
+      ssize_t n = ::send(fd, p, pptr() - p, MSG_NOSIGNAL);
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n < 0) {
+        setp(outBuf, outBuf + sizeof(outBuf));
+        return -1;
+      }
+      p += n;
+    }
+    setp(outBuf, outBuf + sizeof(outBuf));
+    return 0;
+  }
+};
+
+//! serves clients of the socket at path one at a time until one of them
+//! shuts the server down
+static void serveSocket(GraphServer& server, const std::string& path) {
+  sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path))
+    GALOIS_DIE("socket path too long: ", path);
+  std::strcpy(addr.sun_path, path.c_str());
+
+  int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenFd < 0)
+    GALOIS_SYS_DIE("socket");
+  unlink(path.c_str());
+  if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+    GALOIS_SYS_DIE("bind ", path);
+  if (listen(listenFd, 16) < 0)
+    GALOIS_SYS_DIE("listen ", path);
+  std::cout << "Listening on " << path << std::endl;
+
+  for (bool running = true; running;) {
+    int fd = accept(listenFd, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR)
+        continue;
+      GALOIS_SYS_DIE("accept ", path);
+    }
+    {
+      SocketBuf buf(fd);
+      std::istream in(&buf);
+      std::ostream out(&buf);
+      running = server.serve(in, out);
+    }
+    close(fd);
+  }
+
+  close(listenFd);
+  unlink(path.c_str());
+}
+
+int main(int argc, char** argv) {
+  galois::SharedMemSys G;
+  LonestarStart(argc, argv, name, desc, url);
+
+  GraphServer server;
+  for (const std::string& spec : graphFiles)
+    server.load(spec);
+
+  if (!queryFile.empty()) {
+    std::ifstream in(queryFile);
+    if (!in)
+      GALOIS_DIE("cannot open query file ", queryFile);
+    server.serve(in, std::cout);
+  } else if (socketPath.empty()) {
+    std::cout << "Reading queries from stdin" << std::endl;
+    server.serve(std::cin, std::cout);
+  } else {
+    serveSocket(server, socketPath);
+  }
+
+  server.reportStats();
+  return 0;
+}
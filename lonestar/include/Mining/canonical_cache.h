@@ -0,0 +1,89 @@
+#ifndef CANONICAL_CACHE_HPP_
+#define CANONICAL_CACHE_HPP_
+#include "quick_pattern.h"
+#include "canonical_graph.h"
+#include "galois/Reduction.h"
+#include "galois/runtime/Statistics.h"
+#include "galois/substrate/PaddedLock.h"
+
+// Memoizes the canonical labeling of quick patterns. Turning a quick pattern
+// into its canonical graph runs bliss, while the number of distinct quick
+// patterns is tiny compared to the number of embeddings, so the same patterns
+// are canonicalized over and over (in every filtering pass and by every
+// thread). The cache is split into shards by quick pattern hash, each a map
+// guarded by its own lock, and is shared by all threads. Entries are never
+// evicted, so they are kept across levels.
+class CanonicalCache {
+public:
+	// find the canonical graph of qp; returns null if it is not cached yet.
+	// Entries never move, so the graph can be used without holding the lock
+	const CanonicalGraph* find(const QuickPattern& qp) {
+		Shard& shard = shards[qp.get_hash() % NUM_SHARDS];
+		shard.lock.lock();
+		const CanonicalGraph* cg = shard.find(qp);
+		shard.lock.unlock();
+		if (cg) hits += 1;
+		else misses += 1;
+		return cg;
+	}
+	// insert the canonical graph of qp and return the cached graph; if
+	// another thread got there first, its entry is kept (both are the same
+	// graph)
+	const CanonicalGraph* insert(const QuickPattern& qp, const CanonicalGraph& cg) {
+		Shard& shard = shards[qp.get_hash() % NUM_SHARDS];
+		shard.lock.lock();
+		const CanonicalGraph* cached = shard.find(qp);
+		if (!cached) cached = &shard.map.emplace(qp.get_hash(), Entry(qp, cg))->second.cg;
+		shard.lock.unlock();
+		return cached;
+	}
+	size_t size() const {
+		size_t n = 0;
+		for (unsigned i = 0; i < NUM_SHARDS; i ++) n += shards[i].map.size();
+		return n;
+	}
+	// report lookups, hits, and the hit rate (in percent) to the stat manager
+	void report(const char* region) {
+		size_t h = hits.reduce(), m = misses.reduce();
+		galois::runtime::reportStat_Single(region, "CanonicalCacheLookups", h + m);
+		galois::runtime::reportStat_Single(region, "CanonicalCacheHits", h);
+		galois::runtime::reportStat_Single(region, "CanonicalCacheHitRate", h + m ? 100.0 * h / (h + m) : 0.0);
+		galois::runtime::reportStat_Single(region, "CanonicalCacheEntries", size());
+	}
+
+private:
+	static const unsigned NUM_SHARDS = 64;
+	// an entry keeps its own copy of the elements of the quick pattern, since
+	// quick patterns are released by their users with clean()
+	struct Entry {
+		std::vector<ElementType> elements;
+		CanonicalGraph cg;
+		Entry(const QuickPattern& qp, const CanonicalGraph& g) : cg(g) {
+			elements.reserve(qp.get_size());
+			for (unsigned i = 0; i < qp.get_size(); ++i) elements.push_back(qp.at(i));
+		}
+		bool matches(const QuickPattern& qp) const {
+			if (elements.size() != qp.get_size()) return false;
+			for (size_t i = 0; i < elements.size(); ++i)
+				if (elements[i].cmp(qp.at(i)) != 0) return false;
+			return true;
+		}
+	};
+	// entries keyed by quick pattern hash; lookups compare the quick pattern
+	// in place, without building a key
+	struct Shard {
+		galois::substrate::PaddedLock<true> lock;
+		std::unordered_multimap<unsigned, Entry> map;
+		const CanonicalGraph* find(const QuickPattern& qp) const {
+			auto range = map.equal_range(qp.get_hash());
+			for (auto it = range.first; it != range.second; ++it)
+				if (it->second.matches(qp)) return &it->second.cg;
+			return nullptr;
+		}
+	};
+	Shard shards[NUM_SHARDS];
+	galois::GAccumulator<size_t> hits;
+	galois::GAccumulator<size_t> misses;
+};
+
+#endif // CANONICAL_CACHE_HPP_
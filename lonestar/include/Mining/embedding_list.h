@@ -0,0 +1,163 @@
+#ifndef EMBEDDING_LIST_HPP_
+#define EMBEDDING_LIST_HPP_
+#include "type.h"
+#include "galois/Galois.h"
+
+// Level-wise embedding list (Pangolin-style prefix tree). Instead of storing a
+// full copy of every embedding, level l holds one element per embedding of
+// size l+1: the vertex added at that level, the index of the parent embedding
+// in level l-1, and the history info (the element the new edge attaches to).
+// An embedding is recovered by following parent indices back to level 0, so
+// embeddings that share a prefix share its storage.
+typedef unsigned IndexTy;
+#define MAX_EMBEDDING_SIZE 32
+
+class EmbeddingList {
+public:
+	EmbeddingList() {}
+	~EmbeddingList() {}
+	// level 0 is the source vertex and level 1 the destination vertex of
+	// every edge (src, dst) with src < dst
+	template <typename GraphTy>
+	void init(GraphTy& graph) {
+		vid_lists.resize(2);
+		idx_lists.resize(2);
+		his_lists.resize(2);
+		// one embedding per edge; sizes of the edge lists give the offsets
+		std::vector<IndexTy> offsets(graph.size() + 1, 0);
+		galois::do_all(galois::iterate(graph.begin(), graph.end()),
+			[&](const typename GraphTy::GraphNode& src) {
+				IndexTy n = 0;
+				for (auto e : graph.edges(src))
+					if (src < graph.getEdgeDst(e)) n ++;
+				offsets[src + 1] = n;
+			},
+			galois::no_stats(), galois::loopname("EmbeddingListCount")
+		);
+		for (size_t i = 0; i < graph.size(); i ++) offsets[i + 1] += offsets[i];
+		size_t num_edges = offsets[graph.size()];
+		GALOIS_ASSERT(num_edges < (size_t)std::numeric_limits<IndexTy>::max());
+		add_level(0, graph.size());
+		add_level(1, num_edges);
+		galois::do_all(galois::iterate(graph.begin(), graph.end()),
+			[&](const typename GraphTy::GraphNode& src) {
+				vid_lists[0][src] = src;
+				IndexTy pos = offsets[src];
+				for (auto e : graph.edges(src)) {
+					auto dst = graph.getEdgeDst(e);
+					if (src < dst) {
+						vid_lists[1][pos] = dst;
+						idx_lists[1][pos] = src;
+						his_lists[1][pos] = 0;
+						pos ++;
+					}
+				}
+			},
+			galois::no_stats(), galois::loopname("EmbeddingListInit")
+		);
+	}
+	// number of embeddings in the last level
+	size_t size() const { return vid_lists.back().size(); }
+	size_t size(unsigned level) const { return vid_lists[level].size(); }
+	// number of elements of the embeddings in the last level
+	unsigned get_num_levels() const { return vid_lists.size(); }
+	VertexId get_vid(unsigned level, size_t id) const { return vid_lists[level][id]; }
+	IndexTy get_idx(unsigned level, size_t id) const { return idx_lists[level][id]; }
+	BYTE get_his(unsigned level, size_t id) const { return his_lists[level][id]; }
+	void set_vid(unsigned level, size_t id, VertexId vid) { vid_lists[level][id] = vid; }
+	void set_idx(unsigned level, size_t id, IndexTy idx) { idx_lists[level][id] = idx; }
+	void set_his(unsigned level, size_t id, BYTE his) { his_lists[level][id] = his; }
+	// allocate the arrays of a level for 'size' embeddings
+	void add_level(unsigned level, size_t size) {
+		GALOIS_ASSERT(size < (size_t)std::numeric_limits<IndexTy>::max());
+		if (level >= vid_lists.size()) {
+			vid_lists.resize(level + 1);
+			idx_lists.resize(level + 1);
+			his_lists.resize(level + 1);
+		}
+		vid_lists[level].resize(size);
+		idx_lists[level].resize(size);
+		his_lists[level].resize(size);
+	}
+	// copy embedding 'id' of the given level into emb[0..level], with the
+	// same elements Miner::extend_edge would have built
+	template <typename GraphTy>
+	void get_embedding(GraphTy& graph, unsigned level, size_t id, ElementType* emb) const {
+		assert(level < MAX_EMBEDDING_SIZE);
+		VertexId vids[MAX_EMBEDDING_SIZE];
+		BYTE his[MAX_EMBEDDING_SIZE];
+		for (unsigned l = level; l > 0; l --) {
+			vids[l] = vid_lists[l][id];
+			his[l] = his_lists[l][id];
+			id = idx_lists[l][id];
+		}
+		vids[0] = vid_lists[0][id];
+		// the initial edge carries vertex ids only
+		emb[0] = ElementType(vids[0]);
+		if (level > 0) emb[1] = ElementType(vids[1]);
+		unsigned num_vertices = 2;
+		for (unsigned l = 2; l <= level; l ++) {
+			bool existed = false;
+			for (unsigned j = 0; j < l; j ++)
+				if (vids[j] == vids[l]) { existed = true; break; }
+			if (!existed) num_vertices ++;
+			BYTE vertex_label = 0;
+			#ifdef ENABLE_LABEL
+			vertex_label = graph.getData(vids[l]);
+			#endif
+			emb[l] = ElementType(vids[l], (BYTE)num_vertices, 0, vertex_label, his[l]);
+		}
+	}
+	// drop the last level
+	void remove_level() {
+		vid_lists.pop_back();
+		idx_lists.pop_back();
+		his_lists.pop_back();
+	}
+	// bytes used by all levels
+	size_t get_memory() const {
+		size_t bytes = 0;
+		for (unsigned l = 0; l < vid_lists.size(); l ++)
+			bytes += size(l) * (sizeof(VertexId) + sizeof(IndexTy) + sizeof(BYTE));
+		return bytes;
+	}
+	void clean() {
+		vid_lists.clear();
+		idx_lists.clear();
+		his_lists.clear();
+	}
+
+private:
+	std::vector<std::vector<VertexId> > vid_lists;
+	std::vector<std::vector<IndexTy> > idx_lists;
+	std::vector<std::vector<BYTE> > his_lists;
+};
+
+// exclusive prefix sum of counts[0..n) into offsets (of size n + 1),
+// computed by blocks of one per thread
+inline void parallel_prefix_sum(const IndexTy* counts, size_t n, std::vector<size_t>& offsets) {
+	offsets.resize(n + 1);
+	unsigned num_blocks = galois::getActiveThreads();
+	std::vector<size_t> block_sums(num_blocks + 1, 0);
+	auto block_begin = [&](unsigned b) { return n * b / num_blocks; };
+	galois::on_each([&](unsigned tid, unsigned nthreads) {
+		for (unsigned b = tid; b < num_blocks; b += nthreads) {
+			size_t sum = 0;
+			for (size_t i = block_begin(b); i < block_begin(b + 1); i ++) sum += counts[i];
+			block_sums[b + 1] = sum;
+		}
+	});
+	for (unsigned b = 0; b < num_blocks; b ++) block_sums[b + 1] += block_sums[b];
+	galois::on_each([&](unsigned tid, unsigned nthreads) {
+		for (unsigned b = tid; b < num_blocks; b += nthreads) {
+			size_t sum = block_sums[b];
+			for (size_t i = block_begin(b); i < block_begin(b + 1); i ++) {
+				offsets[i] = sum;
+				sum += counts[i];
+			}
+		}
+	});
+	offsets[n] = block_sums[num_blocks];
+}
+
+#endif // EMBEDDING_LIST_HPP_
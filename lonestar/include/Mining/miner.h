@@ -2,8 +2,11 @@
 #define MINER_HPP_
 #include "quick_pattern.h"
 #include "canonical_graph.h"
+#include "canonical_cache.h"
+#include "embedding_list.h"
 #include "galois/Bag.h"
 #include "galois/Galois.h"
+#include "galois/SetIntersection.h"
 #include "galois/substrate/PerThreadStorage.h"
 #include "galois/substrate/SimpleLock.h"
 
@@ -80,6 +83,52 @@ public:
 			}
 		}
 	}
+	// edge extension on a level-wise embedding list: adds a level with every
+	// extension of the embeddings in the last level. Runs in two parallel
+	// passes (count, then fill) so that nothing is allocated per embedding.
+	void extend_edge(unsigned max_size, EmbeddingList& emb_list) {
+		std::vector<IndexTy> num_new_emb;
+		count_edge_extensions(max_size, emb_list, num_new_emb);
+		extend_edge(max_size, emb_list, 0, emb_list.size(), num_new_emb);
+	}
+	// number of edge extensions of each embedding in the last level
+	void count_edge_extensions(unsigned max_size, EmbeddingList& emb_list, std::vector<IndexTy>& num_new_emb) {
+		unsigned level = emb_list.get_num_levels() - 1;
+		GALOIS_ASSERT(level + 2 <= MAX_EMBEDDING_SIZE);
+		num_new_emb.resize(emb_list.size());
+		galois::do_all(galois::iterate((size_t)0, emb_list.size()),
+			[&](size_t pos) {
+				ElementType emb[MAX_EMBEDDING_SIZE];
+				emb_list.get_embedding(*graph, level, pos, emb);
+				IndexTy num = 0;
+				for_each_edge_extension(max_size, emb, level + 1, [&](VertexId, BYTE) { num ++; });
+				num_new_emb[pos] = num;
+			},
+			galois::chunk_size<256>(), galois::steal(), galois::loopname("ExtendEdgeCount")
+		);
+	}
+	// adds a level with the extensions of embeddings [begin, end) of the last
+	// level, given their number of extensions from count_edge_extensions
+	void extend_edge(unsigned max_size, EmbeddingList& emb_list, size_t begin, size_t end, const std::vector<IndexTy>& num_new_emb) {
+		unsigned level = emb_list.get_num_levels() - 1;
+		std::vector<size_t> offsets;
+		parallel_prefix_sum(num_new_emb.data() + begin, end - begin, offsets);
+		emb_list.add_level(level + 1, offsets[end - begin]);
+		galois::do_all(galois::iterate(begin, end),
+			[&](size_t pos) {
+				ElementType emb[MAX_EMBEDDING_SIZE];
+				emb_list.get_embedding(*graph, level, pos, emb);
+				size_t start = offsets[pos - begin];
+				for_each_edge_extension(max_size, emb, level + 1, [&](VertexId dst, BYTE history) {
+					emb_list.set_vid(level + 1, start, dst);
+					emb_list.set_idx(level + 1, start, pos);
+					emb_list.set_his(level + 1, start, history);
+					start ++;
+				});
+			},
+			galois::chunk_size<256>(), galois::steal(), galois::loopname("ExtendEdgeFill")
+		);
+	}
 	// extend edge when input graph is DAG (no automorphism check is required)
 	void extend_edge_DAG(unsigned max_size, Embedding emb, EmbeddingQueue &queue) {
 		unsigned size = emb.size();
@@ -166,16 +215,11 @@ public:
 		for(auto e1 : graph->edges(src)) {
 			GNode dst = graph->getEdgeDst(e1);
 			if(dst > src) {
-				unsigned num_edges = 0;
-				for(auto e2 : graph->edges(dst)) {
-					GNode dst_dst = graph->getEdgeDst(e2);
-					for(unsigned i = 0; i < n; ++i) {
-						if (dst_dst == emb[i]) {
-							num_edges ++;
-							break;
-						}
-					}
-				}
+				// vertices are added in ascending order, so the embedding is
+				// sorted and can be intersected with the adjacency list of dst
+				auto begin = graph->edge_begin(dst);
+				size_t num_edges = galois::intersect::count(graph->getEdgeDstPtr(begin),
+					graph->edge_end(dst) - begin, emb.data(), n);
 				if(num_edges == n) {
 					emb.push_back(dst);
 					queue.push_back(emb);
@@ -184,6 +228,41 @@ public:
 			}
 		}
 	}
+	// upper bound on the number of clique extensions of each embedding: the
+	// neighbors of its last vertex that come after it
+	void count_clique_extensions(const std::vector<BaseEmbedding>& embs, std::vector<size_t>& num_new_emb) {
+		num_new_emb.resize(embs.size());
+		galois::do_all(galois::iterate((size_t)0, embs.size()),
+			[&](size_t i) {
+				VertexId src = embs[i].back();
+				auto begin = graph->edge_begin(src);
+				// adjacency lists are sorted by destination
+				const GNode* first = graph->getEdgeDstPtr(begin);
+				const GNode* last = first + (graph->edge_end(src) - begin);
+				num_new_emb[i] = last - std::upper_bound(first, last, src);
+			},
+			galois::chunk_size<256>(), galois::steal(), galois::loopname("ExtendCliqueCount")
+		);
+	}
+	// extends embeddings [begin, end) of embs with extend_vertex_clique
+	void extend_vertex_clique(const std::vector<BaseEmbedding>& embs, size_t begin, size_t end, BaseEmbeddingQueue &queue) {
+		galois::do_all(galois::iterate(begin, end),
+			[&](size_t i) { extend_vertex_clique(embs[i], queue); },
+			galois::chunk_size<256>(), galois::steal(), galois::loopname("ExtendClique")
+		);
+	}
+	// end of the chunk of embeddings starting at 'begin' whose extensions
+	// (counted by count_edge_extensions or count_clique_extensions) fit in
+	// 'budget'; a chunk has at least one embedding, even if it alone
+	// exceeds the budget
+	template <typename CountTy>
+	static size_t chunk_end(const std::vector<CountTy>& num_new_emb, size_t begin, size_t budget) {
+		size_t end = begin, chunk = 0;
+		do {
+			chunk += num_new_emb[end ++];
+		} while (end < num_new_emb.size() && chunk + num_new_emb[end] <= budget);
+		return end;
+	}
 	void aggregate_clique(BaseEmbeddingQueue &in_queue, BaseEmbeddingQueue &out_queue) {
 		SimpleMap simple_agg;
 		for (auto emb : in_queue) {
@@ -250,6 +329,16 @@ public:
 			emb.set_qpid(qp.get_id());
 		}
 	}
+	// aggregate an embedding given as an array of elements (e.g. read from an
+	// EmbeddingList) into quick patterns
+	inline void quick_aggregate_each(const ElementType* emb, unsigned size, QpMapFreq& qp_map) {
+		QuickPattern qp(emb, size);
+		auto it = qp_map.find(qp);
+		if (it != qp_map.end()) {
+			it->second += 1;
+			qp.clean();
+		} else qp_map[qp] = 1;
+	}
 	inline void quick_aggregate_each(Embedding& emb, QpMapDomain& qp_map) {
 		QuickPattern qp(emb);
 		bool qp_existed = false;
@@ -311,6 +400,20 @@ public:
 		}
 		delete cg;
 	}
+	void canonical_aggregate_each(QuickPattern qp, DomainSupport domainSets, CgMapDomain& cg_map) {
+		assert(qp.get_size() == domainSets.size());
+		unsigned numDomains = qp.get_size();
+		// turn the quick pattern into its canonical pattern
+		CanonicalGraph* cg = turn_canonical_graph(qp, false);
+		auto it = cg_map.find(*cg);
+		if (it == cg_map.end()) cg_map[*cg].resize(numDomains);
+		for (unsigned i = 0; i < numDomains; i ++) {
+			unsigned qp_idx = cg->get_quick_pattern_index(i);
+			assert(qp_idx >= 0 && qp_idx < numDomains);
+			cg_map[*cg][i].insert(domainSets[qp_idx].begin(), domainSets[qp_idx].end());
+		}
+		delete cg;
+	}
 	void canonical_aggregate_each(QuickPattern qp, DomainSupport domainSets, CgMapDomain& cg_map, UintMap &id_map) {
 		assert(qp.get_size() == domainSets.size());
 		unsigned numDomains = qp.get_size();
@@ -340,11 +443,10 @@ public:
 		for (auto emb : in_queue) {
 			QuickPattern qp(emb);
 			//turn_quick_pattern_pure(emb, qp);
-			CanonicalGraph* cf = turn_canonical_graph(qp, false);
+			const CanonicalGraph& cf = cached_canonical_graph(qp);
 			qp.clean();
-			assert(cg_map.find(*cf) != cg_map.end());
-			if(cg_map[*cf] >= threshold) out_queue.push_back(emb);
-			delete cf;
+			assert(cg_map.find(cf) != cg_map.end());
+			if(cg_map[cf] >= threshold) out_queue.push_back(emb);
 		}
 	}
 	// filtering for FSM
@@ -353,47 +455,46 @@ public:
 		// find the quick pattern of this embedding
 		QuickPattern qp(emb);
 		// find the pattern (canonical graph) of this embedding
-		CanonicalGraph* cf = turn_canonical_graph(qp, false);
+		const CanonicalGraph& cf = cached_canonical_graph(qp);
 		qp.clean();
-		//assert(cg_map.find(*cf) != cg_map.end());
+		//assert(cg_map.find(cf) != cg_map.end());
 		// compare the count of this pattern with the threshold
 		// if the pattern is frequent, insert this embedding into the task queue
-		if (cg_map[*cf] >= threshold) out_queue.push_back(emb);
-		delete cf;
+		// (at, since cg_map is shared by all threads)
+		if (cg_map.at(cf) >= threshold) out_queue.push_back(emb);
 	}
 	void filter(EmbeddingQueue &in_queue, CgMapDomain &cg_map, EmbeddingQueue &out_queue) {
 		for (auto emb : in_queue) {
 			QuickPattern qp(emb);
-			CanonicalGraph* cf = turn_canonical_graph(qp, false);
+			const CanonicalGraph& cf = cached_canonical_graph(qp);
 			qp.clean();
-			assert(cg_map.find(*cf) != cg_map.end());
+			assert(cg_map.find(cf) != cg_map.end());
 			bool is_frequent = true;
-			unsigned numOfDomains = cg_map[*cf].size();
+			unsigned numOfDomains = cg_map[cf].size();
 			for (unsigned i = 0; i < numOfDomains; i ++) {
-				if (cg_map[*cf][i].size() < threshold) {
+				if (cg_map[cf][i].size() < threshold) {
 					is_frequent = false;
 					break;
 				}
 			}
 			if (is_frequent) out_queue.push_back(emb);
-			delete cf;
 		}
 	}
 	void filter_each(Embedding &emb, CgMapDomain &cg_map, EmbeddingQueue &out_queue) {
 		QuickPattern qp(emb);
-		CanonicalGraph* cf = turn_canonical_graph(qp, false);
+		const CanonicalGraph& cf = cached_canonical_graph(qp);
 		qp.clean();
-		//assert(cg_map.find(*cf) != cg_map.end());
+		//assert(cg_map.find(cf) != cg_map.end());
 		bool is_frequent = true;
-		unsigned numOfDomains = cg_map[*cf].size();
+		const DomainSupport& domains = cg_map.at(cf);
+		unsigned numOfDomains = domains.size();
 		for (unsigned i = 0; i < numOfDomains; i ++) {
-			if (cg_map[*cf][i].size() < threshold) {
+			if (domains[i].size() < threshold) {
 				is_frequent = false;
 				break;
 			}
 		}
 		if (is_frequent) out_queue.push_back(emb);
-		delete cf;
 	}
 	inline void filter(EmbeddingQueue &in_queue, const UintMap id_map, const UintMap support_map, EmbeddingQueue &out_queue) {
 		for (auto emb : in_queue) {
@@ -417,6 +518,7 @@ public:
 	}
 	inline unsigned get_embedding_size() { return embedding_size; }
 	unsigned get_total_num_cliques() { return num_cliques; }
+	void report_cache_stats(const char* region) { cg_cache.report(region); }
 	void printout_embedding(int level, Embedding emb) {
 		if(emb.size() == 0) {
 			std::cout << "(empty)";
@@ -493,15 +595,19 @@ private:
 	Graph *graph;
 	unsigned num_cliques;
 	galois::substrate::SimpleLock slock;
+	CanonicalCache cg_cache; // quick pattern -> canonical graph, shared by all threads
 	inline bool is_automorphism(Embedding & emb, BYTE history, VertexId src, VertexId dst, const bool vertex_existed) {
+		return is_automorphism(emb.data(), emb.size(), history, src, dst, vertex_existed);
+	}
+	inline bool is_automorphism(const ElementType* emb, unsigned size, BYTE history, VertexId src, VertexId dst, const bool vertex_existed) {
 		//check with the first element
-		if(dst < emb.front().vertex_id) return true;
+		if(dst < emb[0].vertex_id) return true;
 		//check loop edge
 		if(dst == emb[emb[history].history_info].vertex_id) return true;
 		//check to see if there already exists the vertex added; if so, just allow to add edge which is (smaller id -> bigger id)
 		if(vertex_existed && src > dst) return true;
 		std::pair<VertexId, VertexId> added_edge(src, dst);
-		for(unsigned index = history + 1; index < emb.size(); ++index) {
+		for(unsigned index = history + 1; index < size; ++index) {
 			std::pair<VertexId, VertexId> edge;
 			getEdge(emb, index, edge);
 			int cmp = compare(added_edge, edge);
@@ -541,7 +647,20 @@ private:
 		return cf;
 	}
 //*/
+	// the canonical graph of qp, canonicalized only the first time qp is
+	// seen. Used by the filtering paths, which look up the pattern of every
+	// embedding; aggregation canonicalizes each quick pattern once, so it
+	// would only fill the cache without hitting it
+	const CanonicalGraph& cached_canonical_graph(QuickPattern & qp) {
+		const CanonicalGraph* cg = cg_cache.find(qp);
+		if (cg) return *cg;
+		CanonicalGraph* cf = turn_canonical_graph(qp, false);
+		cg = cg_cache.insert(qp, *cf);
+		delete cf;
+		return *cg;
+	}
 	CanonicalGraph* turn_canonical_graph(QuickPattern & qp, const bool is_directed) {
+		CanonicalGraph* cg = new CanonicalGraph();
 		//bliss::AbstractGraph* cf = turn_canonical_graph_bliss(qp, is_directed);
 		bliss::AbstractGraph* ag = readGraph(qp, is_directed);
 		bliss::Stats stats;
@@ -549,7 +668,7 @@ private:
 		bliss::AbstractGraph* cf = ag->permute(cl); //permute to canonical form
 		//bliss::AbstractGraph* cf = turnCanonical(ag);
 		delete ag;
-		CanonicalGraph* cg = new CanonicalGraph(cf, is_directed);
+		*cg = CanonicalGraph(cf, is_directed);
 		delete cf;
 		return cg;
 	}
@@ -588,7 +707,37 @@ private:
 		//std::cout << "done read edges\n";
 		return g;
 	}
+	// calls f(dst, history) for every extension of emb (of 'size' elements)
+	// that extend_edge would add; the same checks without any heap allocation
+	template <typename F>
+	inline void for_each_edge_extension(unsigned max_size, const ElementType* emb, unsigned size, F f) {
+		// get the number of distinct vertices in the embedding
+		unsigned num_distinct = 0;
+		for(unsigned i = 0; i < size; i ++)
+			if(!contains(emb, i, emb[i].vertex_id)) num_distinct ++;
+		for(unsigned i = 0; i < size; ++i) {
+			VertexId id = emb[i].vertex_id;
+			// each distinct vertex is expanded only once
+			if(contains(emb, i, id)) continue;
+			for(auto e : graph->edges(id)) {
+				GNode dst = graph->getEdgeDst(e);
+				bool vertex_existed = contains(emb, size, dst);
+				unsigned num_vertices = num_distinct + (vertex_existed ? 0 : 1);
+				if(num_vertices <= max_size && !is_automorphism(emb, size, i, id, dst, vertex_existed))
+					f(dst, (BYTE)i);
+			}
+		}
+	}
+	// whether vertex vid is one of the first n elements of emb
+	inline bool contains(const ElementType* emb, unsigned n, VertexId vid) {
+		for(unsigned i = 0; i < n; i ++)
+			if(emb[i].vertex_id == vid) return true;
+		return false;
+	}
 	inline void getEdge(Embedding & emb, unsigned index, std::pair<VertexId, VertexId>& edge) {
+		getEdge(emb.data(), index, edge);
+	}
+	inline void getEdge(const ElementType* emb, unsigned index, std::pair<VertexId, VertexId>& edge) {
 		auto ele = emb[index];
 		edge.first = emb[ele.history_info].vertex_id;
 		edge.second = ele.vertex_id;
@@ -621,4 +770,10 @@ void printout_embeddings(int level, Miner& miner, EmbeddingQueue& queue, bool ve
 	if(verbose) for (auto embedding : queue) miner.printout_embedding(level, embedding);
 }
 
+// print out the number of embeddings in the last level of an embedding list
+void printout_embeddings(int level, EmbeddingList& emb_list) {
+	std::cout << "Number of embeddings in level " << level << ": " << emb_list.size()
+		<< " (embedding list: " << emb_list.get_memory() << " Bytes)" << std::endl;
+}
+
 #endif // MINER_HPP_
@@ -13,12 +13,13 @@ public:
 		size = subgraph_size / sizeof(ElementType);
 		elements = new ElementType[size];
 	}
-	QuickPattern(const Embedding & emb) {
+	QuickPattern(const Embedding & emb) : QuickPattern(emb.data(), emb.size()) {}
+	QuickPattern(const ElementType* emb, unsigned emb_size) {
 		cg_id = 0;
-		size = emb.size();
+		size = emb_size;
 		unsigned bytes = size * sizeof(ElementType);
 		elements = new ElementType[size];
-		std::memcpy(elements, emb.data(), bytes);
+		std::memcpy(elements, emb, bytes);
 		std::unordered_map<VertexId, VertexId> map;
 		VertexId new_id = 1;
 		for(unsigned i = 0; i < size; i++) {
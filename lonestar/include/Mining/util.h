@@ -64,6 +64,8 @@ int read_graph(Graph &graph, std::string filetype, std::string filename, bool ne
 			}
 		}
 	} else { printf("Unkown file format\n"); exit(1); }
+	// the miners intersect adjacency lists, which requires them to be sorted
+	graph.sortAllEdgesByDst();
 	//print_graph(graph);
 	int core = 0;
 	if (need_relabel) core = mgraph.get_core();
@@ -21,10 +21,14 @@
 #include "galois/gstl.h"
 #include "galois/Reduction.h"
 #include "galois/AtomicHelpers.h"
+#include "galois/Buckets.h"
+#include "galois/Frontier.h"
 #include "galois/graphs/LCGraph.h"
 #include "Lonestar/BoilerPlate.h"
 #include "llvm/Support/CommandLine.h"
 
+#include <fstream>
+
 constexpr static const char* const REGION_NAME = "k-core";
 
 /******************************************************************************/
@@ -32,7 +36,7 @@ constexpr static const char* const REGION_NAME = "k-core";
 /******************************************************************************/
 namespace cll = llvm::cl;
 
-enum Algo { Async = 0, Sync };
+enum Algo { Async = 0, Sync, Decomposition };
 
 //! Input file: should be symmetric graph
 static cll::opt<std::string> inputFilename(cll::Positional,
@@ -43,12 +47,26 @@ static cll::opt<std::string> inputFilename(cll::Positional,
 static cll::opt<Algo> algo("algo",
     cll::desc("Choose an algorithm (default Sync):"),
     cll::values(clEnumVal(Async, "Asynchronous"), clEnumVal(Sync, "Synchronous"),
+                clEnumVal(Decomposition, "Coreness of every node by bucketed "
+                                         "peeling"),
                 clEnumValEnd),
     cll::init(Sync));
 
-//! Required k specification for k-core
+//! k specification for k-core; required unless doing a full decomposition
 static cll::opt<unsigned int> k_core_num("kcore", cll::desc("k-core value"),
-                                         cll::Required);
+                                         cll::init(0));
+
+//! Where to write the coreness of every node (Decomposition only)
+static cll::opt<std::string> coreFilename("coreOutput",
+  cll::desc("File to write the coreness of every node to (Decomposition "
+            "only)"),
+  cll::init(""));
+
+//! Number of consecutive degree buckets kept open by Decomposition
+static cll::opt<unsigned int> numOpenBuckets("openBuckets",
+  cll::desc("Number of consecutive buckets kept open by Decomposition "
+            "(default 128)"),
+  cll::init(128));
 
 //! Flag that forces user to be aware that they should be passing in a
 //! symmetric graph
@@ -64,6 +82,8 @@ static cll::opt<bool> symmetricGraph("symmetricGraph",
 // necessary
 struct NodeData {
   std::atomic<uint32_t> currentDegree;
+  //! Last round of Decomposition in which the degree of the node changed
+  std::atomic<uint32_t> touched;
 };
 
 //! Typedef for graph used, CSR graph
@@ -120,48 +140,36 @@ void setupInitialWorklist(Graph& graph,
 }
 
 /**
- * Starting with initial dead nodes as current worklist; degree decrement;
- * add to next worklist; switch next with current and repeat until worklist
- * is empty (i.e. no more dead nodes).
+ * Starting with initial dead nodes as the first frontier; degree decrement;
+ * add to next frontier; repeat in rounds until no more dead nodes.
  *
  * @param graph Graph to operate on
  */
 void syncCascadeKCore(Graph& graph) {
-  galois::InsertBag<GNode>* current = new galois::InsertBag<GNode>;
-  galois::InsertBag<GNode>* next = new galois::InsertBag<GNode>;
-
   // worklist setup
-  setupInitialWorklist(graph, *next);
-
-  while (!next->empty()) {
-    // make "next" into current
-    std::swap(current, next);
-    next->clear();
+  galois::InsertBag<GNode> initialWorklist;
+  setupInitialWorklist(graph, initialWorklist);
 
-    galois::do_all(
-      galois::iterate(*current),
-      [&] (GNode deadNode) {
-        // decrement degree of all neighbors
-        for (auto e : graph.edges(deadNode)) {
-          GNode dest = graph.getEdgeDst(e);
-          NodeData& destData = graph.getData(dest);
-          uint32_t oldDegree = galois::atomicSubtract(destData.currentDegree, 1u);
+  // every round of for_each_frontier uses galois::steal(), so none is passed
+  galois::for_each_frontier(
+    graph, galois::iterate(initialWorklist),
+    [&] (GNode deadNode, const galois::FrontierContext<GNode>& next) {
+      // decrement degree of all neighbors
+      for (auto e : graph.edges(deadNode)) {
+        GNode dest = graph.getEdgeDst(e);
+        NodeData& destData = graph.getData(dest);
+        uint32_t oldDegree = galois::atomicSubtract(destData.currentDegree, 1u);
 
-          if (oldDegree == k_core_num) {
-            // this thread was responsible for putting degree of destination
-            // below threshold: add to worklist
-            next->emplace(dest);
-          }
+        if (oldDegree == k_core_num) {
+          // this thread was responsible for putting degree of destination
+          // below threshold: add to next frontier
+          next.push(dest);
         }
-      },
-      galois::steal(),
-      galois::chunk_size<CHUNK_SIZE>(),
-      galois::loopname("SyncCascadeDeadNodes")
-    );
-  }
-
-  delete current;
-  delete next;
+      }
+    },
+    galois::chunk_size<CHUNK_SIZE>(),
+    galois::loopname("SyncCascadeDeadNodes")
+  );
 }
 
 /**
@@ -195,6 +203,87 @@ void asyncCascadeKCore(Graph& graph, galois::InsertBag<GNode>& initialWorklist)
   );
 }
 
+/**
+ * Full core decomposition. Nodes are kept in buckets by current degree.
+ * Each round extracts the lowest nonempty bucket k: its nodes have coreness
+ * k and are peeled together, and every neighbor with degree above k loses a
+ * degree (never going below k). The neighbors whose degree changed in the
+ * round are then moved to the bucket of their new degree once, no matter how
+ * many peeled nodes they were adjacent to.
+ *
+ * On return, currentDegree of every node is its coreness.
+ *
+ * @param graph Graph to operate on
+ * @returns number of rounds
+ */
+uint32_t bucketedCoreDecomposition(Graph& graph) {
+  galois::Buckets<GNode> buckets(numOpenBuckets);
+
+  galois::do_all(
+    galois::iterate(graph.begin(), graph.end()),
+    [&] (GNode curNode) {
+      NodeData& curData = graph.getData(curNode);
+      curData.touched.store(0);
+      buckets.push(curNode, curData.currentDegree);
+    },
+    galois::loopname("DecompositionInitBuckets"),
+    galois::no_stats()
+  );
+
+  // an entry is current only if the degree of the node still matches the
+  // bucket it is in
+  auto degreeOf = [&] (GNode n) -> size_t {
+    return graph.getData(n).currentDegree.load(std::memory_order_relaxed);
+  };
+
+  galois::InsertBag<GNode> peeled;
+  galois::InsertBag<GNode> moved;
+  uint32_t round = 0;
+
+  while (buckets.nextBucket(degreeOf, peeled)) {
+    const uint32_t k = buckets.current();
+    ++round;
+    moved.clear();
+
+    galois::do_all(
+      galois::iterate(peeled),
+      [&] (GNode deadNode) {
+        for (auto e : graph.edges(deadNode)) {
+          GNode dest = graph.getEdgeDst(e);
+          NodeData& destData = graph.getData(dest);
+
+          uint32_t oldDegree = destData.currentDegree.load();
+          do {
+            // peeled nodes and nodes in bucket k are left alone
+            if (oldDegree <= k) {
+              break;
+            }
+          } while (!destData.currentDegree.compare_exchange_weak(
+                     oldDegree, oldDegree - 1));
+
+          if (oldDegree > k && destData.touched.exchange(round) != round) {
+            moved.emplace(dest);
+          }
+        }
+      },
+      galois::steal(),
+      galois::chunk_size<CHUNK_SIZE>(),
+      galois::loopname("DecompositionPeel")
+    );
+
+    galois::do_all(
+      galois::iterate(moved),
+      [&] (GNode movedNode) {
+        buckets.push(movedNode, graph.getData(movedNode).currentDegree);
+      },
+      galois::loopname("DecompositionMove"),
+      galois::no_stats()
+    );
+  }
+
+  return round;
+}
+
 /******************************************************************************/
 /* Sanity check operators */
 /******************************************************************************/
@@ -223,6 +312,68 @@ void kCoreSanity(Graph& graph) {
                  aliveNodes.reduce(), "\n");
 }
 
+/**
+ * Checks that the coreness (stored in currentDegree) of every node n is
+ * consistent: n has at least core(n) neighbors with coreness at least core(n)
+ * (n is in the core(n)-core), and fewer than core(n) + 1 neighbors with
+ * coreness above core(n) (n is not in the (core(n) + 1)-core). Prints the
+ * degeneracy and, if -kcore is given, the size of that core.
+ *
+ * @param graph Graph to check
+ */
+void decompositionSanity(Graph& graph) {
+  galois::GReduceMax<uint32_t> maxCore;
+  galois::GAccumulator<uint32_t> aliveNodes;
+  galois::GAccumulator<uint32_t> badNodes;
+
+  galois::do_all(
+    galois::iterate(graph.begin(), graph.end()),
+    [&] (GNode curNode) {
+      uint32_t core = graph.getData(curNode).currentDegree;
+      uint32_t atLeast = 0;
+      uint32_t above = 0;
+      for (auto e : graph.edges(curNode)) {
+        uint32_t other = graph.getData(graph.getEdgeDst(e)).currentDegree;
+        atLeast += (other >= core);
+        above += (other > core);
+      }
+      if (atLeast < core || above > core) {
+        badNodes += 1;
+      }
+      maxCore.update(core);
+      if (k_core_num && core >= k_core_num) {
+        aliveNodes += 1;
+      }
+    },
+    galois::loopname("DecompositionSanityCheck"),
+    galois::no_stats()
+  );
+
+  galois::gPrint("Maximum coreness is ", maxCore.reduce(), "\n");
+  if (k_core_num) {
+    galois::gPrint("Number of nodes in the ", k_core_num, "-core is ",
+                   aliveNodes.reduce(), "\n");
+  }
+  if (badNodes.reduce()) {
+    GALOIS_DIE("Coreness of ", badNodes.reduce(), " nodes is inconsistent");
+  }
+}
+
+/**
+ * Writes "node coreness" lines for every node.
+ *
+ * @param graph Graph holding the coreness of every node in currentDegree
+ */
+void writeCoreness(Graph& graph) {
+  std::ofstream out(coreFilename);
+  if (!out) {
+    GALOIS_DIE("Failed to open ", coreFilename);
+  }
+  for (GNode n : graph) {
+    out << n << " " << graph.getData(n).currentDegree << "\n";
+  }
+}
+
 /******************************************************************************/
 /* Main method for running */
 /******************************************************************************/
@@ -230,7 +381,8 @@ void kCoreSanity(Graph& graph) {
 constexpr static const char* const name = "k-core";
 constexpr static const char* const desc = "Finds the k-core of a graph, defined "
                                           "as the subgraph where all vertices "
-                                          "have degree at least k.";
+                                          "have degree at least k, or the "
+                                          "coreness of every vertex.";
 constexpr static const char* const url  = 0;
 
 int main(int argc, char** argv) {
@@ -242,6 +394,11 @@ int main(int argc, char** argv) {
                "aware this program needs to be passed a symmetric graph.");
   }
 
+  if (algo != Decomposition && !k_core_num) {
+    GALOIS_DIE("-kcore must be given for algorithms other than "
+               "Decomposition");
+  }
+
   // some initial stat reporting
   galois::gInfo("Worklist chunk size of ", CHUNK_SIZE, ": best size may depend"
                 " on input.");
@@ -290,6 +447,10 @@ int main(int argc, char** argv) {
                   k_core_num);
     // synchronous k-core
     syncCascadeKCore(graph);
+  } else if (algo == Decomposition) {
+    galois::gInfo("Running bucketed core decomposition");
+    uint32_t rounds = bucketedCoreDecomposition(graph);
+    galois::runtime::reportStat_Single(REGION_NAME, "Rounds", rounds);
   } else {
     GALOIS_DIE("Invalid specification of k-core algorithm");
   }
@@ -300,7 +461,14 @@ int main(int argc, char** argv) {
   galois::reportPageAlloc("MemAllocPost");
 
   // sanity check
-  if (!skipVerify) {
+  if (algo == Decomposition) {
+    if (!skipVerify) {
+      decompositionSanity(graph);
+    }
+    if (!coreFilename.empty()) {
+      writeCoreness(graph);
+    }
+  } else if (!skipVerify) {
     kCoreSanity(graph);
   }
 
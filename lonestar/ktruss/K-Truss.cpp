@@ -20,6 +20,7 @@
 #include "galois/Galois.h"
 #include "galois/Reduction.h"
 #include "galois/Bag.h"
+#include "galois/SetIntersection.h"
 #include "galois/Timer.h"
 #include "galois/Timer.h"
 #include "galois/graphs/Graph.h"
@@ -162,34 +163,20 @@ bool isSupportNoLessThanJ(G& g, typename G::GraphNode src,
        dstI            = g.edge_begin(dst, galois::MethodFlag::UNPROTECTED),
        dstE            = g.edge_end(dst, galois::MethodFlag::UNPROTECTED);
 
-  while (true) {
-    // find the first valid edge
-    while (srcI != srcE && (g.getEdgeData(srcI) & removed)) {
-      ++srcI;
-    }
-    while (dstI != dstE && (g.getEdgeData(dstI) & removed)) {
-      ++dstI;
-    }
-
-    if (srcI == srcE || dstI == dstE) {
-      return numValidEqual >= j;
-    }
-
-    // check for intersection
-    auto sN = g.getEdgeDst(srcI), dN = g.getEdgeDst(dstI);
-    if (sN < dN) {
-      ++srcI;
-    } else if (dN < sN) {
-      ++dstI;
-    } else {
-      numValidEqual += 1;
-      if (numValidEqual >= j) {
-        return true;
-      }
-      ++srcI;
-      ++dstI;
-    }
+  if (!j) {
+    return true;
   }
+
+  // intersect all edges and skip matches where either edge is removed
+  galois::intersect::forEachMatch(
+      g.getEdgeDstPtr(srcI), srcE - srcI, g.getEdgeDstPtr(dstI), dstE - dstI,
+      [&](size_t i, size_t k) {
+        if (!(g.getEdgeData(srcI + i) & removed) &&
+            !(g.getEdgeData(dstI + k) & removed)) {
+          numValidEqual += 1;
+        }
+        return numValidEqual < j;
+      });
   return numValidEqual >= j;
 }
 
@@ -30,7 +30,10 @@
 #include "Lonestar/BoilerPlate.h"
 
 #include <algorithm>
+#include <atomic>
+#include <deque>
 #include <iostream>
+#include <limits>
 #include <random>
 #include <string>
 #include <vector>
@@ -45,7 +48,7 @@ static const char* desc =
     "edges.";
 static const char* url = "bipartite_mcm";
 
-enum MatchingAlgo { pfpAlgo, ffAlgo, abmpAlgo };
+enum MatchingAlgo { pfpAlgo, ffAlgo, abmpAlgo, pfAlgo };
 
 enum ExecutionType { serial, parallel };
 
@@ -55,7 +58,8 @@ static cll::opt<MatchingAlgo> algo(
     cll::desc("Choose an algorithm:"),
     cll::values(clEnumVal(pfpAlgo, "Preflow-push"),
                 clEnumVal(ffAlgo, "Ford-Fulkerson augmenting paths"),
-                clEnumVal(abmpAlgo, "Alt-Blum-Mehlhorn-Paul"), clEnumValEnd),
+                clEnumVal(abmpAlgo, "Alt-Blum-Mehlhorn-Paul"),
+                clEnumVal(pfAlgo, "Pothen-Fan on a CSR graph"), clEnumValEnd),
     cll::init(abmpAlgo));
 static cll::opt<ExecutionType>
     executionType(cll::desc("Choose execution type:"),
@@ -929,6 +933,330 @@ struct Exists<G, MatchingMF> {
   }
 };
 
+// ********************* Pothen-Fan on CSR ******************************
+
+//! Immutable bipartite graph; nodes with edges form A, the others B
+typedef galois::graphs::LC_CSR_Graph<void, void>::with_no_lockable<
+    true>::type::with_numa_alloc<true>::type CSRBipartiteGraph;
+
+/**
+ * Pothen-Fan matching on an immutable CSR graph. The matching is kept in a
+ * mate array instead of by reversing edges, so the graph is never modified.
+ *
+ * A parallel Karp-Sipser pass builds the initial matching: B nodes with one
+ * unmatched neighbor are matched first, then A nodes greedily. For each B
+ * node, the count of unmatched neighbors and the XOR of their ids share one
+ * 64-bit word. When the count reaches one, the word holds that neighbor
+ * without needing the edges of B.
+ *
+ * Each Pothen-Fan phase then runs vertex-disjoint DFSs from all free A nodes
+ * in parallel; a B node belongs to the first DFS that claims it in the phase.
+ * Before descending, a DFS looks ahead for a free neighbor. The lookahead
+ * position of a node only moves forward, since matched nodes stay matched.
+ * For fairness, the DFS scans edges forward in odd phases and backward in
+ * even ones. The algorithm stops after a phase without augmentations.
+ */
+template <bool Concurrent>
+struct MatchingPF {
+  typedef CSRBipartiteGraph G;
+  typedef G::GraphNode GraphNode;
+  typedef G::edge_iterator edge_iterator;
+  static const uint32_t NONE = std::numeric_limits<uint32_t>::max();
+  static const bool canRunIteratively = false;
+
+  //! DFS frame: A node, its remaining edges, and the B node it was reached by
+  struct Frame {
+    uint32_t a;
+    uint32_t via;
+    edge_iterator lo;
+    edge_iterator hi;
+  };
+
+  G& g;
+  galois::LargeArray<std::atomic<uint32_t>> mate;
+  galois::LargeArray<std::atomic<uint32_t>> visited;
+  galois::LargeArray<uint32_t> lookahead;
+  galois::InsertBag<GraphNode> roots;
+  galois::substrate::PerThreadStorage<std::vector<Frame>> stacks;
+
+  MatchingPF(G& _g) : g(_g) {}
+
+  std::string name() {
+    return std::string(Concurrent ? "Concurrent" : "Serial") +
+           " Pothen-Fan (CSR)";
+  }
+
+  bool isA(GraphNode n) { return g.edge_begin(n) != g.edge_end(n); }
+
+  //! matches a and b if both are still free
+  bool tryMatch(uint32_t a, uint32_t b) {
+    uint32_t expected = NONE;
+    if (!mate[a].compare_exchange_strong(expected, b))
+      return false;
+    expected = NONE;
+    if (!mate[b].compare_exchange_strong(expected, a)) {
+      mate[a] = NONE;
+      return false;
+    }
+    return true;
+  }
+
+  void karpSipser() {
+    // unmatched neighbor count in the high half, XOR of their ids in the low
+    galois::LargeArray<std::atomic<uint64_t>> unmatched;
+    unmatched.allocateInterleaved(g.size());
+    galois::do_all(galois::iterate(g), [&](GraphNode n) { unmatched[n] = 0; },
+                   galois::no_stats());
+    galois::do_all(galois::iterate(g),
+                   [&](GraphNode a) {
+                     for (auto ii : g.edges(a)) {
+                       GraphNode b = g.getEdgeDst(ii);
+                       unmatched[b].fetch_add(uint64_t{1} << 32);
+                       unmatched[b].fetch_xor(a);
+                     }
+                   },
+                   galois::steal(), galois::loopname("KarpSipserDegrees"));
+
+    // a was matched to b; drop it from its other neighbors and queue those
+    // left with one unmatched neighbor
+    auto remove = [&](uint32_t a, uint32_t b, auto& ctx) {
+      for (auto ii : g.edges(a)) {
+        GraphNode dst = g.getEdgeDst(ii);
+        if (dst == b)
+          continue;
+        uint64_t old = unmatched[dst].load();
+        uint64_t next;
+        do {
+          next = (((old >> 32) - 1) << 32) | (uint32_t(old) ^ a);
+        } while (!unmatched[dst].compare_exchange_weak(old, next));
+        if ((next >> 32) == 1 && mate[dst] == NONE)
+          ctx.push(dst);
+      }
+    };
+
+    std::vector<GraphNode> initial;
+    for (auto n : g)
+      if (isA(n) || (unmatched[n] >> 32) == 1)
+        initial.push_back(n);
+
+    // degree-one nodes first
+    auto indexer = [&](GraphNode n) -> unsigned {
+      return isA(n) && std::distance(g.edge_begin(n), g.edge_end(n)) != 1;
+    };
+
+    using namespace galois::worklists;
+    typedef PerSocketChunkFIFO<64> PSchunk;
+    typedef OrderedByIntegerMetric<decltype(indexer), PSchunk> OBIM;
+
+    galois::for_each(galois::iterate(initial),
+                     [&](GraphNode n, auto& ctx) {
+                       if (mate[n] != NONE)
+                         return;
+                       if (isA(n)) {
+                         for (auto ii : g.edges(n)) {
+                           GraphNode b = g.getEdgeDst(ii);
+                           if (mate[b] == NONE && tryMatch(n, b)) {
+                             remove(n, b, ctx);
+                             return;
+                           }
+                         }
+                       } else {
+                         uint64_t word = unmatched[n];
+                         uint32_t a    = word;
+                         if ((word >> 32) == 1 && tryMatch(a, n))
+                           remove(a, n, ctx);
+                       }
+                     },
+                     galois::no_conflicts(), galois::wl<OBIM>(indexer),
+                     galois::loopname("KarpSipser"));
+  }
+
+  //! next edge of a frame; forward or backward depending on the phase
+  bool nextEdge(Frame& f, bool forward, edge_iterator& edge) {
+    if (f.lo == f.hi)
+      return false;
+    edge = forward ? f.lo++ : --f.hi;
+    return true;
+  }
+
+  //! first free and unclaimed neighbor of a, or NONE
+  uint32_t findFree(uint32_t a, uint32_t phase) {
+    edge_iterator ii = g.edge_begin(a), ei = g.edge_end(a);
+    for (std::advance(ii, lookahead[a]); ii != ei; ++ii) {
+      lookahead[a] += 1;
+      GraphNode b = g.getEdgeDst(ii);
+      if (mate[b] == NONE && visited[b].exchange(phase) != phase)
+        return b;
+    }
+    return NONE;
+  }
+
+  //! flips the matching along the stack, ending at the free node b
+  void flip(std::vector<Frame>& stack, uint32_t b) {
+    for (size_t i = stack.size(); i-- > 0;) {
+      uint32_t a = stack[i].a;
+      mate[b]    = a;
+      mate[a]    = b;
+      b          = stack[i].via;
+    }
+  }
+
+  bool augment(GraphNode root, uint32_t phase) {
+    bool forward               = phase % 2;
+    std::vector<Frame>& stack = *stacks.getLocal();
+    stack.clear();
+    stack.push_back(Frame{root, NONE, g.edge_begin(root), g.edge_end(root)});
+
+    while (!stack.empty()) {
+      uint32_t b = findFree(stack.back().a, phase);
+      if (b != NONE) {
+        flip(stack, b);
+        return true;
+      }
+
+      edge_iterator edge;
+      bool advanced = false;
+      while (nextEdge(stack.back(), forward, edge)) {
+        b = g.getEdgeDst(edge);
+        if (visited[b].exchange(phase) == phase)
+          continue;
+        uint32_t a = mate[b];
+        if (a == NONE) {
+          flip(stack, b);
+          return true;
+        }
+        stack.push_back(Frame{a, b, g.edge_begin(a), g.edge_end(a)});
+        advanced = true;
+        break;
+      }
+      if (!advanced)
+        stack.pop_back();
+    }
+    return false;
+  }
+
+  void pothenFan() {
+    galois::do_all(galois::iterate(g),
+                   [&](GraphNode n) {
+                     visited[n]   = 0;
+                     lookahead[n] = 0;
+                     if (isA(n) && mate[n] == NONE)
+                       roots.push(n);
+                   },
+                   galois::no_stats());
+
+    uint32_t phase = 0;
+    while (true) {
+      phase += 1;
+      galois::GAccumulator<size_t> augmented;
+      galois::do_all(galois::iterate(roots),
+                     [&](GraphNode root) {
+                       if (augment(root, phase))
+                         augmented += 1;
+                     },
+                     galois::steal(), galois::loopname("PothenFan"));
+      if (!augmented.reduce())
+        break;
+
+      galois::InsertBag<GraphNode> next;
+      galois::do_all(galois::iterate(roots),
+                     [&](GraphNode root) {
+                       if (mate[root] == NONE)
+                         next.push(root);
+                     },
+                     galois::no_stats());
+      roots.clear();
+      galois::do_all(galois::iterate(next),
+                     [&](GraphNode root) { roots.push(root); },
+                     galois::no_stats());
+    }
+    galois::runtime::reportStat_Single("MatchingPF", "phases", phase);
+  }
+
+  void operator()() {
+    unsigned numThreads = galois::getActiveThreads();
+    galois::setActiveThreads(Concurrent ? numThreads : 1);
+
+    mate.allocateInterleaved(g.size());
+    visited.allocateInterleaved(g.size());
+    lookahead.allocateInterleaved(g.size());
+    galois::do_all(galois::iterate(g), [&](GraphNode n) { mate[n] = NONE; },
+                   galois::no_stats());
+
+    karpSipser();
+    galois::runtime::reportStat_Single("MatchingPF", "KarpSipserMatched",
+                                       size());
+    pothenFan();
+
+    galois::setActiveThreads(numThreads);
+  }
+
+  //! number of matched edges
+  size_t size() {
+    galois::GAccumulator<size_t> count;
+    galois::do_all(galois::iterate(g),
+                   [&](GraphNode n) {
+                     if (isA(n) && mate[n] != NONE)
+                       count += 1;
+                   },
+                   galois::no_stats());
+    return count.reduce();
+  }
+
+  /**
+   * Checks that the mates form a matching of graph edges and, by Berge's
+   * theorem, that no augmenting path starts at a free node of A.
+   */
+  bool verify() {
+    for (auto n : g) {
+      uint32_t m = mate[n];
+      if (m == NONE)
+        continue;
+      if (mate[m] != n) {
+        std::cerr << "Error: not a matching, node " << n << " matched to " << m
+                  << " matched to " << mate[m] << "\n";
+        return false;
+      }
+      bool found = !isA(n);
+      for (auto ii : g.edges(n))
+        found |= g.getEdgeDst(ii) == m;
+      if (!found) {
+        std::cerr << "Error: node " << n << " matched to non-neighbor " << m
+                  << "\n";
+        return false;
+      }
+    }
+
+    std::vector<bool> seen(g.size(), false);
+    std::deque<GraphNode> queue;
+    for (auto n : g)
+      if (isA(n) && mate[n] == NONE) {
+        seen[n] = true;
+        queue.push_back(n);
+      }
+    while (!queue.empty()) {
+      GraphNode a = queue.front();
+      queue.pop_front();
+      for (auto ii : g.edges(a)) {
+        GraphNode b = g.getEdgeDst(ii);
+        if (seen[b])
+          continue;
+        seen[b] = true;
+        if (mate[b] == NONE) {
+          std::cerr << "Error: not maximum, augmenting path to node " << b
+                    << "\n";
+          return false;
+        }
+        if (!seen[mate[b]]) {
+          seen[mate[b]] = true;
+          queue.push_back(mate[b]);
+        }
+      }
+    }
+    return true;
+  }
+};
+
 // ******************* Verification ***************************
 
 template <typename G>
@@ -1174,6 +1502,51 @@ void start(int N, int numEdges, int numGroups) {
   }
 }
 
+template <bool Concurrent>
+void startCSR() {
+  typedef MatchingPF<Concurrent> A;
+
+  CSRBipartiteGraph g;
+
+  if (runIteratively && !A::canRunIteratively)
+    GALOIS_DIE("algo does not support iterative execution");
+
+  switch (inputType) {
+  case generated:
+    generateRandomInput(N, N, numEdges, numGroups, seed, g);
+    break;
+  case fromFile:
+    readInput(inputFilename, g);
+    break;
+  default:
+    GALOIS_DIE("unknown input type");
+  }
+
+  A algo(g);
+  size_t numA = 0;
+  for (auto n : g)
+    numA += algo.isA(n);
+
+  std::cout << "numA: " << numA << " numB: " << g.size() - numA << "\n";
+
+  std::cout << "Starting " << algo.name() << "\n";
+
+  galois::StatTimer t;
+  t.start();
+  algo();
+  t.stop();
+
+  if (!skipVerify) {
+    if (!algo.verify()) {
+      GALOIS_DIE("Verification failed");
+    } else {
+      std::cout << "Verification successful.\n";
+    }
+  }
+
+  std::cout << "Matching of cardinality: " << algo.size() << "\n";
+}
+
 template <bool Concurrent>
 void start() {
   switch (algo) {
@@ -1189,6 +1562,9 @@ void start() {
     start<MatchingFF, MFBipartiteGraph<FFNode, void>, Concurrent>(N, numEdges,
                                                                   numGroups);
     break;
+  case pfAlgo:
+    startCSR<Concurrent>();
+    break;
   default:
     GALOIS_DIE("unknown algo");
   }
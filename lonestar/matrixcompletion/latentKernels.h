@@ -0,0 +1,413 @@
+/*
+ * This file belongs to the Galois project, a C++ library for exploiting parallelism.
+ * The code is being released under the terms of the 3-Clause BSD License (a
+ * copy is located in LICENSE.txt at the top-level directory).
+ *
+ * Copyright (C) 2019, The University of Texas at Austin. All rights reserved.
+ * UNIVERSITY EXPRESSLY DISCLAIMS ANY AND ALL WARRANTIES CONCERNING THIS
+ * SOFTWARE AND DOCUMENTATION, INCLUDING ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR ANY PARTICULAR PURPOSE, NON-INFRINGEMENT AND WARRANTIES OF
+ * PERFORMANCE, AND ANY WARRANTY THAT MIGHT OTHERWISE ARISE FROM COURSE OF
+ * DEALING OR USAGE OF TRADE.  NO WARRANTY IS EITHER EXPRESS OR IMPLIED WITH
+ * RESPECT TO THE USE OF THE SOFTWARE OR DOCUMENTATION. Under no circumstances
+ * shall University be liable for incidental, special, indirect, direct or
+ * consequential damages or loss of profits, interruption of business, or
+ * related expenses which may arise from use of Software or Documentation,
+ * including but not limited to those resulting from defects in Software and/or
+ * Documentation, or loss or inaccuracy of data of any kind.
+ */
+
+#ifndef _LATENT_KERNELS_H_
+#define _LATENT_KERNELS_H_
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX512F__) || (defined(__AVX2__) && defined(__FMA__))
+#include <immintrin.h>
+#endif
+
+/*
+ * SGD kernels over latent vectors.
+ *
+ * Latent vectors are stored padded with zeros to a whole number of blocks of
+ * LATENT_BLOCK values, and each one starts on a block boundary. The kernels
+ * work on one block at a time, one AVX-512 vector or two AVX2 vectors, so
+ * they need no remainder loop: the padding stays zero under the gradient
+ * update and adds nothing to inner products.
+ *
+ * Values are stored as float, bfloat16 or IEEE half. Reduced-precision values
+ * are converted to float on load and rounded to nearest even on store, and
+ * all arithmetic is in float.
+ */
+
+typedef float LatentValue;
+
+static const unsigned LATENT_BLOCK = 16;
+
+//! Number of blocks of a latent vector of the given length
+inline unsigned latentBlocks(unsigned size) {
+  return (size + LATENT_BLOCK - 1) / LATENT_BLOCK;
+}
+
+//! bfloat16: the upper half of a float
+struct BF16 {
+  uint16_t bits;
+};
+
+//! IEEE 754 half precision
+struct FP16 {
+  uint16_t bits;
+};
+
+inline float toFloat(float v) { return v; }
+
+inline float toFloat(BF16 v) {
+  uint32_t x = uint32_t(v.bits) << 16;
+  float f;
+  std::memcpy(&f, &x, sizeof(f));
+  return f;
+}
+
+inline float toFloat(FP16 v) {
+  uint32_t sign = uint32_t(v.bits & 0x8000) << 16;
+  uint32_t exp  = (v.bits >> 10) & 0x1f;
+  uint32_t mant = v.bits & 0x3ff;
+  uint32_t x;
+  if (exp == 0x1f) {
+    x = sign | 0x7f800000 | (mant << 13);
+  } else if (exp != 0) {
+    x = sign | ((exp + 127 - 15) << 23) | (mant << 13);
+  } else if (mant == 0) {
+    x = sign;
+  } else {
+    // subnormal: normalize
+    exp = 127 - 15 + 1;
+    while (!(mant & 0x400)) {
+      mant <<= 1;
+      --exp;
+    }
+    x = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+  }
+  float f;
+  std::memcpy(&f, &x, sizeof(f));
+  return f;
+}
+
+template <typename T>
+T fromFloat(float f);
+
+template <>
+inline float fromFloat<float>(float f) {
+  return f;
+}
+
+template <>
+inline BF16 fromFloat<BF16>(float f) {
+  uint32_t x;
+  std::memcpy(&x, &f, sizeof(x));
+  if ((x & 0x7fffffff) > 0x7f800000) // NaN: keep it a NaN
+    return BF16{uint16_t((x >> 16) | 0x40)};
+  x += 0x7fff + ((x >> 16) & 1);
+  return BF16{uint16_t(x >> 16)};
+}
+
+template <>
+inline FP16 fromFloat<FP16>(float f) {
+  uint32_t x;
+  std::memcpy(&x, &f, sizeof(x));
+  uint32_t sign = (x >> 16) & 0x8000;
+  uint32_t fexp = (x >> 23) & 0xff;
+  uint32_t mant = x & 0x7fffff;
+  if (fexp == 0xff)
+    return FP16{uint16_t(sign | 0x7c00 | (mant ? 0x200 : 0))};
+  int exp = int(fexp) - 127 + 15;
+  if (exp >= 0x1f)
+    return FP16{uint16_t(sign | 0x7c00)};
+  uint32_t shift = 13;
+  uint32_t half  = uint32_t(exp) << 10;
+  if (exp <= 0) {
+    // subnormal, or zero once shifted out
+    if (exp < -10)
+      return FP16{uint16_t(sign)};
+    mant |= 0x800000;
+    shift = 14 - exp;
+    half  = 0;
+  }
+  uint32_t rem = mant & ((1u << shift) - 1);
+  uint32_t mid = 1u << (shift - 1);
+  half |= mant >> shift;
+  // a carry out of the mantissa correctly bumps the exponent
+  if (rem > mid || (rem == mid && (half & 1)))
+    ++half;
+  return FP16{uint16_t(sign | half)};
+}
+
+namespace internal {
+
+#if defined(__AVX512F__)
+
+//! Loads and stores a block as one AVX-512 vector of floats
+template <typename T>
+struct LatentIO;
+
+template <>
+struct LatentIO<float> {
+  static __m512 load(const float* p) { return _mm512_load_ps(p); }
+  static void store(float* p, __m512 v) { _mm512_store_ps(p, v); }
+};
+
+template <>
+struct LatentIO<BF16> {
+  static __m512 load(const BF16* p) {
+    __m256i h = _mm256_load_si256(reinterpret_cast<const __m256i*>(p));
+    // the zero-masking forms here and below: the plain ones pass an
+    // undefined vector that GCC 12 warns about
+    return _mm512_castsi512_ps(_mm512_maskz_slli_epi32(
+        0xffff, _mm512_maskz_cvtepu16_epi32(0xffff, h), 16));
+  }
+  static void store(BF16* p, __m512 v) {
+#if defined(__AVX512BF16__)
+    // rounds to nearest even as well, but flushes denormals to zero
+    _mm256_store_si256(reinterpret_cast<__m256i*>(p),
+                       (__m256i)_mm512_cvtneps_pbh(v));
+#else
+    __m512i x   = _mm512_castps_si512(v);
+    __m512i lsb = _mm512_and_si512(_mm512_srli_epi32(x, 16),
+                                   _mm512_set1_epi32(1));
+    x = _mm512_add_epi32(x, _mm512_add_epi32(lsb, _mm512_set1_epi32(0x7fff)));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(p),
+                       _mm512_cvtepi32_epi16(_mm512_srli_epi32(x, 16)));
+#endif
+  }
+};
+
+template <>
+struct LatentIO<FP16> {
+  static __m512 load(const FP16* p) {
+    return _mm512_maskz_cvtph_ps(
+        0xffff, _mm256_load_si256(reinterpret_cast<const __m256i*>(p)));
+  }
+  static void store(FP16* p, __m512 v) {
+    _mm256_store_si256(reinterpret_cast<__m256i*>(p),
+                       _mm512_maskz_cvtps_ph(0xffff, v,
+                                             _MM_FROUND_TO_NEAREST_INT |
+                                                 _MM_FROUND_NO_EXC));
+  }
+};
+
+#elif defined(__AVX2__) && defined(__FMA__)
+
+//! Loads and stores half a block as one AVX2 vector of floats
+template <typename T>
+struct LatentIO;
+
+template <>
+struct LatentIO<float> {
+  static __m256 load(const float* p) { return _mm256_load_ps(p); }
+  static void store(float* p, __m256 v) { _mm256_store_ps(p, v); }
+};
+
+template <>
+struct LatentIO<BF16> {
+  static __m256 load(const BF16* p) {
+    __m128i h = _mm_load_si128(reinterpret_cast<const __m128i*>(p));
+    return _mm256_castsi256_ps(
+        _mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+  }
+  static void store(BF16* p, __m256 v) {
+    __m256i x   = _mm256_castps_si256(v);
+    __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(x, 16),
+                                   _mm256_set1_epi32(1));
+    x = _mm256_add_epi32(x, _mm256_add_epi32(lsb, _mm256_set1_epi32(0x7fff)));
+    // pack within 128-bit lanes, then gather the two low quadwords
+    __m256i packed = _mm256_packus_epi32(_mm256_srli_epi32(x, 16),
+                                         _mm256_setzero_si256());
+    packed         = _mm256_permute4x64_epi64(packed, 0x08);
+    _mm_store_si128(reinterpret_cast<__m128i*>(p),
+                    _mm256_castsi256_si128(packed));
+  }
+};
+
+#if defined(__F16C__)
+template <>
+struct LatentIO<FP16> {
+  static __m256 load(const FP16* p) {
+    return _mm256_cvtph_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(p)));
+  }
+  static void store(FP16* p, __m256 v) {
+    _mm_store_si128(
+        reinterpret_cast<__m128i*>(p),
+        _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+  }
+};
+#else
+template <>
+struct LatentIO<FP16> {
+  static __m256 load(const FP16* p) {
+    alignas(32) float f[8];
+    for (unsigned i = 0; i < 8; ++i)
+      f[i] = toFloat(p[i]);
+    return _mm256_load_ps(f);
+  }
+  static void store(FP16* p, __m256 v) {
+    alignas(32) float f[8];
+    _mm256_store_ps(f, v);
+    for (unsigned i = 0; i < 8; ++i)
+      p[i] = fromFloat<FP16>(f[i]);
+  }
+};
+#endif
+
+#endif
+
+/**
+ * Inner product and gradient update over BLOCKS blocks of LATENT_BLOCK
+ * values; BLOCKS = 0 takes the number of blocks at runtime. Item and user
+ * vectors are stored as ItemT and UserT.
+ */
+template <unsigned BLOCKS, typename ItemT, typename UserT>
+struct LatentKernel {
+#if defined(__AVX512F__)
+  static LatentValue dot(const void* itemV, const void* userV,
+                         unsigned blocks) {
+    const ItemT* __restrict__ a = static_cast<const ItemT*>(itemV);
+    const UserT* __restrict__ b = static_cast<const UserT*>(userV);
+    const unsigned nb           = BLOCKS ? BLOCKS : blocks;
+    // two accumulators to overlap the latency of dependent FMAs
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    unsigned i  = 0;
+    for (; i + 1 < nb; i += 2) {
+      acc0 = _mm512_fmadd_ps(LatentIO<ItemT>::load(a + i * LATENT_BLOCK),
+                             LatentIO<UserT>::load(b + i * LATENT_BLOCK), acc0);
+      acc1 = _mm512_fmadd_ps(
+          LatentIO<ItemT>::load(a + (i + 1) * LATENT_BLOCK),
+          LatentIO<UserT>::load(b + (i + 1) * LATENT_BLOCK), acc1);
+    }
+    if (i < nb)
+      acc0 = _mm512_fmadd_ps(LatentIO<ItemT>::load(a + i * LATENT_BLOCK),
+                             LatentIO<UserT>::load(b + i * LATENT_BLOCK), acc0);
+    // the tree of _mm512_reduce_add_ps, through memory: GCC 12 warns about
+    // an uninitialized operand inside it
+    alignas(64) LatentValue lanes[16];
+    _mm512_store_ps(lanes, _mm512_add_ps(acc0, acc1));
+    for (unsigned w = 8; w; w /= 2)
+      for (unsigned l = 0; l < w; ++l)
+        lanes[l] += lanes[l + w];
+    return lanes[0];
+  }
+
+  static void update(void* itemV, void* userV, LatentValue scaledError,
+                     LatentValue decay, unsigned blocks) {
+    ItemT* __restrict__ item = static_cast<ItemT*>(itemV);
+    UserT* __restrict__ user = static_cast<UserT*>(userV);
+    const unsigned nb        = BLOCKS ? BLOCKS : blocks;
+    const __m512 se          = _mm512_set1_ps(scaledError);
+    const __m512 dc          = _mm512_set1_ps(decay);
+    for (unsigned i = 0; i < nb; ++i) {
+      __m512 it = LatentIO<ItemT>::load(item + i * LATENT_BLOCK);
+      __m512 us = LatentIO<UserT>::load(user + i * LATENT_BLOCK);
+      LatentIO<ItemT>::store(item + i * LATENT_BLOCK,
+                             _mm512_fnmadd_ps(se, us, _mm512_mul_ps(it, dc)));
+      LatentIO<UserT>::store(user + i * LATENT_BLOCK,
+                             _mm512_fnmadd_ps(se, it, _mm512_mul_ps(us, dc)));
+    }
+  }
+#elif defined(__AVX2__) && defined(__FMA__)
+  static LatentValue dot(const void* itemV, const void* userV,
+                         unsigned blocks) {
+    const ItemT* __restrict__ a = static_cast<const ItemT*>(itemV);
+    const UserT* __restrict__ b = static_cast<const UserT*>(userV);
+    const unsigned nb           = BLOCKS ? BLOCKS : blocks;
+    // a block is two vectors; one accumulator for each
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (unsigned i = 0; i < nb; ++i) {
+      acc0 = _mm256_fmadd_ps(LatentIO<ItemT>::load(a + i * LATENT_BLOCK),
+                             LatentIO<UserT>::load(b + i * LATENT_BLOCK), acc0);
+      acc1 = _mm256_fmadd_ps(LatentIO<ItemT>::load(a + i * LATENT_BLOCK + 8),
+                             LatentIO<UserT>::load(b + i * LATENT_BLOCK + 8),
+                             acc1);
+    }
+    __m256 sum  = _mm256_add_ps(acc0, acc1);
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(sum),
+                             _mm256_extractf128_ps(sum, 1));
+    half        = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half        = _mm_add_ss(half, _mm_movehdup_ps(half));
+    return _mm_cvtss_f32(half);
+  }
+
+  static void update(void* itemV, void* userV, LatentValue scaledError,
+                     LatentValue decay, unsigned blocks) {
+    ItemT* __restrict__ item = static_cast<ItemT*>(itemV);
+    UserT* __restrict__ user = static_cast<UserT*>(userV);
+    const unsigned nb        = BLOCKS ? BLOCKS : blocks;
+    const __m256 se          = _mm256_set1_ps(scaledError);
+    const __m256 dc          = _mm256_set1_ps(decay);
+    for (unsigned i = 0; i < 2 * nb; ++i) {
+      __m256 it = LatentIO<ItemT>::load(item + i * 8);
+      __m256 us = LatentIO<UserT>::load(user + i * 8);
+      LatentIO<ItemT>::store(item + i * 8,
+                             _mm256_fnmadd_ps(se, us, _mm256_mul_ps(it, dc)));
+      LatentIO<UserT>::store(user + i * 8,
+                             _mm256_fnmadd_ps(se, it, _mm256_mul_ps(us, dc)));
+    }
+  }
+#else
+  static LatentValue dot(const void* itemV, const void* userV,
+                         unsigned blocks) {
+    const ItemT* __restrict__ a = static_cast<const ItemT*>(itemV);
+    const UserT* __restrict__ b = static_cast<const UserT*>(userV);
+    const unsigned n            = (BLOCKS ? BLOCKS : blocks) * LATENT_BLOCK;
+    LatentValue sum             = 0;
+    for (unsigned i = 0; i < n; ++i)
+      sum += toFloat(a[i]) * toFloat(b[i]);
+    return sum;
+  }
+
+  static void update(void* itemV, void* userV, LatentValue scaledError,
+                     LatentValue decay, unsigned blocks) {
+    ItemT* __restrict__ item = static_cast<ItemT*>(itemV);
+    UserT* __restrict__ user = static_cast<UserT*>(userV);
+    const unsigned n         = (BLOCKS ? BLOCKS : blocks) * LATENT_BLOCK;
+    for (unsigned i = 0; i < n; ++i) {
+      LatentValue prevItem = toFloat(item[i]);
+      LatentValue prevUser = toFloat(user[i]);
+      item[i] = fromFloat<ItemT>(prevItem * decay - scaledError * prevUser);
+      user[i] = fromFloat<UserT>(prevUser * decay - scaledError * prevItem);
+    }
+  }
+#endif
+};
+
+/**
+ * Calls fn(LatentKernel<B, ItemT, UserT>()) with the kernel specialized for
+ * the number of blocks of the latent vectors, for the common lengths (up to
+ * 16, 32, 64, 100, 128 and 256), and with the runtime-length kernel
+ * otherwise.
+ */
+template <typename ItemT, typename UserT, typename F>
+auto withLatentKernel(unsigned blocks, const F& fn)
+    -> decltype(fn(LatentKernel<0, ItemT, UserT>())) {
+  switch (blocks) {
+  case 1:
+    return fn(LatentKernel<1, ItemT, UserT>());
+  case 2:
+    return fn(LatentKernel<2, ItemT, UserT>());
+  case 4:
+    return fn(LatentKernel<4, ItemT, UserT>());
+  case 7:
+    return fn(LatentKernel<7, ItemT, UserT>());
+  case 8:
+    return fn(LatentKernel<8, ItemT, UserT>());
+  case 16:
+    return fn(LatentKernel<16, ItemT, UserT>());
+  default:
+    return fn(LatentKernel<0, ItemT, UserT>());
+  }
+}
+
+} // namespace internal
+
+#endif
@@ -123,7 +123,7 @@ struct BoldStepFunction : public StepFunction {
 };
 
 template <typename Graph>
-double sumSquaredError(Graph& g) {
+double sumSquaredError(Graph& g, const LatentStorage& storage) {
   typedef typename Graph::GraphNode GNode;
   // computing Root Mean Square Error
   // Assuming only item nodes have edges
@@ -134,7 +134,7 @@ double sumSquaredError(Graph& g) {
         for (auto ii = g.edge_begin(n), ei = g.edge_end(n); ii != ei; ++ii) {
           GNode dst = g.getEdgeDst(ii);
           LatentValue e =
-              predictionError(g.getData(n).latentVector,
+              predictionError(storage, g.getData(n).latentVector,
                               g.getData(dst).latentVector, g.getEdgeData(ii));
           error += (e * e);
         }
@@ -158,16 +158,19 @@ size_t countEdges(Graph& g) {
 }
 
 template <typename Graph>
-void verify(Graph& g, const std::string& prefix) {
+double verify(Graph& g, const LatentStorage& storage,
+              const std::string& prefix) {
   std::cout << countEdges(g) << " : " << g.sizeEdges() << "\n";
   if (countEdges(g) != g.sizeEdges()) {
     GALOIS_DIE("Error: edge list of input graph probably not sorted");
   }
 
-  double error = sumSquaredError(g);
+  double error = sumSquaredError(g, storage);
   double rmse  = std::sqrt(error / g.sizeEdges());
 
   std::cout << prefix << "RMSE: " << rmse << "\n";
+  galois::runtime::reportStat_Single("MatrixCompletion", prefix + "RMSE", rmse);
+  return rmse;
 }
 
 template <typename T, unsigned Size>
@@ -252,11 +255,13 @@ double countFlops(size_t nnz, int rounds, int k) {
  *
  * @param StepFunction to be used
  * @param Graph
+ * @param storage types of the latent vectors of the Graph
  * @param fn (algorithm)
  *
  */
 template <typename Graph, typename Fn>
-void executeUntilConverged(const StepFunction& sf, Graph& g, Fn fn) {
+void executeUntilConverged(const StepFunction& sf, Graph& g,
+                           const LatentStorage& storage, Fn fn) {
   galois::GAccumulator<double> errorAccum;
   std::vector<LatentValue> steps(updatesPerEdge);
   LatentValue last    = -1.0;
@@ -286,7 +291,7 @@ void executeUntilConverged(const StepFunction& sf, Graph& g, Fn fn) {
     executeAlgoTimer.start();
     fn(&steps[0], round + deltaRound, useExactError ? &errorAccum : NULL);
     executeAlgoTimer.stop();
-    double error = useExactError ? errorAccum.reduce() : sumSquaredError(g);
+    double error = useExactError ? errorAccum.reduce() : sumSquaredError(g, storage);
 
     elapsed.stop();
 
@@ -295,7 +300,7 @@ void executeUntilConverged(const StepFunction& sf, Graph& g, Fn fn) {
     unsigned long millis = curElapsed - lastTime;
     lastTime             = curElapsed;
 
-    double gflops = countFlops(g.sizeEdges(), deltaRound, LATENT_VECTOR_SIZE) /
+    double gflops = countFlops(g.sizeEdges(), deltaRound, latentVectorSize) /
                     millis / 1e6;
 
     int curRound = round + deltaRound;
@@ -338,7 +343,7 @@ struct SGDBlockJumpAlgo {
   std::string name() const { return "sgdBlockJumpAlgo"; }
 
   struct Node {
-    LatentValue latentVector[LATENT_VECTOR_SIZE];
+    void* latentVector;
   };
 
   typedef galois::graphs::LC_CSR_Graph<Node, EdgeType>
@@ -374,6 +379,7 @@ struct SGDBlockJumpAlgo {
 
   struct Process {
     Graph& g;
+    const LatentStorage& storage;
     SpinLock *xLocks, *yLocks;
     BlockInfo* blocks;
     size_t numXBlocks, numYBlocks;
@@ -437,9 +443,9 @@ struct SGDBlockJumpAlgo {
           if (user >= lastUser)
             break;
 
-          LatentValue e = doGradientUpdate(itemData.latentVector,
-                                           g.getData(user).latentVector, lambda,
-                                           g.getEdgeData(*ii.base()), stepSize);
+          LatentValue e = doGradientUpdate(
+              storage, itemData.latentVector, g.getData(user).latentVector,
+              lambda, g.getEdgeData(*ii.base()), stepSize);
           if (errorAccum)
             error += e * e;
           ++seen;
@@ -485,9 +491,9 @@ struct SGDBlockJumpAlgo {
           if (user >= lastUser)
             break;
 
-          LatentValue e = doGradientUpdate(itemData.latentVector,
-                                           g.getData(user).latentVector, lambda,
-                                           g.getEdgeData(ii), stepSize);
+          LatentValue e = doGradientUpdate(
+              storage, itemData.latentVector, g.getData(user).latentVector,
+              lambda, g.getEdgeData(ii), stepSize);
           if (errorAccum)
             error += e * e;
           ++seen;
@@ -560,7 +566,8 @@ struct SGDBlockJumpAlgo {
     }
   };
 
-  void operator()(Graph& g, const StepFunction& sf) {
+  void operator()(Graph& g, const StepFunction& sf,
+                  const LatentStorage& storage) {
     galois::StatTimer preProcessTimer("PreProcessingTime");
     preProcessTimer.start();
     const size_t numUsers = g.size() - NUM_ITEM_NODES;
@@ -630,12 +637,13 @@ struct SGDBlockJumpAlgo {
     // galois::StatTimer executeTimer("Total Execution Time");
     galois::StatTimer executeTimer("Time");
     executeTimer.start();
-    executeUntilConverged(sf, g,
+    executeUntilConverged(sf, g, storage,
                           [&](LatentValue* steps, size_t maxUpdates,
                               galois::GAccumulator<double>* errorAccum) {
-                            Process fn{g,      xLocks,     yLocks,
-                                       blocks, numXBlocks, numYBlocks,
-                                       steps,  maxUpdates, errorAccum};
+                            Process fn{g,          storage,    xLocks,
+                                       yLocks,     blocks,     numXBlocks,
+                                       numYBlocks, steps,      maxUpdates,
+                                       errorAccum};
                             galois::on_each(fn);
                           });
     executeTimer.stop();
@@ -650,7 +658,7 @@ class SGDItemsAlgo {
   static const bool makeSerializable = false;
 
   struct BasicNode {
-    LatentValue latentVector[LATENT_VECTOR_SIZE];
+    void* latentVector;
   };
 
   using Node = BasicNode;
@@ -675,6 +683,7 @@ private:
 
   struct Execute {
     Graph& g;
+    const LatentStorage& storage;
     galois::GAccumulator<unsigned>& edgesVisited;
 
     void operator()(LatentValue* steps, int maxUpdates,
@@ -688,6 +697,7 @@ private:
 
               GNode dst         = g.getEdgeDst(ii);
               LatentValue error = doGradientUpdate(
+                  storage,
                   g.getData(src, galois::MethodFlag::UNPROTECTED).latentVector,
                   g.getData(dst).latentVector, lambda, g.getEdgeData(ii),
                   stepSize);
@@ -703,16 +713,17 @@ private:
   };
 
 public:
-  void operator()(Graph& g, const StepFunction& sf) {
-    verify(g, "sgdItemsAlgo");
+  void operator()(Graph& g, const StepFunction& sf,
+                  const LatentStorage& storage) {
+    verify(g, storage, "sgdItemsAlgo");
     galois::GAccumulator<unsigned> edgesVisited;
 
     // galois::StatTimer executeTimer("Total Execution Time");
     galois::StatTimer executeTimer("Time");
     executeTimer.start();
 
-    Execute fn{g, edgesVisited};
-    executeUntilConverged(sf, g, fn);
+    Execute fn{g, storage, edgesVisited};
+    executeUntilConverged(sf, g, storage, fn);
 
     executeTimer.stop();
 
@@ -730,7 +741,7 @@ class SGDEdgeItem {
 
   struct BasicNode {
     // latent vector to be learned.
-    LatentValue latentVector[LATENT_VECTOR_SIZE];
+    void* latentVector;
     // if a item's update is interrupted, where to start when resuming.
     unsigned int edge_offset;
   };
@@ -757,6 +768,7 @@ private:
 
   struct Execute {
     Graph& g;
+    const LatentStorage& storage;
     galois::GAccumulator<unsigned>& edgesVisited;
     void operator()(LatentValue* steps, int maxUpdates,
                     galois::GAccumulator<double>* errorAccum) {
@@ -778,9 +790,9 @@ private:
             // Take lock on the destination as multiple source may update the
             // same destination.
             auto& dstData = g.getData(g.getEdgeDst(ii));
-            LatentValue error =
-                doGradientUpdate(srcData.latentVector, dstData.latentVector,
-                                 lambda, g.getEdgeData(ii), stepSize);
+            LatentValue error = doGradientUpdate(
+                storage, srcData.latentVector, dstData.latentVector, lambda,
+                g.getEdgeData(ii), stepSize);
 
             ++srcData.edge_offset;
             ++ii;
@@ -806,16 +818,17 @@ private:
   };
 
 public:
-  void operator()(Graph& g, const StepFunction& sf) {
-    verify(g, "sgdEdgeItem");
+  void operator()(Graph& g, const StepFunction& sf,
+                  const LatentStorage& storage) {
+    verify(g, storage, "sgdEdgeItem");
     galois::GAccumulator<unsigned> edgesVisited;
 
     // galois::StatTimer executeTimer("Total Execution Time");
     galois::StatTimer executeTimer("Time");
     executeTimer.start();
 
-    Execute fn{g, edgesVisited};
-    executeUntilConverged(sf, g, fn);
+    Execute fn{g, storage, edgesVisited};
+    executeUntilConverged(sf, g, storage, fn);
 
     executeTimer.stop();
 
@@ -834,7 +847,7 @@ class SGDBlockEdgeAlgo {
   static const bool makeSerializable = false;
 
   struct BasicNode {
-    LatentValue latentVector[LATENT_VECTOR_SIZE];
+    void* latentVector;
   };
 
   using Node = BasicNode;
@@ -859,6 +872,7 @@ private:
 
   struct Execute {
     Graph& g;
+    const LatentStorage& storage;
     galois::GAccumulator<unsigned>& edgesVisited;
 
     void operator()(LatentValue* steps, int maxUpdates,
@@ -870,8 +884,9 @@ private:
           [&](GNode src, GNode dst, edge_iterator edge) {
             const LatentValue stepSize = steps[0];
             LatentValue error          = doGradientUpdate(
-                g.getData(src).latentVector, g.getData(dst).latentVector,
-                lambda, g.getEdgeData(edge), stepSize);
+                storage, g.getData(src).latentVector,
+                g.getData(dst).latentVector, lambda, g.getEdgeData(edge),
+                stepSize);
             edgesVisited += 1;
             if (useExactError)
               *errorAccum += error;
@@ -882,16 +897,17 @@ private:
   };
 
 public:
-  void operator()(Graph& g, const StepFunction& sf) {
-    verify(g, "sgdBlockEdgeAlgo");
+  void operator()(Graph& g, const StepFunction& sf,
+                  const LatentStorage& storage) {
+    verify(g, storage, "sgdBlockEdgeAlgo");
     galois::GAccumulator<unsigned> edgesVisited;
 
     // galois::StatTimer executeTimer("Total Execution Time");
     galois::StatTimer executeTimer("Time");
     executeTimer.start();
 
-    Execute fn{g, edgesVisited};
-    executeUntilConverged(sf, g, fn);
+    Execute fn{g, storage, edgesVisited};
+    executeUntilConverged(sf, g, storage, fn);
 
     executeTimer.stop();
 
@@ -910,7 +926,7 @@ struct SimpleALSalgo {
   bool isSgd() const { return false; }
   std::string name() const { return "AlternatingLeastSquares"; }
   struct Node {
-    LatentValue latentVector[LATENT_VECTOR_SIZE];
+    void* latentVector;
   };
 
   typedef typename galois::graphs::LC_CSR_Graph<Node, EdgeType>::with_no_lockable<
@@ -918,8 +934,8 @@ struct SimpleALSalgo {
   typedef Graph::GraphNode GNode;
   // Column-major access
   typedef Eigen::SparseMatrix<LatentValue> Sp;
-  typedef Eigen::Matrix<LatentValue, LATENT_VECTOR_SIZE, Eigen::Dynamic> MT;
-  typedef Eigen::Matrix<LatentValue, LATENT_VECTOR_SIZE, 1> V;
+  typedef Eigen::Matrix<LatentValue, Eigen::Dynamic, Eigen::Dynamic> MT;
+  typedef Eigen::Matrix<LatentValue, Eigen::Dynamic, 1> V;
   typedef Eigen::Map<V> MapV;
 
   Sp A;
@@ -928,10 +944,12 @@ struct SimpleALSalgo {
   void readGraph(Graph& g) { galois::graphs::readGraph(g, inputFilename); }
 
   void copyToGraph(Graph& g, MT& WT, MT& HT) {
+    const int k = latentVectorSize;
     // Copy out
     for (GNode n : g) {
-      LatentValue* ptr = &g.getData(n).latentVector[0];
-      MapV mapV{ptr};
+      LatentValue* ptr =
+          static_cast<LatentValue*>(g.getData(n).latentVector);
+      MapV mapV{ptr, k};
       if (n < NUM_ITEM_NODES) {
         mapV = WT.col(n);
       } else {
@@ -941,9 +959,11 @@ struct SimpleALSalgo {
   }
 
   void copyFromGraph(Graph& g, MT& WT, MT& HT) {
+    const int k = latentVectorSize;
     for (GNode n : g) {
-      LatentValue* ptr = &g.getData(n).latentVector[0];
-      MapV mapV{ptr};
+      LatentValue* ptr =
+          static_cast<LatentValue*>(g.getData(n).latentVector);
+      MapV mapV{ptr, k};
       if (n < NUM_ITEM_NODES) {
         WT.col(n) = mapV;
       } else {
@@ -967,7 +987,8 @@ struct SimpleALSalgo {
     AT = A.transpose();
   }
 
-  void operator()(Graph& g, const StepFunction&) {
+  void operator()(Graph& g, const StepFunction&,
+                  const LatentStorage& storage) {
     galois::TimeAccumulator elapsed;
     elapsed.start();
 
@@ -975,11 +996,12 @@ struct SimpleALSalgo {
     // squares problems:
     //   (W^T W + lambda I) H^T = W^T A (solving for H^T)
     //   (H^T H + lambda I) W^T = H^T A^T (solving for W^T)
-    MT WT{LATENT_VECTOR_SIZE, NUM_ITEM_NODES};
-    MT HT{LATENT_VECTOR_SIZE, g.size() - NUM_ITEM_NODES};
-    typedef Eigen::Matrix<LatentValue, LATENT_VECTOR_SIZE, LATENT_VECTOR_SIZE>
+    const int k = latentVectorSize;
+    MT WT{k, NUM_ITEM_NODES};
+    MT HT{k, g.size() - NUM_ITEM_NODES};
+    typedef Eigen::Matrix<LatentValue, Eigen::Dynamic, Eigen::Dynamic>
         XTX;
-    typedef Eigen::Matrix<LatentValue, LATENT_VECTOR_SIZE, Eigen::Dynamic> XTSp;
+    typedef Eigen::Matrix<LatentValue, Eigen::Dynamic, Eigen::Dynamic> XTSp;
     typedef galois::substrate::PerThreadStorage<XTX> PerThrdXTX;
 
     galois::gPrint("ALS::Start initializeA\n");
@@ -1014,11 +1036,11 @@ struct SimpleALSalgo {
           [&](int col, galois::UserContext<int>&) {
             // Compute WTW = W^T * W for sparse A
             XTX& WTW = *xtxs.getLocal();
-            WTW.setConstant(0);
+            WTW.setZero(k, k);
             for (Sp::InnerIterator it(A, col); it; ++it)
               WTW.triangularView<Eigen::Upper>() +=
                   WT.col(it.row()) * WT.col(it.row()).transpose();
-            for (int i = 0; i < LATENT_VECTOR_SIZE; ++i)
+            for (unsigned i = 0; i < latentVectorSize; ++i)
               WTW(i, i) += lambda;
             HT.col(col) =
                 WTW.selfadjointView<Eigen::Upper>().llt().solve(WTA.col(col));
@@ -1036,11 +1058,11 @@ struct SimpleALSalgo {
           [&](int col, galois::UserContext<int>&) {
             // Compute HTH = H^T * H for sparse A
             XTX& HTH = *xtxs.getLocal();
-            HTH.setConstant(0);
+            HTH.setZero(k, k);
             for (Sp::InnerIterator it(AT, col); it; ++it)
               HTH.triangularView<Eigen::Upper>() +=
                   HT.col(it.row()) * HT.col(it.row()).transpose();
-            for (int i = 0; i < LATENT_VECTOR_SIZE; ++i)
+            for (unsigned i = 0; i < latentVectorSize; ++i)
               HTH(i, i) += lambda;
             WT.col(col) =
                 HTH.selfadjointView<Eigen::Upper>().llt().solve(HTAT.col(col));
@@ -1052,7 +1074,7 @@ struct SimpleALSalgo {
       copyTime.stop();
       totalExecTime.stop();
 
-      double error = sumSquaredError(g);
+      double error = sumSquaredError(g, storage);
       elapsed.stop();
       std::cout << "R: " << round << " elapsed (ms): " << elapsed.get()
                 << " RMSE (R " << round
@@ -1078,7 +1100,7 @@ struct SyncALSalgo {
   std::string name() const { return "SynchronousAlternatingLeastSquares"; }
 
   struct Node {
-    LatentValue latentVector[LATENT_VECTOR_SIZE];
+    void* latentVector;
   };
 
   static const bool NEEDS_LOCKS = false;
@@ -1090,12 +1112,12 @@ struct SyncALSalgo {
   typedef typename Graph::GraphNode GNode;
   // Column-major access
   typedef Eigen::SparseMatrix<LatentValue> Sp;
-  typedef Eigen::Matrix<LatentValue, LATENT_VECTOR_SIZE, Eigen::Dynamic> MT;
-  typedef Eigen::Matrix<LatentValue, LATENT_VECTOR_SIZE, 1> V;
+  typedef Eigen::Matrix<LatentValue, Eigen::Dynamic, Eigen::Dynamic> MT;
+  typedef Eigen::Matrix<LatentValue, Eigen::Dynamic, 1> V;
   typedef Eigen::Map<V> MapV;
-  typedef Eigen::Matrix<LatentValue, LATENT_VECTOR_SIZE, LATENT_VECTOR_SIZE>
+  typedef Eigen::Matrix<LatentValue, Eigen::Dynamic, Eigen::Dynamic>
       XTX;
-  typedef Eigen::Matrix<LatentValue, LATENT_VECTOR_SIZE, Eigen::Dynamic> XTSp;
+  typedef Eigen::Matrix<LatentValue, Eigen::Dynamic, Eigen::Dynamic> XTSp;
 
   typedef galois::substrate::PerThreadStorage<XTX> PerThrdXTX;
   typedef galois::substrate::PerThreadStorage<V> PerThrdV;
@@ -1106,10 +1128,12 @@ struct SyncALSalgo {
   void readGraph(Graph& g) { galois::graphs::readGraph(g, inputFilename); }
 
   void copyToGraph(Graph& g, MT& WT, MT& HT) {
+    const int k = latentVectorSize;
     // Copy out
     for (GNode n : g) {
-      LatentValue* ptr = &g.getData(n).latentVector[0];
-      MapV mapV{ptr};
+      LatentValue* ptr =
+          static_cast<LatentValue*>(g.getData(n).latentVector);
+      MapV mapV{ptr, k};
       if (n < NUM_ITEM_NODES) {
         mapV = WT.col(n);
       } else {
@@ -1119,9 +1143,11 @@ struct SyncALSalgo {
   }
 
   void copyFromGraph(Graph& g, MT& WT, MT& HT) {
+    const int k = latentVectorSize;
     for (GNode n : g) {
-      LatentValue* ptr = &g.getData(n).latentVector[0];
-      MapV mapV{ptr};
+      LatentValue* ptr =
+          static_cast<LatentValue*>(g.getData(n).latentVector);
+      MapV mapV{ptr, k};
       if (n < NUM_ITEM_NODES) {
         WT.col(n) = mapV;
       } else {
@@ -1147,33 +1173,34 @@ struct SyncALSalgo {
 
   void update(Graph& g, size_t col, MT& WT, MT& HT, PerThrdXTX& xtxs,
               PerThrdV& rhs) {
+    const int k = latentVectorSize;
     // Compute WTW = W^T * W for sparse A
     V& r = *rhs.getLocal();
     if (col < NUM_ITEM_NODES) {
-      r.setConstant(0);
+      r.setZero(k);
       // HTAT = HT * AT; r = HTAT.col(col)
       for (Sp::InnerIterator it(AT, col); it; ++it)
         r += it.value() * HT.col(it.row());
       XTX& HTH = *xtxs.getLocal();
-      HTH.setConstant(0);
+      HTH.setZero(k, k);
       for (Sp::InnerIterator it(AT, col); it; ++it)
         HTH.triangularView<Eigen::Upper>() +=
             HT.col(it.row()) * HT.col(it.row()).transpose();
-      for (int i = 0; i < LATENT_VECTOR_SIZE; ++i)
+      for (unsigned i = 0; i < latentVectorSize; ++i)
         HTH(i, i) += lambda;
       WT.col(col) = HTH.selfadjointView<Eigen::Upper>().llt().solve(r);
     } else {
       col = col - NUM_ITEM_NODES;
-      r.setConstant(0);
+      r.setZero(k);
       // WTA = WT * A; x = WTA.col(col)
       for (Sp::InnerIterator it(A, col); it; ++it)
         r += it.value() * WT.col(it.row());
       XTX& WTW = *xtxs.getLocal();
-      WTW.setConstant(0);
+      WTW.setZero(k, k);
       for (Sp::InnerIterator it(A, col); it; ++it)
         WTW.triangularView<Eigen::Upper>() +=
             WT.col(it.row()) * WT.col(it.row()).transpose();
-      for (int i = 0; i < LATENT_VECTOR_SIZE; ++i)
+      for (unsigned i = 0; i < latentVectorSize; ++i)
         WTW(i, i) += lambda;
       HT.col(col) = WTW.selfadjointView<Eigen::Upper>().llt().solve(r);
     }
@@ -1218,7 +1245,8 @@ struct SyncALSalgo {
     }
   };
 
-  void operator()(Graph& g, const StepFunction&) {
+  void operator()(Graph& g, const StepFunction&,
+                  const LatentStorage& storage) {
     if (!useSameLatentVector) {
       galois::gWarn("Results are not deterministic with different numbers of "
                     "threads unless -useSameLatentVector is true");
@@ -1230,8 +1258,9 @@ struct SyncALSalgo {
     // squares problems:
     //   (W^T W + lambda I) H^T = W^T A (solving for H^T)
     //   (H^T H + lambda I) W^T = H^T A^T (solving for W^T)
-    MT WT{LATENT_VECTOR_SIZE, NUM_ITEM_NODES};
-    MT HT{LATENT_VECTOR_SIZE, g.size() - NUM_ITEM_NODES};
+    const int k = latentVectorSize;
+    MT WT{k, NUM_ITEM_NODES};
+    MT HT{k, g.size() - NUM_ITEM_NODES};
 
     initializeA(g);
     copyFromGraph(g, WT, HT);
@@ -1269,7 +1298,7 @@ struct SyncALSalgo {
       copyTime.stop();
       totalExecTime.stop();
 
-      double error = sumSquaredError(g);
+      double error = sumSquaredError(g, storage);
       elapsed.stop();
       std::cout << "R: " << round << " elapsed (ms): " << elapsed.get()
                 << " RMSE (R " << round
@@ -1296,16 +1325,20 @@ struct SyncALSalgo {
  *
  * @tparam Graph type of g
  * @param g Graph to initialize
+ * @param latents storage of the latent vectors of the nodes of g, allocated
+ * here once the items are known
+ * @param storage types of the item and user latent vectors
  * @returns number of item nodes, i.e. nodes with outgoing edges. They should
  * be the first nodes of the graph in memory
  */
 
 template <typename Graph>
-size_t initializeGraphData(Graph& g) {
+size_t initializeGraphData(Graph& g, LatentVectors& latents,
+                           const LatentStorage& storage) {
   galois::gPrint("initializeGraphData\n");
   galois::StatTimer initTimer("InitializeGraph");
   initTimer.start();
-  double top = 1.0 / std::sqrt(LATENT_VECTOR_SIZE);
+  double top = 1.0 / std::sqrt(double(latentVectorSize));
   galois::substrate::PerThreadStorage<std::mt19937> gen;
 
 #if __cplusplus >= 201103L || defined(HAVE_CXX11_UNIFORM_INT_DISTRIBUTION)
@@ -1314,34 +1347,6 @@ size_t initializeGraphData(Graph& g) {
   std::uniform_real<LatentValue> dist(0, top);
 #endif
 
-  if (useDetInit) {
-    galois::do_all(galois::iterate(g), [&](typename Graph::GraphNode n) {
-      auto& data = g.getData(n);
-      auto val   = genVal(n);
-      for (int i = 0; i < LATENT_VECTOR_SIZE; i++) {
-        data.latentVector[i] = val;
-      }
-    });
-  } else {
-    galois::do_all(galois::iterate(g), [&](typename Graph::GraphNode n) {
-      auto& data = g.getData(n);
-
-      // all threads initialize their assignment with same generator or
-      // a thread local one
-      if (useSameLatentVector) {
-        std::mt19937 sameGen;
-        for (int i = 0; i < LATENT_VECTOR_SIZE; i++) {
-          data.latentVector[i] = dist(sameGen);
-        }
-      } else {
-        for (int i = 0; i < LATENT_VECTOR_SIZE; i++) {
-          data.latentVector[i] = dist(*gen.getLocal());
-        }
-      }
-    });
-  }
-
-
    auto activeThreads = galois::getActiveThreads();
    std::vector<uint32_t> largestNodeID_perThread(activeThreads);
 
@@ -1371,6 +1376,36 @@ size_t initializeGraphData(Graph& g) {
     }
     size_t numItemNodes = largestNodeID + 1;
 
+  // items are stored apart from users, possibly at a different precision
+  latents.allocate(g.size(), numItemNodes, storage);
+  galois::do_all(galois::iterate(g), [&](typename Graph::GraphNode n) {
+    g.getData(n).latentVector = latents[n];
+  });
+
+  if (useDetInit) {
+    galois::do_all(galois::iterate(g), [&](typename Graph::GraphNode n) {
+      auto val = genVal(n);
+      for (unsigned i = 0; i < latentVectorSize; i++) {
+        latents.set(n, i, val);
+      }
+    });
+  } else {
+    galois::do_all(galois::iterate(g), [&](typename Graph::GraphNode n) {
+      // all threads initialize their assignment with same generator or
+      // a thread local one
+      if (useSameLatentVector) {
+        std::mt19937 sameGen;
+        for (unsigned i = 0; i < latentVectorSize; i++) {
+          latents.set(n, i, dist(sameGen));
+        }
+      } else {
+        for (unsigned i = 0; i < latentVectorSize; i++) {
+          latents.set(n, i, dist(*gen.getLocal()));
+        }
+      }
+    });
+  }
+
   initTimer.stop();
   return numItemNodes;
 }
@@ -1393,37 +1428,58 @@ StepFunction* newStepFunction() {
 }
 
 template <typename Graph>
-void writeBinaryLatentVectors(Graph& g, const std::string& filename) {
+void writeBinaryLatentVectors(Graph& g, LatentVectors& latents,
+                              const std::string& filename) {
   std::ofstream file(filename);
   for (auto ii = g.begin(), ei = g.end(); ii != ei; ++ii) {
-    auto& v = g.getData(*ii).latentVector;
-    for (int i = 0; i < LATENT_VECTOR_SIZE; ++i) {
-      file.write(reinterpret_cast<char*>(&v[i]), sizeof(v[i]));
+    for (unsigned i = 0; i < latentVectorSize; ++i) {
+      LatentValue v = latents.get(*ii, i);
+      file.write(reinterpret_cast<char*>(&v), sizeof(v));
     }
   }
   file.close();
 }
 
 template <typename Graph>
-void writeAsciiLatentVectors(Graph& g, const std::string& filename) {
+void writeAsciiLatentVectors(Graph& g, LatentVectors& latents,
+                             const std::string& filename) {
   std::ofstream file(filename);
   for (auto ii = g.begin(), ei = g.end(); ii != ei; ++ii) {
-    auto& v = g.getData(*ii).latentVector;
-    for (int i = 0; i < LATENT_VECTOR_SIZE; ++i) {
-      file << v[i] << " ";
+    for (unsigned i = 0; i < latentVectorSize; ++i) {
+      file << latents.get(*ii, i) << " ";
     }
     file << "\n";
   }
   file.close();
 }
 
+/**
+ * Trains again with float storage and returns the final RMSE, as the
+ * reference of a run with 16-bit storage. With -useDetInit both runs start
+ * from the same latent vectors.
+ */
+template <typename Algo>
+double fp32Rmse() {
+  const LatentStorage fp32{};
+
+  typename Algo::Graph g;
+  Algo algo;
+  algo.readGraph(g);
+  LatentVectors latents;
+  initializeGraphData(g, latents, fp32);
+  std::unique_ptr<StepFunction> sf{newStepFunction()};
+  algo(g, *sf, fp32);
+  return std::sqrt(sumSquaredError(g, fp32) / g.sizeEdges());
+}
+
 /**
  * Run the provided algorithm (provided through the template argument).
  *
  * @param Algo algorithm to run
+ * @param storage types of the item and user latent vectors
  */
 template <typename Algo>
-void run() {
+void run(const LatentStorage& storage) {
   typename Algo::Graph g;
   Algo algo;
 
@@ -1438,7 +1494,8 @@ void run() {
   galois::runtime::reportNumaAlloc("NumaAlloc1");
 
   // initialize latent vectors and get number of item nodes
-  NUM_ITEM_NODES = initializeGraphData(g);
+  LatentVectors latents;
+  NUM_ITEM_NODES = initializeGraphData(g, latents, storage);
 
   galois::runtime::reportNumaAlloc("NumaAlloc2");
 
@@ -1447,7 +1504,9 @@ void run() {
             << " num ratings: " << g.sizeEdges() << "\n";
 
   std::unique_ptr<StepFunction> sf{newStepFunction()};
-  std::cout << "latent vector size: " << LATENT_VECTOR_SIZE
+  std::cout << "latent vector size: " << latentVectorSize << " precision: "
+            << latentPrecisionName(storage.items) << " (items) "
+            << latentPrecisionName(storage.users) << " (users)"
             << " algo: " << algo.name() << " lambda: " << lambda;
 
   if (algo.isSgd()) {
@@ -1459,27 +1518,40 @@ void run() {
   std::cout << "\n";
 
   if (!skipVerify) {
-    verify(g, "Initial");
+    verify(g, storage, "Initial");
   }
 
   // algorithm call
   galois::StatTimer totalTimer("Total Time");
   totalTimer.start();
-  algo(g, *sf);
+  algo(g, *sf, storage);
   totalTimer.stop();
 
+  double rmse = 0;
   if (!skipVerify) {
-    verify(g, "Final");
+    rmse = verify(g, storage, "Final");
+  }
+
+  if (fp32RmseTolerance > 0 && storage.users != LatentPrecision::fp32) {
+    if (skipVerify)
+      rmse = std::sqrt(sumSquaredError(g, storage) / g.sizeEdges());
+    double reference = fp32Rmse<Algo>();
+    std::cout << "fp32 RMSE: " << reference << "\n";
+    galois::runtime::reportStat_Single("MatrixCompletion", "Fp32RMSE",
+                                       reference);
+    if (!(rmse <= reference * (1 + fp32RmseTolerance)))
+      GALOIS_DIE("RMSE ", rmse, " exceeds the fp32 RMSE ", reference,
+                 " by more than ", fp32RmseTolerance);
   }
 
   if (outputFilename != "") {
     std::cout << "Writing latent vectors to " << outputFilename << "\n";
     switch (outputType) {
     case OutputType::binary:
-      writeBinaryLatentVectors(g, outputFilename);
+      writeBinaryLatentVectors(g, latents, outputFilename);
       break;
     case OutputType::ascii:
-      writeAsciiLatentVectors(g, outputFilename);
+      writeAsciiLatentVectors(g, latents, outputFilename);
       break;
     default:
       GALOIS_DIE("Invalid output type for latent vector output");
@@ -1493,26 +1565,37 @@ int main(int argc, char** argv) {
   galois::SharedMemSys G;
   LonestarStart(argc, argv, name, desc, url);
 
+  if (latentVectorSize == 0) {
+    GALOIS_DIE("latent vector size must be positive");
+  }
+  const LatentStorage storage = LatentStorage::fromOptions();
+  if ((algo == Algo::syncALS || algo == Algo::simpleALS) &&
+      storage.users != LatentPrecision::fp32) {
+    GALOIS_DIE("ALS requires -latentPrecision=fp32");
+  }
+  galois::runtime::reportParam("MatrixCompletion", "LatentPrecision",
+                               latentPrecisionName(storage.users));
+
   switch (algo) {
 #ifdef HAS_EIGEN
   case Algo::syncALS:
-    run<SyncALSalgo>();
+    run<SyncALSalgo>(storage);
     break;
   case Algo::simpleALS:
-    run<SimpleALSalgo>();
+    run<SimpleALSalgo>(storage);
     break;
 #endif
   case Algo::sgdByItems:
-    run<SGDItemsAlgo>();
+    run<SGDItemsAlgo>(storage);
     break;
   case Algo::sgdByEdges:
-    run<SGDEdgeItem>();
+    run<SGDEdgeItem>(storage);
     break;
   case Algo::sgdBlockEdge:
-    run<SGDBlockEdgeAlgo>();
+    run<SGDBlockEdgeAlgo>(storage);
     break;
   case Algo::sgdBlockJump:
-    run<SGDBlockJumpAlgo>();
+    run<SGDBlockJumpAlgo>(storage);
     break;
   default:
     GALOIS_DIE("unknown algorithm");
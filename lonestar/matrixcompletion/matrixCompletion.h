@@ -22,21 +22,21 @@
 
 #include <cassert>
 #include <galois/gstl.h>
+#include <galois/Galois.h>
+#include <galois/LargeArray.h>
 #include <string>
 #include "llvm/Support/CommandLine.h"
+#include "latentKernels.h"
 
-typedef float LatentValue;
 typedef float EdgeType;
 
-// Purdue, CSGD: 100; Intel: 20
-// static const int LATENT_VECTOR_SIZE = 100;
-static const int LATENT_VECTOR_SIZE = 20; // Purdue, CSGD: 100; Intel: 20
-
 /**
  * Common commandline parameters to for matrix completion algorithms
  */
 enum OutputType { binary, ascii };
 
+enum LatentPrecision { fp32, bf16, fp16 };
+
 namespace cll = llvm::cl;
 static cll::opt<std::string>
     inputFilename(cll::Positional, cll::desc("<input file>"), cll::Required);
@@ -68,6 +68,33 @@ static cll::opt<float> lambda("lambda",
                               cll::desc("regularization parameter [lambda]"),
                               cll::init(0.05));
 
+// Purdue, CSGD: 100; Intel: 20
+static cll::opt<unsigned>
+    latentVectorSize("latentVectorSize",
+                     cll::desc("length of latent vectors (default 20)"),
+                     cll::init(20));
+
+static cll::opt<LatentPrecision> latentPrecision(
+    "latentPrecision",
+    cll::desc("Storage type of latent vectors (SGD only; ALS rejects "
+              "anything but fp32):"),
+    cll::values(clEnumValN(LatentPrecision::fp32, "fp32", "float (default)"),
+                clEnumValN(LatentPrecision::bf16, "bf16", "bfloat16"),
+                clEnumValN(LatentPrecision::fp16, "fp16", "IEEE half"),
+                clEnumValEnd),
+    cll::init(LatentPrecision::fp32));
+static cll::opt<bool>
+    fp32Items("fp32Items",
+              cll::desc("keep item latent vectors in float and store only "
+                        "user latent vectors as -latentPrecision"),
+              cll::init(false));
+static cll::opt<double> fp32RmseTolerance(
+    "fp32RmseTolerance",
+    cll::desc("with 16-bit storage, train again in float and fail if the "
+              "final RMSE exceeds the float one by more than this fraction "
+              "(default 0: no check)"),
+    cll::init(0));
+
 static cll::opt<unsigned> usersPerBlock("usersPerBlock",
                                         cll::desc("users per block"),
                                         cll::init(2048));
@@ -117,37 +144,153 @@ static cll::opt<bool>
                          "use deterministic values for latent vector"),
                cll::init(false));
 
+inline const char* latentPrecisionName(LatentPrecision p) {
+  switch (p) {
+  case LatentPrecision::bf16:
+    return "bf16";
+  case LatentPrecision::fp16:
+    return "fp16";
+  default:
+    return "fp32";
+  }
+}
+
+inline size_t latentValueSize(LatentPrecision p) {
+  return p == LatentPrecision::fp32 ? sizeof(float) : sizeof(uint16_t);
+}
+
 /**
- * Inner product of 2 vectors.
- *
- * Like std::inner_product but rewritten here to check vectorization
- *
- * @param first1 Pointer to beginning of vector 1
- * @param last1 Pointer to end of vector 1. Should be exactly LATENT_VECTOR_SIZE
- * away from first1
- * @param first2 Pointer to beginning of vector 2. Should have at least
- * LATENT_VECTOR_SIZE elements from this point.
- * @param init Initial value to accumulate sum into
- *
- * @returns init + the inner product (i.e. the inner product if init is 0, error
- * if init is -"ground truth"
+ * Storage types of the item and user latent vectors. Items are stored either
+ * as float or as the type of the users.
  */
-template <typename T>
-T innerProduct(T* __restrict__ first1, T* __restrict__ last1,
-               T* __restrict__ first2, T init) {
-  assert(first1 + LATENT_VECTOR_SIZE == last1);
-  for (int i = 0; i < LATENT_VECTOR_SIZE; ++i) {
-    init += first1[i] * first2[i];
+struct LatentStorage {
+  LatentPrecision items = LatentPrecision::fp32;
+  LatentPrecision users = LatentPrecision::fp32;
+
+  //! Storage selected by -latentPrecision and -fp32Items
+  static LatentStorage fromOptions() {
+    LatentStorage s;
+    s.users = latentPrecision;
+    s.items = fp32Items ? LatentPrecision::fp32 : latentPrecision;
+    return s;
+  }
+};
+
+/**
+ * Latent vectors of all nodes of a graph, in one page aligned array: the
+ * vectors of the items followed by the vectors of the users, each stored as
+ * given by a LatentStorage. Every vector starts on a block boundary.
+ */
+class LatentVectors {
+  galois::LargeArray<char> bytes;
+  LatentStorage storage;
+  size_t numItems;
+  size_t itemStride;
+  size_t userStride;
+
+  static float get(const void* v, LatentPrecision p, unsigned i) {
+    switch (p) {
+    case LatentPrecision::bf16:
+      return toFloat(static_cast<const BF16*>(v)[i]);
+    case LatentPrecision::fp16:
+      return toFloat(static_cast<const FP16*>(v)[i]);
+    default:
+      return static_cast<const float*>(v)[i];
+    }
+  }
+
+  static void set(void* v, LatentPrecision p, unsigned i, float val) {
+    switch (p) {
+    case LatentPrecision::bf16:
+      static_cast<BF16*>(v)[i] = fromFloat<BF16>(val);
+      break;
+    case LatentPrecision::fp16:
+      static_cast<FP16*>(v)[i] = fromFloat<FP16>(val);
+      break;
+    default:
+      static_cast<float*>(v)[i] = val;
+      break;
+    }
+  }
+
+public:
+  //! Allocates zeroed vectors of length latentVectorSize for n nodes, the
+  //! first items of which are items, stored as s
+  void allocate(size_t n, size_t items, const LatentStorage& s) {
+    storage       = s;
+    numItems      = items;
+    size_t padded = latentBlocks(latentVectorSize) * LATENT_BLOCK;
+    itemStride    = padded * latentValueSize(storage.items);
+    userStride    = padded * latentValueSize(storage.users);
+    size_t total  = numItems * itemStride + (n - numItems) * userStride;
+    bytes.allocateInterleaved(total);
+    galois::do_all(galois::iterate(size_t{0}, total),
+                   [&](size_t i) { bytes.constructAt(i, 0); },
+                   galois::no_stats());
+  }
+
+  void* operator[](size_t n) {
+    if (n < numItems)
+      return &bytes[n * itemStride];
+    return &bytes[numItems * itemStride + (n - numItems) * userStride];
+  }
+
+  LatentPrecision precision(size_t n) const {
+    return n < numItems ? storage.items : storage.users;
+  }
+
+  //! Value i of the latent vector of node n, as a float
+  float get(size_t n, unsigned i) { return get((*this)[n], precision(n), i); }
+
+  //! Sets value i of the latent vector of node n, rounding it to its
+  //! storage type
+  void set(size_t n, unsigned i, float val) {
+    set((*this)[n], precision(n), i, val);
+  }
+};
+
+/**
+ * Calls fn(LatentKernel<B, ItemT, UserT>()) with the kernel for the length
+ * of the latent vectors and the storage types s.
+ */
+template <typename F>
+auto withLatentKernel(const LatentStorage& s, const F& fn)
+    -> decltype(fn(internal::LatentKernel<0, float, float>())) {
+  const unsigned blocks = latentBlocks(latentVectorSize);
+  bool floatItems       = s.items == LatentPrecision::fp32;
+  switch (s.users) {
+  case LatentPrecision::bf16:
+    if (floatItems)
+      return internal::withLatentKernel<float, BF16>(blocks, fn);
+    return internal::withLatentKernel<BF16, BF16>(blocks, fn);
+  case LatentPrecision::fp16:
+    if (floatItems)
+      return internal::withLatentKernel<float, FP16>(blocks, fn);
+    return internal::withLatentKernel<FP16, FP16>(blocks, fn);
+  default:
+    return internal::withLatentKernel<float, float>(blocks, fn);
   }
-  return init;
 }
 
-template <typename T>
-T predictionError(T* __restrict__ itemLatent, T* __restrict__ userLatent,
-                  double actual) {
-  T v = actual;
-  return innerProduct(itemLatent, itemLatent + LATENT_VECTOR_SIZE, userLatent,
-                      -v);
+/**
+ * Error of the prediction of a rating by the inner product of 2 latent
+ * vectors.
+ *
+ * @param storage storage types of the latent vectors
+ * @param itemLatent latent vector of the item
+ * @param userLatent latent vector of the user
+ * @param actual the rating
+ *
+ * @returns inner product - actual
+ */
+inline LatentValue predictionError(const LatentStorage& storage,
+                                   const void* itemLatent,
+                                   const void* userLatent, double actual) {
+  const unsigned blocks = latentBlocks(latentVectorSize);
+  LatentValue v         = actual;
+  return withLatentKernel(storage, [&](auto kernel) {
+    return kernel.dot(itemLatent, userLatent, blocks) - v;
+  });
 }
 
 /**
@@ -155,6 +298,7 @@ T predictionError(T* __restrict__ itemLatent, T* __restrict__ userLatent,
  *
  * Updates latent vectors to reduce the error from the edge value.
  *
+ * @param storage storage types of the latent vectors
  * @param itemLatent latent vector of the item
  * @param userLatent latent vector of the user
  * @param lambda learning parameter
@@ -165,25 +309,23 @@ T predictionError(T* __restrict__ itemLatent, T* __restrict__ userLatent,
  *
  * @return Error before gradient update
  */
-template <typename T>
-T doGradientUpdate(T* __restrict__ itemLatent, T* __restrict__ userLatent,
-                   double lambda, double edgeRating, double stepSize) {
-  // Implicit cast to type T
-  T l      = lambda;
-  T step   = stepSize;
-  T rating = edgeRating;
-  T error  = innerProduct(itemLatent, itemLatent + LATENT_VECTOR_SIZE,
-                         userLatent, -rating);
-
-  // Take gradient step to reduce error
-  for (int i = 0; i < LATENT_VECTOR_SIZE; i++) {
-    T prevItem = itemLatent[i];
-    T prevUser = userLatent[i];
-    itemLatent[i] -= step * (error * prevUser + l * prevItem);
-    userLatent[i] -= step * (error * prevItem + l * prevUser);
-  }
+inline LatentValue doGradientUpdate(const LatentStorage& storage,
+                                    void* itemLatent, void* userLatent,
+                                    double lambda, double edgeRating,
+                                    double stepSize) {
+  const unsigned blocks = latentBlocks(latentVectorSize);
+  // Implicit cast to LatentValue
+  LatentValue l      = lambda;
+  LatentValue step   = stepSize;
+  LatentValue rating = edgeRating;
 
-  return error;
+  return withLatentKernel(storage, [&](auto kernel) {
+    LatentValue error = kernel.dot(itemLatent, userLatent, blocks) - rating;
+    // Take gradient step to reduce error:
+    //   item -= step * (error * user + l * item), and the same for user
+    kernel.update(itemLatent, userLatent, step * error, 1 - step * l, blocks);
+    return error;
+  });
 }
 
 struct StepFunction {
@@ -204,6 +346,7 @@ static double genVal(uint32_t n) {
 StepFunction* newStepFunction();
 
 template <typename Graph>
-size_t initializeGraphData(Graph& g);
+size_t initializeGraphData(Graph& g, LatentVectors& latents,
+                           const LatentStorage& storage);
 
 #endif
@@ -0,0 +1,564 @@
+/*
+ * This file belongs to the Galois project, a C++ library for exploiting parallelism.
+ * The code is being released under the terms of the 3-Clause BSD License (a
+ * copy is located in LICENSE.txt at the top-level directory).
+ *
+ * Copyright (C) 2019, The University of Texas at Austin. All rights reserved.
+ * UNIVERSITY EXPRESSLY DISCLAIMS ANY AND ALL WARRANTIES CONCERNING THIS
+ * SOFTWARE AND DOCUMENTATION, INCLUDING ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR ANY PARTICULAR PURPOSE, NON-INFRINGEMENT AND WARRANTIES OF
+ * PERFORMANCE, AND ANY WARRANTY THAT MIGHT OTHERWISE ARISE FROM COURSE OF
+ * DEALING OR USAGE OF TRADE.  NO WARRANTY IS EITHER EXPRESS OR IMPLIED WITH
+ * RESPECT TO THE USE OF THE SOFTWARE OR DOCUMENTATION. Under no circumstances
+ * shall University be liable for incidental, special, indirect, direct or
+ * consequential damages or loss of profits, interruption of business, or
+ * related expenses which may arise from use of Software or Documentation,
+ * including but not limited to those resulting from defects in Software and/or
+ * Documentation, or loss or inaccuracy of data of any kind.
+ */
+
+#ifndef _GALOIS_INTERNEDPOINTSTOSET_
+#define _GALOIS_INTERNEDPOINTSTOSET_
+
+#include <galois/AtomicWrapper.h>
+#include <galois/Reduction.h>
+#include <galois/runtime/Statistics.h>
+#include <galois/substrate/PaddedLock.h>
+#include <galois/substrate/PerThreadStorage.h>
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <boost/iterator/iterator_facade.hpp>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace galois {
+
+/**
+ * Points-to sets of a set of variables, hash-consed: every distinct set is
+ * stored once, immutable and reference counted, and a variable only holds a
+ * pointer to its current set. Variables that end up with the same points-to
+ * set (common after copy chains and collapsed cycles) share the storage, and
+ * two variables can be compared for equality by pointer.
+ *
+ * A set is a sorted array of 128-bit bitmap blocks, each tagged with its base
+ * (element / 128); only non-empty blocks are stored. Union and subset tests
+ * merge the two block arrays and combine matching blocks with one SSE2
+ * or/and-not each. Unions are memoized on the pair of input sets, so
+ * propagating the same set along many edges is a table lookup.
+ *
+ * Updating a variable builds the union in a per-thread buffer, interns it,
+ * and swaps the variable's pointer (with a CAS in the concurrent version).
+ * Sets whose count drops to zero are not freed right away since other
+ * threads may still be reading them; reclaim() frees them and must be called
+ * when no set operation is in flight.
+ */
+template <bool IsConcurrent>
+class InternedPointsToSets {
+public:
+  static const unsigned blockSize = 128;
+
+  //! 128 elements of a set, starting at base * blockSize
+  struct alignas(16) Block {
+    uint64_t bits[2];
+  };
+
+  /**
+   * An interned set: the header is followed by the blocks and then their
+   * bases in one allocation.
+   */
+  struct alignas(16) Set {
+    size_t hash;
+    std::atomic<unsigned> refs;
+    unsigned numBlocks;
+    unsigned numElements;
+
+    Block* blocks() { return reinterpret_cast<Block*>(this + 1); }
+    const Block* blocks() const {
+      return reinterpret_cast<const Block*>(this + 1);
+    }
+    uint32_t* bases() {
+      return reinterpret_cast<uint32_t*>(blocks() + numBlocks);
+    }
+    const uint32_t* bases() const {
+      return reinterpret_cast<const uint32_t*>(blocks() + numBlocks);
+    }
+
+    //! @returns bytes used by a set with n blocks
+    static size_t bytes(unsigned n) {
+      return sizeof(Set) + n * (sizeof(Block) + sizeof(uint32_t));
+    }
+  };
+  static_assert(sizeof(Set) % alignof(Block) == 0,
+                "blocks must be aligned after the set header");
+
+  /**
+   * Iterator over the elements of a set, in increasing order. The set it
+   * walks is a snapshot; concurrent updates of the variable are not seen.
+   */
+  class SetIterator
+      : public boost::iterator_facade<SetIterator, const unsigned,
+                                      boost::forward_traversal_tag> {
+    const Set* set;
+    unsigned block;
+    unsigned word;
+    uint64_t remaining; // bits of the current word not visited yet
+    unsigned currentValue;
+
+    void advance() {
+      while (remaining == 0) {
+        if (++word == 2) {
+          word = 0;
+          if (++block == set->numBlocks) {
+            set = nullptr;
+            return;
+          }
+        }
+        remaining = set->blocks()[block].bits[word];
+      }
+      currentValue = set->bases()[block] * blockSize + word * 64 +
+                     __builtin_ctzll(remaining);
+    }
+
+  public:
+    //! end iterator
+    SetIterator()
+        : set(nullptr), block(0), word(0), remaining(0), currentValue(-1) {}
+
+    SetIterator(const Set* s)
+        : set(s), block(0), word(0), remaining(0), currentValue(-1) {
+      if (set) {
+        remaining = set->blocks()[0].bits[0];
+        advance();
+      }
+    }
+
+  private:
+    friend class boost::iterator_core_access;
+
+    void increment() {
+      remaining &= remaining - 1;
+      advance();
+    }
+
+    bool equal(const SetIterator& other) const {
+      if (set == nullptr || other.set == nullptr) {
+        return set == other.set;
+      }
+      return set == other.set && block == other.block && word == other.word &&
+             remaining == other.remaining;
+    }
+
+    const unsigned& dereference() const { return currentValue; }
+  };
+
+  /**
+   * Handle to the points-to set of one variable, with the same interface as
+   * the SparseBitVector it replaces.
+   */
+  class Ref {
+    InternedPointsToSets* sets;
+    size_t var;
+
+  public:
+    Ref(InternedPointsToSets* s, size_t v) : sets(s), var(v) {}
+
+    //! Adds num to the set; @returns true if it was not there already
+    bool set(unsigned num) { return sets->insert(var, num); }
+
+    //! @returns true if every element of this set is in second's set
+    bool isSubsetEq(const Ref& second) const {
+      return InternedPointsToSets::isSubsetEq(sets->get(var),
+                                              sets->get(second.var));
+    }
+
+    //! Adds second's elements to this set; @returns 1 if it changed
+    unsigned unify(const Ref& second) {
+      return sets->update(var, sets->get(second.var));
+    }
+
+    unsigned count() const {
+      const Set* s = sets->get(var);
+      return s ? s->numElements : 0;
+    }
+
+    SetIterator begin() const { return SetIterator(sets->get(var)); }
+    SetIterator end() const { return SetIterator(); }
+
+    void print(std::ostream& out, std::string prefix = std::string("")) const {
+      out << "Elements(" << count() << "): ";
+      for (auto ii = begin(); ii != end(); ++ii) {
+        out << prefix << *ii << ", ";
+      }
+      out << "\n";
+    }
+  };
+
+private:
+  using SetPointer =
+      typename std::conditional<IsConcurrent, galois::CopyableAtomic<Set*>,
+                                Set*>::type;
+  using Lock = galois::substrate::PaddedLock<IsConcurrent>;
+
+  static const unsigned NUM_SHARDS = 64;
+  //! a union cache shard is dropped when it grows past this many entries
+  static const size_t MAX_CACHED_UNIONS = 1 << 14;
+
+  //! interned sets by hash
+  struct TableShard {
+    Lock lock;
+    std::unordered_multimap<size_t, Set*> sets;
+  };
+
+  struct PairHash {
+    size_t operator()(const std::pair<const Set*, const Set*>& p) const {
+      return std::hash<const Set*>()(p.first) * 31 +
+             std::hash<const Set*>()(p.second);
+    }
+  };
+
+  //! memoized unions; entries hold no references, so they are only valid
+  //! until the next reclaim()
+  struct CacheShard {
+    Lock lock;
+    std::unordered_map<std::pair<const Set*, const Set*>, Set*, PairHash>
+        unions;
+  };
+
+  //! where a union is built before it is interned
+  struct Buffer {
+    std::vector<uint32_t> bases;
+    std::vector<Block> blocks;
+  };
+
+  std::vector<SetPointer> pointsTo;
+  TableShard table[NUM_SHARDS];
+  CacheShard cache[NUM_SHARDS];
+  galois::substrate::PerThreadStorage<Buffer> buffers;
+
+  std::atomic<size_t> liveBytes{0};
+  std::atomic<size_t> liveSets{0};
+  size_t peakBytes = 0;
+  galois::GAccumulator<size_t> unionLookups;
+  galois::GAccumulator<size_t> unionHits;
+
+  static Block orBlocks(const Block& a, const Block& b) {
+    Block r;
+#ifdef __SSE2__
+    __m128i x = _mm_load_si128(reinterpret_cast<const __m128i*>(&a));
+    __m128i y = _mm_load_si128(reinterpret_cast<const __m128i*>(&b));
+    _mm_store_si128(reinterpret_cast<__m128i*>(&r), _mm_or_si128(x, y));
+#else
+    r.bits[0] = a.bits[0] | b.bits[0];
+    r.bits[1] = a.bits[1] | b.bits[1];
+#endif
+    return r;
+  }
+
+  //! @returns true if a has no element that b does not have
+  static bool blockSubsetEq(const Block& a, const Block& b) {
+#ifdef __SSE2__
+    __m128i diff =
+        _mm_andnot_si128(_mm_load_si128(reinterpret_cast<const __m128i*>(&b)),
+                         _mm_load_si128(reinterpret_cast<const __m128i*>(&a)));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) ==
+           0xFFFF;
+#else
+    return (a.bits[0] & ~b.bits[0]) == 0 && (a.bits[1] & ~b.bits[1]) == 0;
+#endif
+  }
+
+  static size_t hashBlocks(const uint32_t* bases, const Block* blocks,
+                           unsigned n) {
+    size_t h = n;
+    auto mix = [&h](uint64_t v) {
+      h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    };
+    for (unsigned i = 0; i < n; ++i) {
+      mix(bases[i]);
+      mix(blocks[i].bits[0]);
+      mix(blocks[i].bits[1]);
+    }
+    return h;
+  }
+
+  static bool sameBlocks(const Set* s, const uint32_t* bases,
+                         const Block* blocks, unsigned n) {
+    if (s->numBlocks != n) {
+      return false;
+    }
+    for (unsigned i = 0; i < n; ++i) {
+      if (s->bases()[i] != bases[i] ||
+          s->blocks()[i].bits[0] != blocks[i].bits[0] ||
+          s->blocks()[i].bits[1] != blocks[i].bits[1]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  Set* get(size_t var) const { return pointsTo[var]; }
+
+  //! swaps var's set from expected to desired; fails if var changed since
+  //! expected was read
+  bool replace(size_t var, Set* expected, Set* desired) {
+    return replaceImpl(pointsTo[var], expected, desired);
+  }
+  static bool replaceImpl(galois::CopyableAtomic<Set*>& p, Set* expected,
+                          Set* desired) {
+    return p.compare_exchange_strong(expected, desired);
+  }
+  static bool replaceImpl(Set*& p, Set*, Set* desired) {
+    p = desired;
+    return true;
+  }
+
+  static Set* acquire(Set* s) {
+    if (s) {
+      s->refs++;
+    }
+    return s;
+  }
+
+  //! drops a reference; the set stays in the table until reclaim()
+  static void release(Set* s) {
+    if (s) {
+      s->refs--;
+    }
+  }
+
+  /**
+   * @returns the interned set with the given blocks, with a reference taken
+   * for the caller; creates it if it does not exist yet
+   */
+  Set* intern(const uint32_t* bases, const Block* blocks, unsigned n) {
+    size_t hash       = hashBlocks(bases, blocks, n);
+    TableShard& shard = table[hash % NUM_SHARDS];
+
+    shard.lock.lock();
+    auto range = shard.sets.equal_range(hash);
+    for (auto ii = range.first; ii != range.second; ++ii) {
+      if (sameBlocks(ii->second, bases, blocks, n)) {
+        Set* found = acquire(ii->second);
+        shard.lock.unlock();
+        return found;
+      }
+    }
+
+    Set* s         = static_cast<Set*>(::operator new(Set::bytes(n)));
+    s->hash        = hash;
+    s->refs        = 1;
+    s->numBlocks   = n;
+    s->numElements = 0;
+    for (unsigned i = 0; i < n; ++i) {
+      s->blocks()[i] = blocks[i];
+      s->bases()[i]  = bases[i];
+      s->numElements += __builtin_popcountll(blocks[i].bits[0]) +
+                        __builtin_popcountll(blocks[i].bits[1]);
+    }
+    shard.sets.emplace(hash, s);
+    shard.lock.unlock();
+
+    liveBytes += Set::bytes(n);
+    liveSets++;
+    return s;
+  }
+
+  /**
+   * @returns the union of a and b (b must not be null), with a reference
+   * taken for the caller
+   */
+  Set* unionOf(Set* a, Set* b) {
+    if (a == nullptr || a == b) {
+      return acquire(b);
+    }
+
+    std::pair<const Set*, const Set*> key(std::min(a, b), std::max(a, b));
+    CacheShard& shard = cache[PairHash()(key) % NUM_SHARDS];
+    unionLookups += 1;
+
+    shard.lock.lock();
+    auto cached = shard.unions.find(key);
+    if (cached != shard.unions.end()) {
+      Set* found = acquire(cached->second);
+      shard.lock.unlock();
+      unionHits += 1;
+      return found;
+    }
+    shard.lock.unlock();
+
+    // merge the two sorted block arrays
+    Buffer& buf = *buffers.getLocal();
+    buf.bases.clear();
+    buf.blocks.clear();
+    const uint32_t* aBases = a->bases();
+    const uint32_t* bBases = b->bases();
+    unsigned i = 0, j = 0;
+    while (i < a->numBlocks && j < b->numBlocks) {
+      if (aBases[i] == bBases[j]) {
+        buf.bases.push_back(aBases[i]);
+        buf.blocks.push_back(orBlocks(a->blocks()[i++], b->blocks()[j++]));
+      } else if (aBases[i] < bBases[j]) {
+        buf.bases.push_back(aBases[i]);
+        buf.blocks.push_back(a->blocks()[i++]);
+      } else {
+        buf.bases.push_back(bBases[j]);
+        buf.blocks.push_back(b->blocks()[j++]);
+      }
+    }
+    for (; i < a->numBlocks; ++i) {
+      buf.bases.push_back(aBases[i]);
+      buf.blocks.push_back(a->blocks()[i]);
+    }
+    for (; j < b->numBlocks; ++j) {
+      buf.bases.push_back(bBases[j]);
+      buf.blocks.push_back(b->blocks()[j]);
+    }
+
+    Set* result = intern(buf.bases.data(), buf.blocks.data(), buf.bases.size());
+
+    shard.lock.lock();
+    if (shard.unions.size() >= MAX_CACHED_UNIONS) {
+      shard.unions.clear();
+    }
+    shard.unions.emplace(key, result);
+    shard.lock.unlock();
+
+    return result;
+  }
+
+  static bool isSubsetEq(const Set* a, const Set* b) {
+    if (a == nullptr || a == b) {
+      return true;
+    }
+    if (b == nullptr || a->numElements > b->numElements) {
+      return false;
+    }
+
+    const uint32_t* aBases = a->bases();
+    const uint32_t* bBases = b->bases();
+    unsigned j             = 0;
+    for (unsigned i = 0; i < a->numBlocks; ++i) {
+      while (j < b->numBlocks && bBases[j] < aBases[i]) {
+        ++j;
+      }
+      if (j == b->numBlocks || bBases[j] != aBases[i] ||
+          !blockSubsetEq(a->blocks()[i], b->blocks()[j])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Makes var's set the union of itself and src.
+   *
+   * @returns 1 if var's set changed, 0 otherwise
+   */
+  unsigned update(size_t var, Set* src) {
+    while (true) {
+      Set* old = get(var);
+      if (src == nullptr || src == old) {
+        return 0;
+      }
+
+      Set* merged = unionOf(old, src);
+      if (merged == old) {
+        release(merged);
+        return 0;
+      }
+      if (replace(var, old, merged)) {
+        release(old);
+        return 1;
+      }
+      // lost a race with another update of var; retry on its result
+      release(merged);
+    }
+  }
+
+  //! adds num to var's set; @returns true if it was not there already
+  bool insert(size_t var, unsigned num) {
+    uint32_t base = num / blockSize;
+    Block single  = {{0, 0}};
+    single.bits[(num % blockSize) / 64] = (uint64_t)1 << (num % 64);
+
+    Set* s          = intern(&base, &single, 1);
+    unsigned change = update(var, s);
+    release(s);
+    return change;
+  }
+
+public:
+  InternedPointsToSets() = default;
+
+  ~InternedPointsToSets() {
+    for (unsigned i = 0; i < NUM_SHARDS; ++i) {
+      for (auto& entry : table[i].sets) {
+        ::operator delete(entry.second);
+      }
+    }
+  }
+
+  /**
+   * @param n Number of variables; all start with the empty set
+   */
+  void initialize(size_t n) { pointsTo.resize(n); }
+
+  size_t size() const { return pointsTo.size(); }
+
+  Ref operator[](size_t var) { return Ref(this, var); }
+
+  /**
+   * Frees the sets no variable refers to anymore and drops the union cache.
+   * Not thread safe: no other operation may run concurrently.
+   */
+  void reclaim() {
+    peakBytes = std::max(peakBytes, liveBytes.load());
+
+    for (unsigned i = 0; i < NUM_SHARDS; ++i) {
+      cache[i].unions.clear();
+
+      auto& sets = table[i].sets;
+      for (auto ii = sets.begin(); ii != sets.end();) {
+        if (ii->second->refs == 0) {
+          liveBytes -= Set::bytes(ii->second->numBlocks);
+          liveSets--;
+          ::operator delete(ii->second);
+          ii = sets.erase(ii);
+        } else {
+          ++ii;
+        }
+      }
+    }
+  }
+
+  /**
+   * Reports the memory used by the sets (including the per-variable
+   * pointers), the number of distinct sets, and the union cache hit rate.
+   */
+  void reportStats(const char* region) {
+    size_t perVariable = pointsTo.size() * sizeof(SetPointer);
+    peakBytes          = std::max(peakBytes, liveBytes.load());
+
+    galois::runtime::reportStat_Single(region, "PointsToSetBytes",
+                                       liveBytes + perVariable);
+    galois::runtime::reportStat_Single(region, "PointsToSetPeakBytes",
+                                       peakBytes + perVariable);
+    galois::runtime::reportStat_Single(region, "DistinctPointsToSets",
+                                       liveSets.load());
+    galois::runtime::reportStat_Single(region, "UnionCacheLookups",
+                                       unionLookups.reduce());
+    galois::runtime::reportStat_Single(region, "UnionCacheHits",
+                                       unionHits.reduce());
+  }
+};
+
+} // namespace galois
+
+#endif
@@ -24,6 +24,7 @@
 #include <fstream>
 #include <deque>
 #include "SparseBitVector.h"
+#include "InternedPointsToSet.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 // Command line parameters
@@ -67,6 +68,16 @@ static cll::opt<unsigned>
                            "(default 500000)"),
                  cll::init(500000));
 
+enum PointsToSetKind { sbv, interned };
+
+static cll::opt<PointsToSetKind> pointsToSet(
+    "pointsToSet", cll::desc("Representation of the points-to sets:"),
+    cll::values(clEnumVal(sbv, "Sparse bit vector per variable (default)"),
+                clEnumVal(interned, "Hash-consed sets of bitmap blocks, "
+                                    "shared by variables with equal sets"),
+                clEnumValEnd),
+    cll::init(sbv));
+
 ////////////////////////////////////////////////////////////////////////////////
 // Declaration of strutures, types, and variables
 ////////////////////////////////////////////////////////////////////////////////
@@ -125,19 +136,64 @@ public:
   }
 };
 
+/**
+ * Points-to sets stored as one sparse bit vector per node.
+ */
+template <bool IsConcurrent>
+class SparseBitVectorSets {
+  using SparseBitVector = galois::SparseBitVector<IsConcurrent>;
+  using Node            = typename SparseBitVector::Node;
+
+  std::vector<SparseBitVector> sets;
+
+public:
+  void initialize(size_t n, galois::FixedSizeAllocator<Node>& nodeAllocator) {
+    sets.resize(n);
+    for (auto& set : sets) {
+      set.init(&nodeAllocator);
+    }
+  }
+
+  size_t size() const { return sets.size(); }
+
+  SparseBitVector& operator[](size_t i) { return sets[i]; }
+
+  //! words of a sparse bit vector are never freed
+  void reclaim() {}
+
+  /**
+   * Reports the memory used by the bit vector words (plus the list heads).
+   */
+  void reportStats(const char* region) const {
+    size_t words = 0;
+    for (auto& set : sets) {
+      for (Node* ptr = set.head; ptr; ptr = ptr->_next) {
+        ++words;
+      }
+    }
+
+    galois::runtime::reportStat_Single(region, "PointsToSetBytes",
+                                       words * sizeof(Node) +
+                                           sets.size() *
+                                               sizeof(SparseBitVector));
+    galois::runtime::reportStat_Single(region, "PointsToSetWords", words);
+  }
+};
+
 /**
  * Points to analysis runner base class. Does not have a run method itself.
  *
  * @tparam IsConcurrent if set to true, the data structures used for points
  * to results and outgoing edges will be thread safe
+ * @tparam PointsToInfo representation of the points-to sets of all nodes
+ * (SparseBitVectorSets or galois::InternedPointsToSets)
  */
-template <bool IsConcurrent>
+template <bool IsConcurrent, typename PointsToInfo>
 class PTABase {
   // sparse bit vector is concurrent or serial based on template parameter
   using SparseBitVector = galois::SparseBitVector<IsConcurrent>;
 
   using PointsToConstraints = std::vector<PtsToCons>;
-  using PointsToInfo        = std::vector<SparseBitVector>;
   using EdgeVector          = std::vector<SparseBitVector>;
 
   using NodeAllocator =
@@ -158,8 +214,7 @@ protected:
    */
   struct OnlineCycleDetection {
   private:
-    PTABase<IsConcurrent>&
-        outerPTA; // reference to outer PTA instance to get runtime info
+    PTABase& outerPTA; // reference to outer PTA instance to get runtime info
 
     galois::gstl::Vector<unsigned> ancestors; // TODO find better representation
     galois::gstl::Vector<bool> visited;       // TODO use better representation
@@ -286,7 +341,7 @@ protected:
     }
 
   public:
-    OnlineCycleDetection(PTABase<IsConcurrent>& o) : outerPTA(o) {}
+    OnlineCycleDetection(PTABase& o) : outerPTA(o) {}
 
     /**
      * Init fields (outerPTA needs to have numNodes set).
@@ -493,6 +548,17 @@ protected:
     return newPtsTo;
   }
 
+  static void initPointsTo(SparseBitVectorSets<IsConcurrent>& sets, size_t n,
+                           NodeAllocator& nodeAllocator) {
+    sets.initialize(n, nodeAllocator);
+  }
+
+  // interned sets manage their own memory
+  template <typename Sets>
+  static void initPointsTo(Sets& sets, size_t n, NodeAllocator&) {
+    sets.initialize(n);
+  }
+
 public:
   PTABase() : ocd(*this) {}
 
@@ -508,12 +574,11 @@ public:
     numNodes = n;
 
     // initialize different constructs based on which version is being run
-    pointsToResult.resize(numNodes);
+    initPointsTo(pointsToResult, numNodes, nodeAllocator);
     outgoingEdges.resize(numNodes);
 
     // initialize vectors
     for (unsigned i = 0; i < numNodes; i++) {
-      pointsToResult[i].init(&nodeAllocator);
       outgoingEdges[i].init(&nodeAllocator);
     }
 
@@ -635,8 +700,8 @@ public:
   unsigned countPointsToFacts() {
     unsigned count = 0;
 
-    for (auto ii = pointsToResult.begin(); ii != pointsToResult.end(); ++ii) {
-      unsigned repr = ocd.getFinalRepresentative(ii - pointsToResult.begin());
+    for (unsigned ii = 0; ii < pointsToResult.size(); ++ii) {
+      unsigned repr = ocd.getFinalRepresentative(ii);
       count += pointsToResult[repr].count();
     }
 
@@ -649,18 +714,34 @@ public:
   void printPointsToInfo() {
     std::string prefix = "v";
 
-    for (auto ii = pointsToResult.begin(); ii != pointsToResult.end(); ++ii) {
-      std::cerr << prefix << ii - pointsToResult.begin() << ": ";
-      unsigned repr = ocd.getFinalRepresentative(ii - pointsToResult.begin());
+    for (unsigned ii = 0; ii < pointsToResult.size(); ++ii) {
+      std::cerr << prefix << ii << ": ";
+      unsigned repr = ocd.getFinalRepresentative(ii);
       pointsToResult[repr].print(std::cerr, prefix);
     }
   }
+
+  /**
+   * Reports memory statistics of the points-to sets.
+   */
+  void reportPointsToStats() { pointsToResult.reportStats("PointsTo"); }
 }; // end class PTA
 
 /**
  * Serial points to executor.
  */
-class PTASerial : public PTABase<false> {
+template <typename PointsToInfo>
+class PTASerial : public PTABase<false, PointsToInfo> {
+  using Base = PTABase<false, PointsToInfo>;
+  using Base::addressCopyConstraints;
+  using Base::loadStoreConstraints;
+  using Base::numNodes;
+  using Base::ocd;
+  using Base::outgoingEdges;
+  using Base::pointsToResult;
+  using Base::processLoadStore;
+  using Base::propagate;
+
 public:
   /**
    * Run points-to-analysis on a single thread.
@@ -672,9 +753,11 @@ public:
     galois::gDebug("no of nodes = ", numNodes);
 
     std::deque<unsigned> updates;
-    updates = processAddressOfCopy<galois::StdForEach, std::deque<unsigned>>(
+    updates = this->template processAddressOfCopy<galois::StdForEach,
+                                                  std::deque<unsigned>>(
         addressCopyConstraints);
-    processLoadStore<galois::StdForEach>(loadStoreConstraints, updates);
+    this->template processLoadStore<galois::StdForEach>(loadStoreConstraints,
+                                                        updates);
 
     unsigned numUps = 0;
 
@@ -696,24 +779,37 @@ public:
 
       if (updates.empty() || numUps >= THRESHOLD_LS) {
         galois::gDebug("No of points-to facts computed = ",
-                       countPointsToFacts());
+                       this->countPointsToFacts());
         numUps = 0;
 
+        // no set is being read here; free the ones that were replaced
+        pointsToResult.reclaim();
+
         // After propagating all constraints, see if load/store
         // constraints need to be added in since graph was potentially updated
-        processLoadStore<galois::StdForEach>(loadStoreConstraints, updates);
+        this->template processLoadStore<galois::StdForEach>(
+            loadStoreConstraints, updates);
 
         // do cycle squashing
         ocd.process(updates);
       }
     }
+
+    pointsToResult.reclaim();
   }
 };
 
 /**
  * Concurrent points to executor.
  */
-class PTAConcurrent : public PTABase<true> {
+template <typename PointsToInfo>
+class PTAConcurrent : public PTABase<true, PointsToInfo> {
+  using Base = PTABase<true, PointsToInfo>;
+  using Base::addressCopyConstraints;
+  using Base::loadStoreConstraints;
+  using Base::numNodes;
+  using Base::pointsToResult;
+
 public:
   /**
    * Run points-to-analysis using galois::for_each as the main loop.
@@ -725,9 +821,11 @@ public:
     galois::gDebug("no of nodes = ", numNodes);
 
     galois::InsertBag<unsigned> updates;
-    updates = processAddressOfCopy<galois::DoAll, galois::InsertBag<unsigned>>(
+    updates = this->template processAddressOfCopy<galois::DoAll,
+                                                  galois::InsertBag<unsigned>>(
         addressCopyConstraints);
-    processLoadStore<galois::DoAll>(loadStoreConstraints, updates);
+    this->template processLoadStore<galois::DoAll>(loadStoreConstraints,
+                                                   updates);
 
     while (!updates.empty()) {
       galois::for_each(
@@ -746,13 +844,18 @@ public:
                                                                  // with this
       );
 
-      galois::gDebug("No of points-to facts computed = ", countPointsToFacts());
+      galois::gDebug("No of points-to facts computed = ",
+                     this->countPointsToFacts());
 
       updates.clear();
 
+      // the loop is done, so no set is being read; free the replaced ones
+      pointsToResult.reclaim();
+
       // After propagating all constraints, see if load/store constraints need
       // to be added in since graph was potentially updated
-      processLoadStore<galois::DoAll>(loadStoreConstraints, updates);
+      this->template processLoadStore<galois::DoAll>(loadStoreConstraints,
+                                                     updates);
 
       // do cycle squashing
       // ocd.process(updates); // TODO have parallel OCD, if possible
@@ -764,7 +867,7 @@ public:
  * Method from running PTA.
  */
 template <typename PTAClass, typename Alloc>
-void runPTA(PTAClass& pta, Alloc nodeAllocator) {
+void runPTA(PTAClass& pta, Alloc& nodeAllocator) {
   size_t numNodes = pta.readConstraints(input.c_str());
   pta.initialize(numNodes, nodeAllocator);
 
@@ -774,6 +877,7 @@ void runPTA(PTAClass& pta, Alloc nodeAllocator) {
   pta.run();
   T.stop();
 
+  pta.reportPointsToStats();
   galois::gInfo("No of points-to facts computed = ", pta.countPointsToFacts());
 
   if (!skipVerify) {
@@ -799,20 +903,31 @@ int main(int argc, char** argv) {
     galois::gInfo("Note correctness of this version is relative to the serial "
                   "version.");
 
-    PTAConcurrent p;
+    // the allocator must outlive the vectors using it
     galois::FixedSizeAllocator<typename galois::SparseBitVector<true>::Node>
         nodeAllocator;
-    runPTA(p, nodeAllocator);
+    if (pointsToSet == interned) {
+      PTAConcurrent<galois::InternedPointsToSets<true>> p;
+      runPTA(p, nodeAllocator);
+    } else {
+      PTAConcurrent<SparseBitVectorSets<true>> p;
+      runPTA(p, nodeAllocator);
+    }
   } else {
     galois::gInfo("-------- Sequential version.");
     galois::gInfo(
         "The load store threshold (-lsThreshold) may need tweaking for "
         "best performance; its current setting may not be the best for "
         "your input and may actually degrade performance.");
-    PTASerial p;
     galois::FixedSizeAllocator<typename galois::SparseBitVector<false>::Node>
         nodeAllocator;
-    runPTA(p, nodeAllocator);
+    if (pointsToSet == interned) {
+      PTASerial<galois::InternedPointsToSets<false>> p;
+      runPTA(p, nodeAllocator);
+    } else {
+      PTASerial<SparseBitVectorSets<false>> p;
+      runPTA(p, nodeAllocator);
+    }
   }
 
   return 0;
@@ -18,7 +18,9 @@
  */
 
 #include "galois/Reduction.h"
+#include "galois/AtomicHelpers.h"
 #include "galois/Bag.h"
+#include "galois/Frontier.h"
 #include "galois/Galois.h"
 #include "galois/Timer.h"
 #include "galois/graphs/LCGraph.h"
@@ -49,6 +51,12 @@ static cll::opt<uint32_t> sinkId(cll::Positional, cll::desc("sinkID"),
 static cll::opt<bool> useHLOrder("useHLOrder",
                                  cll::desc("Use HL ordering heuristic"),
                                  cll::init(false));
+static cll::opt<bool>
+    useGapHeuristic("useGapHeuristic",
+                    cll::desc("Lift nodes above an empty height to the "
+                              "number of nodes (default true with "
+                              "-useHLOrder, false otherwise)"),
+                    cll::init(false));
 static cll::opt<bool>
     useUnitCapacity("useUnitCapacity",
                     cll::desc("Assume all capacities are unit"),
@@ -113,6 +121,27 @@ struct PreflowPush {
   GNode source;
   int global_relabel_interval;
   bool should_global_relabel = false;
+  bool should_gap_relabel    = false;
+  bool gapHeuristic          = false;
+
+  //! node of a height bucket; entries of nodes that have since been
+  //! relabeled are stale and skipped
+  struct BucketEntry {
+    GNode node;
+    BucketEntry* next;
+  };
+
+  //! number of nodes at each height below graph.size(); only maintained with
+  //! the gap heuristic, as are the fields below
+  galois::LargeArray<int> heightCount;
+  //! lock-free list of the nodes relabeled to each height since the last
+  //! global relabel, so that a gap visits only the heights it empties
+  galois::LargeArray<BucketEntry*> bucketHeads;
+  galois::InsertBag<BucketEntry> bucketEntries;
+  std::atomic<int> maxHeight;    //!< bound of the heights below graph.size()
+  std::atomic<int> gapCandidate; //!< lowest height emptied since the last gap
+  size_t gapRelabels    = 0;
+  size_t gapLiftedNodes = 0;
   galois::LargeArray<Graph::edge_iterator>
       reverseDirectionEdgeIterator; // ideally should be on the graph as
                                     // graph.getReverseEdgeIterator()
@@ -227,13 +256,37 @@ struct PreflowPush {
     assert(minHeight != std::numeric_limits<int>::max());
     ++minHeight;
 
-    Node& node = graph.getData(src, galois::MethodFlag::UNPROTECTED);
+    Node& node    = graph.getData(src, galois::MethodFlag::UNPROTECTED);
+    int oldHeight = node.height;
     if (minHeight < (int)graph.size()) {
+      // count the new height before the node leaves the old one, so a count
+      // of zero means no node is at that height
+      if (gapHeuristic) {
+        __sync_fetch_and_add(&heightCount[minHeight], 1);
+        addToBucket(minHeight, src);
+        galois::atomicMax(maxHeight, minHeight);
+      }
       node.height  = minHeight;
       node.current = minEdge;
     } else {
       node.height = graph.size();
     }
+
+    // nodes above an empty height cannot reach the sink; they are lifted
+    // once the discharge loop stops (see gapRelabel)
+    if (gapHeuristic &&
+        __sync_sub_and_fetch(&heightCount[oldHeight], 1) == 0) {
+      galois::atomicMin(gapCandidate, oldHeight);
+      should_gap_relabel = true;
+    }
+  }
+
+  void addToBucket(int h, const GNode& src) {
+    BucketEntry* e = &bucketEntries.emplace(BucketEntry{src, nullptr});
+    e->next        = __atomic_load_n(&bucketHeads[h], __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&bucketHeads[h], &e->next, e, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+      ;
   }
 
   template <typename C>
@@ -319,9 +372,8 @@ struct PreflowPush {
           counter.peekLocal() >= relabel_interval) {
         this->should_global_relabel = true;
         return true;
-      } else {
-        return false;
       }
+      return false;
     };
 
     galois::for_each(
@@ -351,8 +403,12 @@ struct PreflowPush {
         galois::det_parallel_break<decltype(detBreakFn)>(detBreakFn));
   }
 
+  //! Discharges the nodes of initial. Once a relabel empties a height, the
+  //! remaining nodes are moved to pending without being discharged, so that
+  //! the gap can be handled and the loop resumed with them.
   template <typename W>
-  void nonDetDischarge(galois::InsertBag<GNode>& initial, Counter& counter,
+  void nonDetDischarge(galois::InsertBag<GNode>& initial,
+                       galois::InsertBag<GNode>& pending, Counter& counter,
                        const W& wl_opt) {
 
     // per thread
@@ -361,7 +417,11 @@ struct PreflowPush {
 
     galois::for_each(
         galois::iterate(initial),
-        [&counter, relabel_interval, this](GNode& src, auto& ctx) {
+        [&pending, &counter, relabel_interval, this](GNode& src, auto& ctx) {
+          if (this->should_gap_relabel) {
+            pending.push(src);
+            return;
+          }
           int increment = 1;
           this->acquire(src);
           if (this->discharge(src, ctx)) {
@@ -446,6 +506,137 @@ struct PreflowPush {
         galois::loopname("updateHeights"));
   }
 
+  /**
+   * Reverse BFS on the residual graph, one level per round of a
+   * galois::for_each_frontier (a do_all over the level). Levels reached by
+   * many edges are pulled instead: every unlabeled node looks for a residual
+   * edge into the current level.
+   */
+  void updateHeightsFrontier() {
+    using Context = galois::FrontierContext<GNode>;
+    const int n   = graph.size();
+
+    auto push = [&, this](const GNode& src, const Context& next) {
+      int newHeight = next.round() + 1;
+      for (auto ii : graph.edges(src, galois::MethodFlag::UNPROTECTED)) {
+        GNode dst = graph.getEdgeDst(ii);
+        if (graph.getEdgeData(reverseDirectionEdgeIterator[*ii]) > 0) {
+          Node& node = graph.getData(dst, galois::MethodFlag::UNPROTECTED);
+          // racing writers store the same height
+          if (node.height == n) {
+            node.height = newHeight;
+            next.push(dst);
+          }
+        }
+      }
+    };
+
+    auto pull = [&](const GNode& src, const Context& curr) {
+      Node& node = graph.getData(src, galois::MethodFlag::UNPROTECTED);
+      if (node.height != n)
+        return false;
+      for (auto ii : graph.edges(src, galois::MethodFlag::UNPROTECTED)) {
+        if (graph.getEdgeData(ii) > 0 &&
+            curr.contains(graph.getEdgeDst(ii))) {
+          node.height = curr.round() + 1;
+          return true;
+        }
+      }
+      return false;
+    };
+
+    galois::for_each_frontier(
+        graph, galois::iterate({sink}), push,
+        galois::make_trait_with_args<galois::pull_op>(pull),
+        galois::loopname("updateHeights"));
+  }
+
+  //! Rebuilds heightCount and the height buckets from the heights of the
+  //! nodes.
+  void countHeights() {
+    const int n = graph.size();
+    galois::do_all(galois::iterate(size_t{0}, heightCount.size()),
+                   [&](size_t h) {
+                     heightCount[h] = 0;
+                     bucketHeads[h] = nullptr;
+                   },
+                   galois::no_stats());
+    bucketEntries.clear();
+    maxHeight    = 0;
+    gapCandidate = n;
+    galois::do_all(galois::iterate(graph),
+                   [&, this](const GNode& src) {
+                     int h = graph.getData(src, galois::MethodFlag::UNPROTECTED)
+                                 .height;
+                     if (h < n) {
+                       __sync_fetch_and_add(&heightCount[h], 1);
+                       addToBucket(h, src);
+                       galois::atomicMax(maxHeight, h);
+                     }
+                   },
+                   galois::loopname("CountHeights"));
+  }
+
+  template <typename IncomingWL>
+  void findWork(IncomingWL& incoming) {
+    galois::do_all(galois::iterate(graph),
+                   [&incoming, this](const GNode& src) {
+                     Node& node = this->graph.getData(
+                         src, galois::MethodFlag::UNPROTECTED);
+                     if (src == this->sink || src == this->source ||
+                         node.height >= (int)this->graph.size())
+                       return;
+                     if (node.excess > 0)
+                       incoming.push_back(src);
+                   },
+                   galois::loopname("FindWork"));
+  }
+
+  /**
+   * Gap heuristic (Cherkassky and Goldberg): if no node has height h but some
+   * node is higher, no node above h has a residual path to the sink, since
+   * residual edges go down at most one height at a time. Those nodes are
+   * lifted to graph.size() and never discharged again.
+   *
+   * Called when the discharge loop stopped because a relabel emptied a
+   * height, so the counts are exact. A concurrent relabel may have refilled
+   * the lowest emptied height, so the first empty height at or above it is
+   * used. The nodes above it are found in the buckets of the heights up to
+   * maxHeight, so a gap costs the heights and bucket entries it clears rather
+   * than a pass over the graph. A relabel raises maxHeight by at most one, so
+   * the heights visited are bounded by the relabels since the last global
+   * relabel.
+   */
+  void gapRelabel() {
+    const int n = graph.size();
+    int top     = maxHeight;
+    int gap     = gapCandidate;
+    gapCandidate = n;
+    ++gapRelabels;
+    while (gap < top && heightCount[gap] != 0)
+      ++gap;
+    if (gap >= top)
+      return;
+
+    galois::GAccumulator<size_t> lifted;
+    galois::do_all(galois::iterate(gap + 1, top + 1),
+                   [&, this](int h) {
+                     for (BucketEntry* e = bucketHeads[h]; e; e = e->next) {
+                       Node& node = this->graph.getData(
+                           e->node, galois::MethodFlag::UNPROTECTED);
+                       if (node.height == h) {
+                         node.height = n;
+                         lifted += 1;
+                       }
+                     }
+                     bucketHeads[h] = nullptr;
+                     heightCount[h] = 0;
+                   },
+                   galois::steal(), galois::loopname("GapRelabel"));
+    gapLiftedNodes += lifted.reduce();
+    maxHeight = gap - 1;
+  }
+
   template <typename IncomingWL>
   void globalRelabel(IncomingWL& incoming) {
 
@@ -460,11 +651,10 @@ struct PreflowPush {
                    },
                    galois::loopname("ResetHeights"));
 
-    using BSWL = galois::worklists::BulkSynchronous<>;
-    using DWL  = galois::worklists::Deterministic<>;
+    using DWL = galois::worklists::Deterministic<>;
     switch (detAlgo) {
     case nondet:
-      updateHeights<nondet, BSWL>();
+      updateHeightsFrontier();
       break;
     case detBase:
       updateHeights<detBase, DWL>();
@@ -477,17 +667,10 @@ struct PreflowPush {
       abort();
     }
 
-    galois::do_all(galois::iterate(graph),
-                   [&incoming, this](const GNode& src) {
-                     Node& node = this->graph.getData(
-                         src, galois::MethodFlag::UNPROTECTED);
-                     if (src == this->sink || src == this->source ||
-                         node.height >= (int)this->graph.size())
-                       return;
-                     if (node.excess > 0)
-                       incoming.push_back(src);
-                   },
-                   galois::loopname("FindWork"));
+    if (gapHeuristic)
+      countHeights();
+
+    findWork(incoming);
   }
 
   template <typename C>
@@ -517,16 +700,27 @@ struct PreflowPush {
     galois::InsertBag<GNode> initial;
     initializePreflow(initial);
 
+    if (gapHeuristic) {
+      heightCount.allocateBlocked(graph.size());
+      bucketHeads.allocateBlocked(graph.size());
+      countHeights();
+    }
+
+    // work since the last global relabel
+    Counter counter;
+    // nodes left over by a discharge loop that stopped for a gap
+    galois::InsertBag<GNode> pending;
+
     while (initial.begin() != initial.end()) {
       galois::StatTimer T_discharge("DischargeTime");
       T_discharge.start();
-      Counter counter;
       switch (detAlgo) {
       case nondet:
         if (useHLOrder) {
-          nonDetDischarge(initial, counter, galois::wl<OBIM>(obimIndexer));
+          nonDetDischarge(initial, pending, counter,
+                          galois::wl<OBIM>(obimIndexer));
         } else {
-          nonDetDischarge(initial, counter, galois::wl<Chunk>());
+          nonDetDischarge(initial, pending, counter, galois::wl<Chunk>());
         }
         break;
       case detBase:
@@ -545,15 +739,33 @@ struct PreflowPush {
         galois::StatTimer T_global_relabel("GlobalRelabelTime");
         T_global_relabel.start();
         initial.clear();
+        pending.clear();
         globalRelabel(initial);
         should_global_relabel = false;
+        should_gap_relabel    = false;
+        counter.reset();
         std::cout << " Flow after global relabel: "
                   << graph.getData(sink).excess << "\n";
         T_global_relabel.stop();
+      } else if (should_gap_relabel) {
+        galois::StatTimer T_gap_relabel("GapRelabelTime");
+        T_gap_relabel.start();
+        gapRelabel();
+        initial.clear();
+        std::swap(initial, pending);
+        should_gap_relabel = false;
+        T_gap_relabel.stop();
       } else {
         break;
       }
     }
+
+    if (gapHeuristic) {
+      galois::runtime::reportStat_Single("PreflowPush", "GapRelabels",
+                                         gapRelabels);
+      galois::runtime::reportStat_Single("PreflowPush", "GapLiftedNodes",
+                                         gapLiftedNodes);
+    }
   }
 
   template <typename EdgeTy>
@@ -845,6 +1057,15 @@ int main(int argc, char** argv) {
   PreflowPush app;
   app.initializeGraph(filename, sourceId, sinkId);
 
+  // the gap heuristic pays off with HL ordering, which otherwise keeps
+  // discharging nodes that cannot reach the sink; with FIFO order its
+  // bookkeeping costs about as much as it saves
+  app.gapHeuristic = useGapHeuristic.getNumOccurrences() > 0
+                         ? useGapHeuristic
+                         : useHLOrder && detAlgo == nondet;
+  if (app.gapHeuristic && detAlgo != nondet)
+    GALOIS_DIE("-useGapHeuristic requires the nondeterministic schedule");
+
   app.checkSorting();
 
   if (relabelInt == 0) {
@@ -31,6 +31,12 @@
 #include "Lonestar/BFS_SSSP.h"
 
 #include <iostream>
+#include <limits>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SSSP_SIMD_X86 1
+#include <immintrin.h>
+#endif
 
 namespace cll = llvm::cl;
 
@@ -64,12 +70,15 @@ enum Algo {
   dijkstraTile,
   dijkstra,
   topo,
-  topoTile
+  topoTile,
+  deltaSimdTile,
+  deltaSimd
 };
 
 const char* const ALGO_NAMES[] = {"deltaTile", "deltaStep",    "serDeltaTile",
                                   "serDelta",  "dijkstraTile", "dijkstra",
-                                  "topo",      "topoTile"};
+                                  "topo",      "topoTile",     "deltaSimdTile",
+                                  "deltaSimd"};
 
 static cll::opt<Algo>
     algo("algo", cll::desc("Choose an algorithm:"),
@@ -79,7 +88,9 @@ static cll::opt<Algo>
                      clEnumVal(serDelta, "serDelta"),
                      clEnumVal(dijkstraTile, "dijkstraTile"),
                      clEnumVal(dijkstra, "dijkstra"), clEnumVal(topo, "topo"),
-                     clEnumVal(topoTile, "topoTile"), clEnumValEnd),
+                     clEnumVal(topoTile, "topoTile"),
+                     clEnumVal(deltaSimdTile, "deltaSimdTile"),
+                     clEnumVal(deltaSimd, "deltaSimd"), clEnumValEnd),
          cll::init(deltaTile));
 
 // typedef galois::graphs::LC_InlineEdge_Graph<std::atomic<unsigned int>,
@@ -93,6 +104,8 @@ typedef Graph::GraphNode GNode;
 constexpr static const bool TRACK_WORK          = false;
 constexpr static const unsigned CHUNK_SIZE      = 64u;
 constexpr static const ptrdiff_t EDGE_TILE_SIZE = 512;
+//! Number of edges filtered at once by the batched relaxation
+constexpr static const unsigned SIMD_WIDTH = 8u;
 
 using SSSP                 = BFS_SSSP<Graph, uint32_t, true, EDGE_TILE_SIZE>;
 using Dist                 = SSSP::Dist;
@@ -179,6 +192,188 @@ void deltaStepAlgo(Graph& graph, GNode source, const P& pushWrap,
   }
 }
 
+//! Lowers d to v if v is smaller; returns true if it did
+static bool atomicMinDist(Dist& d, const Dist v) {
+  Dist old = __atomic_load_n(&d, __ATOMIC_RELAXED);
+  while (old > v) {
+    if (__atomic_compare_exchange_n(&d, &old, v, true, __ATOMIC_RELAXED,
+                                    __ATOMIC_RELAXED)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+#ifdef SSSP_SIMD_X86
+/**
+ * AVX2 body of relaxBatched: filters the edges SIMD_WIDTH at a time and
+ * returns the number of edges it consumed; the tail is left to the caller.
+ * Compiled for AVX2 regardless of the build flags and only called when the
+ * CPU supports it.
+ */
+template <typename F>
+__attribute__((target("avx2"))) size_t
+relaxGatherAVX2(const uint32_t* dsts, const uint32_t* weights, size_t n,
+                const Dist sdist, Dist* dist, size_t& filtered,
+                const F& relax) {
+  const __m256i src = _mm256_set1_epi32(sdist);
+  size_t i          = 0;
+
+  for (; i + SIMD_WIDTH <= n; i += SIMD_WIDTH) {
+    const __m256i dst =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dsts + i));
+    const __m256i wt =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+    const __m256i newDist = _mm256_add_epi32(src, wt);
+    const __m256i oldDist = _mm256_i32gather_epi32(
+        reinterpret_cast<const int*>(dist), dst, sizeof(Dist));
+    // unsigned newDist >= oldDist iff min(newDist, oldDist) == oldDist
+    const __m256i noGain =
+        _mm256_cmpeq_epi32(_mm256_min_epu32(newDist, oldDist), oldDist);
+    unsigned mask = ~_mm256_movemask_ps(_mm256_castsi256_ps(noGain)) & 0xffu;
+
+    filtered += SIMD_WIDTH - __builtin_popcount(mask);
+    for (; mask; mask &= mask - 1) {
+      const unsigned l = __builtin_ctz(mask);
+      relax(dsts[i + l], sdist + weights[i + l]);
+    }
+  }
+
+  return i;
+}
+
+//! True if relaxBatched can use the AVX2 gather on this CPU
+static bool haveAVX2() {
+  static const bool avx2 = [] {
+    __builtin_cpu_init();
+    return bool(__builtin_cpu_supports("avx2"));
+  }();
+  return avx2;
+}
+#endif
+
+/**
+ * Relaxes the n edges given by the arrays dsts and weights from a node at
+ * distance sdist. Edges are filtered SIMD_WIDTH at a time: the distances of
+ * the destinations are gathered and compared with the candidate distances in
+ * vector registers, and only the lanes that improve are passed on to
+ * relax(dst, newDist), which does the atomic min. Most relaxations do not
+ * improve, so most edges never touch the distance array with a CAS. The
+ * vector path is picked at runtime; without AVX2 every edge takes the scalar
+ * loop.
+ *
+ * @param gather use the vector gather; requires node ids that fit in int32_t
+ * @returns number of edges dropped by the filter
+ */
+template <typename F>
+size_t relaxBatched(const uint32_t* dsts, const uint32_t* weights, size_t n,
+                    const Dist sdist, Dist* dist, bool gather, const F& relax) {
+  size_t i        = 0;
+  size_t filtered = 0;
+
+#ifdef SSSP_SIMD_X86
+  if (gather && haveAVX2())
+    i = relaxGatherAVX2(dsts, weights, n, sdist, dist, filtered, relax);
+#else
+  (void)gather;
+#endif
+
+  for (; i < n; ++i) {
+    const Dist newDist = sdist + weights[i];
+    if (__atomic_load_n(&dist[dsts[i]], __ATOMIC_RELAXED) > newDist) {
+      relax(dsts[i], newDist);
+    } else {
+      ++filtered;
+    }
+  }
+
+  return filtered;
+}
+
+//! Edges of a work item of deltaStepSimdAlgo
+static std::pair<Graph::edge_iterator, Graph::edge_iterator>
+itemEdges(Graph& graph, const UpdateRequest& req) {
+  constexpr galois::MethodFlag flag = galois::MethodFlag::UNPROTECTED;
+  return std::make_pair(graph.edge_begin(req.src, flag),
+                        graph.edge_end(req.src, flag));
+}
+
+static std::pair<Graph::edge_iterator, Graph::edge_iterator>
+itemEdges(Graph&, const SrcEdgeTile& tile) {
+  return std::make_pair(tile.beg, tile.end);
+}
+
+/**
+ * Delta-stepping over a dense array of 32-bit distances kept apart from the
+ * graph, with the edges of each work item relaxed by relaxBatched. The
+ * distances are copied into the node data at the end.
+ */
+template <typename T, typename P>
+void deltaStepSimdAlgo(Graph& graph, GNode source, const P& pushWrap) {
+
+  galois::GAccumulator<size_t> WLEmptyWork;
+  galois::GAccumulator<size_t> FilteredWork;
+
+  namespace gwl = galois::worklists;
+
+  using PSchunk = gwl::PerSocketChunkFIFO<CHUNK_SIZE>;
+  using OBIM    = gwl::OrderedByIntegerMetric<UpdateRequestIndexer, PSchunk>;
+
+  galois::LargeArray<Dist> dist;
+  dist.allocateInterleaved(graph.size());
+
+  galois::do_all(galois::iterate(size_t{0}, graph.size()),
+                 [&](size_t i) { dist[i] = SSSP::DIST_INFINITY; },
+                 galois::no_stats(), galois::loopname("initDistArray"));
+
+  dist[source] = 0;
+
+  // the gather takes signed 32-bit indices
+  const bool gather =
+      graph.size() <= size_t(std::numeric_limits<int32_t>::max());
+
+  galois::InsertBag<T> initBag;
+  pushWrap(initBag, source, 0, "parallel");
+
+  galois::for_each(
+      galois::iterate(initBag),
+      [&](const T& item, auto& ctx) {
+        const Dist sdist = __atomic_load_n(&dist[item.src], __ATOMIC_RELAXED);
+
+        if (sdist < item.dist) {
+          if (TRACK_WORK)
+            WLEmptyWork += 1;
+          return;
+        }
+
+        const auto edges      = itemEdges(graph, item);
+        const size_t filtered = relaxBatched(
+            graph.getEdgeDstPtr(edges.first), graph.getEdgeDataPtr(edges.first),
+            edges.second - edges.first, sdist, dist.data(), gather,
+            [&](GNode dst, Dist newDist) {
+              if (atomicMinDist(dist[dst], newDist)) {
+                pushWrap(ctx, dst, newDist);
+              }
+            });
+
+        if (TRACK_WORK)
+          FilteredWork += filtered;
+      },
+      galois::wl<OBIM>(UpdateRequestIndexer{stepShift}),
+      galois::no_conflicts(), galois::loopname("SSSP"));
+
+  galois::do_all(galois::iterate(graph),
+                 [&](GNode n) { graph.getData(n) = dist[n]; },
+                 galois::no_stats(), galois::loopname("copyDistArray"));
+
+  if (TRACK_WORK) {
+    galois::runtime::reportStat_Single("SSSP", "WLEmptyWork",
+                                       WLEmptyWork.reduce());
+    galois::runtime::reportStat_Single("SSSP", "FilteredWork",
+                                       FilteredWork.reduce());
+  }
+}
+
 template <typename T, typename P, typename R>
 void serDeltaAlgo(Graph& graph, const GNode& source, const P& pushWrap,
                   const R& edgeRange) {
@@ -390,7 +585,7 @@ int main(int argc, char** argv) {
   galois::reportPageAlloc("MeminfoPre");
 
   if (algo == deltaStep || algo == deltaTile || algo == serDelta ||
-      algo == serDeltaTile) {
+      algo == serDeltaTile || algo == deltaSimd || algo == deltaSimdTile) {
     std::cout << "INFO: Using delta-step of " << (1 << stepShift) << "\n";
     std::cout
         << "WARNING: Performance varies considerably due to delta parameter.\n";
@@ -439,6 +634,12 @@ int main(int argc, char** argv) {
   case topoTile:
     topoTileAlgo(graph, source);
     break;
+  case deltaSimdTile:
+    deltaStepSimdAlgo<SrcEdgeTile>(graph, source, SrcEdgeTilePushWrap{graph});
+    break;
+  case deltaSimd:
+    deltaStepSimdAlgo<UpdateRequest>(graph, source, ReqPushWrap());
+    break;
   default:
     std::abort();
   }
@@ -23,6 +23,8 @@
 #include "galois/Timer.h"
 #include "galois/graphs/LCGraph.h"
 #include "galois/ParallelSTL.h"
+#include "galois/SetIntersection.h"
+#include "galois/substrate/PerThreadStorage.h"
 #include "llvm/Support/CommandLine.h"
 #include "Lonestar/BoilerPlate.h"
 
@@ -44,7 +46,8 @@ constexpr static const unsigned CHUNK_SIZE  = 64u;
 enum Algo {
   nodeiterator,
   edgeiterator,
-  orderedCount
+  orderedCount,
+  orderedIntersect
 };
 
 namespace cll = llvm::cl;
@@ -57,8 +60,27 @@ static cll::opt<Algo> algo(
                            "Edge Iterator"),
                 clEnumValN(Algo::orderedCount, "orderedCount",
                            "Ordered Simple Count (default)"),
+                clEnumValN(Algo::orderedIntersect, "orderedIntersect",
+                           "Ordered Count with intersection kernels"),
                 clEnumValEnd),
     cll::init(Algo::orderedCount));
+static cll::opt<galois::intersect::Kernel> intersectKernel(
+    "intersect", cll::desc("Intersection kernel for edgeiterator and "
+                           "orderedIntersect:"),
+    cll::values(clEnumValN(galois::intersect::Auto, "auto",
+                           "Select by list lengths (default)"),
+                clEnumValN(galois::intersect::Merge, "merge", "Scalar merge"),
+                clEnumValN(galois::intersect::Gallop, "gallop",
+                           "Galloping search"),
+                clEnumValN(galois::intersect::SIMD, "simd",
+                           "SIMD block merge"),
+                clEnumValEnd),
+    cll::init(galois::intersect::Auto));
+static cll::opt<unsigned> hubThreshold(
+    "hubThreshold",
+    cll::desc("orderedIntersect: nodes with at least this many lower "
+              "neighbors are intersected through a bitmap (0 to disable)"),
+    cll::init(1024));
 
 typedef galois::graphs::LC_CSR_Graph<uint32_t, void>::with_numa_alloc<
     true>::type ::with_no_lockable<true>::type Graph;
@@ -91,27 +113,15 @@ Iterator lowerBound(Iterator first, Iterator last, Compare comp) {
 }
 
 /**
- * std::set_intersection over edge_iterators.
+ * Size of the intersection of two sorted ranges of edge destinations.
  */
 template <typename G>
 size_t countEqual(G& g, typename G::edge_iterator aa,
                   typename G::edge_iterator ea, typename G::edge_iterator bb,
                   typename G::edge_iterator eb) {
-  size_t retval = 0;
-  while (aa != ea && bb != eb) {
-    typename G::GraphNode a = g.getEdgeDst(aa);
-    typename G::GraphNode b = g.getEdgeDst(bb);
-    if (a < b) {
-      ++aa;
-    } else if (b < a) {
-      ++bb;
-    } else {
-      retval += 1;
-      ++aa;
-      ++bb;
-    }
-  }
-  return retval;
+  return galois::intersect::count(g.getEdgeDstPtr(aa), ea - aa,
+                                  g.getEdgeDstPtr(bb), eb - bb,
+                                  intersectKernel);
 }
 
 template <typename G>
@@ -271,6 +281,72 @@ void orderedCountAlgo(Graph& graph) {
   std::cout << "Num Triangles: " << numTriangles.reduce() << "\n";
 }
 
+/**
+ * Ordered count where, for each node n and lower neighbor v, the lower
+ * neighbors of v are intersected with the lower neighbors of n using the
+ * galois::intersect kernels. For hub nodes (many lower neighbors), the lower
+ * neighbors of n are marked in a per-thread bitmap once and every
+ * intersection becomes a scan of the shorter list with bitmap lookups.
+ */
+void orderedIntersectAlgo(Graph& graph) {
+  constexpr const galois::MethodFlag flag = galois::MethodFlag::UNPROTECTED;
+
+  galois::GAccumulator<size_t> numTriangles;
+  galois::GAccumulator<size_t> numHubs;
+  galois::substrate::PerThreadStorage<galois::intersect::HubBitmap> bitmaps;
+
+  // number of neighbors of n with smaller ids; edges are sorted by id
+  auto lowerDegree = [&](GNode n) {
+    Graph::edge_iterator first = graph.edge_begin(n, flag);
+    return lowerBound(first, graph.edge_end(n, flag),
+                      LessThan<Graph>(graph, n)) -
+           first;
+  };
+
+  galois::do_all(
+      galois::iterate(graph),
+      [&](const GNode& n) {
+        const uint32_t* lower = graph.getEdgeDstPtr(graph.edge_begin(n, flag));
+        const size_t numLower = lowerDegree(n);
+        const bool useBitmap  = hubThreshold && numLower >= hubThreshold;
+
+        galois::intersect::HubBitmap& bitmap = *bitmaps.getLocal();
+        if (useBitmap) {
+          if (bitmap.universe() < graph.size()) {
+            bitmap.resize(graph.size());
+          }
+          bitmap.set(lower, numLower);
+          numHubs += 1;
+        }
+
+        size_t count = 0;
+        for (size_t i = 0; i < numLower; ++i) {
+          GNode v = lower[i];
+          const uint32_t* vLower =
+              graph.getEdgeDstPtr(graph.edge_begin(v, flag));
+          // lower neighbors of v are < v, so only lower[0, i) can match
+          size_t numVLower = lowerDegree(v);
+          if (useBitmap) {
+            count += bitmap.count(vLower, numVLower);
+          } else {
+            count += galois::intersect::count(lower, i, vLower, numVLower,
+                                              intersectKernel);
+          }
+        }
+        numTriangles += count;
+
+        if (useBitmap) {
+          bitmap.reset(lower, numLower);
+        }
+      },
+      galois::chunk_size<CHUNK_SIZE>(), galois::steal(),
+      galois::loopname("orderedIntersectAlgo"));
+
+  galois::runtime::reportStat_Single("orderedIntersectAlgo", "HubNodes",
+                                     numHubs.reduce());
+  std::cout << "Num Triangles: " << numTriangles.reduce() << "\n";
+}
+
 /**
  * Edge Iterator algorithm for counting triangles.
  * <code>
@@ -439,6 +515,12 @@ int main(int argc, char** argv) {
     orderedCountAlgo(graph);
     break;
 
+  case orderedIntersect:
+    std::cout << "Intersection SIMD kernel: " << galois::intersect::simdName()
+              << "\n";
+    orderedIntersectAlgo(graph);
+    break;
+
   default:
     std::cerr << "Unknown algo: " << algo << "\n";
   }
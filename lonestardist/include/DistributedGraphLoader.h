@@ -44,7 +44,7 @@ enum PARTITIONING_SCHEME {
   HIVC,                  //!< incoming hybrid vertex cut
   CART_VCUT,             //!< cartesian vertex cut
   CART_VCUT_IEC,         //!< cartesian vertex cut using iec
-  //CEC,                   //!< custom edge cut
+  CEC,                   //!< custom edge cut from a partition file
   GINGER_O,              //!< Ginger, outgoing
   GINGER_I,              //!< Ginger, incoming
   FENNEL_O,              //!< Fennel, oec
@@ -72,8 +72,8 @@ inline const char* EnumToString(PARTITIONING_SCHEME e) {
     return "cvc";
   case CART_VCUT_IEC:
     return "cvc_iec";
-  //case CEC:
-  //  return "cec";
+  case CEC:
+    return "cec";
   case GINGER_O:
     return "ginger-oec";
   case GINGER_I:
@@ -104,8 +104,8 @@ extern cll::opt<std::string> inputFileTranspose;
 extern cll::opt<bool> inputFileSymmetric;
 //! partitioning scheme to use
 extern cll::opt<galois::graphs::PARTITIONING_SCHEME> partitionScheme;
-////! path to vertex id map for custom edge cut
-//extern cll::opt<std::string> vertexIDMapFileName;
+//! path to vertex id map for custom edge cut
+extern cll::opt<std::string> vertexIDMapFileName;
 //! true if you want to read graph structure from a file
 extern cll::opt<bool> readFromFile;
 //! path to local graph structure to read
@@ -158,9 +158,13 @@ constructSymmetricGraph(std::vector<unsigned>& scaleFactor) {
       inputFile, galois::CUSP_CSR, galois::CUSP_CSR, true, inputFileTranspose
     );
 
-  //case CEC:
-  //  return new Graph_customEdgeCut(inputFile, "", net.ID, net.Num,
-  //                                 scaleFactor, vertexIDMapFileName, false);
+  case CEC:
+    // masters are fixed by the file, so one state round is enough
+    PartitionFileP::setPartitionFile(vertexIDMapFileName);
+    return cuspPartitionGraph<PartitionFileP, NodeData, EdgeData>(
+      inputFile, galois::CUSP_CSR, galois::CUSP_CSR, true, inputFileTranspose,
+      true, 1
+    );
 
   case GINGER_O:
   case GINGER_I:
@@ -256,9 +260,12 @@ constructGraph(std::vector<unsigned>& scaleFactor) {
       break;
     }
 
-  //case CEC:
-  //  return new Graph_customEdgeCut(inputFile, "", net.ID, net.Num,
-  //                                 scaleFactor, vertexIDMapFileName, false);
+  case CEC:
+    PartitionFileP::setPartitionFile(vertexIDMapFileName);
+    return cuspPartitionGraph<PartitionFileP, NodeData, EdgeData>(
+      inputFile, galois::CUSP_CSR, galois::CUSP_CSR, false, inputFileTranspose,
+      true, 1
+    );
 
   case GINGER_O:
     return cuspPartitionGraph<GingerP, NodeData, EdgeData>(
@@ -380,15 +387,17 @@ constructGraph(std::vector<unsigned>& scaleFactor) {
       break;
     }
 
-  //case CEC:
-  //  if (inputFileTranspose.size()) {
-  //    return new Graph_customEdgeCut(inputFileTranspose, "", net.ID,
-  //                                   net.Num, scaleFactor, vertexIDMapFileName,
-  //                                   false);
-  //  } else {
-  //    GALOIS_DIE("Error: (cec) iterate over in-edges without transpose graph");
-  //    break;
-  //  }
+  case CEC:
+    if (inputFileTranspose.size()) {
+      PartitionFileP::setPartitionFile(vertexIDMapFileName);
+      return cuspPartitionGraph<PartitionFileP, NodeData, EdgeData>(
+        inputFile, galois::CUSP_CSC, galois::CUSP_CSC, false,
+        inputFileTranspose, true, 1
+      );
+    } else {
+      GALOIS_DIE("Error: (cec) iterate over in-edges without transpose graph");
+      break;
+    }
 
   case GINGER_O:
     return cuspPartitionGraph<GingerP, NodeData, EdgeData>(
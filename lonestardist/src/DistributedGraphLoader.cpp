@@ -49,7 +49,7 @@ cll::opt<PARTITIONING_SCHEME> partitionScheme(
         clEnumValN(HIVC, "hivc", "Incoming Hybrid Vertex-Cut"),
         clEnumValN(CART_VCUT, "cvc", "Cartesian Vertex-Cut of oec"),
         clEnumValN(CART_VCUT_IEC, "cvc-iec", "Cartesian Vertex-Cut of iec"),
-        //clEnumValN(CEC, "cec", "Custom edge cut from vertexID mapping"),
+        clEnumValN(CEC, "cec", "Custom edge cut from vertexID mapping"),
         clEnumValN(GINGER_O, "ginger-o", "ginger, outgiong edges, using CuSP"),
         clEnumValN(GINGER_I, "ginger-i", "ginger, incoming edges, using CuSP"),
         clEnumValN(FENNEL_O, "fennel-o", "fennel, outgoing edge cut, using CuSP"),
@@ -58,12 +58,13 @@ cll::opt<PARTITIONING_SCHEME> partitionScheme(
         clEnumValEnd),
     cll::init(OEC));
 
-//cll::opt<std::string>
-//    vertexIDMapFileName("vertexIDMapFileName",
-//                        cll::desc("<file containing the "
-//                                  "vertexID to hosts mapping for "
-//                                  "the custom edge cut.>"),
-//                        cll::init(""), cll::Hidden);
+cll::opt<std::string>
+    vertexIDMapFileName("vertexIDMapFileName",
+                        cll::desc("<file containing the "
+                                  "vertexID to hosts mapping for "
+                                  "the custom edge cut, one host per line "
+                                  "(e.g. gmetis -output).>"),
+                        cll::init(""));
 
 cll::opt<bool> readFromFile("readFromFile",
                             cll::desc("Set this flag if graph is to be "
@@ -20,9 +20,11 @@
 #include "galois/Timer.h"
 #include "galois/Galois.h"
 #include "galois/substrate/Barrier.h"
+#include "galois/substrate/IdleWait.h"
 
 #include <iostream>
 #include <cstdlib>
+#include <ctime>
 #include <unistd.h>
 
 unsigned iter       = 1;
@@ -50,21 +52,47 @@ struct emp {
   }
 };
 
+const char* policyName(galois::substrate::IdlePolicy p) {
+  switch (p) {
+  case galois::substrate::IdlePolicy::SPIN:
+    return "spin";
+  case galois::substrate::IdlePolicy::YIELD:
+    return "yield";
+  default:
+    return "sleep";
+  }
+}
+
+//! prints host, barrier, idle policy, threads, wall time (ms) and CPU time
+//! of all threads (ms)
 void test(std::unique_ptr<galois::substrate::Barrier> b) {
-  unsigned M = numThreads;
-  if (M > 16)
-    M /= 2;
-  while (M) {
-    galois::setActiveThreads(M); // galois::runtime::LL::getMaxThreads());
-    b->reinit(M);
-    galois::Timer t;
-    t.start();
-    emp e{*b.get()};
-    galois::on_each(e);
-    t.stop();
-    std::cout << bname << "," << b->name() << "," << M << "," << t.get()
-              << "\n";
-    M -= 1;
+  // not all barriers are available on every platform
+  if (!b)
+    return;
+  using galois::substrate::IdlePolicy;
+  const unsigned budget = galois::substrate::getIdleSpinBudget();
+  for (IdlePolicy p :
+       {IdlePolicy::SPIN, IdlePolicy::YIELD, IdlePolicy::SLEEP}) {
+    galois::substrate::setIdlePolicy(p, budget);
+    unsigned M = numThreads;
+    if (M > 16)
+      M /= 2;
+    while (M) {
+      // the barrier must not wait for more threads than can be run
+      M = galois::setActiveThreads(M);
+      b->reinit(M);
+      galois::Timer t;
+      std::clock_t cpu = std::clock();
+      t.start();
+      emp e{*b.get()};
+      galois::on_each(e);
+      t.stop();
+      cpu = std::clock() - cpu;
+      std::cout << bname << "," << b->name() << "," << policyName(p) << ","
+                << M << "," << t.get() << ","
+                << 1000 * cpu / CLOCKS_PER_SEC << "\n";
+      M -= 1;
+    }
   }
 }
 
@@ -0,0 +1,82 @@
+/*
+ * This file belongs to the Galois project, a C++ library for exploiting parallelism.
+ * The code is being released under the terms of the 3-Clause BSD License (a
+ * copy is located in LICENSE.txt at the top-level directory).
+ *
+ * Copyright (C) 2019, The University of Texas at Austin. All rights reserved.
+ * UNIVERSITY EXPRESSLY DISCLAIMS ANY AND ALL WARRANTIES CONCERNING THIS
+ * SOFTWARE AND DOCUMENTATION, INCLUDING ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR ANY PARTICULAR PURPOSE, NON-INFRINGEMENT AND WARRANTIES OF
+ * PERFORMANCE, AND ANY WARRANTY THAT MIGHT OTHERWISE ARISE FROM COURSE OF
+ * DEALING OR USAGE OF TRADE.  NO WARRANTY IS EITHER EXPRESS OR IMPLIED WITH
+ * RESPECT TO THE USE OF THE SOFTWARE OR DOCUMENTATION. Under no circumstances
+ * shall University be liable for incidental, special, indirect, direct or
+ * consequential damages or loss of profits, interruption of business, or
+ * related expenses which may arise from use of Software or Documentation,
+ * including but not limited to those resulting from defects in Software and/or
+ * Documentation, or loss or inaccuracy of data of any kind.
+ */
+
+#include "galois/Galois.h"
+#include "galois/Buckets.h"
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+int main(int argc, char** argv) {
+  galois::SharedMemSys Galois_runtime;
+  galois::setActiveThreads(galois::substrate::getThreadPool().getMaxThreads());
+
+  const size_t numItems = 10000;
+  const size_t maxKey   = 1000;
+
+  std::mt19937 gen(0);
+  std::vector<size_t> keys(numItems);
+  std::vector<char> done(numItems, 0);
+  for (auto& k : keys) {
+    k = gen() % maxKey;
+  }
+
+  // small window so that the overflow bag is redistributed several times
+  galois::Buckets<size_t> buckets(8);
+  galois::do_all(galois::iterate(size_t{0}, numItems),
+                 [&](size_t i) { buckets.push(i, keys[i]); });
+
+  auto keyFn = [&](size_t i) {
+    return done[i] ? galois::Buckets<size_t>::NULL_KEY : keys[i];
+  };
+
+  galois::InsertBag<size_t> bucket;
+  size_t last      = 0;
+  size_t extracted = 0;
+  while (buckets.nextBucket(keyFn, bucket)) {
+    const size_t key = buckets.current();
+    GALOIS_ASSERT(key >= last, "buckets out of order: ", key, " < ", last);
+    last = key;
+
+    for (size_t i : bucket) {
+      GALOIS_ASSERT(!done[i], "item ", i, " extracted twice");
+      GALOIS_ASSERT(keys[i] == key, "item ", i, " in wrong bucket");
+      done[i] = 1;
+      extracted += 1;
+    }
+
+    // lower the keys of some remaining items, but not below the current key
+    for (size_t n = 0; n < 50; ++n) {
+      size_t i = gen() % numItems;
+      if (done[i] || keys[i] == key) {
+        continue;
+      }
+      size_t lowered = keys[i] - 1 - gen() % (keys[i] - key);
+      keys[i]        = lowered;
+      buckets.push(i, lowered);
+    }
+  }
+
+  GALOIS_ASSERT(extracted == numItems, "extracted ", extracted, " of ",
+                numItems);
+  std::cout << "extracted " << extracted << " items\n";
+
+  return 0;
+}
@@ -0,0 +1,232 @@
+/*
+ * This file belongs to the Galois project, a C++ library for exploiting parallelism.
+ * The code is being released under the terms of the 3-Clause BSD License (a
+ * copy is located in LICENSE.txt at the top-level directory).
+ *
+ * Copyright (C) 2019, The University of Texas at Austin. All rights reserved.
+ * UNIVERSITY EXPRESSLY DISCLAIMS ANY AND ALL WARRANTIES CONCERNING THIS
+ * SOFTWARE AND DOCUMENTATION, INCLUDING ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR ANY PARTICULAR PURPOSE, NON-INFRINGEMENT AND WARRANTIES OF
+ * PERFORMANCE, AND ANY WARRANTY THAT MIGHT OTHERWISE ARISE FROM COURSE OF
+ * DEALING OR USAGE OF TRADE.  NO WARRANTY IS EITHER EXPRESS OR IMPLIED WITH
+ * RESPECT TO THE USE OF THE SOFTWARE OR DOCUMENTATION. Under no circumstances
+ * shall University be liable for incidental, special, indirect, direct or
+ * consequential damages or loss of profits, interruption of business, or
+ * related expenses which may arise from use of Software or Documentation,
+ * including but not limited to those resulting from defects in Software and/or
+ * Documentation, or loss or inaccuracy of data of any kind.
+ */
+
+#include "galois/Galois.h"
+#include "galois/Frontier.h"
+#include "galois/graphs/LCGraph.h"
+
+#include <atomic>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <random>
+#include <set>
+#include <vector>
+
+typedef galois::Frontier<uint32_t> Frontier;
+typedef galois::graphs::LC_CSR_Graph<uint32_t, uint32_t>::with_no_lockable<
+    true>::type Graph;
+
+const uint32_t UNREACHED = std::numeric_limits<uint32_t>::max();
+
+//! nodes of f (without duplicates) and checks each is visited once per push
+std::set<uint32_t> contents(const Frontier& f, size_t numNodes) {
+  std::vector<std::atomic<unsigned>> visits(numNodes);
+  f.do_all([&](uint32_t n) { visits[n] += 1; });
+  std::set<uint32_t> retval;
+  size_t total = 0;
+  for (size_t n = 0; n < numNodes; ++n) {
+    if (visits[n]) {
+      GALOIS_ASSERT(!f.isDense() || visits[n] == 1, "dense visits ", n,
+                    " twice");
+      retval.insert(n);
+      total += visits[n];
+    }
+  }
+  GALOIS_ASSERT(total == f.size(), "visited ", total, " of ", f.size());
+  // a chunk_size counts nodes; here it is smaller than a work item
+  std::atomic<size_t> chunked(0);
+  f.do_all([&](uint32_t) { chunked += 1; }, galois::chunk_size<64>());
+  GALOIS_ASSERT(chunked == total, "chunked visited ", chunked.load());
+  return retval;
+}
+
+//! symmetric graph of a few hubs and a long tail, with unreachable nodes
+void makeGraph(Graph& g, uint32_t numNodes) {
+  std::vector<std::vector<uint32_t>> adj(numNodes);
+  std::mt19937 gen(2);
+  auto addEdge = [&](uint32_t u, uint32_t v) {
+    adj[u].push_back(v);
+    adj[v].push_back(u);
+  };
+  uint32_t reached = numNodes - 100;
+  for (uint32_t i = 1; i < reached; ++i) {
+    addEdge(i, gen() % 16);
+    if (i > 1000)
+      addEdge(i, i - 1 - gen() % 1000);
+  }
+  uint64_t numEdges = 0;
+  for (auto& l : adj)
+    numEdges += l.size();
+  Graph tmp(
+      numNodes, numEdges, [&](uint32_t n) { return adj[n].size(); },
+      [&](uint32_t n, uint64_t e) { return adj[n][e]; },
+      [&](uint32_t, uint64_t) { return 0u; });
+  swap(g, tmp);
+}
+
+//! runs a BFS from node 0 with for_each_frontier and checks it level by level
+template <typename... Args>
+void checkBFS(Graph& g, const std::vector<uint32_t>& expected,
+              const Args&... args) {
+  std::vector<std::atomic<unsigned>> visits(g.size());
+  galois::do_all(galois::iterate(g), [&](uint32_t n) {
+    g.getData(n) = UNREACHED;
+    visits[n]    = 0;
+  });
+  g.getData(0) = 0;
+
+  // racy check of the level; a node pushed twice in a round is kept once
+  size_t rounds = galois::for_each_frontier(
+      g, galois::iterate({0u}),
+      [&](uint32_t n, const galois::FrontierContext<uint32_t>& ctx) {
+        visits[n] += 1;
+        for (auto e : g.edges(n)) {
+          uint32_t dst = g.getEdgeDst(e);
+          if (g.getData(dst) == UNREACHED) {
+            g.getData(dst) = ctx.round() + 1;
+            ctx.push(dst);
+          }
+        }
+      },
+      args...);
+
+  uint32_t maxLevel = 0;
+  for (uint32_t n = 0; n < g.size(); ++n) {
+    GALOIS_ASSERT(g.getData(n) == expected[n], "level of ", n);
+    if (expected[n] != UNREACHED)
+      maxLevel = std::max(maxLevel, expected[n]);
+  }
+  GALOIS_ASSERT(rounds == maxLevel + 1, "rounds ", rounds);
+  // with pull rounds, nodes activated by pulling are not visited by push
+  if (!galois::exists_by_supertype<galois::pull_op_tag,
+                                   std::tuple<Args...>>::value)
+    for (uint32_t n = 0; n < g.size(); ++n)
+      GALOIS_ASSERT(visits[n] == (expected[n] != UNREACHED), "visits ", n);
+}
+
+int main(int argc, char** argv) {
+  galois::SharedMemSys Galois_runtime;
+  galois::setActiveThreads(galois::substrate::getThreadPool().getMaxThreads());
+
+  // not a multiple of the word or block size
+  const size_t numNodes = 100003;
+
+  std::mt19937 gen(0);
+  std::set<uint32_t> small, large, other;
+  while (small.size() < 100)
+    small.insert(gen() % numNodes);
+  while (large.size() < numNodes / 4)
+    large.insert(gen() % numNodes);
+  while (other.size() < numNodes / 3)
+    other.insert(gen() % numNodes);
+  large.insert(numNodes - 1);
+
+  std::vector<uint32_t> smallV(small.begin(), small.end());
+  std::vector<uint32_t> largeV(large.begin(), large.end());
+  std::vector<uint32_t> otherV(other.begin(), other.end());
+
+  Frontier f(numNodes);
+  GALOIS_ASSERT(f.empty() && !f.isDense());
+
+  // small frontiers stay sparse; duplicates are kept until converted
+  galois::do_all(galois::iterate(smallV), [&](uint32_t n) { f.push(n); });
+  f.push(smallV[0]);
+  GALOIS_ASSERT(f.adapt() == small.size() + 1);
+  GALOIS_ASSERT(!f.isDense() && f.size() == small.size() + 1);
+  GALOIS_ASSERT(contents(f, numNodes) == small);
+  f.toDense();
+  GALOIS_ASSERT(f.size() == small.size() && f.test(smallV[0]));
+  GALOIS_ASSERT(contents(f, numNodes) == small);
+
+  // large frontiers become dense and survive a round trip
+  f.clear();
+  GALOIS_ASSERT(f.empty() && !f.isDense());
+  galois::do_all(galois::iterate(largeV), [&](uint32_t n) { f.push(n); });
+  f.push(largeV[0]);
+  GALOIS_ASSERT(f.adapt() == large.size());
+  GALOIS_ASSERT(f.isDense() && f.size() == large.size());
+  GALOIS_ASSERT(contents(f, numNodes) == large);
+  f.toSparse();
+  GALOIS_ASSERT(!f.isDense() && f.size() == large.size());
+  GALOIS_ASSERT(contents(f, numNodes) == large);
+
+  // set operations in all combinations of representations
+  std::set<uint32_t> both, either(large);
+  for (auto n : other) {
+    if (large.count(n))
+      both.insert(n);
+    either.insert(n);
+  }
+  for (int mine = 0; mine < 2; ++mine) {
+    for (int theirs = 0; theirs < 2; ++theirs) {
+      Frontier a(numNodes), b(numNodes);
+      galois::do_all(galois::iterate(largeV), [&](uint32_t n) { a.push(n); });
+      galois::do_all(galois::iterate(otherV), [&](uint32_t n) { b.push(n); });
+      if (mine)
+        a.toDense();
+      if (theirs)
+        b.toDense();
+      Frontier c(numNodes);
+      c.unite(a);
+      c.intersect(b);
+      GALOIS_ASSERT(contents(c, numNodes) == both, "intersect ", mine, theirs);
+      a.unite(b);
+      GALOIS_ASSERT(contents(a, numNodes) == either, "unite ", mine, theirs);
+    }
+  }
+
+  // level-synchronous BFS, pushing only and switching to pull
+  Graph g;
+  makeGraph(g, numNodes);
+  std::vector<uint32_t> levels(numNodes, UNREACHED);
+  std::queue<uint32_t> queue;
+  levels[0] = 0;
+  queue.push(0);
+  while (!queue.empty()) {
+    uint32_t n = queue.front();
+    queue.pop();
+    for (auto e : g.edges(n)) {
+      uint32_t dst = g.getEdgeDst(e);
+      if (levels[dst] == UNREACHED) {
+        levels[dst] = levels[n] + 1;
+        queue.push(dst);
+      }
+    }
+  }
+  checkBFS(g, levels);
+  checkBFS(g, levels, galois::chunk_size<8192>());
+  checkBFS(g, levels,
+           galois::make_trait_with_args<galois::pull_op>(
+               [&](uint32_t n, const galois::FrontierContext<uint32_t>& ctx) {
+                 if (g.getData(n) != UNREACHED)
+                   return false;
+                 for (auto e : g.edges(n)) {
+                   if (ctx.contains(g.getEdgeDst(e))) {
+                     g.getData(n) = ctx.round() + 1;
+                     return true;
+                   }
+                 }
+                 return false;
+               }),
+           galois::loopname("FrontierBFS"));
+
+  std::cout << "frontier ok\n";
+  return 0;
+}
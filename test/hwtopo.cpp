@@ -23,15 +23,30 @@
 
 int main(int argc, char** argv) {
   auto t = galois::substrate::getHWTopo();
-  std::cout << "T,C,P,N: " << t.first.maxThreads << " " << t.first.maxCores
-            << " " << t.first.maxSockets << " " << t.first.maxNumaNodes << "\n";
+  std::cout << "T,C,P,N,L3: " << t.first.maxThreads << " " << t.first.maxCores
+            << " " << t.first.maxSockets << " " << t.first.maxNumaNodes << " "
+            << t.first.maxL3Domains << "\n";
   for (unsigned i = 0; i < t.first.maxThreads; ++i) {
     auto& c = t.second[i];
     std::cout << "tid: " << c.tid << " leader: " << c.socketLeader
               << " socket: " << c.socket << " numaNode: " << c.numaNode
               << " cumulativeMaxSocket: " << c.cumulativeMaxSocket
               << " osContext: " << c.osContext
-              << " osNumaNode: " << c.osNumaNode << "\n";
+              << " osNumaNode: " << c.osNumaNode << " l3Leader: " << c.l3Leader
+              << " l3Domain: " << c.l3Domain
+              << " cumulativeMaxL3: " << c.cumulativeMaxL3 << "\n";
+  }
+
+  // L3 domains nest within sockets, and leaders are members of their domain
+  if (t.first.maxL3Domains < t.first.maxSockets)
+    return 1;
+  for (unsigned i = 0; i < t.first.maxThreads; ++i) {
+    auto& c      = t.second[i];
+    auto& leader = t.second[c.l3Leader];
+    if (c.l3Domain >= t.first.maxL3Domains || leader.l3Domain != c.l3Domain ||
+        leader.socket != c.socket || c.l3Leader > i ||
+        c.cumulativeMaxL3 < c.l3Domain)
+      return 1;
   }
   return 0;
 }
@@ -0,0 +1,96 @@
+/*
+ * This file belongs to the Galois project, a C++ library for exploiting parallelism.
+ * The code is being released under the terms of the 3-Clause BSD License (a
+ * copy is located in LICENSE.txt at the top-level directory).
+ *
+ * Copyright (C) 2018, The University of Texas at Austin. All rights reserved.
+ * UNIVERSITY EXPRESSLY DISCLAIMS ANY AND ALL WARRANTIES CONCERNING THIS
+ * SOFTWARE AND DOCUMENTATION, INCLUDING ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR ANY PARTICULAR PURPOSE, NON-INFRINGEMENT AND WARRANTIES OF
+ * PERFORMANCE, AND ANY WARRANTY THAT MIGHT OTHERWISE ARISE FROM COURSE OF
+ * DEALING OR USAGE OF TRADE.  NO WARRANTY IS EITHER EXPRESS OR IMPLIED WITH
+ * RESPECT TO THE USE OF THE SOFTWARE OR DOCUMENTATION. Under no circumstances
+ * shall University be liable for incidental, special, indirect, direct or
+ * consequential damages or loss of profits, interruption of business, or
+ * related expenses which may arise from use of Software or Documentation,
+ * including but not limited to those resulting from defects in Software and/or
+ * Documentation, or loss or inaccuracy of data of any kind.
+ */
+
+#include "galois/Galois.h"
+#include "galois/Reduction.h"
+#include "galois/runtime/Context.h"
+
+#include <iostream>
+#include <vector>
+
+struct Counter : public galois::runtime::Lockable {
+  size_t value = 0;
+};
+
+int main(int argc, char** argv) {
+  galois::SharedMemSys Galois_runtime;
+  galois::setActiveThreads(galois::substrate::getThreadPool().getMaxThreads());
+
+  const size_t outer = 64;
+  const size_t inner = 10000;
+
+  // one heavy iteration whose inner loop should be shared with idle threads
+  std::vector<size_t> sizes(outer, 1);
+  sizes[0] = inner;
+
+  galois::GAccumulator<size_t> doAllSum;
+  galois::do_all(
+      galois::iterate(sizes),
+      [&](size_t n) {
+        galois::do_all(galois::iterate(size_t{0}, n),
+                       [&](size_t i) {
+                         galois::do_all(galois::iterate(size_t{0}, size_t{4}),
+                                        [&](size_t) { doAllSum += 1; });
+                       },
+                       galois::chunk_size<16>());
+      },
+      galois::steal(), galois::loopname("nested-do_all"));
+
+  galois::GAccumulator<size_t> forEachSum;
+  galois::for_each(galois::iterate(sizes),
+                   [&](size_t n, auto&) {
+                     galois::do_all(galois::iterate(size_t{0}, n),
+                                    [&](size_t i) { forEachSum += i; },
+                                    galois::loopname("nested-inner"));
+                   },
+                   galois::no_conflicts(), galois::no_pushes(),
+                   galois::loopname("nested-for_each"));
+
+  // every iteration locks all counters in a nested loop before incrementing
+  // them, so each increment must be covered by conflict detection
+  std::vector<Counter> counters(inner);
+  galois::for_each(
+      galois::iterate(sizes),
+      [&](size_t n, auto&) {
+        galois::runtime::SimpleRuntimeContext* cnx =
+            galois::runtime::getThreadContext();
+        galois::do_all(galois::iterate(size_t{0}, n), [&](size_t i) {
+          GALOIS_ASSERT(galois::runtime::getThreadContext() == cnx);
+          galois::runtime::acquire(&counters[i], galois::MethodFlag::WRITE);
+        });
+        for (size_t i = 0; i < n; ++i)
+          counters[i].value += 1;
+      },
+      galois::no_pushes(), galois::loopname("nested-conflicts"));
+
+  const size_t expectedDoAll   = 4 * (inner + outer - 1);
+  const size_t expectedForEach = inner * (inner - 1) / 2;
+  std::cout << "do_all: " << doAllSum.reduce() << " (expected "
+            << expectedDoAll << ")\n";
+  std::cout << "for_each: " << forEachSum.reduce() << " (expected "
+            << expectedForEach << ")\n";
+
+  GALOIS_ASSERT(doAllSum.reduce() == expectedDoAll);
+  GALOIS_ASSERT(forEachSum.reduce() == expectedForEach);
+  // counter 0 is incremented by every iteration, the others by sizes[0] only
+  GALOIS_ASSERT(counters[0].value == outer);
+  for (size_t i = 1; i < inner; ++i)
+    GALOIS_ASSERT(counters[i].value == 1);
+  return 0;
+}
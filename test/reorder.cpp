@@ -0,0 +1,171 @@
+/*
+ * This file belongs to the Galois project, a C++ library for exploiting parallelism.
+ * The code is being released under the terms of the 3-Clause BSD License (a
+ * copy is located in LICENSE.txt at the top-level directory).
+ *
+ * Copyright (C) 2019, The University of Texas at Austin. All rights reserved.
+ * UNIVERSITY EXPRESSLY DISCLAIMS ANY AND ALL WARRANTIES CONCERNING THIS
+ * SOFTWARE AND DOCUMENTATION, INCLUDING ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR ANY PARTICULAR PURPOSE, NON-INFRINGEMENT AND WARRANTIES OF
+ * PERFORMANCE, AND ANY WARRANTY THAT MIGHT OTHERWISE ARISE FROM COURSE OF
+ * DEALING OR USAGE OF TRADE.  NO WARRANTY IS EITHER EXPRESS OR IMPLIED WITH
+ * RESPECT TO THE USE OF THE SOFTWARE OR DOCUMENTATION. Under no circumstances
+ * shall University be liable for incidental, special, indirect, direct or
+ * consequential damages or loss of profits, interruption of business, or
+ * related expenses which may arise from use of Software or Documentation,
+ * including but not limited to those resulting from defects in Software and/or
+ * Documentation, or loss or inaccuracy of data of any kind.
+ */
+
+#include "galois/Galois.h"
+#include "galois/graphs/LCGraph.h"
+#include "galois/graphs/Reorder.h"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <tuple>
+#include <vector>
+
+typedef galois::graphs::LC_CSR_Graph<uint32_t, uint32_t>::with_no_lockable<
+    true>::type Graph;
+typedef std::vector<std::vector<std::pair<uint32_t, uint32_t>>> AdjList;
+
+//! symmetric graph with a few components, isolated nodes and hubs
+AdjList makeGraph(uint32_t numNodes) {
+  AdjList adj(numNodes);
+  std::mt19937 gen(0);
+  auto addEdge = [&](uint32_t u, uint32_t v) {
+    uint32_t w = gen() % 100;
+    adj[u].emplace_back(v, w);
+    adj[v].emplace_back(u, w);
+  };
+  // two halves without edges between them; the last 10 nodes are isolated
+  uint32_t half = (numNodes - 10) / 2;
+  for (uint32_t c = 0; c < 2; ++c) {
+    uint32_t base = c * half;
+    for (uint32_t i = 1; i < half; ++i)
+      addEdge(base + i, base + gen() % i);
+    for (uint32_t i = 0; i < half; ++i)
+      addEdge(base + i, base + gen() % 8);
+  }
+  return adj;
+}
+
+//! path whose nodes have shuffled ids
+AdjList makePath(uint32_t numNodes) {
+  std::vector<uint32_t> ids(numNodes);
+  for (uint32_t i = 0; i < numNodes; ++i)
+    ids[i] = i;
+  std::shuffle(ids.begin(), ids.end(), std::mt19937(1));
+  AdjList adj(numNodes);
+  for (uint32_t i = 1; i < numNodes; ++i) {
+    adj[ids[i]].emplace_back(ids[i - 1], i);
+    adj[ids[i - 1]].emplace_back(ids[i], i);
+  }
+  return adj;
+}
+
+void construct(Graph& g, const AdjList& adj) {
+  uint64_t numEdges = 0;
+  for (auto& l : adj)
+    numEdges += l.size();
+  Graph tmp(
+      adj.size(), numEdges, [&](uint32_t n) { return adj[n].size(); },
+      [&](uint32_t n, uint64_t e) { return adj[n][e].first; },
+      [&](uint32_t n, uint64_t e) { return adj[n][e].second; });
+  swap(g, tmp);
+  for (uint32_t n = 0; n < g.size(); ++n)
+    g.getData(n) = n;
+}
+
+//! checks that g is adj relabeled by r
+void check(Graph& g, const AdjList& adj,
+           const galois::graphs::NodeRelabeling& r) {
+  const size_t numNodes = adj.size();
+  GALOIS_ASSERT(g.size() == numNodes && r.newId.size() == numNodes &&
+                r.oldId.size() == numNodes);
+  std::vector<bool> seen(numNodes, false);
+  for (uint32_t n = 0; n < numNodes; ++n) {
+    GALOIS_ASSERT(r.newId[n] < numNodes && !seen[r.newId[n]],
+                  "not a permutation");
+    seen[r.newId[n]] = true;
+    GALOIS_ASSERT(r.oldId[r.newId[n]] == n);
+  }
+  for (uint32_t n = 0; n < numNodes; ++n) {
+    uint32_t m = r.newId[n];
+    GALOIS_ASSERT(g.getData(m) == n, "node data did not move");
+    std::vector<std::pair<uint32_t, uint32_t>> expected, actual;
+    for (auto& e : adj[n])
+      expected.emplace_back(r.newId[e.first], e.second);
+    for (auto e : g.edges(m))
+      actual.emplace_back(g.getEdgeDst(e), g.getEdgeData(e));
+    GALOIS_ASSERT(std::is_sorted(actual.begin(), actual.end(),
+                                 [](auto& a, auto& b) {
+                                   return a.first < b.first;
+                                 }),
+                  "edges not sorted");
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    GALOIS_ASSERT(expected == actual, "edges of ", n, " differ");
+  }
+}
+
+uint32_t bandwidth(Graph& g) {
+  uint32_t retval = 0;
+  for (uint32_t n = 0; n < g.size(); ++n)
+    for (auto e : g.edges(n)) {
+      uint32_t dst = g.getEdgeDst(e);
+      retval       = std::max(retval, dst > n ? dst - n : n - dst);
+    }
+  return retval;
+}
+
+int main() {
+  galois::SharedMemSys Galois_runtime;
+  galois::setActiveThreads(galois::substrate::getThreadPool().getMaxThreads());
+
+  using galois::graphs::ReorderAlgo;
+  AdjList adj = makeGraph(5010);
+
+  for (ReorderAlgo algo : {ReorderAlgo::DEGREE, ReorderAlgo::HUB,
+                           ReorderAlgo::RCM, ReorderAlgo::GORDER}) {
+    Graph g;
+    construct(g, adj);
+    auto r = galois::graphs::reorder(g, algo);
+    check(g, adj, r);
+  }
+
+  // orders that should come out in a particular way
+  {
+    Graph g;
+    construct(g, adj);
+    auto newId = galois::graphs::degreeSortOrder(g);
+    std::vector<uint32_t> oldId = galois::graphs::invertPermutation(newId);
+    for (uint32_t i = 1; i < oldId.size(); ++i)
+      GALOIS_ASSERT(adj[oldId[i - 1]].size() >= adj[oldId[i]].size());
+
+    auto hub = galois::graphs::hubClusterOrder(g);
+    double average = double(g.sizeEdges()) / g.size();
+    for (uint32_t n = 1; n < g.size(); ++n) {
+      bool h0 = adj[n - 1].size() > average, h1 = adj[n].size() > average;
+      if (h0 == h1)
+        GALOIS_ASSERT(hub[n - 1] < hub[n], "hub order not stable");
+    }
+  }
+
+  // RCM and Gorder recover a shuffled path
+  for (ReorderAlgo algo : {ReorderAlgo::RCM, ReorderAlgo::GORDER}) {
+    AdjList path = makePath(3000);
+    Graph g;
+    construct(g, path);
+    GALOIS_ASSERT(bandwidth(g) > 1);
+    auto r = galois::graphs::reorder(g, algo);
+    check(g, path, r);
+    if (algo == ReorderAlgo::RCM)
+      GALOIS_ASSERT(bandwidth(g) == 1, "RCM bandwidth ", bandwidth(g));
+  }
+
+  std::cout << "reorder ok\n";
+  return 0;
+}
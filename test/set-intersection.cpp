@@ -0,0 +1,83 @@
+/*
+ * This file belongs to the Galois project, a C++ library for exploiting parallelism.
+ * The code is being released under the terms of the 3-Clause BSD License (a
+ * copy is located in LICENSE.txt at the top-level directory).
+ *
+ * Copyright (C) 2019, The University of Texas at Austin. All rights reserved.
+ * UNIVERSITY EXPRESSLY DISCLAIMS ANY AND ALL WARRANTIES CONCERNING THIS
+ * SOFTWARE AND DOCUMENTATION, INCLUDING ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR ANY PARTICULAR PURPOSE, NON-INFRINGEMENT AND WARRANTIES OF
+ * PERFORMANCE, AND ANY WARRANTY THAT MIGHT OTHERWISE ARISE FROM COURSE OF
+ * DEALING OR USAGE OF TRADE.  NO WARRANTY IS EITHER EXPRESS OR IMPLIED WITH
+ * RESPECT TO THE USE OF THE SOFTWARE OR DOCUMENTATION. Under no circumstances
+ * shall University be liable for incidental, special, indirect, direct or
+ * consequential damages or loss of profits, interruption of business, or
+ * related expenses which may arise from use of Software or Documentation,
+ * including but not limited to those resulting from defects in Software and/or
+ * Documentation, or loss or inaccuracy of data of any kind.
+ */
+
+#include "galois/SetIntersection.h"
+#include "galois/gIO.h"
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+std::vector<uint32_t> randomList(std::mt19937& gen, size_t n, uint32_t range) {
+  std::uniform_int_distribution<uint32_t> dist(0, range - 1);
+  std::vector<uint32_t> v(n);
+  for (auto& x : v)
+    x = dist(gen);
+  std::sort(v.begin(), v.end());
+  v.erase(std::unique(v.begin(), v.end()), v.end());
+  return v;
+}
+
+int main() {
+  std::mt19937 gen(0);
+  std::cout << "SIMD kernel: " << galois::intersect::simdName() << "\n";
+
+  const size_t sizes[] = {0, 1, 7, 8, 15, 16, 17, 100, 1000, 50000};
+  const galois::intersect::Kernel kernels[] = {
+      galois::intersect::Auto, galois::intersect::Merge,
+      galois::intersect::Gallop, galois::intersect::SIMD};
+
+  galois::intersect::HubBitmap bitmap(1 << 16);
+
+  for (size_t na : sizes) {
+    for (size_t nb : sizes) {
+      auto la = randomList(gen, na, 1 << 16);
+      auto lb = randomList(gen, nb, 1 << 16);
+
+      std::vector<uint32_t> expected;
+      std::set_intersection(la.begin(), la.end(), lb.begin(), lb.end(),
+                            std::back_inserter(expected));
+
+      for (auto k : kernels) {
+        size_t c = galois::intersect::count(la.data(), la.size(), lb.data(),
+                                            lb.size(), k);
+        GALOIS_ASSERT(c == expected.size(), "kernel ", k, " sizes ", na, " ",
+                      nb, ": ", c, " != ", expected.size());
+      }
+
+      std::vector<uint32_t> matches;
+      galois::intersect::forEachMatch(
+          la.data(), la.size(), lb.data(), lb.size(), [&](size_t i, size_t j) {
+            GALOIS_ASSERT(la[i] == lb[j]);
+            matches.push_back(la[i]);
+            return true;
+          });
+      GALOIS_ASSERT(matches == expected);
+
+      bitmap.set(la.data(), la.size());
+      GALOIS_ASSERT(bitmap.count(lb.data(), lb.size()) == expected.size());
+      bitmap.reset(la.data(), la.size());
+      GALOIS_ASSERT(bitmap.count(lb.data(), lb.size()) == 0);
+    }
+  }
+
+  return 0;
+}
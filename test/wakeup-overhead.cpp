@@ -20,13 +20,17 @@
 #include "galois/Galois.h"
 #include "galois/Reduction.h"
 #include "galois/Timer.h"
+#include "galois/substrate/IdleWait.h"
 #include "Lonestar/BoilerPlate.h"
 #include "llvm/Support/CommandLine.h"
 
 #include <boost/iterator/counting_iterator.hpp>
 
+#include <chrono>
 #include <cmath>
+#include <ctime>
 #include <iostream>
+#include <thread>
 #include <vector>
 
 typedef galois::GAccumulator<double> AccumDouble;
@@ -39,6 +43,21 @@ static cll::opt<int> rounds("rounds", cll::desc("number of rounds"),
                             cll::init(10000));
 static cll::opt<int> trials("trials", cll::desc("number of trials"),
                             cll::init(1));
+static cll::opt<int> gap("gap",
+                         cll::desc("microseconds the master thread sleeps "
+                                   "between parallel regions (default 0)"),
+                         cll::init(0));
+static cll::opt<int>
+    spinBudget("spin",
+               cll::desc("polls before a waiting thread applies the idle "
+                         "policy (default: runtime default)"),
+               cll::init(-1));
+
+//! models a service that gets short queries with pauses in between
+void pauseBetweenRegions() {
+  if (gap > 0)
+    std::this_thread::sleep_for(std::chrono::microseconds(gap));
+}
 
 void runDoAllBurn(int num) {
   galois::substrate::getThreadPool().burnPower(galois::getActiveThreads());
@@ -47,6 +66,7 @@ void runDoAllBurn(int num) {
     galois::do_all(galois::iterate(0, num), [&](int i) {
       asm volatile("" ::: "memory");
     });
+    pauseBetweenRegions();
   }
 
   galois::substrate::getThreadPool().beKind();
@@ -57,6 +77,7 @@ void runDoAll(int num) {
     galois::do_all(galois::iterate(0, num), [&](int i) {
       asm volatile("" ::: "memory");
     });
+    pauseBetweenRegions();
   }
 }
 
@@ -77,16 +98,20 @@ void runExplicitThread(int num) {
   });
 }
 
+//! reports wall time and the CPU time of all threads, which shows what the
+//! idle policy costs in latency and saves in burnt cycles
 void run(std::function<void(int)> fn, std::string name) {
   galois::Timer t;
+  std::clock_t cpu = std::clock();
   t.start();
   fn(size);
   t.stop();
-  std::cout << name << " time: " << t.get() << "\n";
+  cpu = std::clock() - cpu;
+  std::cout << name << " time: " << t.get()
+            << " cpu: " << 1000 * cpu / CLOCKS_PER_SEC << "\n";
 }
 
 std::atomic<int> EXIT;
-#include <chrono>
 
 int main(int argc, char* argv[]) {
   galois::SharedMemSys Galois_runtime;
@@ -105,10 +130,22 @@ int main(int argc, char* argv[]) {
   std::cout << "threads: " << galois::getActiveThreads()
             << " rounds: " << rounds << " size: " << size << "\n";
 
+  using galois::substrate::IdlePolicy;
+  const std::pair<IdlePolicy, std::string> policies[] = {
+      {IdlePolicy::SPIN, "Spin"},
+      {IdlePolicy::YIELD, "Yield"},
+      {IdlePolicy::SLEEP, "Sleep"}};
+  const unsigned budget = spinBudget >= 0
+                              ? unsigned(spinBudget)
+                              : galois::substrate::getIdleSpinBudget();
+
   for (int t = 0; t < trials; ++t) {
-    run(runDoAll, "DoAll");
+    for (auto& p : policies) {
+      galois::substrate::setIdlePolicy(p.first, budget);
+      run(runDoAll, p.second + " DoAll");
+      run(runExplicitThread, p.second + " ExplicitThread");
+    }
     run(runDoAllBurn, "DoAllBurn");
-    run(runExplicitThread, "ExplicitThread");
   }
   EXIT = 1;
   return 0;